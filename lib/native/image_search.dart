@@ -1,3 +1,5 @@
+import 'dart:async';
+import 'dart:convert';
 import 'dart:ffi';
 import 'dart:io';
 import 'dart:typed_data';
@@ -19,6 +21,30 @@ base class SearchResult extends Struct {
 typedef LoadTemplateC = Int32 Function(Pointer<Utf8> path);
 typedef LoadTemplateDart = int Function(Pointer<Utf8> path);
 
+typedef LoadTemplatesBulkC =
+    Int32 Function(
+      Pointer<TemplateSource> sources,
+      Int32 count,
+      Pointer<Int32> outIds,
+      Pointer<TemplateSize> outSizes,
+    );
+typedef LoadTemplatesBulkDart =
+    int Function(
+      Pointer<TemplateSource> sources,
+      int count,
+      Pointer<Int32> outIds,
+      Pointer<TemplateSize> outSizes,
+    );
+
+typedef LoadTemplatePackC =
+    Int32 Function(
+      Pointer<Utf8> path,
+      Pointer<TemplatePackItem> out,
+      Int32 capacity,
+    );
+typedef LoadTemplatePackDart =
+    int Function(Pointer<Utf8> path, Pointer<TemplatePackItem> out, int capacity);
+
 typedef ReleaseTemplateC = Void Function(Int32 id);
 typedef ReleaseTemplateDart = void Function(int id);
 
@@ -40,6 +66,26 @@ typedef FindImageDart =
 typedef DebugSaveLastCaptureC = Void Function(Pointer<Utf8> path);
 typedef DebugSaveLastCaptureDart = void Function(Pointer<Utf8> path);
 
+typedef DebugSinkConfigureC =
+    Void Function(
+      Int32 mode,
+      Int32 everyN,
+      Double nearMissMargin,
+      Int32 queueCapacity,
+      Pointer<Utf8> directory,
+    );
+typedef DebugSinkConfigureDart =
+    void Function(
+      int mode,
+      int everyN,
+      double nearMissMargin,
+      int queueCapacity,
+      Pointer<Utf8> directory,
+    );
+
+typedef DebugSinkGetStatsC = Void Function(Pointer<DebugSinkStats> out);
+typedef DebugSinkGetStatsDart = void Function(Pointer<DebugSinkStats> out);
+
 // 批量查找接口定义
 typedef FindImagesBatchC =
     Void Function(
@@ -64,16 +110,350 @@ typedef FindImagesBatchDart =
       Pointer<SearchResultItem> results,
     );
 
+typedef FindImagesBatchExC =
+    Int32 Function(
+      Pointer<Uint8> imageBytes,
+      Int32 length,
+      Int32 width,
+      Int32 height,
+      Int32 stride,
+      Pointer<SearchRequest> requests,
+      Int32 count,
+      Pointer<SearchResultEx> results,
+      Pointer<BatchHeader> header,
+    );
+typedef FindImagesBatchExDart =
+    int Function(
+      Pointer<Uint8> imageBytes,
+      int length,
+      int width,
+      int height,
+      int stride,
+      Pointer<SearchRequest> requests,
+      int count,
+      Pointer<SearchResultEx> results,
+      Pointer<BatchHeader> header,
+    );
+
+// 异步批量查找接口定义
+typedef BatchCompletionCallbackC =
+    Void Function(Int32 ticket, Int32 status, Pointer<Void> userData);
+
+typedef SubmitBatchC =
+    Int32 Function(
+      Pointer<Uint8> imageBytes,
+      Int32 length,
+      Int32 width,
+      Int32 height,
+      Int32 stride,
+      Pointer<SearchRequest> requests,
+      Int32 count,
+      Pointer<SearchResultItem> results,
+      Pointer<NativeFunction<BatchCompletionCallbackC>> callback,
+      Pointer<Void> userData,
+    );
+typedef SubmitBatchDart =
+    int Function(
+      Pointer<Uint8> imageBytes,
+      int length,
+      int width,
+      int height,
+      int stride,
+      Pointer<SearchRequest> requests,
+      int count,
+      Pointer<SearchResultItem> results,
+      Pointer<NativeFunction<BatchCompletionCallbackC>> callback,
+      Pointer<Void> userData,
+    );
+
+// 引擎实例接口 (engine_*)，参数在旧接口前多一个引擎句柄
+typedef EngineCreateC = Int32 Function();
+typedef EngineCreateDart = int Function();
+
+typedef EngineDestroyC = Void Function(Int32 engine);
+typedef EngineDestroyDart = void Function(int engine);
+
+typedef EngineLoadTemplateC = Int32 Function(Int32 engine, Pointer<Utf8> path);
+typedef EngineLoadTemplateDart = int Function(int engine, Pointer<Utf8> path);
+
+typedef EngineReleaseTemplateC = Void Function(Int32 engine, Int32 id);
+typedef EngineReleaseTemplateDart = void Function(int engine, int id);
+
+typedef EngineFindImagesBatchC =
+    Void Function(
+      Int32 engine,
+      Pointer<Uint8> imageBytes,
+      Int32 length,
+      Int32 width,
+      Int32 height,
+      Int32 stride,
+      Pointer<SearchRequest> requests,
+      Int32 count,
+      Pointer<SearchResultItem> results,
+    );
+typedef EngineFindImagesBatchDart =
+    void Function(
+      int engine,
+      Pointer<Uint8> imageBytes,
+      int length,
+      int width,
+      int height,
+      int stride,
+      Pointer<SearchRequest> requests,
+      int count,
+      Pointer<SearchResultItem> results,
+    );
+
+typedef EngineAcquireInputBufferC =
+    Pointer<Uint8> Function(Int32 engine, Int32 size);
+typedef EngineAcquireInputBufferDart =
+    Pointer<Uint8> Function(int engine, int size);
+
+typedef EngineReleaseInputBufferC =
+    Void Function(Int32 engine, Pointer<Uint8> buffer);
+typedef EngineReleaseInputBufferDart =
+    void Function(int engine, Pointer<Uint8> buffer);
+
+typedef AcquireInputBufferC = Pointer<Uint8> Function(Int32 size);
+typedef AcquireInputBufferDart = Pointer<Uint8> Function(int size);
+
+typedef ReleaseInputBufferC = Void Function(Pointer<Uint8> buffer);
+typedef ReleaseInputBufferDart = void Function(Pointer<Uint8> buffer);
+
+typedef GetSearchStatsC =
+    Int32 Function(
+      Pointer<SearchStats> out,
+      Pointer<TemplateStats> templates,
+      Int32 capacity,
+    );
+typedef GetSearchStatsDart =
+    int Function(
+      Pointer<SearchStats> out,
+      Pointer<TemplateStats> templates,
+      int capacity,
+    );
+
+typedef ResetSearchStatsC = Void Function();
+typedef ResetSearchStatsDart = void Function();
+
+typedef TraceEnableC = Void Function(Int32 enabled);
+typedef TraceEnableDart = void Function(int enabled);
+
+typedef TraceIsEnabledC = Int32 Function();
+typedef TraceIsEnabledDart = int Function();
+
+typedef TraceNowNsC = Int64 Function();
+typedef TraceNowNsDart = int Function();
+
+typedef TraceInternC = Pointer<Utf8> Function(Pointer<Utf8> name);
+typedef TraceInternDart = Pointer<Utf8> Function(Pointer<Utf8> name);
+
+typedef TraceRecordC =
+    Void Function(Pointer<Utf8> name, Int64 startNs, Int64 durationNs);
+typedef TraceRecordDart =
+    void Function(Pointer<Utf8> name, int startNs, int durationNs);
+
+typedef TraceClearC = Void Function();
+typedef TraceClearDart = void Function();
+
+typedef TraceDumpC = Int32 Function(Pointer<Utf8> path);
+typedef TraceDumpDart = int Function(Pointer<Utf8> path);
+
+// 帧驱动自动化
+typedef AutomationEventCallbackC =
+    Void Function(
+      Int32 kind,
+      Int32 rule,
+      Int32 templateId,
+      Int32 x,
+      Int32 y,
+      Double score,
+      Int64 frameId,
+      Int64 latencyNs,
+      Pointer<Void> userData,
+    );
+
+typedef AutomationStartC =
+    Int32 Function(
+      Int32 engine,
+      Pointer<AutomationRule> rules,
+      Int32 count,
+      Pointer<NativeFunction<AutomationEventCallbackC>> callback,
+      Pointer<Void> userData,
+    );
+typedef AutomationStartDart =
+    int Function(
+      int engine,
+      Pointer<AutomationRule> rules,
+      int count,
+      Pointer<NativeFunction<AutomationEventCallbackC>> callback,
+      Pointer<Void> userData,
+    );
+
+typedef AutomationStopC = Void Function();
+typedef AutomationStopDart = void Function();
+
+typedef AutomationGetStatsC = Void Function(Pointer<AutomationStats> out);
+typedef AutomationGetStatsDart = void Function(Pointer<AutomationStats> out);
+
+typedef AutomationSetGovernorC =
+    Void Function(Pointer<AutomationGovernorConfig> config);
+typedef AutomationSetGovernorDart =
+    void Function(Pointer<AutomationGovernorConfig> config);
+
+typedef AutomationSetFrameBudgetC = Void Function(Int64 budgetUs);
+typedef AutomationSetFrameBudgetDart = void Function(int budgetUs);
+
+typedef AutomationGetRuleStatsC =
+    Int32 Function(Pointer<AutomationRuleStats> out, Int32 capacity);
+typedef AutomationGetRuleStatsDart =
+    int Function(Pointer<AutomationRuleStats> out, int capacity);
+
+typedef ScenarioStartC =
+    Int32 Function(
+      Int32 engine,
+      Pointer<Utf8> path,
+      Pointer<NativeFunction<AutomationEventCallbackC>> callback,
+      Pointer<Void> userData,
+      Pointer<Utf8> error,
+      Int32 errorSize,
+    );
+typedef ScenarioStartDart =
+    int Function(
+      int engine,
+      Pointer<Utf8> path,
+      Pointer<NativeFunction<AutomationEventCallbackC>> callback,
+      Pointer<Void> userData,
+      Pointer<Utf8> error,
+      int errorSize,
+    );
+
+typedef ScenarioGetRuleC =
+    Int32 Function(Int32 index, Pointer<ScenarioRuleInfo> out);
+typedef ScenarioGetRuleDart =
+    int Function(int index, Pointer<ScenarioRuleInfo> out);
+
+typedef RecorderStartC =
+    Int32 Function(Pointer<Utf8> path, Int32 keyframeInterval);
+typedef RecorderStartDart =
+    int Function(Pointer<Utf8> path, int keyframeInterval);
+
+typedef RecorderStopC = Int32 Function();
+typedef RecorderStopDart = int Function();
+
+typedef RecorderGetStatsC = Void Function(Pointer<RecorderStats> out);
+typedef RecorderGetStatsDart = void Function(Pointer<RecorderStats> out);
+
+typedef GetLastBatchDebugStatsC =
+    Void Function(Pointer<BatchDebugStats> out);
+typedef GetLastBatchDebugStatsDart =
+    void Function(Pointer<BatchDebugStats> out);
+
+// 编译好的查找计划
+typedef CompileSearchPlanC =
+    Int32 Function(
+      Pointer<SearchRequest> requests,
+      Int32 count,
+      Int32 frameWidth,
+      Int32 frameHeight,
+      Pointer<Int32> priorities,
+    );
+typedef CompileSearchPlanDart =
+    int Function(
+      Pointer<SearchRequest> requests,
+      int count,
+      int frameWidth,
+      int frameHeight,
+      Pointer<Int32> priorities,
+    );
+
+typedef RunSearchPlanC =
+    Int32 Function(
+      Int32 planId,
+      Pointer<Uint8> pixels,
+      Int32 stride,
+      Pointer<SearchResultItem> results,
+    );
+typedef RunSearchPlanDart =
+    int Function(
+      int planId,
+      Pointer<Uint8> pixels,
+      int stride,
+      Pointer<SearchResultItem> results,
+    );
+
+typedef RunSearchPlanExC =
+    Int32 Function(
+      Int32 planId,
+      Pointer<Uint8> pixels,
+      Int32 stride,
+      Pointer<SearchResultEx> results,
+      Pointer<BatchHeader> header,
+    );
+typedef RunSearchPlanExDart =
+    int Function(
+      int planId,
+      Pointer<Uint8> pixels,
+      int stride,
+      Pointer<SearchResultEx> results,
+      Pointer<BatchHeader> header,
+    );
+
+typedef ReleaseSearchPlanC = Void Function(Int32 planId);
+typedef ReleaseSearchPlanDart = void Function(int planId);
+
 class NativeImageSearch {
   static NativeImageSearch? _instance;
   late DynamicLibrary _lib;
 
   late LoadTemplateDart _loadTemplate;
+  late LoadTemplatesBulkDart _loadTemplatesBulk;
+  late LoadTemplatePackDart _loadTemplatePack;
   late ReleaseTemplateDart _releaseTemplate;
   late ReleaseAllTemplatesDart _releaseAllTemplates;
   late FindImageDart _findImage;
   late DebugSaveLastCaptureDart _debugSaveLastCapture;
+  late DebugSinkConfigureDart _debugSinkConfigure;
+  late EngineCreateDart _engineCreate;
+  late EngineDestroyDart _engineDestroy;
+  late EngineLoadTemplateDart _engineLoadTemplate;
+  late EngineReleaseTemplateDart _engineReleaseTemplate;
+  late EngineFindImagesBatchDart _engineFindImagesBatch;
+  late EngineAcquireInputBufferDart _engineAcquireInputBuffer;
+  late EngineReleaseInputBufferDart _engineReleaseInputBuffer;
+  late DebugSinkGetStatsDart _debugSinkGetStats;
   late FindImagesBatchDart _findImagesBatch;
+  late FindImagesBatchExDart _findImagesBatchEx;
+  late SubmitBatchDart _submitBatch;
+  late AcquireInputBufferDart _acquireInputBuffer;
+  late ReleaseInputBufferDart _releaseInputBuffer;
+  late GetLastBatchDebugStatsDart _getLastBatchDebugStats;
+  late GetSearchStatsDart _getSearchStats;
+  late ResetSearchStatsDart _resetSearchStats;
+  late TraceEnableDart _traceEnable;
+  late TraceIsEnabledDart _traceIsEnabled;
+  late TraceNowNsDart _traceNowNs;
+  late TraceInternDart _traceIntern;
+  late TraceRecordDart _traceRecord;
+  // 已驻留的追踪事件名称 -> 原生句柄 (进程内有效，不释放)
+  final _traceNames = <String, Pointer<Utf8>>{};
+  late TraceClearDart _traceClear;
+  late TraceDumpDart _traceDump;
+  late AutomationStartDart _automationStart;
+  late AutomationStopDart _automationStop;
+  late AutomationGetStatsDart _automationGetStats;
+  late AutomationSetGovernorDart _automationSetGovernor;
+  late AutomationSetFrameBudgetDart _automationSetFrameBudget;
+  late AutomationGetRuleStatsDart _automationGetRuleStats;
+  late ScenarioStartDart _scenarioStart;
+  late ScenarioGetRuleDart _scenarioGetRule;
+  late RecorderStartDart _recorderStart;
+  late RecorderStopDart _recorderStop;
+  late RecorderGetStatsDart _recorderGetStats;
+  late CompileSearchPlanDart _compileSearchPlan;
+  late RunSearchPlanDart _runSearchPlan;
+  late RunSearchPlanExDart _runSearchPlanEx;
+  late ReleaseSearchPlanDart _releaseSearchPlan;
 
   factory NativeImageSearch() {
     _instance ??= NativeImageSearch._internal();
@@ -129,6 +509,14 @@ class NativeImageSearch {
       _loadTemplate = _lib.lookupFunction<LoadTemplateC, LoadTemplateDart>(
         'load_template',
       );
+      _loadTemplatesBulk = _lib
+          .lookupFunction<LoadTemplatesBulkC, LoadTemplatesBulkDart>(
+            'load_templates_bulk',
+          );
+      _loadTemplatePack = _lib
+          .lookupFunction<LoadTemplatePackC, LoadTemplatePackDart>(
+            'load_template_pack',
+          );
       _releaseTemplate = _lib
           .lookupFunction<ReleaseTemplateC, ReleaseTemplateDart>(
             'release_template',
@@ -142,10 +530,151 @@ class NativeImageSearch {
           .lookupFunction<DebugSaveLastCaptureC, DebugSaveLastCaptureDart>(
             'debug_save_last_capture',
           );
+      _debugSinkConfigure = _lib
+          .lookupFunction<DebugSinkConfigureC, DebugSinkConfigureDart>(
+            'debug_sink_configure',
+          );
+      _debugSinkGetStats = _lib
+          .lookupFunction<DebugSinkGetStatsC, DebugSinkGetStatsDart>(
+            'debug_sink_get_stats',
+          );
+      _engineCreate = _lib.lookupFunction<EngineCreateC, EngineCreateDart>(
+        'engine_create',
+      );
+      _engineDestroy = _lib.lookupFunction<EngineDestroyC, EngineDestroyDart>(
+        'engine_destroy',
+      );
+      _engineLoadTemplate = _lib
+          .lookupFunction<EngineLoadTemplateC, EngineLoadTemplateDart>(
+            'engine_load_template',
+          );
+      _engineReleaseTemplate = _lib
+          .lookupFunction<EngineReleaseTemplateC, EngineReleaseTemplateDart>(
+            'engine_release_template',
+          );
+      _engineFindImagesBatch = _lib
+          .lookupFunction<EngineFindImagesBatchC, EngineFindImagesBatchDart>(
+            'engine_find_images_batch',
+          );
+      _engineAcquireInputBuffer = _lib
+          .lookupFunction<
+            EngineAcquireInputBufferC,
+            EngineAcquireInputBufferDart
+          >('engine_acquire_input_buffer');
+      _engineReleaseInputBuffer = _lib
+          .lookupFunction<
+            EngineReleaseInputBufferC,
+            EngineReleaseInputBufferDart
+          >('engine_release_input_buffer');
       _findImagesBatch = _lib
           .lookupFunction<FindImagesBatchC, FindImagesBatchDart>(
             'find_images_batch',
           );
+      _findImagesBatchEx = _lib
+          .lookupFunction<FindImagesBatchExC, FindImagesBatchExDart>(
+            'find_images_batch_ex',
+          );
+      _submitBatch = _lib.lookupFunction<SubmitBatchC, SubmitBatchDart>(
+        'submit_batch',
+      );
+      _acquireInputBuffer = _lib
+          .lookupFunction<AcquireInputBufferC, AcquireInputBufferDart>(
+            'acquire_input_buffer',
+          );
+      _releaseInputBuffer = _lib
+          .lookupFunction<ReleaseInputBufferC, ReleaseInputBufferDart>(
+            'release_input_buffer',
+          );
+      _getLastBatchDebugStats = _lib
+          .lookupFunction<GetLastBatchDebugStatsC, GetLastBatchDebugStatsDart>(
+            'get_last_batch_debug_stats',
+          );
+      _getSearchStats = _lib
+          .lookupFunction<GetSearchStatsC, GetSearchStatsDart>(
+            'get_search_stats',
+          );
+      _resetSearchStats = _lib
+          .lookupFunction<ResetSearchStatsC, ResetSearchStatsDart>(
+            'reset_search_stats',
+          );
+      _traceEnable = _lib.lookupFunction<TraceEnableC, TraceEnableDart>(
+        'trace_enable',
+      );
+      _traceIsEnabled = _lib
+          .lookupFunction<TraceIsEnabledC, TraceIsEnabledDart>(
+            'trace_is_enabled',
+          );
+      _traceNowNs = _lib.lookupFunction<TraceNowNsC, TraceNowNsDart>(
+        'trace_now_ns',
+      );
+      _traceIntern = _lib.lookupFunction<TraceInternC, TraceInternDart>(
+        'trace_intern',
+      );
+      _traceRecord = _lib.lookupFunction<TraceRecordC, TraceRecordDart>(
+        'trace_record',
+      );
+      _traceClear = _lib.lookupFunction<TraceClearC, TraceClearDart>(
+        'trace_clear',
+      );
+      _traceDump = _lib.lookupFunction<TraceDumpC, TraceDumpDart>(
+        'trace_dump',
+      );
+      _automationStart = _lib
+          .lookupFunction<AutomationStartC, AutomationStartDart>(
+            'automation_start',
+          );
+      _automationStop = _lib
+          .lookupFunction<AutomationStopC, AutomationStopDart>(
+            'automation_stop',
+          );
+      _automationGetStats = _lib
+          .lookupFunction<AutomationGetStatsC, AutomationGetStatsDart>(
+            'automation_get_stats',
+          );
+      _automationSetGovernor = _lib
+          .lookupFunction<AutomationSetGovernorC, AutomationSetGovernorDart>(
+            'automation_set_governor',
+          );
+      _automationSetFrameBudget = _lib
+          .lookupFunction<AutomationSetFrameBudgetC, AutomationSetFrameBudgetDart>(
+            'automation_set_frame_budget',
+          );
+      _automationGetRuleStats = _lib
+          .lookupFunction<AutomationGetRuleStatsC, AutomationGetRuleStatsDart>(
+            'automation_get_rule_stats',
+          );
+      _scenarioStart = _lib.lookupFunction<ScenarioStartC, ScenarioStartDart>(
+        'scenario_start',
+      );
+      _scenarioGetRule = _lib
+          .lookupFunction<ScenarioGetRuleC, ScenarioGetRuleDart>(
+            'scenario_get_rule',
+          );
+      _recorderStart = _lib.lookupFunction<RecorderStartC, RecorderStartDart>(
+        'recorder_start',
+      );
+      _recorderStop = _lib.lookupFunction<RecorderStopC, RecorderStopDart>(
+        'recorder_stop',
+      );
+      _recorderGetStats = _lib
+          .lookupFunction<RecorderGetStatsC, RecorderGetStatsDart>(
+            'recorder_get_stats',
+          );
+      _compileSearchPlan = _lib
+          .lookupFunction<CompileSearchPlanC, CompileSearchPlanDart>(
+            'compile_search_plan_ex',
+          );
+      _runSearchPlan = _lib.lookupFunction<RunSearchPlanC, RunSearchPlanDart>(
+        'run_search_plan',
+      );
+      _runSearchPlanEx = _lib
+          .lookupFunction<RunSearchPlanExC, RunSearchPlanExDart>(
+            'run_search_plan_ex',
+          );
+      _releaseSearchPlan = _lib
+          .lookupFunction<ReleaseSearchPlanC, ReleaseSearchPlanDart>(
+            'release_search_plan',
+          );
     } catch (e) {
       print('Failed to load native_image_search.dll: $e');
       // 可以选择抛出异常或降级处理
@@ -164,6 +693,78 @@ class NativeImageSearch {
     }
   }
 
+  /// 批量加载模板 (原生线程池并行解码，一次返回 ID 与尺寸)
+  /// 结果与 [sources] 一一对应；失败项的 id <= 0
+  List<LoadedTemplate> loadTemplatesBulk(List<TemplateSourceSpec> sources) {
+    if (sources.isEmpty) return [];
+    final count = sources.length;
+
+    return using((arena) {
+      final srcPtr = arena<TemplateSource>(count);
+      for (int i = 0; i < count; i++) {
+        final spec = sources[i];
+        final src = srcPtr[i];
+        src.kind = spec.kind;
+        src.width = spec.width;
+        src.height = spec.height;
+        src.stride = spec.stride;
+        src.path = spec.path != null
+            ? spec.path!.toNativeUtf8(allocator: arena)
+            : nullptr;
+        src.length = spec.data?.length ?? 0;
+        if (spec.data != null) {
+          final data = arena<Uint8>(spec.data!.length);
+          data.asTypedList(spec.data!.length).setAll(0, spec.data!);
+          src.data = data;
+        } else {
+          src.data = nullptr;
+        }
+      }
+
+      final idsPtr = arena<Int32>(count);
+      final sizesPtr = arena<TemplateSize>(count);
+      _loadTemplatesBulk(srcPtr, count, idsPtr, sizesPtr);
+
+      return List.generate(
+        count,
+        (i) => LoadedTemplate(
+          id: idsPtr[i],
+          width: sizesPtr[i].width,
+          height: sizesPtr[i].height,
+        ),
+      );
+    });
+  }
+
+  /// 加载模板包 (tools/template_packer 生成的 .pack 文件，内存映射，无需解码)
+  /// 返回 名称 -> 模板；文件无效时返回 null
+  Map<String, LoadedTemplate>? loadTemplatePack(String path) {
+    return using((arena) {
+      final pathPtr = path.toNativeUtf8(allocator: arena);
+      final count = _loadTemplatePack(pathPtr, nullptr, 0);
+      if (count < 0) return null;
+      if (count == 0) return <String, LoadedTemplate>{};
+
+      final items = arena<TemplatePackItem>(count);
+      if (_loadTemplatePack(pathPtr, items, count) != count) return null;
+
+      final loaded = <String, LoadedTemplate>{};
+      for (int i = 0; i < count; i++) {
+        final item = items[i];
+        final nameBytes = <int>[];
+        for (int k = 0; k < 64 && item.name[k] != 0; k++) {
+          nameBytes.add(item.name[k]);
+        }
+        loaded[utf8.decode(nameBytes)] = LoadedTemplate(
+          id: item.templateId,
+          width: item.width,
+          height: item.height,
+        );
+      }
+      return loaded;
+    });
+  }
+
   /// 释放指定模板
   void releaseTemplate(int id) {
     _releaseTemplate(id);
@@ -190,7 +791,7 @@ class NativeImageSearch {
     return _findImage(templateId, x, y, w, h, threshold);
   }
 
-  /// 调试：保存最后一次截图
+  /// 调试：保存调试输出最近采样的一张图片 (调试输出关闭时无效果)
   void debugSaveLastCapture(String path) {
     final pathPtr = path.toNativeUtf8();
     try {
@@ -200,6 +801,52 @@ class NativeImageSearch {
     }
   }
 
+  /// 配置调试图片输出 (默认关闭)
+  ///
+  /// [mode] 为 [DebugSinkMode] 的组合；采中的图片由后台线程写入 [directory]，
+  /// 文件名为 `<tag>_<序号>.png`，并覆盖 `debug_last_<tag>.png`。
+  /// 队列超过 [queueCapacity] 时丢弃新图片，不阻塞查找。
+  void configureDebugSink({
+    int mode = DebugSinkMode.off,
+    int everyN = 1,
+    double nearMissMargin = 0.0,
+    int queueCapacity = 4,
+    String? directory,
+  }) {
+    using((arena) {
+      _debugSinkConfigure(
+        mode,
+        everyN,
+        nearMissMargin,
+        queueCapacity,
+        directory != null ? directory.toNativeUtf8(allocator: arena) : nullptr,
+      );
+    });
+  }
+
+  /// 调试输出计数: sampled / written / dropped / failed
+  Map<String, int> getDebugSinkStats() {
+    return using((arena) {
+      final ptr = arena<DebugSinkStats>();
+      _debugSinkGetStats(ptr);
+      return {
+        'sampled': ptr.ref.sampled,
+        'written': ptr.ref.written,
+        'dropped': ptr.ref.dropped,
+        'failed': ptr.ref.failed,
+      };
+    });
+  }
+
+  /// 从原生缓冲池取得一块输入缓冲 (64 字节对齐)
+  /// 调用方直接写入 [NativeInputBuffer.bytes]，再交给 [findImagesBatchInBuffer]，
+  /// 用完调用 [NativeInputBuffer.release] 归还。返回 null 表示分配失败
+  NativeInputBuffer? acquireInputBuffer(int size) {
+    final ptr = _acquireInputBuffer(size);
+    if (ptr == nullptr) return null;
+    return NativeInputBuffer._(ptr, size);
+  }
+
   /// 批量查找图片
   /// [imageBytes] 源图片数据 (PNG/JPG 或 Raw BGRA)
   /// [width], [height] 如果是 Raw 数据，必须提供宽高；如果是压缩数据，传 0
@@ -213,31 +860,47 @@ class NativeImageSearch {
   }) {
     if (requests.isEmpty) return [];
 
-    final int count = requests.length;
-    final int stride = width * 4; // 假设标准 stride
+    // 写入池化的原生缓冲，帧尺寸不变时不再分配内存
+    final buffer = acquireInputBuffer(imageBytes.length);
+    if (buffer == null) {
+      throw StateError('Failed to acquire input buffer');
+    }
+    try {
+      buffer.bytes.setAll(0, imageBytes);
+      return findImagesBatchInBuffer(
+        buffer,
+        requests,
+        length: imageBytes.length,
+        width: width,
+        height: height,
+      );
+    } finally {
+      buffer.release();
+    }
+  }
 
-    // 分配内存
-    final imgPtr = calloc<Uint8>(imageBytes.length);
-    final imgList = imgPtr.asTypedList(imageBytes.length);
-    imgList.setAll(0, imageBytes);
+  /// 在已写入原生缓冲的帧上批量查找 (原生层原地读取，不复制)
+  /// [length] 有效数据长度，默认为整个缓冲
+  List<SearchResultStruct> findImagesBatchInBuffer(
+    NativeInputBuffer buffer,
+    List<SearchRequestStruct> requests, {
+    int? length,
+    int width = 0,
+    int height = 0,
+  }) {
+    if (requests.isEmpty) return [];
+    if (buffer.isReleased) throw StateError('Input buffer already released');
 
-    final reqPtr = calloc<SearchRequest>(count);
-    for (int i = 0; i < count; i++) {
-      final req = reqPtr[i];
-      req.templateId = requests[i].templateId;
-      req.roiX = requests[i].roiX;
-      req.roiY = requests[i].roiY;
-      req.roiW = requests[i].roiW;
-      req.roiH = requests[i].roiH;
-      req.threshold = requests[i].threshold;
-    }
+    final int count = requests.length;
+    final int stride = width * 4; // 假设标准 stride
 
+    final reqPtr = _allocRequests(requests);
     final resPtr = calloc<SearchResultItem>(count);
 
     try {
       _findImagesBatch(
-        imgPtr,
-        imageBytes.length,
+        buffer.pointer,
+        length ?? buffer.size,
         width,
         height,
         stride,
@@ -256,33 +919,602 @@ class NativeImageSearch {
         );
       });
     } finally {
-      calloc.free(imgPtr);
       calloc.free(reqPtr);
       calloc.free(resPtr);
     }
   }
-}
-
-// 纯 Dart 类用于批量请求 (避免暴露 FFI Struct)
-class SearchResultStruct {
-  final int templateId;
-  final int x;
-  final int y;
-  final double score;
 
-  SearchResultStruct({
-    required this.templateId,
-    required this.x,
-    required this.y,
-    required this.score,
-  });
-}
+  /// 批量查找并返回逐请求的耗时与代价统计 (调优 ROI 与阈值用)
+  /// 参数含义与 [findImagesBatch] 相同
+  /// [deadlineUs] > 0 时为批次预算 (微秒)：按优先级执行，超出预算的非关键请求被跳过
+  /// ([SearchResultExData.skippedDeadline])，下一批次优先执行
+  BatchReport findImagesBatchEx(
+    Uint8List imageBytes,
+    List<SearchRequestStruct> requests, {
+    int width = 0,
+    int height = 0,
+    int deadlineUs = 0,
+  }) {
+    if (requests.isEmpty) {
+      return BatchReport(status: 0, header: const {}, results: const []);
+    }
+    final count = requests.length;
+    final buffer = acquireInputBuffer(imageBytes.length);
+    if (buffer == null) {
+      throw StateError('Failed to acquire input buffer');
+    }
+    final reqPtr = _allocRequests(requests);
+    final resPtr = calloc<SearchResultEx>(count);
+    final headerPtr = calloc<BatchHeader>();
+    // 优先级不在 SearchRequest 中 (其布局固定)，随带版本的 BatchHeader 传入
+    final priorities = calloc<Int32>(count);
+    try {
+      buffer.bytes.setAll(0, imageBytes);
+      for (int i = 0; i < count; i++) {
+        priorities[i] = requests[i].priority;
+      }
+      headerPtr.ref.version = searchResultExVersion;
+      headerPtr.ref.resultSize = sizeOf<SearchResultEx>();
+      headerPtr.ref.deadlineUs = deadlineUs;
+      headerPtr.ref.priorities = priorities;
+      final status = _findImagesBatchEx(
+        buffer.pointer,
+        imageBytes.length,
+        width,
+        height,
+        width * 4,
+        reqPtr,
+        count,
+        resPtr,
+        headerPtr,
+      );
+      final h = headerPtr.ref;
+      return BatchReport(
+        status: status,
+        header: {
+          'requestCount': h.requestCount,
+          'regionCount': h.regionCount,
+          'decodeNs': h.decodeNs,
+          'convertNs': h.convertNs,
+          'matchNs': h.matchNs,
+          'totalNs': h.totalNs,
+          'skippedCount': h.skippedCount,
+        },
+        results: status == 0 || status == -2
+            ? List.generate(count, (i) => SearchResultExData.from(resPtr[i]))
+            : const [],
+      );
+    } finally {
+      buffer.release();
+      calloc.free(reqPtr);
+      calloc.free(resPtr);
+      calloc.free(headerPtr);
+      calloc.free(priorities);
+    }
+  }
+
+  /// 异步批量查找 (原生工作线程池执行，不经过 Isolate 消息复制)
+  /// 多个批次可同时在途；完成后在调用方 Isolate 的事件循环中返回结果
+  /// 参数含义与 [findImagesBatch] 相同
+  Future<List<SearchResultStruct>> submitBatch(
+    Uint8List imageBytes,
+    List<SearchRequestStruct> requests, {
+    int width = 0,
+    int height = 0,
+  }) {
+    if (requests.isEmpty) return Future.value(const []);
+
+    final buffer = acquireInputBuffer(imageBytes.length);
+    if (buffer == null) {
+      return Future.error(StateError('Failed to acquire input buffer'));
+    }
+    buffer.bytes.setAll(0, imageBytes);
+
+    final count = requests.length;
+    final reqPtr = _allocRequests(requests);
+    final resPtr = calloc<SearchResultItem>(count);
+    final ticket = _submitBatch(
+      buffer.pointer,
+      imageBytes.length,
+      width,
+      height,
+      width * 4,
+      reqPtr,
+      count,
+      resPtr,
+      _batchCompletion.nativeFunction,
+      nullptr,
+    );
+    // 请求数组已在原生层复制
+    calloc.free(reqPtr);
+
+    if (ticket <= 0) {
+      buffer.release();
+      calloc.free(resPtr);
+      return Future.error(StateError('submit_batch failed: $ticket'));
+    }
+
+    // 回调经由事件循环投递，必然在这里登记之后才会执行
+    final pending = _PendingBatch(buffer, resPtr, count);
+    _pendingBatches[ticket] = pending;
+    return pending.completer.future;
+  }
+
+  final _pendingBatches = <int, _PendingBatch>{};
+
+  late final NativeCallable<BatchCompletionCallbackC> _batchCompletion =
+      NativeCallable<BatchCompletionCallbackC>.listener(_onBatchCompleted);
+
+  void _onBatchCompleted(int ticket, int status, Pointer<Void> userData) {
+    final pending = _pendingBatches.remove(ticket);
+    if (pending == null) return;
+    try {
+      if (status != 0) {
+        pending.completer.completeError(
+          StateError('Batch $ticket failed: $status'),
+        );
+        return;
+      }
+      pending.completer.complete(
+        List.generate(pending.count, (i) {
+          final item = pending.results[i];
+          return SearchResultStruct(
+            templateId: item.templateId,
+            x: item.x,
+            y: item.y,
+            score: item.score,
+          );
+        }),
+      );
+    } finally {
+      pending.buffer.release();
+      calloc.free(pending.results);
+    }
+  }
+
+  static Pointer<SearchRequest> _allocRequests(
+    List<SearchRequestStruct> requests,
+  ) {
+    final reqPtr = calloc<SearchRequest>(requests.length);
+    for (int i = 0; i < requests.length; i++) {
+      final req = reqPtr[i];
+      req.templateId = requests[i].templateId;
+      req.roiX = requests[i].roiX;
+      req.roiY = requests[i].roiY;
+      req.roiW = requests[i].roiW;
+      req.roiH = requests[i].roiH;
+      req.method = requests[i].method;
+      req.threshold = requests[i].threshold;
+    }
+    return reqPtr;
+  }
+
+  /// 编译可重复执行的查找计划 (每帧发送相同请求列表时使用)
+  /// [width], [height] 为之后每帧 BGRA 原始像素的尺寸
+  /// 请求的 priority 在编译时固定，只在 [CompiledSearchPlan.runPointerEx] 设置了预算时生效
+  /// 返回 null 表示编译失败
+  CompiledSearchPlan? compileSearchPlan(
+    List<SearchRequestStruct> requests, {
+    required int width,
+    required int height,
+  }) {
+    if (requests.isEmpty) return null;
+    final reqPtr = _allocRequests(requests);
+    final priorities = calloc<Int32>(requests.length);
+    try {
+      for (int i = 0; i < requests.length; i++) {
+        priorities[i] = requests[i].priority;
+      }
+      final id = _compileSearchPlan(
+        reqPtr,
+        requests.length,
+        width,
+        height,
+        priorities,
+      );
+      if (id <= 0) return null;
+      return CompiledSearchPlan._(id, requests.length, width, height);
+    } finally {
+      calloc.free(reqPtr);
+      calloc.free(priorities);
+    }
+  }
+
+  /// 运行期统计快照 (调用次数、命中率与解码 / 转换 / 匹配延迟分位数)
+  /// 代价很低，可由 UI 每秒轮询
+  Map<String, dynamic> getSearchStats({int maxTemplates = 256}) {
+    return using((arena) {
+      final stats = arena<SearchStats>();
+      final templates = arena<TemplateStats>(maxTemplates);
+      final total = _getSearchStats(stats, templates, maxTemplates);
+
+      Map<String, int> latency(LatencySummary l) => {
+        'count': l.count,
+        'totalNs': l.totalNs,
+        'p50Ns': l.p50Ns,
+        'p99Ns': l.p99Ns,
+        'maxNs': l.maxNs,
+      };
+
+      final s = stats.ref;
+      return {
+        'batches': s.batches,
+        'decode': latency(s.decode),
+        'convert': latency(s.convert),
+        'match': latency(s.match),
+        'templates': [
+          for (int i = 0; i < total && i < maxTemplates; i++)
+            {
+              'templateId': templates[i].templateId,
+              'calls': templates[i].calls,
+              'hits': templates[i].hits,
+              'totalNs': templates[i].totalNs,
+              'maxNs': templates[i].maxNs,
+            },
+        ],
+      };
+    });
+  }
+
+  /// 清零运行期统计
+  void resetSearchStats() {
+    _resetSearchStats();
+  }
+
+  /// 开关追踪 (需以 IMAGE_SEARCH_TRACING 构建 DLL，否则无效果)
+  void traceEnable(bool enabled) {
+    _traceEnable(enabled ? 1 : 0);
+  }
+
+  bool get traceEnabled => _traceIsEnabled() != 0;
+
+  /// 与原生追踪事件同一时基的时钟 (纳秒)
+  int traceNowNs() => _traceNowNs();
+
+  /// 驻留事件名称，返回供 [traceRecord] 使用的句柄；同名只在首次调用时进入原生层
+  /// (未编译追踪支持时为 nullptr，traceRecord 会忽略)
+  Pointer<Utf8> traceIntern(String name) {
+    return _traceNames.putIfAbsent(name, () {
+      return using((arena) {
+        return _traceIntern(name.toNativeUtf8(allocator: arena));
+      });
+    });
+  }
+
+  /// 记录一个 Dart 侧的完整事件 (如 isolate 往返)；name 为 [traceIntern] 返回的句柄
+  void traceRecord(Pointer<Utf8> name, int startNs, int durationNs) {
+    _traceRecord(name, startNs, durationNs);
+  }
+
+  void traceClear() {
+    _traceClear();
+  }
+
+  /// 导出 Chrome trace-event JSON，返回事件数；-1 无法写入, -2 未编译追踪支持
+  int traceDump(String path) {
+    return using((arena) {
+      return _traceDump(path.toNativeUtf8(allocator: arena));
+    });
+  }
+
+  /// 启动帧驱动自动化
+  /// Runner 每收到一帧就在原生工作线程上评估全部 [rules]，
+  /// 规则出现 / 消失 / 按 repeatMs 持续出现时通过 [onEvent] 上报 (在当前 Isolate 的事件循环中)。
+  /// 同一时间只有一组规则生效，再次调用会替换旧规则。
+  /// 返回值: 0 成功, -3 参数无效, -5 引擎无效
+  int startAutomation(
+    List<AutomationRuleSpec> rules,
+    void Function(AutomationEvent event) onEvent, {
+    int engine = 0,
+  }) {
+    stopAutomation();
+    if (rules.isEmpty) return -3;
+
+    final callable = _automationListener(onEvent);
+    final status = using((arena) {
+      final rulePtr = arena<AutomationRule>(rules.length);
+      for (int i = 0; i < rules.length; i++) {
+        final spec = rules[i];
+        final rule = rulePtr[i];
+        rule.request.templateId = spec.request.templateId;
+        rule.request.roiX = spec.request.roiX;
+        rule.request.roiY = spec.request.roiY;
+        rule.request.roiW = spec.request.roiW;
+        rule.request.roiH = spec.request.roiH;
+        rule.request.method = spec.request.method;
+        rule.request.threshold = spec.request.threshold;
+        rule.repeatMs = spec.repeatMs;
+        rule.priority = spec.request.priority;
+      }
+      return _automationStart(
+        engine,
+        rulePtr,
+        rules.length,
+        callable.nativeFunction,
+        nullptr,
+      );
+    });
+
+    if (status != 0) {
+      callable.close();
+      return status;
+    }
+    _automationCallback = callable;
+    return 0;
+  }
+
+  NativeCallable<AutomationEventCallbackC>? _automationCallback;
+
+  static NativeCallable<AutomationEventCallbackC> _automationListener(
+    void Function(AutomationEvent event) onEvent,
+  ) {
+    return NativeCallable<AutomationEventCallbackC>.listener((
+      int kind,
+      int rule,
+      int templateId,
+      int x,
+      int y,
+      double score,
+      int frameId,
+      int latencyNs,
+      Pointer<Void> userData,
+    ) {
+      onEvent(
+        AutomationEvent(
+          kind: kind,
+          rule: rule,
+          templateId: templateId,
+          x: x,
+          y: y,
+          score: score,
+          frameId: frameId,
+          latencyNs: latencyNs,
+        ),
+      );
+    });
+  }
+
+  /// 从场景文件 (JSON，格式见 native_lib/scenario.h) 启动自动化
+  /// 模板、ROI、阈值、前置条件、冷却时间与动作都在场景中描述，调整后无需重新构建程序。
+  /// [onEvent] 中的 rule 为返回列表的下标；动作 (按键) 由调用方根据 [ScenarioRuleData] 执行。
+  /// 场景无效或模板加载失败时抛出 [StateError]
+  List<ScenarioRuleData> startScenario(
+    String path,
+    void Function(AutomationEvent event) onEvent, {
+    int engine = 0,
+  }) {
+    stopAutomation();
+    final callable = _automationListener(onEvent);
+    return using((arena) {
+      const errorSize = 512;
+      final error = arena<Uint8>(errorSize);
+      final count = _scenarioStart(
+        engine,
+        path.toNativeUtf8(allocator: arena),
+        callable.nativeFunction,
+        nullptr,
+        error.cast<Utf8>(),
+        errorSize,
+      );
+      if (count <= 0) {
+        callable.close();
+        final message = count == -1 ? error.cast<Utf8>().toDartString() : '';
+        throw StateError('scenario_start failed ($count): $message');
+      }
+      _automationCallback = callable;
+
+      final info = arena<ScenarioRuleInfo>();
+      final rules = <ScenarioRuleData>[];
+      for (int i = 0; i < count; i++) {
+        if (_scenarioGetRule(i, info) != 0) break;
+        rules.add(
+          ScenarioRuleData(
+            name: _decodeCString(info.ref.name, 32),
+            label: _decodeCString(info.ref.label, 64),
+            templateId: info.ref.templateId,
+            templateWidth: info.ref.templateWidth,
+            templateHeight: info.ref.templateHeight,
+            actionKey: info.ref.actionKey,
+            actionHoldMs: info.ref.actionHoldMs,
+            cooldownMs: info.ref.cooldownMs,
+          ),
+        );
+      }
+      return rules;
+    });
+  }
+
+  static String _decodeCString(Array<Uint8> bytes, int size) {
+    final data = <int>[];
+    for (int i = 0; i < size && bytes[i] != 0; i++) {
+      data.add(bytes[i]);
+    }
+    // 原生层截断可能切开多字节字符
+    return utf8.decode(data, allowMalformed: true);
+  }
+
+  /// 停止自动化；返回后不会再有新的事件
+  void stopAutomation() {
+    _automationStop();
+    _automationCallback?.close();
+    _automationCallback = null;
+  }
+
+  /// 自动化运行统计 (帧数、丢帧与帧到达到评估完成的反应延迟，单位纳秒)
+  /// cpuUsage 为评估线程忙碌比例，governorScale 为 CPU 预算导致的采样间隔倍数
+  Map<String, num> getAutomationStats() {
+    return using((arena) {
+      final ptr = arena<AutomationStats>();
+      _automationGetStats(ptr);
+      return {
+        'framesSubmitted': ptr.ref.framesSubmitted,
+        'framesEvaluated': ptr.ref.framesEvaluated,
+        'framesDropped': ptr.ref.framesDropped,
+        'events': ptr.ref.events,
+        'lastLatencyNs': ptr.ref.lastLatencyNs,
+        'p50LatencyNs': ptr.ref.p50LatencyNs,
+        'p99LatencyNs': ptr.ref.p99LatencyNs,
+        'maxLatencyNs': ptr.ref.maxLatencyNs,
+        'rulesEvaluated': ptr.ref.rulesEvaluated,
+        'rulesSkipped': ptr.ref.rulesSkipped,
+        'rulesDeferred': ptr.ref.rulesDeferred,
+        'cpuUsage': ptr.ref.cpuUsage,
+        'governorScale': ptr.ref.governorScale,
+      };
+    });
+  }
+
+  /// 自适应调度: 刚命中的规则每 [minIntervalMs] 评估一次 (0 为每帧)，
+  /// 未命中时间隔加倍直到 [maxIntervalMs]；画面变化超过 [sceneChangeThreshold]
+  /// (0-255) 时全部规则立即评估；评估线程忙碌比例超过 [cpuBudget] (0-1) 时放大间隔。
+  /// 立即作用于运行中的自动化，场景文件中的 governor 段优先。[enabled] 为 false 时关闭
+  void setAutomationGovernor({
+    bool enabled = true,
+    int minIntervalMs = 0,
+    int maxIntervalMs = 1000,
+    double sceneChangeThreshold = 0,
+    double cpuBudget = 0,
+  }) {
+    using((arena) {
+      final ptr = arena<AutomationGovernorConfig>();
+      ptr.ref.enabled = enabled ? 1 : 0;
+      ptr.ref.minIntervalMs = minIntervalMs;
+      ptr.ref.maxIntervalMs = maxIntervalMs;
+      ptr.ref.sceneChangeThreshold = sceneChangeThreshold;
+      ptr.ref.cpuBudget = cpuBudget;
+      _automationSetGovernor(ptr);
+    });
+  }
+
+  /// 单帧评估预算 (微秒)，0 表示不限；立即作用于运行中的自动化，并作为之后启动的默认值。
+  /// 预算耗尽后其余非关键规则 (按 [SearchRequestStruct.priority]) 本帧沿用上次结论，下一帧优先评估
+  void setAutomationFrameBudget(int budgetUs) {
+    _automationSetFrameBudget(budgetUs);
+  }
+
+  /// 每条规则的实际评估频率 (rateHz)、命中情况与当前采样间隔
+  List<Map<String, num>> getAutomationRuleStats() {
+    return using((arena) {
+      final count = _automationGetRuleStats(nullptr, 0);
+      if (count <= 0) return <Map<String, num>>[];
+      final ptr = arena<AutomationRuleStats>(count);
+      // 两次调用之间规则组可能被替换，只读取实际写入的部分
+      final written = _automationGetRuleStats(ptr, count);
+      return [
+        for (var i = 0; i < written && i < count; i++)
+          {
+            'evaluations': ptr[i].evaluations,
+            'hits': ptr[i].hits,
+            'rateHz': ptr[i].rateHz,
+            'hitRate': ptr[i].hitRate,
+            'intervalMs': ptr[i].intervalMs,
+          },
+      ];
+    });
+  }
+
+  /// 开始把截图帧录制到 [path] (.frec，供 search_replay / automation_replay 回放)
+  /// [keyframeInterval] 为关键帧间隔 (帧数)，<= 0 使用默认值 60；已在录制时先停止旧的录制
+  void startRecording(String path, {int keyframeInterval = 0}) {
+    final code = using(
+      (arena) =>
+          _recorderStart(path.toNativeUtf8(allocator: arena), keyframeInterval),
+    );
+    if (code != 0) {
+      throw StateError('recorder_start failed ($code): $path');
+    }
+  }
+
+  /// 停止录制 (写完排队中的帧与索引)；返回 false 表示没有在录制或写入出错
+  bool stopRecording() => _recorderStop() == 0;
+
+  /// 录制统计: 帧数、丢帧、文件大小与原始大小 (压缩比)、单帧编码耗时 (纳秒)
+  Map<String, int> getRecorderStats() {
+    return using((arena) {
+      final ptr = arena<RecorderStats>();
+      _recorderGetStats(ptr);
+      return {
+        'submitted': ptr.ref.submitted,
+        'written': ptr.ref.written,
+        'dropped': ptr.ref.dropped,
+        'keyframes': ptr.ref.keyframes,
+        'bytesWritten': ptr.ref.bytesWritten,
+        'rawBytes': ptr.ref.rawBytes,
+        'lastEncodeNs': ptr.ref.lastEncodeNs,
+        'maxEncodeNs': ptr.ref.maxEncodeNs,
+        'recording': ptr.ref.recording,
+        'failed': ptr.ref.failed,
+      };
+    });
+  }
+
+  /// 最近一次批量查找的调试统计 (区域合并、请求分组与窗口统计共享情况)
+  Map<String, int> getLastBatchDebugStats() {
+    final ptr = calloc<BatchDebugStats>();
+    try {
+      _getLastBatchDebugStats(ptr);
+      final s = ptr.ref;
+      return {
+        'requestCount': s.requestCount,
+        'opencvRequests': s.opencvRequests,
+        'kernelRequests': s.kernelRequests,
+        'groupCount': s.groupCount,
+        'sharedRequests': s.sharedRequests,
+        'windowStatsPasses': s.windowStatsPasses,
+        'windowStatsSaved': s.windowStatsSaved,
+        'regionCount': s.regionCount,
+        'requestedPixels': s.requestedPixels,
+        'preparedPixels': s.preparedPixels,
+      };
+    } finally {
+      calloc.free(ptr);
+    }
+  }
+}
+
+// 纯 Dart 类用于批量请求 (避免暴露 FFI Struct)
+class SearchResultStruct {
+  final int templateId;
+  final int x;
+  final int y;
+  final double score;
+
+  SearchResultStruct({
+    required this.templateId,
+    required this.x,
+    required this.y,
+    required this.score,
+  });
+}
+
+/// 匹配算法 (与 C++ SearchMethod 对应)
+class SearchMethod {
+  /// OpenCV TM_CCOEFF_NORMED，默认算法，对亮度变化鲁棒
+  static const int ccoeffNormed = 0;
+
+  /// 逐次消除 SSD，适合像素级一致的 UI 元素，分数为 1 - RMS(差值)/255
+  static const int ssd = 1;
+
+  /// 8 位整数 NCC (SIMD)，分数与 [ccoeffNormed] 一致，小模板 / 小 ROI 时更快
+  static const int nccInt8 = 2;
+
+  /// 按代价自动选择: 小 ROI 用 [nccInt8]，大区域用 [ccoeffNormed]
+  static const int auto = 3;
+}
 
 class SearchRequestStruct {
   final int templateId;
   final int roiX, roiY, roiW, roiH;
   final double threshold;
 
+  /// 匹配算法，见 [SearchMethod]
+  final int method;
+
+  /// 优先级，见 [SearchPriority]；只在设置了截止时间 ([NativeImageSearch.findImagesBatchEx]、
+  /// [CompiledSearchPlan.runPointerEx]、[NativeImageSearch.setAutomationFrameBudget]) 时影响执行顺序
+  /// (另行传入，不占用原生 SearchRequest 结构体)
+  final int priority;
+
   SearchRequestStruct(
     this.templateId, {
     this.roiX = 0,
@@ -290,9 +1522,19 @@ class SearchRequestStruct {
     this.roiW = -1,
     this.roiH = -1,
     this.threshold = 0.9,
+    this.method = SearchMethod.ccoeffNormed,
+    this.priority = SearchPriority.normal,
   });
 }
 
+/// 请求优先级 (与 C++ SearchPriority 对应)，越大越先执行
+class SearchPriority {
+  static const int normal = 0;
+
+  /// 不低于该值的请求总是执行，不受截止时间限制
+  static const int critical = 100;
+}
+
 // FFI 结构体定义 (与 C++ 对应)
 base class SearchRequest extends Struct {
   @Int32()
@@ -305,10 +1547,450 @@ base class SearchRequest extends Struct {
   external int roiW;
   @Int32()
   external int roiH;
+  @Int32()
+  external int method;
   @Double()
   external double threshold;
 }
 
+// 帧驱动自动化规则 (与 C++ AutomationRule 对应)
+base class AutomationRule extends Struct {
+  external SearchRequest request;
+  @Int32()
+  external int repeatMs;
+  @Int32()
+  external int priority;
+}
+
+base class AutomationStats extends Struct {
+  @Int64()
+  external int framesSubmitted;
+  @Int64()
+  external int framesEvaluated;
+  @Int64()
+  external int framesDropped;
+  @Int64()
+  external int events;
+  @Int64()
+  external int lastLatencyNs;
+  @Int64()
+  external int p50LatencyNs;
+  @Int64()
+  external int p99LatencyNs;
+  @Int64()
+  external int maxLatencyNs;
+  @Int64()
+  external int rulesEvaluated;
+  @Int64()
+  external int rulesSkipped;
+  @Int64()
+  external int rulesDeferred;
+  @Double()
+  external double cpuUsage;
+  @Double()
+  external double governorScale;
+}
+
+base class AutomationGovernorConfig extends Struct {
+  @Int32()
+  external int enabled;
+  @Int32()
+  external int minIntervalMs;
+  @Int32()
+  external int maxIntervalMs;
+  @Double()
+  external double sceneChangeThreshold;
+  @Double()
+  external double cpuBudget;
+}
+
+base class AutomationRuleStats extends Struct {
+  @Int64()
+  external int evaluations;
+  @Int64()
+  external int hits;
+  @Double()
+  external double rateHz;
+  @Double()
+  external double hitRate;
+  @Int32()
+  external int intervalMs;
+  @Int32()
+  external int reserved;
+}
+
+base class ScenarioRuleInfo extends Struct {
+  @Array(32)
+  external Array<Uint8> name;
+  @Array(64)
+  external Array<Uint8> label;
+  @Int32()
+  external int templateId;
+  @Int32()
+  external int templateWidth;
+  @Int32()
+  external int templateHeight;
+  @Int32()
+  external int actionKey;
+  @Int32()
+  external int actionHoldMs;
+  @Int32()
+  external int cooldownMs;
+}
+
+/// 场景中的一条规则 (名称、模板尺寸与命中时的动作)
+class ScenarioRuleData {
+  final String name;
+  final String label;
+  final int templateId;
+  final int templateWidth;
+  final int templateHeight;
+  final int actionKey; // Windows 虚拟键码，0 表示无动作
+  final int actionHoldMs;
+  final int cooldownMs;
+
+  ScenarioRuleData({
+    required this.name,
+    required this.label,
+    required this.templateId,
+    required this.templateWidth,
+    required this.templateHeight,
+    required this.actionKey,
+    required this.actionHoldMs,
+    required this.cooldownMs,
+  });
+
+  bool get hasAction => actionKey != 0;
+}
+
+/// 一条自动化规则: 查找请求，以及持续出现时重复上报的最小间隔 (0 表示只在出现 / 消失时上报)
+class AutomationRuleSpec {
+  final SearchRequestStruct request;
+  final int repeatMs;
+
+  AutomationRuleSpec(this.request, {this.repeatMs = 0});
+}
+
+// 自动化事件类型 (与 C 端 AutomationEventKind 一致)
+class AutomationEventKind {
+  static const int lost = 0;
+  static const int found = 1;
+  static const int repeat = 2;
+}
+
+class AutomationEvent {
+  final int kind;
+  final int rule; // 规则下标
+  final int templateId;
+  final int x;
+  final int y;
+  final double score;
+  final int frameId;
+  final int latencyNs; // 帧到达到评估完成
+
+  AutomationEvent({
+    required this.kind,
+    required this.rule,
+    required this.templateId,
+    required this.x,
+    required this.y,
+    required this.score,
+    required this.frameId,
+    required this.latencyNs,
+  });
+}
+
+base class BatchDebugStats extends Struct {
+  @Int32()
+  external int requestCount;
+  @Int32()
+  external int opencvRequests;
+  @Int32()
+  external int kernelRequests;
+  @Int32()
+  external int groupCount;
+  @Int32()
+  external int sharedRequests;
+  @Int32()
+  external int windowStatsPasses;
+  @Int32()
+  external int windowStatsSaved;
+  @Int32()
+  external int regionCount;
+  @Int64()
+  external int requestedPixels;
+  @Int64()
+  external int preparedPixels;
+}
+
+base class TemplateSource extends Struct {
+  @Int32()
+  external int kind;
+  @Int32()
+  external int width;
+  @Int32()
+  external int height;
+  @Int32()
+  external int stride;
+  external Pointer<Utf8> path;
+  external Pointer<Uint8> data;
+  @Int32()
+  external int length;
+}
+
+base class TemplatePackItem extends Struct {
+  @Int32()
+  external int templateId;
+  @Int32()
+  external int width;
+  @Int32()
+  external int height;
+  @Array(64)
+  external Array<Uint8> name;
+}
+
+base class TemplateSize extends Struct {
+  @Int32()
+  external int width;
+  @Int32()
+  external int height;
+}
+
+// 模板来源 (与 C 端 TemplateSourceKind 对应)
+class TemplateSourceSpec {
+  static const int kindPath = 0;
+  static const int kindEncoded = 1;
+  static const int kindRawBgra = 2;
+  static const int kindRawBgr = 3;
+
+  final int kind;
+  final String? path;
+  final Uint8List? data;
+  final int width;
+  final int height;
+  final int stride;
+
+  const TemplateSourceSpec._(
+    this.kind, {
+    this.path,
+    this.data,
+    this.width = 0,
+    this.height = 0,
+    this.stride = 0,
+  });
+
+  /// 图片文件路径
+  const TemplateSourceSpec.path(String path) : this._(kindPath, path: path);
+
+  /// 内存中的 PNG/JPG/BMP 编码数据
+  const TemplateSourceSpec.encoded(Uint8List data)
+    : this._(kindEncoded, data: data);
+
+  /// BGRA / BGR 原始像素
+  const TemplateSourceSpec.raw(
+    Uint8List data, {
+    required int width,
+    required int height,
+    int stride = 0,
+    bool bgra = true,
+  }) : this._(
+         bgra ? kindRawBgra : kindRawBgr,
+         data: data,
+         width: width,
+         height: height,
+         stride: stride,
+       );
+}
+
+// 批量加载结果
+class LoadedTemplate {
+  final int id;
+  final int width;
+  final int height;
+
+  LoadedTemplate({required this.id, required this.width, required this.height});
+
+  bool get ok => id > 0;
+}
+
+base class LatencySummary extends Struct {
+  @Int64()
+  external int count;
+  @Int64()
+  external int totalNs;
+  @Int64()
+  external int p50Ns;
+  @Int64()
+  external int p99Ns;
+  @Int64()
+  external int maxNs;
+}
+
+base class SearchStats extends Struct {
+  @Int64()
+  external int batches;
+  external LatencySummary decode;
+  external LatencySummary convert;
+  external LatencySummary match;
+}
+
+// 调试图片采样方式 (与 C 端 DebugSinkMode 一致，可按位组合)
+class DebugSinkMode {
+  static const int off = 0;
+  static const int everyN = 1;
+  static const int misses = 2;
+}
+
+base class RecorderStats extends Struct {
+  @Int64()
+  external int submitted;
+  @Int64()
+  external int written;
+  @Int64()
+  external int dropped;
+  @Int64()
+  external int keyframes;
+  @Int64()
+  external int bytesWritten;
+  @Int64()
+  external int rawBytes;
+  @Int64()
+  external int lastEncodeNs;
+  @Int64()
+  external int maxEncodeNs;
+  @Int32()
+  external int recording;
+  @Int32()
+  external int failed;
+}
+
+base class DebugSinkStats extends Struct {
+  @Int64()
+  external int sampled;
+  @Int64()
+  external int written;
+  @Int64()
+  external int dropped;
+  @Int64()
+  external int failed;
+}
+
+base class TemplateStats extends Struct {
+  @Int32()
+  external int templateId;
+  @Int32()
+  external int reserved;
+  @Int64()
+  external int calls;
+  @Int64()
+  external int hits;
+  @Int64()
+  external int totalNs;
+  @Int64()
+  external int maxNs;
+}
+
+// 扩展结果布局版本 (与 C 端 SEARCH_RESULT_EX_VERSION 一致)
+const int searchResultExVersion = 3;
+
+base class SearchResultEx extends Struct {
+  @Int32()
+  external int templateId;
+  @Int32()
+  external int x;
+  @Int32()
+  external int y;
+  @Int32()
+  external int method;
+  @Double()
+  external double score;
+  @Int64()
+  external int timeNs;
+  @Int64()
+  external int positions;
+  @Int64()
+  external int pixelsScanned;
+  @Int32()
+  external int flags;
+  @Int32()
+  external int reserved;
+}
+
+base class BatchHeader extends Struct {
+  @Int32()
+  external int version;
+  @Int32()
+  external int resultSize;
+  @Int32()
+  external int requestCount;
+  @Int32()
+  external int regionCount;
+  @Int64()
+  external int decodeNs;
+  @Int64()
+  external int convertNs;
+  @Int64()
+  external int matchNs;
+  @Int64()
+  external int totalNs;
+  @Int64()
+  external int deadlineUs;
+  @Int32()
+  external int skippedCount;
+  @Int32()
+  external int reserved;
+  external Pointer<Int32> priorities;
+}
+
+// 扩展结果 (纯 Dart)
+class SearchResultExData {
+  static const int flagNotRun = 1 << 0;
+  static const int flagCached = 1 << 1;
+  static const int flagPrefiltered = 1 << 2;
+  static const int flagSkippedDeadline = 1 << 3;
+  static const int flagTiled = 1 << 4;
+
+  final int templateId;
+  final int x;
+  final int y;
+  final double score;
+  final int method;
+  final int timeNs;
+  final int positions;
+  final int pixelsScanned;
+  final int flags;
+
+  SearchResultExData.from(SearchResultEx r)
+    : templateId = r.templateId,
+      x = r.x,
+      y = r.y,
+      score = r.score,
+      method = r.method,
+      timeNs = r.timeNs,
+      positions = r.positions,
+      pixelsScanned = r.pixelsScanned,
+      flags = r.flags;
+
+  bool get notRun => flags & flagNotRun != 0;
+  bool get cached => flags & flagCached != 0;
+  bool get prefiltered => flags & flagPrefiltered != 0;
+  bool get skippedDeadline => flags & flagSkippedDeadline != 0;
+  bool get tiled => flags & flagTiled != 0;
+}
+
+class BatchReport {
+  /// 0 成功, -2 图片无效, -3 参数无效, -4 版本不匹配
+  final int status;
+  final Map<String, int> header;
+  final List<SearchResultExData> results;
+
+  BatchReport({
+    required this.status,
+    required this.header,
+    required this.results,
+  });
+}
+
 base class SearchResultItem extends Struct {
   @Int32()
   external int templateId;
@@ -320,6 +2002,247 @@ base class SearchResultItem extends Struct {
   external double score;
 }
 
+// 在途的异步批次 (输入缓冲与结果缓冲在完成回调中释放)
+class _PendingBatch {
+  final NativeInputBuffer buffer;
+  final Pointer<SearchResultItem> results;
+  final int count;
+  final completer = Completer<List<SearchResultStruct>>();
+
+  _PendingBatch(this.buffer, this.results, this.count);
+}
+
+/// 原生缓冲池中的一块输入缓冲
+/// 独立的原生引擎实例
+///
+/// 拥有自己的模板表 (模板 ID 独立编号)、输入缓冲池与运行期统计；
+/// 同时处理多个游戏窗口时每个会话各用一个引擎，互不争用。
+/// [NativeImageSearch] 的其余方法都作用于默认引擎。
+class ImageSearchEngine {
+  final int handle;
+  bool _disposed = false;
+
+  ImageSearchEngine._(this.handle);
+
+  /// 创建引擎；数量达到上限 (64) 时返回 null
+  static ImageSearchEngine? create() {
+    final handle = NativeImageSearch()._engineCreate();
+    return handle > 0 ? ImageSearchEngine._(handle) : null;
+  }
+
+  bool get isDisposed => _disposed;
+
+  /// 加载模板，返回本引擎内的模板 ID (>0 成功)
+  int loadTemplate(String imagePath) {
+    _checkAlive();
+    return using((arena) {
+      return NativeImageSearch()._engineLoadTemplate(
+        handle,
+        imagePath.toNativeUtf8(allocator: arena),
+      );
+    });
+  }
+
+  void releaseTemplate(int id) {
+    _checkAlive();
+    NativeImageSearch()._engineReleaseTemplate(handle, id);
+  }
+
+  /// 与 [NativeImageSearch.findImagesBatch] 相同，使用本引擎的模板与缓冲池
+  List<SearchResultStruct> findImagesBatch(
+    Uint8List imageBytes,
+    List<SearchRequestStruct> requests, {
+    int width = 0,
+    int height = 0,
+  }) {
+    _checkAlive();
+    if (requests.isEmpty) return [];
+
+    final native = NativeImageSearch();
+    final count = requests.length;
+    final buffer = native._engineAcquireInputBuffer(
+      handle,
+      imageBytes.length,
+    );
+    if (buffer == nullptr) {
+      throw StateError('Failed to acquire input buffer');
+    }
+    final reqPtr = NativeImageSearch._allocRequests(requests);
+    final resPtr = calloc<SearchResultItem>(count);
+    try {
+      buffer.asTypedList(imageBytes.length).setAll(0, imageBytes);
+      native._engineFindImagesBatch(
+        handle,
+        buffer,
+        imageBytes.length,
+        width,
+        height,
+        width * 4,
+        reqPtr,
+        count,
+        resPtr,
+      );
+      return List.generate(count, (i) {
+        final item = resPtr[i];
+        return SearchResultStruct(
+          templateId: item.templateId,
+          x: item.x,
+          y: item.y,
+          score: item.score,
+        );
+      });
+    } finally {
+      calloc.free(reqPtr);
+      calloc.free(resPtr);
+      native._engineReleaseInputBuffer(handle, buffer);
+    }
+  }
+
+  /// 销毁引擎及其模板；进行中的原生调用会安全完成
+  void dispose() {
+    if (_disposed) return;
+    _disposed = true;
+    NativeImageSearch()._engineDestroy(handle);
+  }
+
+  void _checkAlive() {
+    if (_disposed) throw StateError('ImageSearchEngine already disposed');
+  }
+}
+
+class NativeInputBuffer {
+  final Pointer<Uint8> pointer;
+  final int size;
+  bool _released = false;
+
+  NativeInputBuffer._(this.pointer, this.size);
+
+  bool get isReleased => _released;
+
+  /// 直接映射原生内存的视图，写入即写入原生缓冲
+  Uint8List get bytes {
+    if (_released) throw StateError('Input buffer already released');
+    return pointer.asTypedList(size);
+  }
+
+  /// 归还到缓冲池
+  void release() {
+    if (_released) return;
+    _released = true;
+    NativeImageSearch()._releaseInputBuffer(pointer);
+  }
+}
+
+/// 编译好的查找计划
+/// 结果缓冲与帧缓冲在首次使用时分配，之后每帧复用
+class CompiledSearchPlan {
+  final int id;
+  final int requestCount;
+  final int width;
+  final int height;
+  Pointer<SearchResultItem> _results = nullptr;
+  Pointer<SearchResultEx> _extended = nullptr;
+  NativeInputBuffer? _frame;
+  bool _disposed = false;
+
+  CompiledSearchPlan._(this.id, this.requestCount, this.width, this.height);
+
+  /// 在一帧 BGRA 原始像素上执行计划
+  /// 返回 null 表示计划无效或正在其他线程执行
+  List<SearchResultStruct>? run(Uint8List bgra, {int stride = 0}) {
+    if (_disposed) throw StateError('Search plan already disposed');
+    final size = height * (stride > 0 ? stride : width * 4);
+    if (bgra.length < size) {
+      throw ArgumentError('Frame buffer too small: ${bgra.length} < $size');
+    }
+    final frame = _frame ??= NativeImageSearch().acquireInputBuffer(size);
+    if (frame == null || frame.size < size) {
+      throw StateError('Failed to acquire input buffer');
+    }
+    frame.bytes.setRange(0, size, bgra);
+    return runPointer(frame.pointer, stride: stride);
+  }
+
+  /// 在已位于原生内存中的 BGRA 像素上执行计划 (不复制)
+  List<SearchResultStruct>? runPointer(Pointer<Uint8> pixels, {int stride = 0}) {
+    if (_disposed) throw StateError('Search plan already disposed');
+    if (_results == nullptr) {
+      _results = calloc<SearchResultItem>(requestCount);
+    }
+    final rc = NativeImageSearch()._runSearchPlan(id, pixels, stride, _results);
+    if (rc != 0) return null;
+    return List.generate(requestCount, (i) {
+      final item = _results[i];
+      return SearchResultStruct(
+        templateId: item.templateId,
+        x: item.x,
+        y: item.y,
+        score: item.score,
+      );
+    });
+  }
+
+  /// 与 [runPointer] 相同，但返回逐请求的耗时与代价统计
+  /// [deadlineUs] > 0 时为本帧预算 (微秒)：按编译时的优先级执行，超出预算的非关键请求被跳过
+  /// ([SearchResultExData.skippedDeadline])，下一次执行优先
+  /// status: 0 成功, -1 计划无效, -2 正在其他线程执行, -3 参数无效, -4 版本不匹配
+  BatchReport runPointerEx(
+    Pointer<Uint8> pixels, {
+    int stride = 0,
+    int deadlineUs = 0,
+  }) {
+    if (_disposed) throw StateError('Search plan already disposed');
+    if (_extended == nullptr) {
+      _extended = calloc<SearchResultEx>(requestCount);
+    }
+    final headerPtr = calloc<BatchHeader>();
+    try {
+      headerPtr.ref.version = searchResultExVersion;
+      headerPtr.ref.resultSize = sizeOf<SearchResultEx>();
+      headerPtr.ref.deadlineUs = deadlineUs;
+      final status = NativeImageSearch()._runSearchPlanEx(
+        id,
+        pixels,
+        stride,
+        _extended,
+        headerPtr,
+      );
+      final h = headerPtr.ref;
+      return BatchReport(
+        status: status,
+        header: {
+          'requestCount': h.requestCount,
+          'regionCount': h.regionCount,
+          'convertNs': h.convertNs,
+          'matchNs': h.matchNs,
+          'totalNs': h.totalNs,
+          'skippedCount': h.skippedCount,
+        },
+        results: status == 0
+            ? List.generate(
+                requestCount,
+                (i) => SearchResultExData.from(_extended[i]),
+              )
+            : const [],
+      );
+    } finally {
+      calloc.free(headerPtr);
+    }
+  }
+
+  void dispose() {
+    if (_disposed) return;
+    _disposed = true;
+    NativeImageSearch()._releaseSearchPlan(id);
+    if (_results != nullptr) calloc.free(_results);
+    if (_extended != nullptr) calloc.free(_extended);
+    _frame?.release();
+    _results = nullptr;
+    _extended = nullptr;
+    _frame = null;
+  }
+}
+
 class ImageTemplate {
   final int id;
   final String path;
@@ -24,6 +24,16 @@ class LoadTemplateMessage extends WorkerMessage {
   LoadTemplateMessage(int id, this.path) : super(id);
 }
 
+class LoadTemplatesBulkMessage extends WorkerMessage {
+  final List<TemplateSourceSpec> sources;
+  LoadTemplatesBulkMessage(int id, this.sources) : super(id);
+}
+
+class LoadTemplatePackMessage extends WorkerMessage {
+  final String path;
+  LoadTemplatePackMessage(int id, this.path) : super(id);
+}
+
 class ReleaseTemplateMessage extends WorkerMessage {
   final int templateId;
   ReleaseTemplateMessage(int id, this.templateId) : super(id);
@@ -87,9 +97,21 @@ class ImageSearchWorker {
     final completer = Completer<List<SearchResultStruct>>();
     _completers[id] = completer;
 
+    // 追踪开启时记录 isolate 往返 (消息复制 + 排队 + 搜索 + 回传)
+    final native = NativeImageSearch();
+    final traced = native.traceEnabled;
+    final start = traced ? native.traceNowNs() : 0;
+
     _sendPort!.send(SearchRequestMessage(id, imageBytes, requests,
         width: width, height: height));
-    return completer.future;
+    if (!traced) return completer.future;
+    return completer.future.whenComplete(() {
+      native.traceRecord(
+        native.traceIntern('worker_round_trip'),
+        start,
+        native.traceNowNs() - start,
+      );
+    });
   }
 
   Future<int> loadTemplate(String path) async {
@@ -103,6 +125,30 @@ class ImageSearchWorker {
     return completer.future;
   }
 
+  Future<List<LoadedTemplate>> loadTemplatesBulk(
+    List<TemplateSourceSpec> sources,
+  ) async {
+    if (!_isReady) await _readyCompleter.future;
+
+    final id = _nextId++;
+    final completer = Completer<List<LoadedTemplate>>();
+    _completers[id] = completer;
+
+    _sendPort!.send(LoadTemplatesBulkMessage(id, sources));
+    return completer.future;
+  }
+
+  Future<Map<String, LoadedTemplate>?> loadTemplatePack(String path) async {
+    if (!_isReady) await _readyCompleter.future;
+
+    final id = _nextId++;
+    final completer = Completer<Map<String, LoadedTemplate>?>();
+    _completers[id] = completer;
+
+    _sendPort!.send(LoadTemplatePackMessage(id, path));
+    return completer.future;
+  }
+
   Future<void> releaseTemplate(int templateId) async {
     if (!_isReady) await _readyCompleter.future;
 
@@ -160,6 +206,20 @@ class ImageSearchWorker {
         } catch (e) {
           sendPort.send(WorkerResponse(message.id, null, error: e.toString()));
         }
+      } else if (message is LoadTemplatesBulkMessage) {
+        try {
+          final loaded = searcher.loadTemplatesBulk(message.sources);
+          sendPort.send(WorkerResponse(message.id, loaded));
+        } catch (e) {
+          sendPort.send(WorkerResponse(message.id, null, error: e.toString()));
+        }
+      } else if (message is LoadTemplatePackMessage) {
+        try {
+          final loaded = searcher.loadTemplatePack(message.path);
+          sendPort.send(WorkerResponse(message.id, loaded));
+        } catch (e) {
+          sendPort.send(WorkerResponse(message.id, null, error: e.toString()));
+        }
       } else if (message is ReleaseTemplateMessage) {
         try {
           searcher.releaseTemplate(message.templateId);
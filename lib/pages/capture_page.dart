@@ -90,28 +90,14 @@ class _CapturePageState extends State<CapturePage> {
 
   // Auto Task State
   bool _autoTaskEnabled = false;
-  Timer? _autoTaskTimer;
-  final Map<String, int> _taskTemplateIds = {};
-  final Map<int, Size> _taskTemplateSizes = {};
-  List<SearchResultStruct> _taskSearchResults = [];
-
-  // Auto Task Search ROI
-  int _searchRoiX = 0;
-  int _searchRoiY = 0;
-  int _searchRoiW = -1;
-  int _searchRoiH = -1;
+  // 当前场景的规则 (下标即事件中的 rule) 与正在命中的规则
+  List<ScenarioRuleData> _scenarioRules = [];
+  final Map<int, ScenarioMatch> _activeRuleResults = {};
+  List<ScenarioMatch> _taskSearchResults = [];
+  bool _actionInFlight = false;
 
   final ImageSearchWorker _imageWorker = ImageSearchWorker();
 
-  void updateSearchRoi(int x, int y, int w, int h) {
-    setState(() {
-      _searchRoiX = x;
-      _searchRoiY = y;
-      _searchRoiW = w;
-      _searchRoiH = h;
-    });
-  }
-
   @override
   void initState() {
     super.initState();
@@ -129,7 +115,7 @@ class _CapturePageState extends State<CapturePage> {
     _imageWorker.dispose();
     _autoTimer?.cancel();
     _checkAliveTimer?.cancel();
-    _autoTaskTimer?.cancel();
+    if (_autoTaskEnabled) NativeImageSearch().stopAutomation();
     _inputFocusNode.dispose();
     super.dispose();
   }
@@ -557,57 +543,39 @@ class _CapturePageState extends State<CapturePage> {
     }
     setState(() => _errorMessage = null);
 
-    final templates = ['juqing.png', 'tiaoguo.png', 'f.png'];
-    _taskTemplateIds.clear();
-    _taskTemplateSizes.clear();
-
+    // 模板、ROI、阈值、前置条件与动作都由场景文件描述，
+    // 在原生层编译为规则图，Runner 每收到一帧就评估一次，只有状态变化时才回调
+    final scenarioPath = _resolveResourcePath('scenario.json');
+    if (!File(scenarioPath).existsSync()) {
+      setState(
+        () => _errorMessage = '资源文件缺失: scenario.json\n路径: $scenarioPath',
+      );
+      return;
+    }
     try {
-      for (final name in templates) {
-        final path = _resolveResourcePath(name);
-        if (!File(path).existsSync()) {
-          throw '资源文件缺失: $name\n路径: $path';
-        }
-
-        final bytes = await File(path).readAsBytes();
-        final codec = await ui.instantiateImageCodec(bytes);
-        final frame = await codec.getNextFrame();
-        final size = Size(
-          frame.image.width.toDouble(),
-          frame.image.height.toDouble(),
-        );
-        frame.image.dispose();
-
-        final id = await _imageWorker.loadTemplate(path);
-        if (id <= 0) {
-          throw '加载模板失败: $name (ID: $id)';
-        }
-        _taskTemplateIds[name] = id;
-        _taskTemplateSizes[id] = size;
-      }
+      _scenarioRules = NativeImageSearch().startScenario(
+        scenarioPath,
+        _onAutomationEvent,
+      );
     } catch (e) {
-      await _stopAutoTask();
-      setState(() => _errorMessage = e.toString());
+      setState(() => _errorMessage = '加载场景失败: $e');
       return;
     }
-
-    if (!_autoEnabled) {
-      await _startAutoCapture();
-    }
+    _activeRuleResults.clear();
 
     setState(() {
       _autoTaskEnabled = true;
     });
 
-    _autoTaskTimer = Timer.periodic(const Duration(milliseconds: 1000), (
-      timer,
-    ) {
-      _autoTaskLoop();
-    });
+    if (!_autoEnabled) {
+      await _startAutoCapture();
+    }
   }
 
   Future<void> _stopAutoTask() async {
-    _autoTaskTimer?.cancel();
-    _autoTaskTimer = null;
+    NativeImageSearch().stopAutomation();
+    _activeRuleResults.clear();
+    _scenarioRules = [];
 
     try {
       await _channel.invokeMethod('closeOverlay');
@@ -615,134 +583,47 @@ class _CapturePageState extends State<CapturePage> {
       debugPrint('Close overlay error: $e');
     }
 
-    for (final id in _taskTemplateIds.values) {
-      await _imageWorker.releaseTemplate(id);
-    }
-    _taskTemplateIds.clear();
-    _taskTemplateSizes.clear();
-
     setState(() {
       _autoTaskEnabled = false;
       _taskSearchResults = [];
     });
   }
 
-  Future<void> _autoTaskLoop() async {
+  void _onAutomationEvent(AutomationEvent event) {
     if (!_autoTaskEnabled || _selectedProcess == null) return;
+    if (event.rule < 0 || event.rule >= _scenarioRules.length) return;
+    final rule = _scenarioRules[event.rule];
 
-    try {
-      final Uint8List? imageBytes = await _channel.invokeMethod<Uint8List>(
-        'getLastFrame',
+    if (event.kind == AutomationEventKind.lost) {
+      _activeRuleResults.remove(event.rule);
+    } else {
+      _activeRuleResults[event.rule] = ScenarioMatch(
+        rule,
+        event.x,
+        event.y,
+        event.score,
       );
+      // 前置条件已在原生层判定；出现时以及冷却后仍在时执行动作
+      if (rule.hasAction) _performAction(rule);
+    }
 
-      if (imageBytes == null || imageBytes.isEmpty) return;
-
-      final juqingId = _taskTemplateIds['juqing.png'];
-      final tiaoId = _taskTemplateIds['tiaoguo.png'];
-      final fId = _taskTemplateIds['f.png'];
-
-      if (juqingId == null) return;
-
-      final results = await _imageWorker.findImagesBatch(imageBytes, [
-        SearchRequestStruct(
-          juqingId,
-          threshold: 0.7,
-          roiX: _searchRoiX,
-          roiY: _searchRoiY,
-          roiW: _searchRoiW,
-          roiH: _searchRoiH,
-        ),
-      ]);
-
-      List<SearchResultStruct> currentResults = [];
-
-      // 检查是否找到剧情图片
-      bool foundJuqing = false;
-      for (final res in results) {
-        if (res.score >= 0.7) {
-          currentResults.add(res);
-          if (res.templateId == juqingId) {
-            foundJuqing = true;
-          }
-        }
-      }
-
-      if (foundJuqing) {
-        final subRequests = <SearchRequestStruct>[];
-        if (tiaoId != null) {
-          subRequests.add(
-            SearchRequestStruct(
-              tiaoId,
-              threshold: 0.5,
-              roiX: 900,
-              roiY: 1000,
-              roiW: 1100,
-              roiH: 1100,
-            ),
-          );
-        }
-        if (fId != null) {
-          subRequests.add(
-            SearchRequestStruct(
-              fId,
-              threshold: 0.7,
-              roiX: 1000,
-              roiY: 400,
-              roiW: 1500,
-              roiH: 1100,
-            ),
-          );
-        }
-
-        if (subRequests.isNotEmpty) {
-          final subResults = await _imageWorker.findImagesBatch(
-            imageBytes,
-            subRequests,
-          );
-
-          bool foundSub = false;
-          for (final res in subResults) {
-            if (res.score >= 0.7) {
-              currentResults.add(res);
-              foundSub = true;
-            }
-          }
-
-          if (foundSub) {
-            _inputController.sendKeyEvent(_selectedProcess!.pid, 0x46, true);
-            await Future.delayed(const Duration(milliseconds: 50));
-            _inputController.sendKeyEvent(_selectedProcess!.pid, 0x46, false);
-          }
-        }
-      }
-
-      // Update Overlay
-      List<Map<String, dynamic>> overlayRects = [];
-      for (final res in currentResults) {
-        final size = _taskTemplateSizes[res.templateId];
-        if (size != null) {
-          overlayRects.add({
-            'x': res.x,
-            'y': res.y,
-            'width': size.width.toInt(),
-            'height': size.height.toInt(),
-          });
-        }
-      }
-
-      // try {
-      //   await _channel.invokeMethod('updateOverlay', {'rects': overlayRects});
-      // } catch (e) {
-      //   debugPrint('Update overlay error: $e');
-      // }
+    if (mounted) {
+      setState(() {
+        _taskSearchResults = _activeRuleResults.values.toList();
+      });
+    }
+  }
 
-      if (mounted) {
-        setState(() {
-          _taskSearchResults = currentResults;
-        });
-      }
-    } catch (e) {
-      debugPrint('Auto task error: $e');
+  Future<void> _performAction(ScenarioRuleData rule) async {
+    final process = _selectedProcess;
+    if (process == null || _actionInFlight) return;
+    _actionInFlight = true;
+    try {
+      _inputController.sendKeyEvent(process.pid, rule.actionKey, true);
+      await Future.delayed(Duration(milliseconds: rule.actionHoldMs));
+      _inputController.sendKeyEvent(process.pid, rule.actionKey, false);
+    } finally {
+      _actionInFlight = false;
     }
   }
 
@@ -939,11 +820,7 @@ class _CapturePageState extends State<CapturePage> {
             Texture(textureId: _textureId!),
             if (_taskSearchResults.isNotEmpty)
               CustomPaint(
-                painter: SearchResultPainter(
-                  _taskSearchResults,
-                  _taskTemplateSizes,
-                  _taskTemplateIds,
-                ),
+                painter: SearchResultPainter(_taskSearchResults),
               ),
             if (!hasTextureSize) loadingOverlay,
           ],
@@ -975,11 +852,7 @@ class _CapturePageState extends State<CapturePage> {
           if (_taskSearchResults.isNotEmpty)
             Positioned.fill(
               child: CustomPaint(
-                painter: SearchResultPainter(
-                  _taskSearchResults,
-                  _taskTemplateSizes,
-                  _taskTemplateIds,
-                ),
+                painter: SearchResultPainter(_taskSearchResults),
               ),
             ),
         ],
@@ -1294,12 +1167,20 @@ class _CapturePageState extends State<CapturePage> {
   }
 }
 
+/// 场景规则的一次命中 (左上角坐标)
+class ScenarioMatch {
+  final ScenarioRuleData rule;
+  final int x;
+  final int y;
+  final double score;
+
+  ScenarioMatch(this.rule, this.x, this.y, this.score);
+}
+
 class SearchResultPainter extends CustomPainter {
-  final List<SearchResultStruct> results;
-  final Map<int, Size> templateSizes;
-  final Map<String, int> templateIds;
+  final List<ScenarioMatch> results;
 
-  SearchResultPainter(this.results, this.templateSizes, this.templateIds);
+  SearchResultPainter(this.results);
 
   @override
   void paint(Canvas canvas, Size size) {
@@ -1308,26 +1189,21 @@ class SearchResultPainter extends CustomPainter {
       ..strokeWidth = 3.0;
 
     for (final res in results) {
-      if (res.templateId == templateIds['juqing.png']) {
-        paint.color = Colors.green;
-      } else {
-        paint.color = Colors.red;
-      }
-
-      final templateSize = templateSizes[res.templateId] ?? const Size(50, 50);
+      // 带动作的规则 (按钮) 标红，仅作为条件的规则 (界面状态) 标绿
+      paint.color = res.rule.hasAction ? Colors.red : Colors.green;
 
       canvas.drawRect(
         Rect.fromLTWH(
           res.x.toDouble(),
           res.y.toDouble(),
-          templateSize.width,
-          templateSize.height,
+          res.rule.templateWidth.toDouble(),
+          res.rule.templateHeight.toDouble(),
         ),
         paint,
       );
 
       final textSpan = TextSpan(
-        text: res.templateId == templateIds['juqing.png'] ? '剧情' : '交互',
+        text: res.rule.label,
         style: TextStyle(
           color: paint.color,
           fontSize: 14,
@@ -0,0 +1,373 @@
+#include "automation.h"
+#include "trace.h"
+
+#include <algorithm>
+
+// 命中率滑动平均的权重，以及条件顺序的调整间隔 (帧)
+static const double kHitRateAlpha = 1.0 / 32;
+static const int64_t kReorderInterval = 32;
+// 缓存的计划数上限 (不同的规则集合)，超出时全部丢弃重新编译
+static const size_t kMaxCachedPlans = 64;
+// 调度: 未命中时间隔从 16 ms 开始加倍；CPU 用量按 0.5 秒窗口统计，每个窗口调整一次预算倍数
+static const int64_t kBackoffBaseNs = 16 * 1000000LL;
+static const int64_t kBudgetWindowNs = 500 * 1000000LL;
+static const double kBudgetStep = 1.25;
+static const double kMaxBudgetScale = 64;
+
+Automation::Automation(const AutomationRule* rules, const std::shared_ptr<const TemplateEntry>* entries, int count,
+                       std::shared_ptr<SearchStatsRegistry> recorder, EventSink sink, const AutomationGraph& graph)
+    : rules_(rules, rules + count),
+      entries_(entries, entries + count),
+      recorder_(std::move(recorder)),
+      sink_(std::move(sink)),
+      results_(count),
+      states_(count),
+      decisions_(count, kUndecided),
+      carried_(count, 0),
+      pipeline_([this](const FramePipeline::PreparedFrame& frame) {
+          Evaluate(frame.image, frame.arrivalNs, frame.sceneChange);
+      }),
+      ruleStats_(count) {
+    stats_.governorScale = 1;
+    requests_.reserve(count);
+    for (const AutomationRule& rule : rules_) {
+        requests_.push_back(rule.request);
+    }
+    for (int i = 0; i < count; i++) {
+        if (i < static_cast<int>(graph.probabilities.size())) {
+            states_[i].hitRate = graph.probabilities[i];
+        }
+        if (i >= static_cast<int>(graph.conditions.size())) continue;
+        for (const int condition : graph.conditions[i]) {
+            if (condition < 0 || condition >= count || condition == i) continue;
+            states_[i].conditions.push_back(condition);
+            states_[condition].target = false;
+        }
+    }
+}
+
+Automation::~Automation() {
+    Stop();
+}
+
+void Automation::Emit(int kind, int rule, const SearchResultItem& result, int64_t frameId, int64_t latencyNs) {
+    AutomationEvent event = {};
+    event.kind = kind;
+    event.rule = rule;
+    event.templateId = result.templateId;
+    event.x = result.x;
+    event.y = result.y;
+    event.score = result.score;
+    event.frameId = frameId;
+    event.latencyNs = latencyNs;
+    {
+        std::lock_guard<std::mutex> lock(statsMutex_);
+        stats_.events++;
+    }
+    if (sink_ && !stopped_.load(std::memory_order_acquire)) {
+        sink_(event);
+    }
+}
+
+void Automation::RecordFrame(int64_t latencyNs, int evaluated, int skipped, int deferred) {
+    std::lock_guard<std::mutex> lock(statsMutex_);
+    stats_.framesEvaluated++;
+    stats_.rulesEvaluated += evaluated;
+    stats_.rulesSkipped += skipped;
+    stats_.rulesDeferred += deferred;
+    for (size_t i = 0; i < ruleStats_.size(); i++) {
+        AutomationRuleStats& rule = ruleStats_[i];
+        if (!carried_[i] && (decisions_[i] == kHit || decisions_[i] == kMiss)) {
+            rule.evaluations++;
+            if (decisions_[i] == kHit) rule.hits++;
+        }
+        rule.hitRate = states_[i].hitRate;
+        rule.intervalMs = static_cast<int>(states_[i].intervalNs / 1000000);
+    }
+    stats_.lastLatencyNs = latencyNs;
+    stats_.maxLatencyNs = std::max<long long>(stats_.maxLatencyNs, latencyNs);
+    latencies_[latencyCount_ % kLatencyWindow] = latencyNs;
+    latencyCount_++;
+}
+
+// 估算单条规则的匹配代价: ROI 内候选位置数 x 模板面积 (与直接相关的乘加次数成正比)
+void Automation::UpdateCosts() {
+    for (size_t i = 0; i < rules_.size(); i++) {
+        const SearchRequest& request = requests_[i];
+        RuleState& state = states_[i];
+        if (!entries_[i]) {
+            state.cost = 0; // 模板不存在: 必然未命中，作为条件时最先判定
+            continue;
+        }
+        int x = 0;
+        int y = 0;
+        int w = planWidth_;
+        int h = planHeight_;
+        if (request.roiW > 0 && request.roiH > 0) {
+            x = std::max(0, request.roiX);
+            y = std::max(0, request.roiY);
+            w = std::min(request.roiX + request.roiW, planWidth_) - x;
+            h = std::min(request.roiY + request.roiH, planHeight_) - y;
+        }
+        const int tw = entries_[i]->image.cols;
+        const int th = entries_[i]->image.rows;
+        const double positions = static_cast<double>(std::max(0, w - tw + 1)) * std::max(0, h - th + 1);
+        state.cost = positions * tw * th;
+    }
+}
+
+// 前置条件按 代价 / 未命中概率 升序: 便宜且最可能不满足的条件先判定，短路收益最大
+void Automation::OrderConditions() {
+    for (RuleState& state : states_) {
+        std::stable_sort(state.conditions.begin(), state.conditions.end(), [this](int a, int b) {
+            const double keyA = states_[a].cost / std::max(1.0 - states_[a].hitRate, 0.01);
+            const double keyB = states_[b].cost / std::max(1.0 - states_[b].hitRate, 0.01);
+            return keyA < keyB;
+        });
+    }
+}
+
+// 判定规则所需的下一步: 返回需要匹配的规则下标，或 -1 表示已有结论 (命中 / 未命中 / 跳过)
+int Automation::Resolve(int rule) {
+    if (decisions_[rule] != kUndecided) return -1;
+    for (const int condition : states_[rule].conditions) {
+        if (decisions_[condition] == kUndecided) {
+            const int next = Resolve(condition);
+            if (next >= 0) return next;
+        }
+        if (decisions_[condition] != kHit) {
+            decisions_[rule] = kSkipped; // 短路: 前置条件未满足
+            return -1;
+        }
+    }
+    if (!IsDue(rule)) {
+        // 调度: 未到期，沿用上次结论
+        decisions_[rule] = states_[rule].active ? kHit : kMiss;
+        carried_[rule] = 1;
+        return -1;
+    }
+    return rule;
+}
+
+bool Automation::IsDue(int rule) const {
+    return !governor_.enabled || sceneChanged_ || frameNs_ >= states_[rule].nextDueNs;
+}
+
+// 命中后回到最小间隔，未命中时加倍直到最大间隔；CPU 超出预算时再整体放大
+void Automation::Schedule(int rule, bool hit) {
+    RuleState& state = states_[rule];
+    const int64_t minNs = static_cast<int64_t>(std::max(0, governor_.minIntervalMs)) * 1000000;
+    const int64_t maxNs = std::max(minNs, static_cast<int64_t>(governor_.maxIntervalMs) * 1000000);
+    if (hit) {
+        state.intervalNs = minNs;
+    } else {
+        state.intervalNs = std::min(std::max(state.intervalNs * 2, std::max(kBackoffBaseNs, minNs)), maxNs);
+    }
+    int64_t delayNs = state.intervalNs;
+    if (budgetScale_ > 1) {
+        delayNs = static_cast<int64_t>(std::max(delayNs, kBackoffBaseNs) * budgetScale_);
+    }
+    state.nextDueNs = frameNs_ + delayNs;
+}
+
+// 累计评估耗时；每个窗口结束时计算忙碌比例、调整预算倍数与每条规则的实际频率
+void Automation::UpdateBudget(int64_t startNs, int64_t endNs) {
+    if (windowStartNs_ == 0) windowStartNs_ = startNs;
+    windowBusyNs_ += endNs - startNs;
+    const int64_t elapsedNs = endNs - windowStartNs_;
+    if (elapsedNs < kBudgetWindowNs) return;
+
+    const double usage = static_cast<double>(windowBusyNs_) / elapsedNs;
+    if (governor_.enabled && governor_.cpuBudget > 0) {
+        if (usage > governor_.cpuBudget) {
+            budgetScale_ = std::min(budgetScale_ * kBudgetStep, kMaxBudgetScale);
+        } else if (usage < governor_.cpuBudget * 0.5) {
+            budgetScale_ = std::max(budgetScale_ / kBudgetStep, 1.0);
+        }
+    } else {
+        budgetScale_ = 1;
+    }
+    {
+        std::lock_guard<std::mutex> lock(statsMutex_);
+        stats_.cpuUsage = usage;
+        stats_.governorScale = budgetScale_;
+        for (size_t i = 0; i < states_.size(); i++) {
+            ruleStats_[i].rateHz = states_[i].windowEvaluations * 1e9 / elapsedNs;
+        }
+    }
+    for (RuleState& state : states_) {
+        state.windowEvaluations = 0;
+    }
+    windowStartNs_ = endNs;
+    windowBusyNs_ = 0;
+}
+
+Automation::RulePlan& Automation::PlanFor(uint64_t mask, const cv::Mat& frame) {
+    auto it = plans_.find(mask);
+    if (it != plans_.end()) return *it->second;
+
+    if (plans_.size() >= kMaxCachedPlans) plans_.clear();
+    std::unique_ptr<RulePlan> plan(new RulePlan());
+    std::vector<SearchRequest> requests;
+    std::vector<std::shared_ptr<const TemplateEntry>> entries;
+    std::vector<int> priorities;
+    for (int i = 0; i < static_cast<int>(rules_.size()); i++) {
+        if (!(mask & (uint64_t(1) << i))) continue;
+        plan->rules.push_back(i);
+        requests.push_back(requests_[i]);
+        entries.push_back(entries_[i]);
+        priorities.push_back(rules_[i].priority);
+    }
+    const int count = static_cast<int>(plan->rules.size());
+    plan->results.resize(count);
+    plan->plan.Compile(requests.data(), entries.data(), count, frame.cols, frame.rows, frame.channels(), recorder_,
+                       priorities.data());
+    return *plans_.emplace(mask, std::move(plan)).first->second;
+}
+
+void Automation::Evaluate(const cv::Mat& frame, int64_t arrivalNs, double sceneChange) {
+    TRACE_SCOPE("automation_frame");
+    const int count = static_cast<int>(rules_.size());
+    if (count == 0 || count > kMaxRules || frame.empty()) return;
+    frameNs_ = StatsNowNs();
+    {
+        std::lock_guard<std::mutex> lock(governorMutex_);
+        governor_ = governorConfig_;
+    }
+    const int64_t budgetNs = frameBudgetNs_.load(std::memory_order_relaxed);
+    const int64_t deadlineNs = budgetNs > 0 ? frameNs_ + budgetNs : 0;
+
+    // 帧尺寸或通道变化时丢弃已编译的计划 (通常只在开始与窗口缩放时发生)
+    if (frame.cols != planWidth_ || frame.rows != planHeight_ || frame.channels() != planChannels_) {
+        plans_.clear();
+        planWidth_ = frame.cols;
+        planHeight_ = frame.rows;
+        planChannels_ = frame.channels();
+        UpdateCosts();
+        OrderConditions();
+    } else if (nextFrameId_ % kReorderInterval == 0) {
+        OrderConditions();
+    }
+
+    // 画面明显变化时所有规则立即到期，并从最小间隔重新开始退避
+    sceneChanged_ = false;
+    if (governor_.enabled && governor_.sceneChangeThreshold > 0 &&
+        (sceneChange >= 0 ? sceneChange : scene_.Update(frame)) >= governor_.sceneChangeThreshold) {
+        sceneChanged_ = true;
+        for (RuleState& state : states_) {
+            state.intervalNs = 0;
+        }
+    }
+
+    // 逐轮推进: 每轮收集所有目标当前需要匹配的规则，合并为一个计划执行
+    std::fill(decisions_.begin(), decisions_.end(), static_cast<uint8_t>(kUndecided));
+    std::fill(carried_.begin(), carried_.end(), static_cast<uint8_t>(0));
+    int evaluated = 0;
+    for (;;) {
+        uint64_t needed = 0;
+        for (int i = 0; i < count; i++) {
+            if (!states_[i].target) continue;
+            const int next = Resolve(i);
+            if (next >= 0) needed |= uint64_t(1) << next;
+        }
+        if (needed == 0) break;
+
+        RulePlan& plan = PlanFor(needed, frame);
+        plan.plan.Run(frame, plan.results.data(), nullptr, nullptr, nullptr, deadlineNs);
+        for (size_t k = 0; k < plan.rules.size(); k++) {
+            const int rule = plan.rules[k];
+            if (plan.plan.Skipped(static_cast<int>(k))) {
+                // 超出单帧预算: 沿用上次结论，不重新排期 (仍然到期)，计划记住跳过以便下一帧优先
+                decisions_[rule] = states_[rule].active ? kHit : kMiss;
+                carried_[rule] = 1;
+                continue;
+            }
+            const bool hit = plan.results[k].x >= 0;
+            results_[rule] = plan.results[k];
+            decisions_[rule] = hit ? kHit : kMiss;
+            states_[rule].hitRate += ((hit ? 1.0 : 0.0) - states_[rule].hitRate) * kHitRateAlpha;
+            states_[rule].windowEvaluations++;
+            Schedule(rule, hit);
+        }
+        evaluated += static_cast<int>(plan.rules.size()) - plan.plan.SkippedCount();
+    }
+
+    const int64_t frameId = nextFrameId_++;
+    const int64_t now = StatsNowNs();
+    const int64_t latencyNs = now - (arrivalNs > 0 ? arrivalNs : now);
+    int deferred = 0;
+    for (int i = 0; i < count; i++) {
+        if (carried_[i]) {
+            deferred++; // 结论与状态未变，不产生事件
+            continue;
+        }
+        if (decisions_[i] != kHit && decisions_[i] != kMiss) {
+            // 跳过的规则视为未命中；前置条件恢复后立即评估
+            results_[i].templateId = requests_[i].templateId;
+            results_[i].x = -1;
+            results_[i].y = -1;
+            results_[i].score = 0;
+            states_[i].nextDueNs = 0;
+        }
+        const SearchResultItem& result = results_[i];
+        const bool found = decisions_[i] == kHit;
+        RuleState& state = states_[i];
+        if (found && !state.active) {
+            state.active = true;
+            state.lastEventNs = now;
+            Emit(AUTOMATION_EVENT_FOUND, i, result, frameId, latencyNs);
+        } else if (found && rules_[i].repeatMs > 0 &&
+                   now - state.lastEventNs >= static_cast<int64_t>(rules_[i].repeatMs) * 1000000) {
+            state.lastEventNs = now;
+            Emit(AUTOMATION_EVENT_REPEAT, i, result, frameId, latencyNs);
+        } else if (!found && state.active) {
+            state.active = false;
+            state.lastEventNs = now;
+            Emit(AUTOMATION_EVENT_LOST, i, result, frameId, latencyNs);
+        }
+    }
+    RecordFrame(latencyNs, evaluated, count - evaluated - deferred, deferred);
+    UpdateBudget(frameNs_, StatsNowNs());
+}
+
+void Automation::Start() {
+    if (stopped_.load()) return;
+    pipeline_.Start();
+}
+
+bool Automation::Submit(const uint8_t* pixels, int width, int height, int stride, int64_t arrivalNs) {
+    return pipeline_.Submit(pixels, width, height, stride, arrivalNs);
+}
+
+void Automation::Stop() {
+    stopped_.store(true, std::memory_order_release);
+    pipeline_.Stop();
+}
+
+void Automation::SetGovernor(const AutomationGovernorConfig& config) {
+    std::lock_guard<std::mutex> lock(governorMutex_);
+    governorConfig_ = config;
+}
+
+int Automation::GetRuleStats(AutomationRuleStats* out, int capacity) const {
+    std::lock_guard<std::mutex> lock(statsMutex_);
+    const int count = static_cast<int>(ruleStats_.size());
+    for (int i = 0; i < std::min(count, capacity); i++) {
+        out[i] = ruleStats_[i];
+    }
+    return count;
+}
+
+void Automation::GetStats(AutomationStats* out) const {
+    const FramePipeline::Stats pipeline = pipeline_.GetStats();
+    std::lock_guard<std::mutex> lock(statsMutex_);
+    *out = stats_;
+    out->framesSubmitted = pipeline.submitted;
+    out->framesDropped = pipeline.droppedCapture + pipeline.droppedPrepared;
+    const int n = std::min(latencyCount_, kLatencyWindow);
+    if (n == 0) return;
+    std::vector<int64_t> window(latencies_, latencies_ + n);
+    std::sort(window.begin(), window.end());
+    out->p50LatencyNs = window[(n - 1) / 2];
+    out->p99LatencyNs = window[std::min(n - 1, static_cast<int>(n * 0.99))];
+}
@@ -0,0 +1,175 @@
+#ifndef AUTOMATION_H
+#define AUTOMATION_H
+
+#include "frame_pipeline.h"
+#include "image_search.h"
+#include "search_plan.h"
+#include "search_stats.h"
+#include "template_entry.h"
+
+#include <opencv2/core.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+// 规则之间的依赖 (场景文件中的 when 条件)
+struct AutomationGraph {
+    std::vector<std::vector<int>> conditions; // conditions[i]: 评估规则 i 前必须全部命中的规则，为空表示无依赖
+    std::vector<double> probabilities;        // 初始命中率估计，为空时取 0.5
+};
+
+// 帧驱动的自动化规则评估
+//
+// 每条规则是一个查找请求；每来一帧就把全部规则作为一个编译好的计划执行一遍，
+// 规则状态变化 (出现 / 消失) 以及持续出现时按 repeatMs 重复时产生事件。
+// 只有事件离开原生层，调用方 (Dart) 不再拉取整帧。
+//
+// 规则可以依赖其他规则 (AutomationGraph)，构成一张无环图:
+//   - 不被任何规则依赖的规则是目标，每帧都要判定；被依赖的规则只在需要时评估
+//   - 目标的前置条件按 代价 / (1 - 命中率) 从小到大逐个判定，遇到未命中即短路，
+//     其余条件与目标本身都不再匹配 (计为跳过)；代价为 ROI 内候选位置数 x 模板面积
+//   - 同一轮中所有待评估的规则合并为一个查找计划执行，共享 ROI 转换与窗口统计；
+//     计划按规则集合缓存，帧尺寸不变时不再重新编译
+//   - 命中率按实际结果滑动平均，条件顺序随之调整
+// 被跳过的规则视为未命中 (此前命中则上报 LOST)。
+//
+// 自适应调度 (AutomationGovernorConfig，默认关闭) 在此基础上按规则决定本帧是否需要匹配:
+//   - 刚命中的规则按 minIntervalMs 采样，连续未命中时间隔指数增长到 maxIntervalMs
+//   - 画面变化超过阈值时全部规则立即到期
+//   - 评估线程的忙碌比例超过 CPU 预算时整体放大间隔
+// 未到期的规则沿用上次的结论 (命中 / 未命中) 参与条件判定，不产生事件 (计为延后)。
+//
+// 设置单帧预算 (SetFrameBudget) 时每轮计划按规则优先级 (AutomationRule::priority) 带截止时间执行:
+// 预算耗尽后其余非关键规则同样沿用上次结论 (计为延后) 且保持到期，
+// 跳过记录保存在按规则集合缓存的计划中，下一帧这些规则优先评估。
+//
+// Evaluate 同步评估一帧，不依赖线程与平台 API，可在 Linux 上对录制的帧回放；
+// Submit 用于实时截图: 帧经 FramePipeline 在准备线程上转换为 BGR 并完成画面变化采样，
+// 匹配线程评估时下一帧已在准备；任何一级跟不上时丢弃最旧的帧 (计为丢弃)。
+class Automation {
+public:
+    typedef std::function<void(const AutomationEvent&)> EventSink;
+
+    static constexpr int kMaxRules = 64;
+
+    // rules / entries 一一对应；entries 为空表示模板不存在 (该规则永远不会触发)
+    // count 不超过 kMaxRules；graph 为空表示规则相互独立，每帧全部评估
+    Automation(const AutomationRule* rules, const std::shared_ptr<const TemplateEntry>* entries, int count,
+               std::shared_ptr<SearchStatsRegistry> recorder, EventSink sink,
+               const AutomationGraph& graph = AutomationGraph());
+    ~Automation();
+
+    Automation(const Automation&) = delete;
+    Automation& operator=(const Automation&) = delete;
+
+    // 同步评估一帧 BGRA (8UC4) 或 BGR (8UC3)
+    // arrivalNs: 帧到达时间 (StatsNowNs 时基)，用于计算反应延迟
+    // sceneChange: 已算好的画面变化 (SceneSampler)，为负时按需自行采样
+    void Evaluate(const cv::Mat& frame, int64_t arrivalNs, double sceneChange = -1);
+
+    // 启动流水线线程
+    void Start();
+
+    // 复制一帧 BGRA 交给流水线；只能在一个线程上调用 (截图回调)。未启动或已停止时返回 false
+    bool Submit(const uint8_t* pixels, int width, int height, int stride, int64_t arrivalNs);
+
+    // 停止并等待流水线线程退出；返回后不会再产生事件
+    // 可在事件回调内调用 (OnPipelineThread 为 true): 此时匹配线程仍在本对象的 Evaluate 中，
+    // 调用方须在其他线程上再次调用 Stop 后才能释放本对象
+    void Stop();
+
+    // 当前线程是否为流水线的匹配线程 (即在 Submit 触发的事件回调内)
+    bool OnPipelineThread() const { return pipeline_.InConsumer(); }
+
+    // 更新调度参数，下一帧生效；可在任意线程调用
+    void SetGovernor(const AutomationGovernorConfig& config);
+
+    // 单帧评估预算 (纳秒，从 Evaluate 开始计)，0 表示不限；下一帧生效，可在任意线程调用
+    void SetFrameBudget(int64_t budgetNs) { frameBudgetNs_.store(budgetNs, std::memory_order_relaxed); }
+
+    void GetStats(AutomationStats* out) const;
+
+    // 写入 min(规则数, capacity) 条规则统计，返回规则数
+    int GetRuleStats(AutomationRuleStats* out, int capacity) const;
+
+private:
+    enum Decision : uint8_t { kUndecided, kHit, kMiss, kSkipped };
+
+    struct RuleState {
+        bool active = false;
+        bool target = true;          // 不被其他规则依赖
+        int64_t lastEventNs = 0;
+        std::vector<int> conditions; // 按判定顺序排列
+        double hitRate = 0.5;
+        double cost = 0;
+        // 调度
+        int64_t intervalNs = 0;      // 未计入 CPU 预算倍数
+        int64_t nextDueNs = 0;       // 0 表示下一次需要时立即评估
+        int windowEvaluations = 0;   // 当前统计窗口内的匹配次数
+    };
+
+    // 一组同时评估的规则编译出的计划
+    struct RulePlan {
+        SearchPlan plan;
+        std::vector<int> rules;
+        std::vector<SearchResultItem> results;
+    };
+
+    int Resolve(int rule);
+    bool IsDue(int rule) const;
+    void Schedule(int rule, bool hit);
+    void UpdateBudget(int64_t startNs, int64_t endNs);
+    RulePlan& PlanFor(uint64_t mask, const cv::Mat& frame);
+    void UpdateCosts();
+    void OrderConditions();
+    void Emit(int kind, int rule, const SearchResultItem& result, int64_t frameId, int64_t latencyNs);
+    void RecordFrame(int64_t latencyNs, int evaluated, int skipped, int deferred);
+
+    std::vector<AutomationRule> rules_;
+    std::vector<SearchRequest> requests_;
+    std::vector<std::shared_ptr<const TemplateEntry>> entries_;
+    std::shared_ptr<SearchStatsRegistry> recorder_;
+    EventSink sink_;
+
+    // 评估状态 (Evaluate 只在一个线程上调用)
+    std::unordered_map<uint64_t, std::unique_ptr<RulePlan>> plans_; // 键为规则集合的位掩码
+    int planWidth_ = 0;
+    int planHeight_ = 0;
+    int planChannels_ = 0;
+    std::vector<SearchResultItem> results_;
+    std::vector<RuleState> states_;
+    std::vector<uint8_t> decisions_; // 当前帧每条规则的 Decision
+    int64_t nextFrameId_ = 1;
+
+    // 调度状态 (同样只在评估线程上访问)；配置由 SetGovernor 写入，每帧开始时复制
+    mutable std::mutex governorMutex_;
+    AutomationGovernorConfig governorConfig_ = {};
+    AutomationGovernorConfig governor_ = {};   // 本帧使用的副本
+    std::atomic<int64_t> frameBudgetNs_{0};
+    int64_t frameNs_ = 0;                      // 本帧开始时间
+    bool sceneChanged_ = false;
+    std::vector<uint8_t> carried_;             // 本帧沿用上次结论的规则
+    SceneSampler scene_;                       // 同步评估 (未经流水线) 时使用
+    double budgetScale_ = 1;
+    int64_t windowStartNs_ = 0;
+    int64_t windowBusyNs_ = 0;
+
+    // 实时截图流水线 (Start 后运行)
+    FramePipeline pipeline_;
+    std::atomic<bool> stopped_{false};
+
+    // 统计
+    mutable std::mutex statsMutex_;
+    AutomationStats stats_ = {};
+    static constexpr int kLatencyWindow = 256;
+    int64_t latencies_[kLatencyWindow] = {};
+    int latencyCount_ = 0;
+    std::vector<AutomationRuleStats> ruleStats_;
+};
+
+#endif // AUTOMATION_H
@@ -0,0 +1,94 @@
+#include "batch_planner.h"
+
+#include <algorithm>
+
+static PlanRect Intersect(const PlanRect& a, const PlanRect& b) {
+    PlanRect r;
+    r.x = std::max(a.x, b.x);
+    r.y = std::max(a.y, b.y);
+    r.width = std::min(a.x + a.width, b.x + b.width) - r.x;
+    r.height = std::min(a.y + a.height, b.y + b.height) - r.y;
+    return r;
+}
+
+static PlanRect Bounding(const PlanRect& a, const PlanRect& b) {
+    PlanRect r;
+    r.x = std::min(a.x, b.x);
+    r.y = std::min(a.y, b.y);
+    r.width = std::max(a.x + a.width, b.x + b.width) - r.x;
+    r.height = std::max(a.y + a.height, b.y + b.height) - r.y;
+    return r;
+}
+
+static bool Contains(const PlanRect& outer, const PlanRect& inner) {
+    return inner.x >= outer.x && inner.y >= outer.y &&
+           inner.x + inner.width <= outer.x + outer.width &&
+           inner.y + inner.height <= outer.y + outer.height;
+}
+
+// 判断两个区域是否值得合并
+static bool ShouldMerge(const PlanRect& a, const PlanRect& b) {
+    const PlanRect inter = Intersect(a, b);
+    if (inter.Empty()) {
+        return false;
+    }
+    const double unionArea = static_cast<double>(a.Area() + b.Area() - inter.Area());
+    return static_cast<double>(Bounding(a, b).Area()) <= unionArea * kRegionMergeSlack;
+}
+
+void PlanBatch(const PlanRect* areas, int count, BatchPlan* plan) {
+    plan->regions.clear();
+    plan->requests.clear();
+    plan->requestedPixels = 0;
+    plan->preparedPixels = 0;
+
+    for (int i = 0; i < count; i++) {
+        if (areas[i].Empty()) continue;
+        plan->regions.push_back(areas[i]);
+        plan->requestedPixels += areas[i].Area();
+    }
+
+    // 反复合并直到稳定；一批请求通常只有个位数到几十个，O(n^2) 足够
+    bool merged = true;
+    while (merged) {
+        merged = false;
+        for (size_t a = 0; a < plan->regions.size() && !merged; a++) {
+            for (size_t b = a + 1; b < plan->regions.size(); b++) {
+                if (ShouldMerge(plan->regions[a], plan->regions[b])) {
+                    plan->regions[a] = Bounding(plan->regions[a], plan->regions[b]);
+                    plan->regions.erase(plan->regions.begin() + b);
+                    merged = true;
+                    break;
+                }
+            }
+        }
+    }
+
+    std::sort(plan->regions.begin(), plan->regions.end(), [](const PlanRect& a, const PlanRect& b) {
+        return a.y != b.y ? a.y < b.y : a.x < b.x;
+    });
+    for (const PlanRect& region : plan->regions) {
+        plan->preparedPixels += region.Area();
+    }
+
+    // 每个请求归入包含它的第一个区域 (合并保证至少有一个区域完整包含它)
+    for (int i = 0; i < count; i++) {
+        if (areas[i].Empty()) continue;
+        PlannedRequest req;
+        req.index = i;
+        req.area = areas[i];
+        for (size_t r = 0; r < plan->regions.size(); r++) {
+            if (Contains(plan->regions[r], areas[i])) {
+                req.region = static_cast<int>(r);
+                break;
+            }
+        }
+        plan->requests.push_back(req);
+    }
+
+    std::stable_sort(plan->requests.begin(), plan->requests.end(),
+                     [](const PlannedRequest& a, const PlannedRequest& b) {
+                         if (a.region != b.region) return a.region < b.region;
+                         return a.area.y != b.area.y ? a.area.y < b.area.y : a.area.x < b.area.x;
+                     });
+}
@@ -0,0 +1,43 @@
+#ifndef BATCH_PLANNER_H
+#define BATCH_PLANNER_H
+
+#include <vector>
+
+// 批量查找的区域规划
+//
+// 一批请求常常落在相同或互相重叠的 ROI 上。规划阶段把重叠的 ROI 合并为"准备区域"，
+// 像素转换 (BGRA -> BGR 等) 每个区域只做一次，请求再从区域中取零拷贝子视图。
+// 请求按区域、再按区域内位置排序，使同一区域的数据在缓存中保持热度。
+
+struct PlanRect {
+    int x = 0;
+    int y = 0;
+    int width = 0;
+    int height = 0;
+
+    bool Empty() const { return width <= 0 || height <= 0; }
+    long long Area() const { return static_cast<long long>(width) * height; }
+};
+
+struct PlannedRequest {
+    int index = 0;   // 原请求下标
+    int region = 0;  // 所属准备区域
+    PlanRect area;   // 请求 ROI (源图坐标)
+};
+
+struct BatchPlan {
+    std::vector<PlanRect> regions;        // 准备区域，按从上到下、从左到右排序
+    std::vector<PlannedRequest> requests; // 执行顺序
+    long long requestedPixels = 0;        // 各 ROI 面积之和 (不合并时需要准备的像素数)
+    long long preparedPixels = 0;         // 合并后实际需要准备的像素数
+};
+
+// 两个重叠区域合并后的包围盒面积不超过二者并集面积的该倍数时才合并，
+// 避免两个仅在角上相交的长条 ROI 合并成一大块无用区域
+constexpr double kRegionMergeSlack = 1.3;
+
+// 规划一批请求；areas[i] 为空表示该请求无效 (不参与规划)
+// plan 由调用者持有以便复用内存
+void PlanBatch(const PlanRect* areas, int count, BatchPlan* plan);
+
+#endif // BATCH_PLANNER_H
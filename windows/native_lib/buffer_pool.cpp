@@ -0,0 +1,136 @@
+#include "buffer_pool.h"
+
+#include <cstdlib>
+#include <unordered_set>
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+// 容量按页对齐，帧尺寸略有变化 (例如窗口边框) 时仍能复用同一块
+static const size_t kCapacityGranularity = 4096;
+
+// 已析构的池中仍借出的块
+// 有意不析构，进程退出时未归还的块与其他泄漏一样交给操作系统回收
+struct OrphanBlocks {
+    std::mutex mutex;
+    std::unordered_set<uint8_t*> blocks;
+};
+
+static OrphanBlocks& Orphans() {
+    static OrphanBlocks* orphans = new OrphanBlocks();
+    return *orphans;
+}
+
+BufferPool::~BufferPool() {
+    for (const Block& block : idle_) {
+        FreeAligned(block.data);
+    }
+    if (!inUse_.empty()) {
+        OrphanBlocks& orphans = Orphans();
+        std::lock_guard<std::mutex> lock(orphans.mutex);
+        for (const auto& item : inUse_) {
+            orphans.blocks.insert(item.first);
+        }
+    }
+}
+
+bool BufferPool::ReleaseOrphan(uint8_t* buffer) {
+    OrphanBlocks& orphans = Orphans();
+    {
+        std::lock_guard<std::mutex> lock(orphans.mutex);
+        if (orphans.blocks.erase(buffer) == 0) {
+            return false;
+        }
+    }
+    FreeAligned(buffer);
+    return true;
+}
+
+uint8_t* BufferPool::AllocateAligned(size_t size) {
+#ifdef _WIN32
+    return static_cast<uint8_t*>(_aligned_malloc(size, kAlignment));
+#else
+    void* data = nullptr;
+    if (posix_memalign(&data, kAlignment, size) != 0) {
+        return nullptr;
+    }
+    return static_cast<uint8_t*>(data);
+#endif
+}
+
+void BufferPool::FreeAligned(uint8_t* data) {
+#ifdef _WIN32
+    _aligned_free(data);
+#else
+    std::free(data);
+#endif
+}
+
+uint8_t* BufferPool::Acquire(size_t size) {
+    if (size == 0) {
+        return nullptr;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        // 选取满足条件的最小空闲块
+        size_t best = idle_.size();
+        for (size_t i = 0; i < idle_.size(); i++) {
+            const size_t capacity = idle_[i].capacity;
+            if (capacity < size || capacity / 2 > size) continue;
+            if (best == idle_.size() || capacity < idle_[best].capacity) {
+                best = i;
+            }
+        }
+        if (best != idle_.size()) {
+            const Block block = idle_[best];
+            idle_.erase(idle_.begin() + best);
+            inUse_[block.data] = block.capacity;
+            return block.data;
+        }
+    }
+
+    // 在锁外分配，避免大块分配阻塞其他线程归还缓冲
+    const size_t capacity = (size + kCapacityGranularity - 1) / kCapacityGranularity * kCapacityGranularity;
+    uint8_t* data = AllocateAligned(capacity);
+    if (!data) {
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    inUse_[data] = capacity;
+    return data;
+}
+
+bool BufferPool::Release(uint8_t* buffer) {
+    uint8_t* evicted = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = inUse_.find(buffer);
+        if (it == inUse_.end()) {
+            return false;
+        }
+        idle_.push_back({it->first, it->second});
+        inUse_.erase(it);
+
+        if (idle_.size() > maxIdle_) {
+            // 淘汰最久未用的块，刚归还的块最可能被下一帧复用
+            evicted = idle_.front().data;
+            idle_.erase(idle_.begin());
+        }
+    }
+    if (evicted) {
+        FreeAligned(evicted);
+    }
+    return true;
+}
+
+size_t BufferPool::InUse() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return inUse_.size();
+}
+
+size_t BufferPool::Idle() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return idle_.size();
+}
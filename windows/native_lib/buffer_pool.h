@@ -0,0 +1,57 @@
+#ifndef BUFFER_POOL_H
+#define BUFFER_POOL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+// 输入帧缓冲池
+//
+// 每次查找都分配一块整帧大小的内存、写入后再释放，代价与帧大小成正比。
+// 缓冲池按 64 字节对齐 (缓存行 / AVX 加载友好) 分配块，释放后保留在空闲列表中，
+// 下一帧尺寸相同时直接复用。调用方 (Dart 或 Runner) 把像素直接写入池中的块，
+// find_images_batch 原地读取，不再额外复制。
+class BufferPool {
+public:
+    static const size_t kAlignment = 64;
+
+    // maxIdle: 空闲列表最多保留的块数，超出时释放最久未用的块
+    explicit BufferPool(size_t maxIdle = 4) : maxIdle_(maxIdle) {}
+    // 只释放空闲块；仍借出的块调用方可能还在读写，转入进程级的孤儿列表，由 ReleaseOrphan 归还时释放
+    ~BufferPool();
+
+    BufferPool(const BufferPool&) = delete;
+    BufferPool& operator=(const BufferPool&) = delete;
+
+    // 取得至少 size 字节的缓冲，失败返回 nullptr
+    // 优先复用容量在 [size, 2 * size] 之间的空闲块，避免小请求占用大块
+    uint8_t* Acquire(size_t size);
+
+    // 归还缓冲；不是本池分配的指针会被忽略，返回 false
+    bool Release(uint8_t* buffer);
+
+    // 归还所属池已析构的块并释放；不是这类块时返回 false
+    static bool ReleaseOrphan(uint8_t* buffer);
+
+    // 当前借出的块数 / 空闲块数 (调试用)
+    size_t InUse() const;
+    size_t Idle() const;
+
+private:
+    struct Block {
+        uint8_t* data;
+        size_t capacity;
+    };
+
+    static uint8_t* AllocateAligned(size_t size);
+    static void FreeAligned(uint8_t* data);
+
+    mutable std::mutex mutex_;
+    size_t maxIdle_;
+    std::vector<Block> idle_;
+    std::unordered_map<uint8_t*, size_t> inUse_; // 指针 -> 容量
+};
+
+#endif // BUFFER_POOL_H
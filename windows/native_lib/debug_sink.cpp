@@ -0,0 +1,123 @@
+#include "debug_sink.h"
+
+#include <opencv2/imgcodecs.hpp>
+
+#include <cstdio>
+#include <vector>
+
+DebugSink::~DebugSink() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    cv_.notify_all();
+    if (writer_.joinable()) {
+        writer_.join();
+    }
+}
+
+void DebugSink::Configure(const Config& config) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    config_ = config;
+    if (config_.everyN < 1) config_.everyN = 1;
+    if (config_.queueCapacity < 1) config_.queueCapacity = 1;
+    if (config_.directory.empty()) config_.directory = ".";
+    if (config_.mode != kOff && !writer_.joinable()) {
+        writer_ = std::thread(&DebugSink::WriterLoop, this);
+    }
+    everyN_.store(config_.everyN, std::memory_order_relaxed);
+    nearMissMargin_.store(config_.nearMissMargin, std::memory_order_relaxed);
+    mode_.store(config_.mode, std::memory_order_relaxed);
+}
+
+bool DebugSink::ShouldSample(bool hit, double score, double threshold) {
+    const int mode = mode_.load(std::memory_order_relaxed);
+    if (mode == kOff) {
+        return false;
+    }
+    const int64_t call = calls_.fetch_add(1, std::memory_order_relaxed);
+
+    const int everyN = everyN_.load(std::memory_order_relaxed);
+    const double margin = nearMissMargin_.load(std::memory_order_relaxed);
+    if ((mode & kEveryN) && call % everyN == 0) {
+        return true;
+    }
+    if ((mode & kMisses) && !hit) {
+        return margin <= 0.0 || score < 0.0 || score >= threshold - margin;
+    }
+    return false;
+}
+
+void DebugSink::Submit(const char* tag, const cv::Mat& image) {
+    if (image.empty()) return;
+    // 先在锁内占一个队列位置，队列满时直接丢弃，不做注定被丢弃的整帧复制
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (static_cast<int>(queue_.size()) + reserved_ >= config_.queueCapacity) {
+            counters_.dropped++;
+            return;
+        }
+        reserved_++;
+    }
+    // 在锁外复制，调用方的缓冲 (如 BGRA 输入帧) 在返回后可能被复用
+    cv::Mat copy = image.clone();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    reserved_--;
+    last_ = copy;
+    queue_.push_back({tag, nextSequence_++, std::move(copy)});
+    counters_.sampled++;
+    cv_.notify_one();
+}
+
+cv::Mat DebugSink::Last() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return last_;
+}
+
+DebugSink::Counters DebugSink::GetCounters() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return counters_;
+}
+
+static bool WriteFileBytes(const std::string& path, const std::vector<uint8_t>& bytes) {
+    FILE* file = std::fopen(path.c_str(), "wb");
+    if (!file) return false;
+    const bool ok = std::fwrite(bytes.data(), 1, bytes.size(), file) == bytes.size();
+    return std::fclose(file) == 0 && ok;
+}
+
+void DebugSink::WriterLoop() {
+    std::vector<uint8_t> encoded;
+    for (;;) {
+        Item item;
+        std::string directory;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+            if (queue_.empty()) {
+                return; // stopping_ 且队列已写完
+            }
+            item = std::move(queue_.front());
+            queue_.pop_front();
+            directory = config_.directory;
+        }
+
+        // 编码一次，同时写出带序号的文件与 debug_last_<tag>.png
+        bool ok = cv::imencode(".png", item.image, encoded);
+        if (ok) {
+            char name[128];
+            std::snprintf(name, sizeof(name), "/%s_%06lld.png", item.tag, static_cast<long long>(item.sequence));
+            ok = WriteFileBytes(directory + name, encoded);
+            std::snprintf(name, sizeof(name), "/debug_last_%s.png", item.tag);
+            ok = WriteFileBytes(directory + name, encoded) && ok;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (ok) {
+            counters_.written++;
+        } else {
+            counters_.failed++;
+        }
+    }
+}
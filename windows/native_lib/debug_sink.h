@@ -0,0 +1,96 @@
+#ifndef DEBUG_SINK_H
+#define DEBUG_SINK_H
+
+#include <opencv2/core.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// 异步调试图片输出
+//
+// PNG 编码与写盘每张需要几十毫秒，不能放在查找路径上。
+// 查找线程只做采样判断 (一次原子读取)；命中采样时复制图片放入有界队列，
+// 由后台线程编码写盘。队列满时丢弃新图片并计数，绝不阻塞查找线程。
+// 默认关闭。
+class DebugSink {
+public:
+    // 采样方式 (可组合)
+    enum Mode {
+        kOff = 0,
+        kEveryN = 1,   // 每 N 次调用采样一次
+        kMisses = 2,   // 未命中时采样 (nearMissMargin > 0 时仅限接近阈值的未命中)
+    };
+
+    struct Config {
+        int mode = kOff;
+        int everyN = 1;
+        double nearMissMargin = 0.0;
+        int queueCapacity = 4;
+        std::string directory = "."; // 输出目录 (需已存在)
+    };
+
+    struct Counters {
+        int64_t sampled = 0;  // 进入队列的图片数
+        int64_t written = 0;  // 已写盘
+        int64_t dropped = 0;  // 队列满被丢弃
+        int64_t failed = 0;   // 编码或写盘失败
+    };
+
+    DebugSink() = default;
+    ~DebugSink();
+
+    DebugSink(const DebugSink&) = delete;
+    DebugSink& operator=(const DebugSink&) = delete;
+
+    // 更新配置；首次开启时启动后台线程。关闭时已排队的图片仍会写完
+    void Configure(const Config& config);
+
+    bool Enabled() const { return mode_.load(std::memory_order_relaxed) != kOff; }
+
+    // 判断本次调用是否采样 (每次调用都会推进 every-N 计数)
+    // score 为最高分；未知时 (如批量请求未命中不返回分数) 传负数，仅按是否命中判断
+    bool ShouldSample(bool hit, double score, double threshold);
+
+    // 放入队列 (内部复制像素)，写为 <directory>/<tag>_<序号>.png，
+    // 并覆盖 <directory>/debug_last_<tag>.png 方便界面回显
+    // tag 须为静态字符串
+    void Submit(const char* tag, const cv::Mat& image);
+
+    // 最近一次提交的图片 (与队列共享像素，不额外复制)
+    cv::Mat Last() const;
+
+    Counters GetCounters() const;
+
+private:
+    struct Item {
+        const char* tag;
+        int64_t sequence;
+        cv::Mat image;
+    };
+
+    void WriterLoop();
+
+    // 采样判断用到的配置单独存放，查找线程不加锁
+    std::atomic<int> mode_{kOff};
+    std::atomic<int> everyN_{1};
+    std::atomic<double> nearMissMargin_{0.0};
+    std::atomic<int64_t> calls_{0};
+
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    Config config_;
+    std::deque<Item> queue_;
+    int reserved_ = 0;              // 已占位、正在锁外复制的图片数
+    cv::Mat last_;
+    Counters counters_;
+    int64_t nextSequence_ = 0;
+    bool stopping_ = false;
+    std::thread writer_;
+};
+
+#endif // DEBUG_SINK_H
@@ -0,0 +1,422 @@
+#include "frame_codec.h"
+
+#include <algorithm>
+#include <cstring>
+
+// 字面段中连续的零不少于该长度时才切分为零段 (切分本身要多花约 2 字节的长度记录)
+static const size_t kMinZeroRun = 4;
+
+static const uint64_t kLowBytes = 0x0101010101010101ull;
+static const uint64_t kHighBits = 0x8080808080808080ull;
+
+// LZ: 哈希表 4096 项 (16 KB，放在栈上)；最短匹配 4 字节，偏移 16 位；
+// 末尾 kLzTail 字节之内不再起始匹配，匹配查找与延伸可以整字读取
+static const int kLzHashBits = 12;
+static const size_t kLzMinMatch = 4;
+static const size_t kLzMaxOffset = 65535;
+static const size_t kLzTail = 12;
+// 连续未命中时加大步长: 每 64 次未命中步长加 1，不可压缩的数据很快跳过
+static const unsigned kLzSkipShift = 6;
+
+static inline uint64_t LoadWord(const uint8_t* p) {
+    uint64_t word;
+    std::memcpy(&word, p, sizeof(word));
+    return word;
+}
+
+static inline uint32_t LoadWord32(const uint8_t* p) {
+    uint32_t word;
+    std::memcpy(&word, p, sizeof(word));
+    return word;
+}
+
+// out = a ^ b
+static void XorBytes(uint8_t* out, const uint8_t* a, const uint8_t* b, size_t size) {
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        const uint64_t word = LoadWord(a + i) ^ LoadWord(b + i);
+        std::memcpy(out + i, &word, sizeof(word));
+    }
+    for (; i < size; i++) {
+        out[i] = a[i] ^ b[i];
+    }
+}
+
+// 从 data 开始连续为 0 的字节数 (不超过 size)
+static size_t ZeroPrefix(const uint8_t* data, size_t size) {
+    size_t i = 0;
+    while (i + 8 <= size && LoadWord(data + i) == 0) {
+        i += 8;
+    }
+    while (i < size && data[i] == 0) {
+        i++;
+    }
+    return i;
+}
+
+// 从 i 开始的字面段的结束位置: 下一个长度 >= kMinZeroRun 的零段 (或数据末尾的零段) 的起点
+static size_t LiteralEnd(const uint8_t* data, size_t i, size_t size) {
+    while (i < size) {
+        // 不含零字节的 8 字节整组跳过
+        if (i + 8 <= size) {
+            const uint64_t word = LoadWord(data + i);
+            if (((word - kLowBytes) & ~word & kHighBits) == 0) {
+                i += 8;
+                continue;
+            }
+        }
+        if (data[i] != 0) {
+            i++;
+            continue;
+        }
+        const size_t run = ZeroPrefix(data + i, std::min(size - i, kMinZeroRun));
+        if (run >= kMinZeroRun || i + run == size) return i;
+        i += run;
+    }
+    return i;
+}
+
+static void PutVarint(std::vector<uint8_t>* out, size_t value) {
+    while (value >= 0x80) {
+        out->push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    out->push_back(static_cast<uint8_t>(value));
+}
+
+static bool GetVarint(const uint8_t** p, const uint8_t* end, size_t* value) {
+    size_t result = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (*p >= end) return false;
+        const uint8_t byte = *(*p)++;
+        result |= static_cast<size_t>(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) {
+            *value = result;
+            return true;
+        }
+    }
+    return false;
+}
+
+void ZeroRunEncode(const uint8_t* data, size_t size, std::vector<uint8_t>* out) {
+    size_t i = 0;
+    while (i < size) {
+        const size_t zeros = ZeroPrefix(data + i, size - i);
+        i += zeros;
+        const size_t start = i;
+        i = LiteralEnd(data, i, size);
+        PutVarint(out, zeros);
+        PutVarint(out, i - start);
+        out->insert(out->end(), data + start, data + i);
+    }
+}
+
+bool ZeroRunDecode(const uint8_t* data, size_t bytes, uint8_t* out, size_t size) {
+    const uint8_t* p = data;
+    const uint8_t* end = data + bytes;
+    size_t pos = 0;
+    while (pos < size) {
+        size_t zeros, literal;
+        if (!GetVarint(&p, end, &zeros) || zeros > size - pos) return false;
+        std::memset(out + pos, 0, zeros);
+        pos += zeros;
+        if (!GetVarint(&p, end, &literal) || literal > size - pos || literal > static_cast<size_t>(end - p)) {
+            return false;
+        }
+        std::memcpy(out + pos, p, literal);
+        p += literal;
+        pos += literal;
+    }
+    return p == end;
+}
+
+static inline uint32_t LzHash(uint32_t word) {
+    return (word * 2654435761u) >> (32 - kLzHashBits);
+}
+
+// a 与 b 从头开始相同的字节数 (不超过 limit)；b 在 a 之前，允许重叠
+static size_t CommonPrefix(const uint8_t* a, const uint8_t* b, size_t limit) {
+    size_t n = 0;
+    while (n + 8 <= limit) {
+        const uint64_t diff = LoadWord(a + n) ^ LoadWord(b + n);
+        if (diff != 0) {
+            // 小端序: 最低的非零字节即第一个不同的字节
+            uint64_t low = diff & (~diff + 1);
+            while ((low & 0xff) == 0) {
+                low >>= 8;
+                n++;
+            }
+            return n;
+        }
+        n += 8;
+    }
+    while (n < limit && a[n] == b[n]) {
+        n++;
+    }
+    return n;
+}
+
+// 长度半字节为 15 时，剩余部分按 255 一组追加；返回写入后的位置
+static uint8_t* PutLzLength(uint8_t* out, size_t length) {
+    if (length >= 255) {
+        const size_t groups = length / 255;
+        std::memset(out, 255, groups);
+        out += groups;
+        length -= groups * 255;
+    }
+    *out++ = static_cast<uint8_t>(length);
+    return out;
+}
+
+static bool GetLzLength(const uint8_t** p, const uint8_t* end, size_t* length) {
+    uint8_t byte;
+    do {
+        if (*p >= end) return false;
+        byte = *(*p)++;
+        *length += byte;
+    } while (byte == 255);
+    return true;
+}
+
+// 一个序列: 字面段，随后 (matchLength > 0 时) 一个匹配；返回写入后的位置
+static uint8_t* PutLzSequence(uint8_t* out, const uint8_t* literals, size_t literalCount, size_t offset,
+                              size_t matchLength) {
+    const size_t match = matchLength > 0 ? matchLength - kLzMinMatch : 0;
+    *out++ = static_cast<uint8_t>((std::min<size_t>(literalCount, 15) << 4) | std::min<size_t>(match, 15));
+    if (literalCount >= 15) out = PutLzLength(out, literalCount - 15);
+    std::memcpy(out, literals, literalCount);
+    out += literalCount;
+    if (matchLength == 0) return out;
+    *out++ = static_cast<uint8_t>(offset);
+    *out++ = static_cast<uint8_t>(offset >> 8);
+    if (match >= 15) out = PutLzLength(out, match - 15);
+    return out;
+}
+
+void LzEncode(const uint8_t* data, size_t size, std::vector<uint8_t>* out) {
+    if (size == 0) return;
+    // 最坏情况 (全是字面) 每 255 字节多 1 字节长度，另加令牌
+    const size_t at = out->size();
+    out->resize(at + size + size / 255 + 16);
+    uint8_t* op = out->data() + at;
+    uint32_t table[1 << kLzHashBits];
+    std::fill(table, table + (1 << kLzHashBits), 0u);
+    const size_t limit = size > kLzTail ? size - kLzTail : 0;
+    size_t anchor = 0;
+    size_t i = 1;
+    unsigned misses = 0;
+    while (i < limit) {
+        const uint32_t word = LoadWord32(data + i);
+        const uint32_t hash = LzHash(word);
+        const size_t candidate = table[hash];
+        table[hash] = static_cast<uint32_t>(i);
+        if (i - candidate > kLzMaxOffset || LoadWord32(data + candidate) != word) {
+            i += 1 + (misses++ >> kLzSkipShift);
+            continue;
+        }
+        misses = 0;
+        // 向前延伸到上一个序列的末尾
+        size_t start = i;
+        size_t from = candidate;
+        while (start > anchor && from > 0 && data[start - 1] == data[from - 1]) {
+            start--;
+            from--;
+        }
+        const size_t end = i + kLzMinMatch + CommonPrefix(data + i + kLzMinMatch, data + candidate + kLzMinMatch,
+                                                          size - i - kLzMinMatch);
+        op = PutLzSequence(op, data + anchor, start - anchor, start - from, end - start);
+        anchor = end;
+        i = end;
+        // 匹配内部的位置也登记一个，下一段相似内容更容易命中
+        if (i - 2 < limit) table[LzHash(LoadWord32(data + i - 2))] = static_cast<uint32_t>(i - 2);
+    }
+    op = PutLzSequence(op, data + anchor, size - anchor, 0, 0);
+    out->resize(static_cast<size_t>(op - out->data()));
+}
+
+// 复制 length 字节的匹配；offset 小于 8 时源与目标在同一个字内重叠，逐字节复制
+static void CopyMatch(uint8_t* out, size_t offset, size_t length) {
+    const uint8_t* from = out - offset;
+    if (offset == 1) {
+        std::memset(out, *from, length);
+        return;
+    }
+    size_t i = 0;
+    if (offset >= 8) {
+        for (; i + 8 <= length; i += 8) {
+            const uint64_t word = LoadWord(from + i);
+            std::memcpy(out + i, &word, sizeof(word));
+        }
+    }
+    for (; i < length; i++) {
+        out[i] = from[i];
+    }
+}
+
+bool LzDecode(const uint8_t* data, size_t bytes, uint8_t* out, size_t size) {
+    if (size == 0) return bytes == 0;
+    const uint8_t* p = data;
+    const uint8_t* end = data + bytes;
+    size_t pos = 0;
+    for (;;) {
+        if (p >= end) return false;
+        const uint8_t token = *p++;
+        size_t literal = token >> 4;
+        if (literal == 15 && !GetLzLength(&p, end, &literal)) return false;
+        if (literal > size - pos || literal > static_cast<size_t>(end - p)) return false;
+        std::memcpy(out + pos, p, literal);
+        p += literal;
+        pos += literal;
+        // 最后一个序列只有字面段
+        if (pos == size) return p == end && (token & 15) == 0;
+        if (end - p < 2) return false;
+        const size_t offset = p[0] | (static_cast<size_t>(p[1]) << 8);
+        p += 2;
+        if (offset == 0 || offset > pos) return false;
+        size_t match = token & 15;
+        if (match == 15 && !GetLzLength(&p, end, &match)) return false;
+        match += kLzMinMatch;
+        if (match > size - pos) return false;
+        CopyMatch(out + pos, offset, match);
+        pos += match;
+    }
+}
+
+// 压缩残差: 零游程，LZ 时再对零游程结果做 LZ (前置其长度)
+static void EncodeResidual(const uint8_t* data, size_t size, FrameResidualCodec codec, FrameCodecScratch* scratch,
+                           std::vector<uint8_t>* out) {
+    if (codec == FRAME_RESIDUAL_ZERO_RUN) {
+        ZeroRunEncode(data, size, out);
+        return;
+    }
+    scratch->runs.clear();
+    ZeroRunEncode(data, size, &scratch->runs);
+    PutVarint(out, scratch->runs.size());
+    LzEncode(scratch->runs.data(), scratch->runs.size(), out);
+}
+
+static bool DecodeResidual(const uint8_t* data, size_t bytes, FrameResidualCodec codec, FrameCodecScratch* scratch,
+                           uint8_t* out, size_t size) {
+    if (codec == FRAME_RESIDUAL_ZERO_RUN) return ZeroRunDecode(data, bytes, out, size);
+    const uint8_t* p = data;
+    const uint8_t* end = data + bytes;
+    size_t runBytes;
+    // 零游程结果不超过 size 的 1.5 倍 (每段至少 5 字节数据，两个长度各占 1 字节)；超出即数据损坏
+    if (!GetVarint(&p, end, &runBytes) || runBytes > size + size / 2 + 32) return false;
+    scratch->runs.resize(runBytes);
+    return LzDecode(p, static_cast<size_t>(end - p), scratch->runs.data(), runBytes) &&
+           ZeroRunDecode(scratch->runs.data(), runBytes, out, size);
+}
+
+void EncodeKeyframe(const uint8_t* bgr, int width, int height, FrameCodecScratch* scratch,
+                    std::vector<uint8_t>* out, FrameResidualCodec codec) {
+    const size_t rowBytes = static_cast<size_t>(width) * 3;
+    const size_t size = rowBytes * height;
+    if (size == 0) return;
+    scratch->residual.resize(size); // 尺寸不变时不重新分配
+    uint8_t* predicted = scratch->residual.data();
+    std::memcpy(predicted, bgr, rowBytes);
+    for (int y = 1; y < height; y++) {
+        const uint8_t* row = bgr + rowBytes * y;
+        XorBytes(predicted + rowBytes * y, row, row - rowBytes, rowBytes);
+    }
+    EncodeResidual(predicted, size, codec, scratch, out);
+}
+
+bool DecodeKeyframe(const uint8_t* data, size_t bytes, int width, int height, FrameCodecScratch* scratch,
+                    uint8_t* bgr, FrameResidualCodec codec) {
+    const size_t rowBytes = static_cast<size_t>(width) * 3;
+    if (!DecodeResidual(data, bytes, codec, scratch, bgr, rowBytes * height)) return false;
+    for (int y = 1; y < height; y++) {
+        uint8_t* row = bgr + rowBytes * y;
+        XorBytes(row, row, row - rowBytes, rowBytes);
+    }
+    return true;
+}
+
+int EncodeDeltaFrame(const uint8_t* bgr, const uint8_t* previous, int width, int height,
+                     FrameCodecScratch* scratch, std::vector<uint8_t>* out, FrameResidualCodec codec) {
+    const size_t rowBytes = static_cast<size_t>(width) * 3;
+    const int tilesX = (width + kFrameCodecTile - 1) / kFrameCodecTile;
+    const int tilesY = (height + kFrameCodecTile - 1) / kFrameCodecTile;
+    const size_t bitmapAt = out->size();
+    out->resize(bitmapAt + (static_cast<size_t>(tilesX) * tilesY + 7) / 8, 0);
+
+    // 变化块的异或结果按块顺序写入 residual (最多整帧大小)
+    scratch->residual.resize(rowBytes * height);
+    uint8_t* const residual = scratch->residual.data();
+    uint8_t* cursor = residual;
+    int changed = 0;
+    for (int ty = 0; ty < tilesY; ty++) {
+        const int y0 = ty * kFrameCodecTile;
+        const int y1 = std::min(height, y0 + kFrameCodecTile);
+        for (int tx = 0; tx < tilesX; tx++) {
+            const size_t x0 = static_cast<size_t>(tx) * kFrameCodecTile * 3;
+            const size_t tileBytes = std::min(rowBytes - x0, static_cast<size_t>(kFrameCodecTile) * 3);
+            int y = y0;
+            while (y < y1 && std::memcmp(bgr + rowBytes * y + x0, previous + rowBytes * y + x0, tileBytes) == 0) {
+                y++;
+            }
+            if (y == y1) continue;
+
+            const size_t bit = static_cast<size_t>(ty) * tilesX + tx;
+            (*out)[bitmapAt + bit / 8] |= static_cast<uint8_t>(1u << (bit % 8));
+            changed++;
+            // 前面比较过的行相同，异或为 0
+            std::memset(cursor, 0, tileBytes * (y - y0));
+            cursor += tileBytes * (y - y0);
+            for (; y < y1; y++) {
+                XorBytes(cursor, bgr + rowBytes * y + x0, previous + rowBytes * y + x0, tileBytes);
+                cursor += tileBytes;
+            }
+        }
+    }
+    EncodeResidual(residual, static_cast<size_t>(cursor - residual), codec, scratch, out);
+    return changed;
+}
+
+bool DecodeDeltaFrame(const uint8_t* data, size_t bytes, int width, int height, FrameCodecScratch* scratch,
+                      uint8_t* bgr, FrameResidualCodec codec) {
+    const size_t rowBytes = static_cast<size_t>(width) * 3;
+    const int tilesX = (width + kFrameCodecTile - 1) / kFrameCodecTile;
+    const int tilesY = (height + kFrameCodecTile - 1) / kFrameCodecTile;
+    const size_t bitmapBytes = (static_cast<size_t>(tilesX) * tilesY + 7) / 8;
+    if (bytes < bitmapBytes) return false;
+
+    auto isChanged = [&](int tx, int ty) {
+        const size_t bit = static_cast<size_t>(ty) * tilesX + tx;
+        return (data[bit / 8] >> (bit % 8)) & 1;
+    };
+    auto tileBytes = [&](int tx) {
+        return std::min(rowBytes - static_cast<size_t>(tx) * kFrameCodecTile * 3,
+                        static_cast<size_t>(kFrameCodecTile) * 3);
+    };
+    auto tileRows = [&](int ty) { return std::min(height - ty * kFrameCodecTile, kFrameCodecTile); };
+
+    size_t total = 0;
+    for (int ty = 0; ty < tilesY; ty++) {
+        for (int tx = 0; tx < tilesX; tx++) {
+            if (isChanged(tx, ty)) total += tileBytes(tx) * tileRows(ty);
+        }
+    }
+    scratch->residual.resize(std::max(scratch->residual.size(), total));
+    if (!DecodeResidual(data + bitmapBytes, bytes - bitmapBytes, codec, scratch, scratch->residual.data(), total)) {
+        return false;
+    }
+
+    const uint8_t* cursor = scratch->residual.data();
+    for (int ty = 0; ty < tilesY; ty++) {
+        for (int tx = 0; tx < tilesX; tx++) {
+            if (!isChanged(tx, ty)) continue;
+            const size_t x0 = static_cast<size_t>(tx) * kFrameCodecTile * 3;
+            const size_t length = tileBytes(tx);
+            const int y0 = ty * kFrameCodecTile;
+            for (int y = y0; y < y0 + tileRows(ty); y++) {
+                uint8_t* row = bgr + rowBytes * y + x0;
+                XorBytes(row, row, cursor, length);
+                cursor += length;
+            }
+        }
+    }
+    return true;
+}
@@ -0,0 +1,64 @@
+#ifndef FRAME_CODEC_H
+#define FRAME_CODEC_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// 录制帧的无损压缩 (frame_recorder 使用，不依赖 OpenCV)
+//
+// 帧统一为行紧密排列的 BGR，分两种:
+//   关键帧: 每行与上一行逐字节异或 (第 0 行原样)，再压缩残差。纯色区域与竖直边缘异或后为 0。
+//   差分帧: 画面按 kFrameCodecTile 像素见方的块与上一帧比较，块位图标记变化的块；
+//           变化块与上一帧的对应块逐字节异或后按块顺序拼接，再压缩残差，未变化的块不占空间。
+//
+// 残差压缩 (FrameResidualCodec):
+//   零游程: 交替记录 (零字节数, 字面字节数, 字面字节...)，长度为 LEB128 变长整数；
+//     按 8 字节一组跳过零段与不含零的字面段。只能去掉零段，纹理与动画画面几乎不压缩 (录制版本 1 只用这一级)。
+//   LZ (录制版本 2 起): 零游程结果的长度 (LEB128) + 对零游程结果做的 LZ 压缩。
+//     LZ 为 LZ4 块格式的快速 LZ77: 每个序列为 令牌 (高 4 位字面长度，低 4 位匹配长度 - 4，15 表示后续按 255 一组延长)
+//     + 字面字节 + 16 位小端偏移 + 延长的匹配长度，最后一个序列只有字面段；单趟哈希查找 (4 字节，4096 项)，
+//     连续未命中时加大步长。零段先被零游程压成几个字节，64 KB 窗口因而能覆盖更远的重复纹理与图案。
+
+static const int kFrameCodecTile = 64;
+
+enum FrameResidualCodec {
+    FRAME_RESIDUAL_ZERO_RUN = 0,
+    FRAME_RESIDUAL_LZ = 1,
+};
+
+// 编解码的临时缓冲，由调用方持有并在各帧之间复用 (尺寸不变时不重新分配)
+struct FrameCodecScratch {
+    std::vector<uint8_t> residual; // 异或残差
+    std::vector<uint8_t> runs;     // 零游程结果 (LZ 的输入 / 输出)
+};
+
+// 零游程编码，结果追加到 out
+void ZeroRunEncode(const uint8_t* data, size_t size, std::vector<uint8_t>* out);
+
+// 解码出恰好 size 字节；数据损坏或长度不符时返回 false
+bool ZeroRunDecode(const uint8_t* data, size_t bytes, uint8_t* out, size_t size);
+
+// LZ 编码，结果追加到 out (size 为 0 时不输出)
+void LzEncode(const uint8_t* data, size_t size, std::vector<uint8_t>* out);
+
+// 解码出恰好 size 字节；数据损坏、偏移越界或长度不符时返回 false
+bool LzDecode(const uint8_t* data, size_t bytes, uint8_t* out, size_t size);
+
+// 编码关键帧，结果追加到 out
+void EncodeKeyframe(const uint8_t* bgr, int width, int height, FrameCodecScratch* scratch,
+                    std::vector<uint8_t>* out, FrameResidualCodec codec = FRAME_RESIDUAL_LZ);
+
+bool DecodeKeyframe(const uint8_t* data, size_t bytes, int width, int height, FrameCodecScratch* scratch,
+                    uint8_t* bgr, FrameResidualCodec codec = FRAME_RESIDUAL_LZ);
+
+// 编码相对 previous (同尺寸的上一帧) 的差分帧，结果追加到 out，返回变化的块数
+int EncodeDeltaFrame(const uint8_t* bgr, const uint8_t* previous, int width, int height,
+                     FrameCodecScratch* scratch, std::vector<uint8_t>* out,
+                     FrameResidualCodec codec = FRAME_RESIDUAL_LZ);
+
+// bgr 传入上一帧，就地更新为当前帧
+bool DecodeDeltaFrame(const uint8_t* data, size_t bytes, int width, int height, FrameCodecScratch* scratch,
+                      uint8_t* bgr, FrameResidualCodec codec = FRAME_RESIDUAL_LZ);
+
+#endif // FRAME_CODEC_H
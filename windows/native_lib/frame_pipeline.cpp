@@ -0,0 +1,182 @@
+#include "frame_pipeline.h"
+#include "search_stats.h"
+#include "trace.h"
+
+#include <opencv2/imgproc.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+// 匹配线程所属的流水线 (其他线程为空)
+static thread_local const FramePipeline* t_consumerPipeline = nullptr;
+
+double SceneSampler::Update(const cv::Mat& frame) {
+    const int channels = std::min(frame.channels(), 3); // 忽略 alpha
+    const size_t n = static_cast<size_t>(kCols) * kRows * channels;
+    const bool first = samples_.size() != n || frame.cols != width_ || frame.rows != height_;
+    samples_.resize(n);
+    width_ = frame.cols;
+    height_ = frame.rows;
+    int64_t sum = 0;
+    size_t k = 0;
+    for (int r = 0; r < kRows; r++) {
+        const uint8_t* row = frame.ptr<uint8_t>((2 * r + 1) * frame.rows / (2 * kRows));
+        for (int c = 0; c < kCols; c++) {
+            const uint8_t* pixel = row + static_cast<size_t>((2 * c + 1) * frame.cols / (2 * kCols)) *
+                                             frame.channels();
+            for (int ch = 0; ch < channels; ch++, k++) {
+                sum += std::abs(static_cast<int>(pixel[ch]) - static_cast<int>(samples_[k]));
+                samples_[k] = pixel[ch];
+            }
+        }
+    }
+    return first ? 255.0 : static_cast<double>(sum) / n;
+}
+
+FramePipeline::FramePipeline(Consumer consumer) : consumer_(std::move(consumer)) {
+    for (uint32_t i = 0; i < kCaptureSlots; i++) {
+        captureFree_.TryPush(i);
+    }
+    for (uint32_t i = 0; i < kPreparedSlots; i++) {
+        preparedFree_.TryPush(i);
+    }
+}
+
+FramePipeline::~FramePipeline() {
+    Stop();
+}
+
+void FramePipeline::Start() {
+    if (running_.load() || stopping_.load()) return;
+    running_.store(true, std::memory_order_release);
+    prepareThread_ = std::thread(&FramePipeline::PrepareLoop, this);
+    matchThread_ = std::thread(&FramePipeline::MatchLoop, this);
+}
+
+bool FramePipeline::Submit(const uint8_t* pixels, int width, int height, int stride, int64_t arrivalNs) {
+    if (!running_.load(std::memory_order_acquire) || stopping_.load(std::memory_order_acquire)) return false;
+
+    uint32_t slot;
+    if (captureSpare_ >= 0) {
+        slot = static_cast<uint32_t>(captureSpare_);
+        captureSpare_ = -1;
+    } else if (!captureFree_.TryPop(&slot)) {
+        // 槽位数按最坏情况预留，正常不会走到这里
+        droppedCapture_.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    CaptureSlot& frame = captureSlots_[slot];
+    {
+        TRACE_SCOPE("pipeline_copy");
+        const size_t rowBytes = static_cast<size_t>(width) * 4;
+        if (stride <= 0) stride = static_cast<int>(rowBytes);
+        frame.pixels.resize(rowBytes * height);
+        if (static_cast<size_t>(stride) == rowBytes) {
+            std::memcpy(frame.pixels.data(), pixels, frame.pixels.size());
+        } else {
+            for (int y = 0; y < height; y++) {
+                std::memcpy(frame.pixels.data() + rowBytes * y, pixels + static_cast<size_t>(stride) * y, rowBytes);
+            }
+        }
+    }
+    frame.width = width;
+    frame.height = height;
+    frame.arrivalNs = arrivalNs > 0 ? arrivalNs : StatsNowNs();
+    frame.frameNumber = nextFrameNumber_++;
+
+    uint32_t dropped;
+    if (captureRing_.Push(slot, &dropped)) {
+        captureSpare_ = static_cast<int>(dropped);
+        droppedCapture_.fetch_add(1, std::memory_order_relaxed);
+    }
+    submitted_.fetch_add(1, std::memory_order_relaxed);
+    prepareSignal_.Notify();
+    return true;
+}
+
+void FramePipeline::PrepareLoop() {
+    for (;;) {
+        const uint32_t seen = prepareSignal_.Sequence();
+        if (stopping_.load(std::memory_order_acquire)) return;
+        uint32_t slot;
+        if (!captureRing_.Pop(&slot)) {
+            prepareSignal_.Wait(seen);
+            continue;
+        }
+
+        uint32_t target;
+        if (preparedSpare_ >= 0) {
+            target = static_cast<uint32_t>(preparedSpare_);
+            preparedSpare_ = -1;
+        } else if (!preparedFree_.TryPop(&target)) {
+            captureFree_.TryPush(slot);
+            droppedPrepared_.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+
+        const CaptureSlot& in = captureSlots_[slot];
+        PreparedFrame& out = preparedSlots_[target];
+        const int64_t start = StatsNowNs();
+        {
+            TRACE_SCOPE("pipeline_prepare");
+            const cv::Mat bgra(in.height, in.width, CV_8UC4, const_cast<uint8_t*>(in.pixels.data()));
+            cv::cvtColor(bgra, out.image, cv::COLOR_BGRA2BGR); // 尺寸不变时复用 out.image
+            out.sceneChange = scene_.Update(out.image);
+        }
+        out.arrivalNs = in.arrivalNs;
+        out.frameNumber = in.frameNumber;
+        lastPrepareNs_.store(StatsNowNs() - start, std::memory_order_relaxed);
+        captureFree_.TryPush(slot);
+
+        uint32_t dropped;
+        if (preparedRing_.Push(target, &dropped)) {
+            preparedSpare_ = static_cast<int>(dropped);
+            droppedPrepared_.fetch_add(1, std::memory_order_relaxed);
+        }
+        prepared_.fetch_add(1, std::memory_order_relaxed);
+        matchSignal_.Notify();
+    }
+}
+
+void FramePipeline::MatchLoop() {
+    t_consumerPipeline = this;
+    for (;;) {
+        const uint32_t seen = matchSignal_.Sequence();
+        if (stopping_.load(std::memory_order_acquire)) return;
+        uint32_t slot;
+        if (!preparedRing_.Pop(&slot)) {
+            matchSignal_.Wait(seen);
+            continue;
+        }
+        consumer_(preparedSlots_[slot]);
+        consumed_.fetch_add(1, std::memory_order_relaxed);
+        preparedFree_.TryPush(slot);
+    }
+}
+
+void FramePipeline::Stop() {
+    stopping_.store(true, std::memory_order_release);
+    prepareSignal_.Notify();
+    matchSignal_.Notify();
+    if (prepareThread_.joinable()) prepareThread_.join();
+    // 在 consumer 中停止时不能等待自身: 线程在 consumer 返回后看到 stopping_ 退出，由之后的 Stop 回收
+    if (matchThread_.joinable() && !InConsumer()) matchThread_.join();
+    running_.store(false, std::memory_order_release);
+}
+
+bool FramePipeline::InConsumer() const {
+    return t_consumerPipeline == this;
+}
+
+FramePipeline::Stats FramePipeline::GetStats() const {
+    Stats stats;
+    stats.submitted = submitted_.load(std::memory_order_relaxed);
+    stats.prepared = prepared_.load(std::memory_order_relaxed);
+    stats.consumed = consumed_.load(std::memory_order_relaxed);
+    stats.droppedCapture = droppedCapture_.load(std::memory_order_relaxed);
+    stats.droppedPrepared = droppedPrepared_.load(std::memory_order_relaxed);
+    stats.lastPrepareNs = lastPrepareNs_.load(std::memory_order_relaxed);
+    return stats;
+}
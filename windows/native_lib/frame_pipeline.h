@@ -0,0 +1,129 @@
+#ifndef FRAME_PIPELINE_H
+#define FRAME_PIPELINE_H
+
+#include "spsc_queue.h"
+
+#include <opencv2/core.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <thread>
+#include <vector>
+
+// 画面变化采样: 固定网格上的像素与上一帧的平均绝对差 (0-255)
+// 没有上一帧或帧尺寸变化时返回 255 (视为完全变化)
+class SceneSampler {
+public:
+    double Update(const cv::Mat& frame);
+    void Reset() { samples_.clear(); }
+
+private:
+    static const int kCols = 64;
+    static const int kRows = 36;
+
+    std::vector<uint8_t> samples_;
+    int width_ = 0;
+    int height_ = 0;
+};
+
+// 三级帧流水线
+//
+//   截图回调 (Submit)  ->  准备线程  ->  匹配线程 (consumer)
+//     复制 BGRA            BGRA -> BGR 转换、画面变化采样
+//
+// 级间是有界的无锁单生产者 / 单消费者环，满时丢弃最旧的帧: 第 N 帧匹配时第 N+1 帧已在准备，
+// 任何一级跟不上都只会丢帧而不会阻塞截图线程。帧缓冲在启动时按槽位预分配，
+// 各级通过空闲队列归还槽位，帧尺寸不变时稳态不分配内存。
+// 线程只在无事可做时经 WakeSignal 休眠。
+class FramePipeline {
+public:
+    struct PreparedFrame {
+        cv::Mat image;          // BGR (8UC3)
+        int64_t arrivalNs = 0;  // Submit 时给出的帧到达时间
+        int64_t frameNumber = 0;// 提交序号 (从 1 开始)，可据此判断丢了哪些帧
+        double sceneChange = 0; // SceneSampler::Update 的结果
+    };
+
+    struct Stats {
+        long long submitted;        // Submit 接受的帧
+        long long prepared;         // 完成转换的帧
+        long long consumed;         // 交给 consumer 的帧
+        long long droppedCapture;   // 准备线程跟不上，被新帧挤掉
+        long long droppedPrepared;  // 匹配线程跟不上，被新帧挤掉
+        long long lastPrepareNs;    // 最近一帧的转换与采样耗时
+    };
+
+    // consumer 在匹配线程上依次调用，frame 只在调用期间有效
+    typedef std::function<void(const PreparedFrame&)> Consumer;
+
+    explicit FramePipeline(Consumer consumer);
+    ~FramePipeline();
+
+    FramePipeline(const FramePipeline&) = delete;
+    FramePipeline& operator=(const FramePipeline&) = delete;
+
+    void Start();
+
+    // 复制一帧 BGRA；只能在一个线程上调用 (截图回调)。未启动或已停止时返回 false
+    bool Submit(const uint8_t* pixels, int width, int height, int stride, int64_t arrivalNs);
+
+    // 停止并等待两个线程退出，排队中的帧被丢弃
+    // 可在 consumer 内调用: 此时只等待准备线程，匹配线程在 consumer 返回后自行退出；
+    // 之后必须在其他线程上再次调用 Stop (或析构) 等待它退出。不能在 consumer 内析构本对象
+    void Stop();
+
+    // 当前线程是否为本流水线的匹配线程 (即在 consumer 内)
+    bool InConsumer() const;
+
+    Stats GetStats() const;
+
+private:
+    // 级间环的深度，以及各级槽位数 (环 + 下游持有 + 上游正在写入 + 被挤出后暂存)
+    static const size_t kCaptureDepth = 2;
+    static const size_t kPreparedDepth = 1;
+    static const size_t kCaptureSlots = kCaptureDepth + 3;
+    static const size_t kPreparedSlots = kPreparedDepth + 3;
+
+    struct CaptureSlot {
+        std::vector<uint8_t> pixels;
+        int width = 0;
+        int height = 0;
+        int64_t arrivalNs = 0;
+        int64_t frameNumber = 0;
+    };
+
+    void PrepareLoop();
+    void MatchLoop();
+
+    Consumer consumer_;
+    std::atomic<bool> running_{false};
+    std::atomic<bool> stopping_{false};
+    std::thread prepareThread_;
+    std::thread matchThread_;
+
+    // 截图 -> 准备
+    CaptureSlot captureSlots_[kCaptureSlots];
+    DropOldestRing<kCaptureDepth> captureRing_;
+    SpscQueue<uint32_t, 8> captureFree_;      // 准备线程归还，截图线程取用
+    int captureSpare_ = -1;                   // 截图线程从环中挤出的槽位，下次直接复用
+    int64_t nextFrameNumber_ = 1;             // 截图线程独占
+    WakeSignal prepareSignal_;
+
+    // 准备 -> 匹配
+    PreparedFrame preparedSlots_[kPreparedSlots];
+    DropOldestRing<kPreparedDepth> preparedRing_;
+    SpscQueue<uint32_t, 4> preparedFree_;     // 匹配线程归还，准备线程取用
+    int preparedSpare_ = -1;
+    SceneSampler scene_;                      // 准备线程独占
+    WakeSignal matchSignal_;
+
+    std::atomic<long long> submitted_{0};
+    std::atomic<long long> prepared_{0};
+    std::atomic<long long> consumed_{0};
+    std::atomic<long long> droppedCapture_{0};
+    std::atomic<long long> droppedPrepared_{0};
+    std::atomic<long long> lastPrepareNs_{0};
+};
+
+#endif // FRAME_PIPELINE_H
@@ -0,0 +1,369 @@
+#include "frame_recorder.h"
+#include "frame_codec.h"
+#include "search_stats.h"
+#include "trace.h"
+
+#include <opencv2/imgproc.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+// 文件布局依赖结构体大小 (写入与读取直接按结构体复制)
+static_assert(sizeof(FrameRecordHeader) == 40, "FrameRecordHeader layout");
+static_assert(sizeof(FrameChunkHeader) == 40, "FrameChunkHeader layout");
+static_assert(sizeof(FrameIndexEntry) == 32, "FrameIndexEntry layout");
+static_assert(sizeof(FrameRecordFooter) == 24, "FrameRecordFooter layout");
+
+// 写入线程的文件缓冲 (合并块头与压缩数据的小块写入)
+static const size_t kFileBufferBytes = 1 << 20;
+
+FrameRecorder::FrameRecorder() {
+    for (uint32_t i = 0; i < kQueueDepth; i++) {
+        free_.TryPush(i);
+    }
+}
+
+FrameRecorder::~FrameRecorder() {
+    Stop();
+}
+
+bool FrameRecorder::Start(const std::string& path, int keyframeInterval, std::string* error) {
+    if (file_ || running_.load()) {
+        if (error) *error = "recorder already started";
+        return false;
+    }
+    file_ = std::fopen(path.c_str(), "wb");
+    if (!file_) {
+        if (error) *error = "cannot create " + path;
+        return false;
+    }
+    std::setvbuf(file_, nullptr, _IOFBF, kFileBufferBytes);
+    keyframeInterval_ = keyframeInterval > 0 ? keyframeInterval : kDefaultKeyframeInterval;
+
+    FrameRecordHeader header = {};
+    std::memcpy(header.magic, kFrameRecordMagic, sizeof(header.magic));
+    header.version = kFrameRecordVersion;
+    header.headerSize = sizeof(FrameRecordHeader);
+    header.chunkHeaderSize = sizeof(FrameChunkHeader);
+    header.tileSize = kFrameCodecTile;
+    header.keyframeInterval = static_cast<uint32_t>(keyframeInterval_);
+    header.startNs = StatsNowNs();
+    if (!WriteBytes(&header, sizeof(header))) {
+        std::fclose(file_);
+        file_ = nullptr;
+        if (error) *error = "cannot write " + path;
+        return false;
+    }
+
+    running_.store(true, std::memory_order_release);
+    thread_ = std::thread(&FrameRecorder::WriteLoop, this);
+    return true;
+}
+
+bool FrameRecorder::Submit(const uint8_t* pixels, int width, int height, int stride, int64_t arrivalNs) {
+    if (!running_.load(std::memory_order_acquire)) return false;
+    // 先登记再检查 stopping_ (与 Stop 的先置位再等待构成 Dekker 式握手，均为顺序一致):
+    // Stop 要么看到本次登记并等它入队，要么本次看到 stopping_ 而放弃
+    submitting_.fetch_add(1);
+    if (stopping_.load()) {
+        submitting_.fetch_sub(1);
+        return false;
+    }
+    const bool accepted = Enqueue(pixels, width, height, stride, arrivalNs);
+    submitting_.fetch_sub(1);
+    return accepted;
+}
+
+bool FrameRecorder::Enqueue(const uint8_t* pixels, int width, int height, int stride, int64_t arrivalNs) {
+    const int64_t frameNumber = nextFrameNumber_++;
+    uint32_t slot;
+    if (!free_.TryPop(&slot)) {
+        // 写入线程落后 kQueueDepth 帧: 丢弃这一帧，不等待
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    Slot& frame = slots_[slot];
+    {
+        TRACE_SCOPE("recorder_copy");
+        const size_t rowBytes = static_cast<size_t>(width) * 4;
+        if (stride <= 0) stride = static_cast<int>(rowBytes);
+        frame.pixels.resize(rowBytes * height);
+        if (static_cast<size_t>(stride) == rowBytes) {
+            std::memcpy(frame.pixels.data(), pixels, frame.pixels.size());
+        } else {
+            for (int y = 0; y < height; y++) {
+                std::memcpy(frame.pixels.data() + rowBytes * y, pixels + static_cast<size_t>(stride) * y, rowBytes);
+            }
+        }
+    }
+    frame.width = width;
+    frame.height = height;
+    frame.arrivalNs = arrivalNs > 0 ? arrivalNs : StatsNowNs();
+    frame.frameNumber = frameNumber;
+
+    ready_.TryPush(slot); // 槽位数等于队列容量，不会满
+    submitted_.fetch_add(1, std::memory_order_relaxed);
+    signal_.Notify();
+    return true;
+}
+
+void FrameRecorder::WriteLoop() {
+    for (;;) {
+        const uint32_t seen = signal_.Sequence();
+        uint32_t slot;
+        if (!ready_.TryPop(&slot)) {
+            // 停止时先写完排队中的帧
+            if (stopping_.load(std::memory_order_acquire)) return;
+            signal_.Wait(seen);
+            continue;
+        }
+        if (!failed_.load(std::memory_order_relaxed) && !WriteFrame(slots_[slot])) {
+            failed_.store(true, std::memory_order_relaxed);
+        }
+        free_.TryPush(slot);
+    }
+}
+
+bool FrameRecorder::WriteFrame(const Slot& slot) {
+    const int64_t start = StatsNowNs();
+    TRACE_SCOPE("recorder_write");
+    {
+        const cv::Mat bgra(slot.height, slot.width, CV_8UC4, const_cast<uint8_t*>(slot.pixels.data()));
+        cv::cvtColor(bgra, current_, cv::COLOR_BGRA2BGR); // 尺寸不变时复用 current_
+    }
+
+    const bool keyframe = previous_.empty() || previous_.cols != current_.cols || previous_.rows != current_.rows ||
+                          sinceKeyframe_ >= keyframeInterval_;
+    payload_.clear();
+    if (keyframe) {
+        EncodeKeyframe(current_.data, current_.cols, current_.rows, &scratch_, &payload_);
+        sinceKeyframe_ = 1;
+    } else {
+        EncodeDeltaFrame(current_.data, previous_.data, current_.cols, current_.rows, &scratch_, &payload_);
+        sinceKeyframe_++;
+    }
+
+    FrameChunkHeader chunk = {};
+    chunk.magic = kFrameChunkMagic;
+    chunk.type = keyframe ? kFrameChunkKeyframe : kFrameChunkDelta;
+    chunk.width = current_.cols;
+    chunk.height = current_.rows;
+    chunk.frameNumber = slot.frameNumber;
+    chunk.arrivalNs = slot.arrivalNs;
+    chunk.payloadSize = payload_.size();
+
+    FrameIndexEntry entry = {};
+    entry.offset = offset_;
+    entry.arrivalNs = slot.arrivalNs;
+    entry.type = chunk.type;
+    entry.width = chunk.width;
+    entry.height = chunk.height;
+    if (!WriteBytes(&chunk, sizeof(chunk)) || !WriteBytes(payload_.data(), payload_.size())) return false;
+    index_.push_back(entry);
+    std::swap(current_, previous_);
+
+    const long long elapsed = StatsNowNs() - start;
+    written_.fetch_add(1, std::memory_order_relaxed);
+    if (keyframe) keyframes_.fetch_add(1, std::memory_order_relaxed);
+    rawBytes_.fetch_add(static_cast<long long>(previous_.total() * previous_.elemSize()), std::memory_order_relaxed);
+    lastEncodeNs_.store(elapsed, std::memory_order_relaxed);
+    if (elapsed > maxEncodeNs_.load(std::memory_order_relaxed)) {
+        maxEncodeNs_.store(elapsed, std::memory_order_relaxed);
+    }
+    return true;
+}
+
+bool FrameRecorder::WriteBytes(const void* data, size_t size) {
+    if (size > 0 && std::fwrite(data, 1, size, file_) != size) return false;
+    offset_ += size;
+    bytesWritten_.store(static_cast<long long>(offset_), std::memory_order_relaxed);
+    return true;
+}
+
+bool FrameRecorder::Stop() {
+    if (!file_) return !failed_.load();
+    stopping_.store(true);
+    // 等进行中的 Submit 把帧放入队列 (最多一次整帧复制)
+    while (submitting_.load() != 0) {
+        std::this_thread::yield();
+    }
+    signal_.Notify();
+    if (thread_.joinable()) thread_.join();
+    running_.store(false, std::memory_order_release);
+
+    // 写入线程可能在最后一帧入队之前就已看到 stopping_ 并退出，剩余的帧在这里写完
+    uint32_t slot;
+    while (ready_.TryPop(&slot)) {
+        if (!failed_.load(std::memory_order_relaxed) && !WriteFrame(slots_[slot])) {
+            failed_.store(true, std::memory_order_relaxed);
+        }
+        free_.TryPush(slot);
+    }
+
+    bool ok = !failed_.load();
+    if (ok) {
+        FrameRecordFooter footer = {};
+        footer.indexOffset = offset_;
+        footer.frameCount = index_.size();
+        footer.magic = kFrameFooterMagic;
+        ok = WriteBytes(index_.data(), index_.size() * sizeof(FrameIndexEntry)) &&
+             WriteBytes(&footer, sizeof(footer));
+    }
+    if (std::fclose(file_) != 0) ok = false;
+    file_ = nullptr;
+    if (!ok) failed_.store(true);
+    return ok;
+}
+
+void FrameRecorder::GetStats(RecorderStats* out) const {
+    out->submitted = submitted_.load(std::memory_order_relaxed);
+    out->written = written_.load(std::memory_order_relaxed);
+    out->dropped = dropped_.load(std::memory_order_relaxed);
+    out->keyframes = keyframes_.load(std::memory_order_relaxed);
+    out->bytesWritten = bytesWritten_.load(std::memory_order_relaxed);
+    out->rawBytes = rawBytes_.load(std::memory_order_relaxed);
+    out->lastEncodeNs = lastEncodeNs_.load(std::memory_order_relaxed);
+    out->maxEncodeNs = maxEncodeNs_.load(std::memory_order_relaxed);
+    out->recording = running_.load(std::memory_order_relaxed) && !stopping_.load(std::memory_order_relaxed) ? 1 : 0;
+    out->failed = failed_.load(std::memory_order_relaxed) ? 1 : 0;
+}
+
+bool FrameRecordReader::Open(const std::string& path, std::string* error) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    index_.clear();
+    cachedIndex_ = -1;
+    file_.close();
+    file_.clear();
+    file_.open(path, std::ios::binary);
+    if (!file_) {
+        if (error) *error = "cannot open " + path;
+        return false;
+    }
+    file_.seekg(0, std::ios::end);
+    fileSize_ = static_cast<uint64_t>(file_.tellg());
+
+    FrameRecordHeader header;
+    if (!ReadAt(0, &header, sizeof(header)) ||
+        std::memcmp(header.magic, kFrameRecordMagic, sizeof(header.magic)) != 0) {
+        if (error) *error = path + ": not a frame recording";
+        return false;
+    }
+    if (header.version < 1 || header.version > kFrameRecordVersion || header.headerSize < sizeof(FrameRecordHeader) ||
+        header.chunkHeaderSize != sizeof(FrameChunkHeader) || header.tileSize != kFrameCodecTile) {
+        if (error) *error = path + ": unsupported recording version";
+        return false;
+    }
+    codec_ = header.version == 1 ? FRAME_RESIDUAL_ZERO_RUN : FRAME_RESIDUAL_LZ;
+    // 正常停止的录制带索引；否则 (进程中途退出) 扫描重建
+    if (!ReadIndex(header.headerSize)) {
+        ScanChunks(header.headerSize);
+    }
+    if (index_.empty() || index_[0].type != kFrameChunkKeyframe) {
+        index_.clear();
+        if (error) *error = path + ": no readable frames";
+        return false;
+    }
+    return true;
+}
+
+bool FrameRecordReader::ReadAt(uint64_t offset, void* data, size_t size) {
+    if (offset > fileSize_ || size > fileSize_ - offset) return false;
+    file_.clear();
+    file_.seekg(static_cast<std::streamoff>(offset));
+    file_.read(static_cast<char*>(data), static_cast<std::streamsize>(size));
+    return static_cast<bool>(file_);
+}
+
+bool FrameRecordReader::ValidChunk(const FrameChunkHeader& chunk, uint64_t offset, uint64_t end) const {
+    return chunk.magic == kFrameChunkMagic &&
+           (chunk.type == kFrameChunkKeyframe || chunk.type == kFrameChunkDelta) && chunk.width > 0 &&
+           chunk.height > 0 && offset + sizeof(FrameChunkHeader) <= end &&
+           chunk.payloadSize <= end - offset - sizeof(FrameChunkHeader);
+}
+
+bool FrameRecordReader::ReadIndex(uint64_t dataStart) {
+    FrameRecordFooter footer;
+    if (fileSize_ < dataStart + sizeof(footer) || !ReadAt(fileSize_ - sizeof(footer), &footer, sizeof(footer)) ||
+        footer.magic != kFrameFooterMagic || footer.indexOffset < dataStart ||
+        footer.frameCount > (fileSize_ - sizeof(footer) - footer.indexOffset) / sizeof(FrameIndexEntry) ||
+        footer.indexOffset + footer.frameCount * sizeof(FrameIndexEntry) + sizeof(footer) != fileSize_) {
+        return false;
+    }
+    index_.resize(footer.frameCount);
+    if (!index_.empty() && !ReadAt(footer.indexOffset, index_.data(), index_.size() * sizeof(FrameIndexEntry))) {
+        index_.clear();
+        return false;
+    }
+    for (const FrameIndexEntry& entry : index_) {
+        if (entry.offset < dataStart || entry.offset >= footer.indexOffset ||
+            (entry.type != kFrameChunkKeyframe && entry.type != kFrameChunkDelta)) {
+            index_.clear();
+            return false;
+        }
+    }
+    return true;
+}
+
+void FrameRecordReader::ScanChunks(uint64_t dataStart) {
+    index_.clear();
+    uint64_t offset = dataStart;
+    FrameChunkHeader chunk;
+    // 遇到第一个不完整或损坏的块即停止 (通常是中途退出时写了一半的最后一块)
+    while (ReadAt(offset, &chunk, sizeof(chunk)) && ValidChunk(chunk, offset, fileSize_)) {
+        FrameIndexEntry entry = {};
+        entry.offset = offset;
+        entry.arrivalNs = chunk.arrivalNs;
+        entry.type = chunk.type;
+        entry.width = chunk.width;
+        entry.height = chunk.height;
+        index_.push_back(entry);
+        offset += sizeof(chunk) + chunk.payloadSize;
+    }
+}
+
+bool FrameRecordReader::DecodeChunk(int index) {
+    const FrameIndexEntry& entry = index_[index];
+    FrameChunkHeader chunk;
+    if (!ReadAt(entry.offset, &chunk, sizeof(chunk)) || !ValidChunk(chunk, entry.offset, fileSize_) ||
+        chunk.type != entry.type || chunk.width != entry.width || chunk.height != entry.height) {
+        return false;
+    }
+    payload_.resize(static_cast<size_t>(chunk.payloadSize));
+    if (!ReadAt(entry.offset + sizeof(chunk), payload_.data(), payload_.size())) return false;
+
+    if (chunk.type == kFrameChunkKeyframe) {
+        cached_.create(chunk.height, chunk.width, CV_8UC3);
+        return DecodeKeyframe(payload_.data(), payload_.size(), chunk.width, chunk.height, &scratch_, cached_.data,
+                              codec_);
+    }
+    // 差分帧基于上一帧 (调用方保证 cached_ 为 index - 1)
+    if (cached_.cols != chunk.width || cached_.rows != chunk.height) return false;
+    return DecodeDeltaFrame(payload_.data(), payload_.size(), chunk.width, chunk.height, &scratch_, cached_.data,
+                            codec_);
+}
+
+bool FrameRecordReader::Read(int index, cv::Mat* frame) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (index < 0 || index >= FrameCount()) return false;
+
+    int keyframe = index;
+    while (keyframe > 0 && index_[keyframe].type != kFrameChunkKeyframe) {
+        keyframe--;
+    }
+    // 缓存的帧与目标在同一关键帧之后且不晚于目标时从缓存继续，否则从关键帧重新解码
+    int next = keyframe;
+    if (cachedIndex_ >= keyframe && cachedIndex_ <= index) {
+        next = cachedIndex_ + 1;
+    }
+    for (int i = next; i <= index; i++) {
+        if (!DecodeChunk(i)) {
+            cachedIndex_ = -1;
+            return false;
+        }
+        cachedIndex_ = i;
+    }
+    cached_.copyTo(*frame);
+    return true;
+}
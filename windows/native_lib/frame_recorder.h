@@ -0,0 +1,193 @@
+#ifndef FRAME_RECORDER_H
+#define FRAME_RECORDER_H
+
+#include "frame_codec.h"
+#include "image_search.h"
+#include "spsc_queue.h"
+
+#include <opencv2/core.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// 帧录制文件 (.frec) 格式
+//
+// 截图帧按写入顺序依次存为块，每块是 FrameChunkHeader + 压缩数据 (编码见 frame_codec.h)。
+// 第一帧、每隔 keyframeInterval 帧以及帧尺寸变化时写关键帧，其余帧为相对上一写入帧的差分帧。
+// 停止录制时在末尾追加索引 (每帧一项) 与 FrameRecordFooter，读取端据此按帧下标随机访问；
+// 进程中途退出导致没有索引时，读取端顺序扫描重建索引，已完整写入的块都能读出。
+//
+// 布局 (小端序):
+//     FrameRecordHeader
+//     (FrameChunkHeader + 压缩数据)[frameCount]
+//     FrameIndexEntry[frameCount]
+//     FrameRecordFooter
+
+static const char kFrameRecordMagic[8] = {'F', 'R', 'A', 'M', 'E', 'R', 'E', 'C'};
+// 版本 2: 残差改为 LZ 压缩 (FRAME_RESIDUAL_LZ)；读取端仍接受版本 1 (零游程) 的文件
+static const uint32_t kFrameRecordVersion = 2;
+static const uint32_t kFrameChunkMagic = 0x4b484346;  // "FCHK"
+static const uint32_t kFrameFooterMagic = 0x58444946; // "FIDX"
+
+// 块类型 (FrameChunkHeader::type)
+static const uint32_t kFrameChunkKeyframe = 1;
+static const uint32_t kFrameChunkDelta = 2;
+
+struct FrameRecordHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t headerSize;        // sizeof(FrameRecordHeader)，用于向后兼容扩展
+    uint32_t chunkHeaderSize;   // sizeof(FrameChunkHeader)
+    uint32_t tileSize;          // 差分帧的块边长 (kFrameCodecTile)
+    uint32_t keyframeInterval;
+    uint32_t reserved;
+    int64_t startNs;            // 录制开始时间 (StatsNowNs 时基)
+};
+
+struct FrameChunkHeader {
+    uint32_t magic;             // kFrameChunkMagic
+    uint32_t type;
+    int32_t width;              // 像素固定为 BGR (8 位 3 通道)
+    int32_t height;
+    int64_t frameNumber;        // 提交序号 (从 1 开始，被丢弃的帧也占号，可据此看出丢了哪些帧)
+    int64_t arrivalNs;          // 帧到达时间 (同 automation_submit_frame)
+    uint64_t payloadSize;
+};
+
+struct FrameIndexEntry {
+    uint64_t offset;            // 块头相对文件开头的偏移
+    int64_t arrivalNs;
+    uint32_t type;
+    int32_t width;
+    int32_t height;
+    uint32_t reserved;
+};
+
+struct FrameRecordFooter {
+    uint64_t indexOffset;
+    uint64_t frameCount;
+    uint32_t magic;             // kFrameFooterMagic
+    uint32_t reserved;
+};
+
+// 截图帧录制器
+//
+//   截图回调 (Submit)  ->  写入线程
+//     复制 BGRA            BGRA -> BGR 转换、关键帧 / 差分编码、写盘
+//
+// 两者之间是按提交顺序的有界无锁队列，槽位在首次使用时按帧尺寸分配，之后复用。
+// 队列满时 Submit 丢弃新帧并计数，不等待写入线程，截图线程因此不会被磁盘或编码拖慢；
+// 差分帧总是相对上一写入帧，丢帧不影响解码。写入出错 (磁盘满等) 后不再写盘，只归还槽位。
+class FrameRecorder {
+public:
+    FrameRecorder();
+    ~FrameRecorder();
+
+    FrameRecorder(const FrameRecorder&) = delete;
+    FrameRecorder& operator=(const FrameRecorder&) = delete;
+
+    // 创建文件并启动写入线程；keyframeInterval <= 0 时使用默认值
+    bool Start(const std::string& path, int keyframeInterval, std::string* error = nullptr);
+
+    // 复制一帧 BGRA；只能在一个线程上调用 (截图回调)。未在录制或队列满时返回 false
+    bool Submit(const uint8_t* pixels, int width, int height, int stride, int64_t arrivalNs);
+
+    // 写完排队中的帧，追加索引与文件尾后关闭文件；返回 false 表示写入出错
+    // 可与 Submit 并发: 已被接受 (返回 true) 的帧都会写入文件
+    bool Stop();
+
+    void GetStats(RecorderStats* out) const;
+
+    static const int kDefaultKeyframeInterval = 60;
+
+private:
+    // 写入线程最多落后的帧数 (1440p 下每个槽位约 14 MB)
+    static const size_t kQueueDepth = 4;
+
+    struct Slot {
+        std::vector<uint8_t> pixels; // BGRA，行紧密排列
+        int width = 0;
+        int height = 0;
+        int64_t arrivalNs = 0;
+        int64_t frameNumber = 0;
+    };
+
+    bool Enqueue(const uint8_t* pixels, int width, int height, int stride, int64_t arrivalNs);
+    void WriteLoop();
+    bool WriteFrame(const Slot& slot);
+    bool WriteBytes(const void* data, size_t size);
+
+    Slot slots_[kQueueDepth];
+    SpscQueue<uint32_t, kQueueDepth> ready_;  // 截图线程提交，写入线程按顺序取出
+    SpscQueue<uint32_t, kQueueDepth> free_;   // 写入线程归还，截图线程取用
+    WakeSignal signal_;
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+    std::atomic<bool> stopping_{false};
+    std::atomic<int> submitting_{0};          // 已通过 stopping_ 检查、尚未入队的 Submit 数
+    int64_t nextFrameNumber_ = 1;             // 截图线程独占
+
+    // 以下由写入线程独占 (Start / Stop 在线程启动前 / 退出后访问)
+    FILE* file_ = nullptr;
+    int keyframeInterval_ = kDefaultKeyframeInterval;
+    int sinceKeyframe_ = 0;
+    uint64_t offset_ = 0;
+    cv::Mat current_;                         // BGR
+    cv::Mat previous_;                        // 上一写入帧，差分的基准
+    FrameCodecScratch scratch_;
+    std::vector<uint8_t> payload_;
+    std::vector<FrameIndexEntry> index_;
+
+    std::atomic<long long> submitted_{0};
+    std::atomic<long long> written_{0};
+    std::atomic<long long> dropped_{0};
+    std::atomic<long long> keyframes_{0};
+    std::atomic<long long> bytesWritten_{0};
+    std::atomic<long long> rawBytes_{0};
+    std::atomic<long long> lastEncodeNs_{0};
+    std::atomic<long long> maxEncodeNs_{0};
+    std::atomic<bool> failed_{false};
+};
+
+// 录制文件的读取器 (回放工具使用)
+// 按帧下标随机访问: 从不晚于目标帧的最近关键帧开始依次解码差分帧；
+// 缓存最近解码的一帧，顺序读取时每帧只解码一次。Read 可在多个线程上调用 (内部串行)。
+class FrameRecordReader {
+public:
+    // 打开并读取索引 (缺少索引时扫描各块重建)，失败返回 false (error 可为空，写入原因)
+    bool Open(const std::string& path, std::string* error = nullptr);
+
+    int FrameCount() const { return static_cast<int>(index_.size()); }
+
+    // 第 index 帧的到达时间与尺寸 (来自块头，不解码)
+    int64_t ArrivalNs(int index) const { return index_[index].arrivalNs; }
+    cv::Size FrameSize(int index) const { return cv::Size(index_[index].width, index_[index].height); }
+
+    // 解码第 index 帧到 frame (BGR)；文件损坏或下标越界时返回 false
+    bool Read(int index, cv::Mat* frame);
+
+private:
+    bool ReadIndex(uint64_t dataStart);
+    void ScanChunks(uint64_t dataStart);
+    bool ReadAt(uint64_t offset, void* data, size_t size);
+    bool ValidChunk(const FrameChunkHeader& chunk, uint64_t offset, uint64_t end) const;
+    bool DecodeChunk(int index);
+
+    std::mutex mutex_;
+    std::ifstream file_;
+    uint64_t fileSize_ = 0;
+    std::vector<FrameIndexEntry> index_;
+    cv::Mat cached_;                          // 最近解码的一帧 (BGR)
+    int cachedIndex_ = -1;
+    std::vector<uint8_t> payload_;
+    FrameCodecScratch scratch_;
+    FrameResidualCodec codec_ = FRAME_RESIDUAL_LZ; // 由文件版本决定
+};
+
+#endif // FRAME_RECORDER_H
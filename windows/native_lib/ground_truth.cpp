@@ -0,0 +1,141 @@
+#include "ground_truth.h"
+#include "json_value.h"
+#include "scenario.h"
+
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <sstream>
+
+// 读取对象中的整数字段；不存在时保持 *out 不变
+static bool ReadInt(const JsonValue& item, const char* key, int* out) {
+    const JsonValue* value = item.Find(key);
+    if (!value) return true;
+    if (!value->IsNumber()) return false;
+    *out = static_cast<int>(value->AsNumber());
+    return true;
+}
+
+bool ParseGroundTruth(const std::string& text, const std::string& baseDir, GroundTruth* out, std::string* error) {
+    JsonValue root;
+    std::string parseError;
+    if (!JsonValue::Parse(text, &root, &parseError)) {
+        return SetError(error, "invalid JSON: " + parseError);
+    }
+    if (!root.IsObject()) return SetError(error, "ground truth must be a JSON object");
+
+    GroundTruth truth;
+    std::map<std::string, int> templateIndex;
+    const JsonValue* templates = root.Find("templates");
+    if (!templates || !templates->IsArray() || templates->Items().empty()) {
+        return SetError(error, "\"templates\" must be a non-empty array");
+    }
+    for (const JsonValue& item : templates->Items()) {
+        const std::string where = "template " + std::to_string(truth.templates.size());
+        if (!item.IsObject()) return SetError(error, where + ": must be an object");
+
+        GroundTruthTemplate templ;
+        const JsonValue* name = item.Find("name");
+        const JsonValue* path = item.Find("path");
+        if (!name || !name->IsString() || name->AsString().empty()) {
+            return SetError(error, where + ": \"name\" is required");
+        }
+        if (!path || !path->IsString() || path->AsString().empty()) {
+            return SetError(error, where + ": \"path\" is required");
+        }
+        templ.name = name->AsString();
+        templ.path = JoinPath(baseDir, path->AsString());
+        if (!templateIndex.emplace(templ.name, static_cast<int>(truth.templates.size())).second) {
+            return SetError(error, where + ": duplicate name \"" + templ.name + "\"");
+        }
+
+        SearchRequest& request = templ.request;
+        request.templateId = static_cast<int>(truth.templates.size()) + 1;
+        request.method = SEARCH_METHOD_CCOEFF_NORMED;
+        request.threshold = 0.8;
+        std::string fieldError;
+        if (!ParseSearchRequestFields(item, &request, &fieldError)) return SetError(error, where + ": " + fieldError);
+        truth.templates.push_back(templ);
+    }
+
+    const JsonValue* frames = root.Find("frames");
+    if (!frames || !frames->IsArray()) return SetError(error, "\"frames\" must be an array");
+    for (const JsonValue& item : frames->Items()) {
+        const std::string where = "frame " + std::to_string(truth.frames.size());
+        if (!item.IsObject()) return SetError(error, where + ": must be an object");
+
+        GroundTruthFrame frame;
+        const JsonValue* image = item.Find("image");
+        if (!image || !image->IsString() || image->AsString().empty()) {
+            return SetError(error, where + ": \"image\" is required");
+        }
+        frame.image = JoinPath(baseDir, image->AsString());
+        if (const JsonValue* objects = item.Find("objects")) {
+            if (!objects->IsArray()) return SetError(error, where + ": \"objects\" must be an array");
+            for (const JsonValue& entry : objects->Items()) {
+                const JsonValue* name = entry.Find("template");
+                if (!name || !name->IsString()) return SetError(error, where + ": object needs \"template\"");
+                auto it = templateIndex.find(name->AsString());
+                if (it == templateIndex.end()) {
+                    return SetError(error, where + ": unknown template \"" + name->AsString() + "\"");
+                }
+                GroundTruthObject object;
+                object.templateIndex = it->second;
+                if (!entry.Find("x") || !entry.Find("y") || !ReadInt(entry, "x", &object.x) ||
+                    !ReadInt(entry, "y", &object.y) || !ReadInt(entry, "w", &object.width) ||
+                    !ReadInt(entry, "h", &object.height)) {
+                    return SetError(error, where + ": object needs numeric \"x\" / \"y\" (and optional \"w\" / \"h\")");
+                }
+                frame.objects.push_back(object);
+            }
+        }
+        truth.frames.push_back(std::move(frame));
+    }
+
+    *out = std::move(truth);
+    return true;
+}
+
+bool LoadGroundTruth(const std::string& path, GroundTruth* out, std::string* error) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return SetError(error, "cannot open " + path);
+    std::ostringstream text;
+    text << file.rdbuf();
+
+    const size_t slash = path.find_last_of("/\\");
+    const std::string baseDir = slash == std::string::npos ? std::string() : path.substr(0, slash + 1);
+    return ParseGroundTruth(text.str(), baseDir, out, error);
+}
+
+bool SaveGroundTruth(const std::string& path, const GroundTruth& truth, std::string* error) {
+    std::ostringstream json;
+    json << "{\n  \"templates\": [\n";
+    for (size_t i = 0; i < truth.templates.size(); i++) {
+        const GroundTruthTemplate& templ = truth.templates[i];
+        const SearchRequest& request = templ.request;
+        json << "    { \"name\": " << JsonQuote(templ.name) << ", \"path\": " << JsonQuote(templ.path)
+             << ", \"threshold\": " << request.threshold << ", \"roi\": [" << request.roiX << ", " << request.roiY
+             << ", " << request.roiW << ", " << request.roiH << "] }" << (i + 1 < truth.templates.size() ? "," : "")
+             << "\n";
+    }
+    json << "  ],\n  \"frames\": [\n";
+    // 每帧一行，便于按行对比两次生成的结果
+    for (size_t i = 0; i < truth.frames.size(); i++) {
+        const GroundTruthFrame& frame = truth.frames[i];
+        json << "    { \"image\": " << JsonQuote(frame.image) << ", \"objects\": [";
+        for (size_t k = 0; k < frame.objects.size(); k++) {
+            const GroundTruthObject& object = frame.objects[k];
+            json << (k > 0 ? ", " : "") << "{ \"template\": "
+                 << JsonQuote(truth.templates[object.templateIndex].name) << ", \"x\": " << object.x
+                 << ", \"y\": " << object.y << ", \"w\": " << object.width << ", \"h\": " << object.height << " }";
+        }
+        json << "] }" << (i + 1 < truth.frames.size() ? "," : "") << "\n";
+    }
+    json << "  ]\n}\n";
+
+    std::ofstream file(path, std::ios::binary);
+    if (!file) return SetError(error, "cannot create " + path);
+    file << json.str();
+    if (!file.flush()) return SetError(error, "cannot write " + path);
+    return true;
+}
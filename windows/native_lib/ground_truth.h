@@ -0,0 +1,61 @@
+#ifndef GROUND_TRUTH_H
+#define GROUND_TRUTH_H
+
+#include "image_search.h"
+
+#include <string>
+#include <vector>
+
+// 标注帧集 (JSON): 每帧中出现了哪些模板、在哪里
+//
+// {
+//   "templates": [
+//     { "name": "boss", "path": "templates/boss.png", "threshold": 0.8, "roi": [0, 0, 0, 0] }
+//   ],
+//   "frames": [
+//     { "image": "frames/000000.png",
+//       "objects": [ { "template": "boss", "x": 120, "y": 300, "w": 64, "h": 64 } ] }
+//   ]
+// }
+//
+// templates: 要查找的模板；name 必填且唯一，path 相对标注文件所在目录，
+//            threshold 默认 0.8，roi 省略或 w/h <= 0 表示整帧
+// frames:    image 相对标注文件所在目录；objects 列出帧中出现的全部模板实例，
+//            x / y / w / h 为实例在帧中的外接矩形 (缩放过的实例 w / h 与模板尺寸不同，省略时取模板尺寸)。
+//            未列出的模板视为不在该帧中。
+// 评估工具 (tools/accuracy_harness) 读取该格式，合成帧生成器输出同一格式。
+
+struct GroundTruthTemplate {
+    std::string name;
+    std::string path;          // 读取时已按标注文件目录解析
+    SearchRequest request = {}; // roi 与 threshold；templateId 为模板下标 + 1，method 由评估方决定
+};
+
+struct GroundTruthObject {
+    int templateIndex = 0;
+    int x = 0;
+    int y = 0;
+    int width = 0;             // 标注中省略时为 0，表示与模板同尺寸
+    int height = 0;
+};
+
+struct GroundTruthFrame {
+    std::string image;         // 读取时已按标注文件目录解析
+    std::vector<GroundTruthObject> objects;
+};
+
+struct GroundTruth {
+    std::vector<GroundTruthTemplate> templates;
+    std::vector<GroundTruthFrame> frames;
+};
+
+// 解析标注文本；baseDir 为相对路径的基准目录 (可为空)
+bool ParseGroundTruth(const std::string& text, const std::string& baseDir, GroundTruth* out, std::string* error);
+
+// 读取并解析标注文件
+bool LoadGroundTruth(const std::string& path, GroundTruth* out, std::string* error);
+
+// 写出标注文件；路径按原样写入 (调用方给出相对标注文件目录的路径)
+bool SaveGroundTruth(const std::string& path, const GroundTruth& truth, std::string* error);
+
+#endif // GROUND_TRUTH_H
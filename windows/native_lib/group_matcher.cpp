@@ -0,0 +1,93 @@
+#include "group_matcher.h"
+
+#include <chrono>
+#include <vector>
+
+static int64_t NowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+bool RunKernelGroup(const ImageView& area, KernelJob* jobs, int count, SlidingWindowStats* scratch,
+                    bool timed) {
+    if (count <= 0) {
+        return false;
+    }
+    const ImageView& first = jobs[0].templ;
+
+    bool needSquares = false;
+    for (int i = 0; i < count; i++) {
+        needSquares |= jobs[i].method == KERNEL_METHOD_NCC;
+    }
+    const int64_t resetStart = timed ? NowNs() : 0;
+    if (first.channels != area.channels || !scratch->Reset(area, first.width, first.height, needSquares)) {
+        return false;
+    }
+    int64_t statsNs = timed ? NowNs() - resetStart : 0;
+
+    // 每个任务的行间状态；组通常只有几个请求，线程局部缓冲避免每批分配
+    thread_local std::vector<SsdMatchResult> ssdStates;
+    thread_local std::vector<NccMatchResult> nccStates;
+    thread_local std::vector<int64_t> ssdLimits;
+    thread_local std::vector<int64_t> jobNs;
+    ssdStates.resize(count);
+    nccStates.resize(count);
+    ssdLimits.resize(count);
+    jobNs.assign(count, 0);
+    for (int i = 0; i < count; i++) {
+        if (jobs[i].method == KERNEL_METHOD_SSD) {
+            ssdLimits[i] = SsdLimitFromThreshold(jobs[i].threshold, jobs[i].sums->area, jobs[i].templ.channels);
+            BeginSsdSearch(ssdLimits[i], &ssdStates[i]);
+        } else {
+            BeginNccSearch(&nccStates[i]);
+        }
+    }
+
+    do {
+        const int32_t* sums = scratch->Sums();
+        const int64_t* squares = scratch->SquareSums();
+        for (int i = 0; i < count; i++) {
+            const KernelJob& job = jobs[i];
+            const int64_t start = timed ? NowNs() : 0;
+            if (job.method == KERNEL_METHOD_SSD) {
+                SsdMatchRow(area, job.templ, *job.sums, sums, scratch->Cols(), scratch->Row(),
+                            ssdLimits[i], &ssdStates[i]);
+            } else {
+                NccMatchRow(area, *job.sums, *job.ncc, sums, squares, scratch->Cols(), scratch->Row(),
+                            &nccStates[i]);
+            }
+            if (timed) jobNs[i] += NowNs() - start;
+        }
+        const int64_t advanceStart = timed ? NowNs() : 0;
+        const bool more = scratch->Advance();
+        if (timed) statsNs += NowNs() - advanceStart;
+        if (!more) break;
+    } while (true);
+
+    const int64_t templPixels = static_cast<int64_t>(first.width) * first.height;
+
+    for (int i = 0; i < count; i++) {
+        KernelJob& job = jobs[i];
+        if (job.method == KERNEL_METHOD_SSD) {
+            const SsdMatchResult& state = ssdStates[i];
+            job.found = state.found;
+            job.x = state.x;
+            job.y = state.y;
+            job.score = state.found ? SsdToScore(state.ssd, job.sums->area, job.templ.channels) : 0.0;
+            job.positions = state.positions;
+            job.pixelsScanned = state.pixelsCompared / job.templ.channels;
+            job.rejectedByBound = state.rejectedByBound;
+        } else {
+            const NccMatchResult& state = nccStates[i];
+            job.found = state.x >= 0 && state.score >= job.threshold;
+            job.x = state.x;
+            job.y = state.y;
+            job.score = state.score;
+            job.positions = state.positions;
+            job.pixelsScanned = state.positions * templPixels;
+            job.rejectedByBound = 0;
+        }
+        job.timeNs = timed ? jobNs[i] + statsNs / count : 0;
+    }
+    return true;
+}
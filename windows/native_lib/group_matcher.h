@@ -0,0 +1,48 @@
+#ifndef GROUP_MATCHER_H
+#define GROUP_MATCHER_H
+
+#include "image_view.h"
+#include "ncc_matcher.h"
+#include "ssd_matcher.h"
+#include "window_stats.h"
+
+// 共享窗口统计的分组匹配
+//
+// 同一 ROI、同一模板尺寸、同一通道数的请求 (例如一排同尺寸技能图标) 需要完全相同的
+// 源图滑动窗口和 / 平方和。组内逐行推进一次 SlidingWindowStats，
+// 然后把这一行的统计依次交给组内每个模板的相关计算，避免每个请求各自重算。
+
+enum KernelMethod {
+    KERNEL_METHOD_SSD = 0,
+    KERNEL_METHOD_NCC = 1,
+};
+
+// 组内单个匹配任务 (输入 + 输出)
+struct KernelJob {
+    // 输入
+    ImageView templ;
+    const TemplateSums* sums = nullptr;
+    const NccTemplate* ncc = nullptr;  // 仅 KERNEL_METHOD_NCC 需要
+    KernelMethod method = KERNEL_METHOD_NCC;
+    double threshold = 0.0;
+
+    // 输出 (坐标相对 ROI 左上角)
+    bool found = false;
+    int x = -1;
+    int y = -1;
+    double score = 0.0;
+
+    // 代价统计
+    int64_t positions = 0;       // 评估的候选位置数
+    int64_t pixelsScanned = 0;   // 参与比较的模板像素次数 (SSD 为剪枝后的实际值)
+    int64_t rejectedByBound = 0; // 被 SSD 窗口和下界直接淘汰的位置数
+    int64_t timeNs = 0;          // 耗时 (仅 timed 时统计；窗口统计的耗时平均分摊到组内各任务)
+};
+
+// 对同一 ROI 执行一组尺寸相同的任务
+// 所有任务的模板宽高与通道数必须一致；返回 false 表示 ROI 小于模板
+// timed: 是否逐任务计时 (每行每任务读取两次时钟，默认关闭)
+bool RunKernelGroup(const ImageView& area, KernelJob* jobs, int count, SlidingWindowStats* scratch,
+                    bool timed = false);
+
+#endif // GROUP_MATCHER_H
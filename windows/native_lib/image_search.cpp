@@ -1,21 +1,198 @@
 #define NOMINMAX
 #include "image_search.h"
+#include "automation.h"
+#include "buffer_pool.h"
+#include "debug_sink.h"
+#include "frame_recorder.h"
+#include "scenario.h"
+#include "search_plan.h"
+#include "search_stats.h"
+#include "snapshot_ptr.h"
+#include "template_entry.h"
+#include "template_pack.h"
+#include "tiled_matcher.h"
+#include "trace.h"
+#include "work_stealing_pool.h"
+#ifdef _WIN32
 #include <windows.h>
+#endif
 #include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
 #include <map>
+#include <memory>
 #include <mutex>
 #include <vector>
 #include <string>
 
-// 全局变量管理模板
-static std::map<int, cv::Mat> g_templates;
-static int g_nextTemplateId = 1;
-static std::mutex g_mutex;
-static cv::Mat g_lastCapture;
+typedef std::map<int, std::shared_ptr<const TemplateEntry>> TemplateMap;
+
+// 引擎实例: 模板表、输入缓冲池、运行期统计与最近一次批次统计各自独立，
+// 同一进程中的多个会话 (如同时挂机两个游戏窗口) 互不争用，模板 ID 也各自编号。
+// 按缓存行对齐，避免相邻分配的两个引擎的热字段落在同一缓存行。
+struct alignas(64) SearchEngine {
+    int id = 0;
+
+    // 模板表读多写少: 读者经 SnapshotPtr 取一份不可变快照，不加锁；
+    // 写者在 mutex 下复制、修改后整体替换 (写时复制)。
+    // 进行中的搜索持有旧快照，因此释放模板不会影响正在使用它的批次。
+    SnapshotPtr<const TemplateMap> templates{std::make_shared<const TemplateMap>()};
+    int nextTemplateId = 1;
+    std::mutex mutex; // 保护模板表的写入与 nextTemplateId
+
+    BatchDebugStats lastBatchStats = {};
+    std::mutex lastBatchStatsMutex; // 与 mutex 分开，批次结束时不与模板加载争用
+
+    // 设置了截止时间的批次中被跳过的请求 (按下标)，下一批次优先执行 (find_images_batch_ex 每次编译临时计划)
+    // 键为整个请求列表的字节，每个调用方各自的请求列表互不覆盖，同一模板的不同 ROI 也各自记录；
+    // 列表数超过 kMaxDeadlineLists 时全部丢弃
+    static const size_t kMaxDeadlineLists = 64;
+    std::map<std::string, std::vector<uint8_t>> deadlineSkipped;
+    std::mutex deadlineMutex;
+
+    BufferPool inputBuffers;
+    // 计划共同持有，引擎销毁后已编译的计划仍可记录
+    std::shared_ptr<SearchStatsRegistry> stats = std::make_shared<SearchStatsRegistry>();
+
+    // 当前模板表快照 (无锁)
+    std::shared_ptr<const TemplateMap> Snapshot() const {
+        return templates.Load();
+    }
+
+    // 写时复制: 复制当前表，由 update 修改后发布
+    // 调用方必须已持有 mutex
+    template <typename Update>
+    void UpdateTemplatesLocked(Update update) {
+        auto next = std::make_shared<TemplateMap>(*templates.Load());
+        update(*next);
+        templates.Store(std::move(next));
+    }
+};
+
+// 引擎注册表
+// 句柄 0 表示默认引擎 (旧的无句柄接口都作用于它)；
+// 其余句柄与计划 ID 一样编码了槽位与代数，销毁后旧句柄不会误命中新引擎。
+// 调用期间持有引擎的引用，engine_destroy 与进行中的调用并发也是安全的。
+static const int kMaxEngines = 64;
+static SnapshotPtr<SearchEngine> g_engines[kMaxEngines];
+static int g_engineGenerations[kMaxEngines] = {};
+static std::mutex g_engineMutex; // 仅保护创建 / 销毁时的槽位分配
+
+static std::atomic<int> g_nextTicket{1};
+
+// 编译好的查找计划注册表
+// 固定大小的槽位表，run_search_plan 无锁读取槽位并在执行期间持有计划的引用，
+// release_search_plan 只清空槽位，计划在最后一次执行结束后才析构；
+// 计划 ID 编码了槽位与代数，槽位被复用后旧 ID 不会误命中新计划
+static const int kMaxSearchPlans = 64;
+static SnapshotPtr<SearchPlan> g_plans[kMaxSearchPlans];
+static int g_planGenerations[kMaxSearchPlans] = {};
+static std::mutex g_planMutex; // 仅保护编译 / 释放时的槽位分配
+
+// 当前生效的自动化规则组
+// 截图回调每帧无锁读取一次；启动 / 停止在 g_automationMutex 下串行
+// 由场景启动时附带每条规则的信息 (名称、模板尺寸与动作)，同样在 g_automationMutex 下读写
+// g_governorConfig / g_frameBudgetUs 为 automation_set_governor / automation_set_frame_budget 设置的默认值
+static SnapshotPtr<Automation> g_automation;
+static std::vector<ScenarioRuleInfo> g_scenarioRules;
+static AutomationGovernorConfig g_governorConfig = {};
+static long long g_frameBudgetUs = 0;
+static std::mutex g_automationMutex;
+
+// 替换当前规则组: 先停止旧的 (返回后旧规则不再回调)，再发布新的
+// governor 为空时使用 g_governorConfig
+static void InstallAutomation(std::shared_ptr<Automation> automation, std::vector<ScenarioRuleInfo> scenarioRules,
+                              const AutomationGovernorConfig* governor = nullptr) {
+    std::lock_guard<std::mutex> lock(g_automationMutex);
+    std::shared_ptr<Automation> previous = g_automation.Load();
+    if (previous) {
+        previous->Stop();
+        // 在旧规则组自己的事件回调中替换 (如回调里调用 automation_stop): 匹配线程仍在其 Evaluate 中，
+        // 不能在这里等待它，也不能让最后一个引用在该线程上释放；交给共用线程池等线程退出后再释放
+        if (previous->OnPipelineThread()) {
+            SharedWorkers().Submit([previous] { previous->Stop(); });
+        }
+    }
+    if (automation) {
+        automation->SetGovernor(governor ? *governor : g_governorConfig);
+        automation->SetFrameBudget(g_frameBudgetUs * 1000);
+        automation->Start();
+    }
+    g_automation.Store(automation);
+    g_scenarioRules = std::move(scenarioRules);
+}
+
+// 当前的帧录制
+// 截图回调每帧无锁读取一次；开始 / 停止在 g_recorderMutex 下串行
+// g_lastRecorderStats 保存最近一次停止的录制的统计，供停止后查询
+static SnapshotPtr<FrameRecorder> g_recorder;
+static RecorderStats g_lastRecorderStats = {};
+static std::mutex g_recorderMutex;
+
+// 撤下并停止当前录制 (调用方持有 g_recorderMutex)；返回 false 表示写入出错
+static bool StopRecorderLocked() {
+    const std::shared_ptr<FrameRecorder> recorder = g_recorder.Load();
+    if (!recorder) return true;
+    // 先撤下再停止: 之后的截图回调不再提交到该录制
+    g_recorder.Store(nullptr);
+    const bool ok = recorder->Stop();
+    recorder->GetStats(&g_lastRecorderStats);
+    return ok;
+}
+
+// 把事件展开为 C 回调的参数
+static Automation::EventSink CallbackSink(AutomationEventCallback callback, void* userData) {
+    return [callback, userData](const AutomationEvent& event) {
+        callback(event.kind, event.rule, event.templateId, event.x, event.y, event.score,
+                 event.frameId, event.latencyNs, userData);
+    };
+}
+
+static void CopyString(const std::string& source, char* out, size_t size) {
+    if (!out || size == 0) return;
+    const size_t n = std::min(source.size(), size - 1);
+    std::memcpy(out, source.data(), n);
+    out[n] = 0;
+}
+
+// BMP 文件头与信息头 (与 BITMAPFILEHEADER / BITMAPINFOHEADER 布局一致)
+// 自行定义，解码路径不依赖 Windows 头文件
+#pragma pack(push, 2)
+struct BmpFileHeader {
+    uint16_t type;
+    uint32_t size;
+    uint16_t reserved1;
+    uint16_t reserved2;
+    uint32_t offBits;
+};
+#pragma pack(pop)
+
+struct BmpInfoHeader {
+    uint32_t size;
+    int32_t width;
+    int32_t height;
+    uint16_t planes;
+    uint16_t bitCount;
+    uint32_t compression;
+    uint32_t sizeImage;
+    int32_t xPelsPerMeter;
+    int32_t yPelsPerMeter;
+    uint32_t clrUsed;
+    uint32_t clrImportant;
+};
+
+static_assert(sizeof(BmpFileHeader) == 14, "BMP file header layout");
+static_assert(sizeof(BmpInfoHeader) == 40, "BMP info header layout");
+// 没有版本号的导出接口按该大小读取请求数组
+static_assert(sizeof(SearchRequest) == 32, "SearchRequest layout is part of the ABI");
+
+static const uint32_t kBmpCompressionRgb = 0; // BI_RGB
 
 // GDI 屏幕截图辅助函数
 // 将屏幕特定区域截图并转换为 cv::Mat
-// 返回的 cv::Mat 为 BGR (8UC3) 格式
+// 返回的 cv::Mat 为 BGR (8UC3) 格式；非 Windows 平台没有屏幕截图，返回空 Mat
+#ifdef _WIN32
 cv::Mat CaptureScreen(int x, int y, int w, int h) {
     HDC hScreenDC = GetDC(NULL);
     HDC hMemoryDC = CreateCompatibleDC(hScreenDC);
@@ -63,16 +240,277 @@ cv::Mat CaptureScreen(int x, int y, int w, int h) {
     if (!mat.empty()) {
         cv::cvtColor(mat, result, cv::COLOR_BGRA2BGR);
     }
-    
-    // 保存最后一次截图用于调试
-    g_lastCapture = result.clone();
 
     return result;
 }
+#else
+cv::Mat CaptureScreen(int, int, int, int) {
+    return cv::Mat();
+}
+#endif
+
+// 调试图片输出 (有意泄漏: 避免进程退出时在 DLL 卸载阶段等待写线程)
+static DebugSink& DebugImages() {
+    static DebugSink* sink = new DebugSink();
+    return *sink;
+}
+
+// 默认引擎 (有意不析构，与工作线程池一样避免 DLL 卸载阶段的析构顺序问题)
+static const std::shared_ptr<SearchEngine>& DefaultEngine() {
+    static std::shared_ptr<SearchEngine>* engine = new std::shared_ptr<SearchEngine>(std::make_shared<SearchEngine>());
+    return *engine;
+}
+
+// 按句柄查找引擎，句柄无效或已销毁时返回空指针
+static std::shared_ptr<SearchEngine> LookupEngine(int handle) {
+    if (handle == 0) return DefaultEngine();
+    if (handle < 0) return nullptr;
+    std::shared_ptr<SearchEngine> engine = g_engines[(handle - 1) % kMaxEngines].Load();
+    return engine && engine->id == handle ? engine : nullptr;
+}
+
+// 从快照解析一批请求引用的模板
+// retain = false 时返回不持有引用计数的指针 (由调用方持有的 snapshot 保活)，
+// 每个请求没有原子操作；长期保存的计划需要 retain = true
+static std::vector<std::shared_ptr<const TemplateEntry>> ResolveTemplates(
+    const TemplateMap& snapshot, const SearchRequest* requests, int count, bool retain) {
+    std::vector<std::shared_ptr<const TemplateEntry>> entries(count);
+    for (int i = 0; i < count; i++) {
+        auto it = snapshot.find(requests[i].templateId);
+        if (it == snapshot.end()) continue;
+        if (retain) {
+            entries[i] = it->second;
+        } else {
+            entries[i] = std::shared_ptr<const TemplateEntry>(std::shared_ptr<const TemplateEntry>(), it->second.get());
+        }
+    }
+    return entries;
+}
+
+// 按 ID 查找计划，ID 无效或已释放时返回空指针
+static std::shared_ptr<SearchPlan> LookupPlan(int planId) {
+    if (planId <= 0) return nullptr;
+    std::shared_ptr<SearchPlan> plan = g_plans[(planId - 1) % kMaxSearchPlans].Load();
+    return plan && plan->id == planId ? plan : nullptr;
+}
+
+// 按来源解码一张模板 (BGR)，失败返回空 Mat
+static cv::Mat DecodeTemplate(const TemplateSource& source) {
+    switch (source.kind) {
+        case TEMPLATE_SOURCE_PATH:
+            if (!source.path) return cv::Mat();
+            return cv::imread(source.path, cv::IMREAD_COLOR);
+        case TEMPLATE_SOURCE_ENCODED:
+            if (!source.data || source.length <= 0) return cv::Mat();
+            return cv::imdecode(cv::Mat(1, source.length, CV_8UC1, const_cast<uint8_t*>(source.data)),
+                                cv::IMREAD_COLOR);
+        case TEMPLATE_SOURCE_RAW_BGRA:
+        case TEMPLATE_SOURCE_RAW_BGR: {
+            if (!source.data || source.width <= 0 || source.height <= 0) return cv::Mat();
+            const bool bgra = source.kind == TEMPLATE_SOURCE_RAW_BGRA;
+            const cv::Mat raw(source.height, source.width, bgra ? CV_8UC4 : CV_8UC3,
+                              const_cast<uint8_t*>(source.data),
+                              source.stride > 0 ? source.stride : cv::Mat::AUTO_STEP);
+            cv::Mat bgr;
+            if (bgra) {
+                cv::cvtColor(raw, bgr, cv::COLOR_BGRA2BGR);
+            } else {
+                bgr = raw.clone();
+            }
+            return bgr;
+        }
+        default:
+            return cv::Mat();
+    }
+}
+
+// 校验调用方声明的 BatchHeader 版本并清零输出字段，不匹配时返回 false (写回库实现的版本)
+// 接受第 1-3 版 (SearchResultEx 布局相同，旧版本的 BatchHeader 没有末尾的截止时间 / 优先级字段)；
+// 更新的调用方或不一致的结构体大小直接拒绝，避免越界写入
+static bool ResetBatchHeader(BatchHeader* header, int count) {
+    if (header->version < 1 || header->version > SEARCH_RESULT_EX_VERSION ||
+        header->resultSize != static_cast<int>(sizeof(SearchResultEx))) {
+        header->version = SEARCH_RESULT_EX_VERSION;
+        return false;
+    }
+    header->requestCount = count;
+    header->regionCount = 0;
+    header->decodeNs = 0;
+    header->convertNs = 0;
+    header->matchNs = 0;
+    header->totalNs = 0;
+    if (header->version >= 2) {
+        header->skippedCount = 0;
+    }
+    return true;
+}
+
+// 解码源图并执行一批请求，返回 0 成功，-2 图片无效
+// 同步接口与异步接口共用；可在多个线程上并发执行
+// results / extended 至少提供其一；header 非空时写入批次耗时
+static int RunBatch(SearchEngine& engine, uint8_t* imageBytes, int length, int width, int height, int stride,
+                    const SearchRequest* requests, int count, SearchResultItem* results,
+                    SearchResultEx* extended = nullptr, BatchHeader* header = nullptr) {
+    TRACE_SCOPE("batch");
+    const long long batchStart = StatsNowNs();
+    cv::Mat sourceImage;
+    // BGRA 源图不在这里整图转换，而是由计划按准备区域转换
+
+    // 1. 解码或构造源图片
+    {
+        TRACE_SCOPE("decode");
+        if (width > 0 && height > 0) {
+            // Raw BGRA 模式
+            // 注意：OpenCV 默认使用 BGR，而 WGC/Flutter 通常是 BGRA
+            // 这里我们假设格式为 BGRA (8UC4)，stride 为每行字节数
+            sourceImage = cv::Mat(height, width, CV_8UC4, imageBytes, stride > 0 ? stride : cv::Mat::AUTO_STEP);
+        } else if (length > 54 && imageBytes[0] == 'B' && imageBytes[1] == 'M') {
+            // BMP Optimization (Zero-Copy Load)
+            BmpFileHeader bmfh;
+            BmpInfoHeader bmih;
+            std::memcpy(&bmfh, imageBytes, sizeof(bmfh));
+            std::memcpy(&bmih, imageBytes + sizeof(bmfh), sizeof(bmih));
+        
+            // Only optimize for 32bpp Top-Down BGRA (which our WGC capture produces)
+            if (bmih.bitCount == 32 && bmih.compression == kBmpCompressionRgb && bmih.height < 0) {
+                int w = bmih.width;
+                int h = -bmih.height; // Absolute height
+                uint8_t* pixels = imageBytes + bmfh.offBits;
+            
+                // Construct Mat pointing to existing memory
+                sourceImage = cv::Mat(h, w, CV_8UC4, pixels);
+            } else {
+                // Fallback for other BMP formats
+                sourceImage = cv::imdecode(cv::Mat(1, length, CV_8UC1, imageBytes), cv::IMREAD_COLOR);
+            }
+        } else {
+            // 压缩图片模式 (PNG/JPG)
+            // 直接包装成 Mat 头解码，不复制压缩数据
+            sourceImage = cv::imdecode(cv::Mat(1, length, CV_8UC1, imageBytes), cv::IMREAD_COLOR);
+        }
+    }
+
+    if (sourceImage.empty()) {
+        // 图片无效，结果仍按请求初始化为未找到
+        for (int i = 0; i < count; i++) {
+            if (results) {
+                results[i].templateId = requests[i].templateId;
+                results[i].x = -1;
+                results[i].y = -1;
+                results[i].score = 0.0;
+            }
+            if (extended) {
+                extended[i] = SearchResultEx();
+                extended[i].templateId = requests[i].templateId;
+                extended[i].x = -1;
+                extended[i].y = -1;
+                extended[i].method = requests[i].method;
+                extended[i].flags = SEARCH_RESULT_NOT_RUN;
+            }
+        }
+        return -2;
+    }
+    const long long decodeNs = StatsNowNs() - batchStart;
+    engine.stats->RecordBatch();
+    engine.stats->RecordStage(STATS_STAGE_DECODE, decodeNs);
+    if (header) {
+        header->decodeNs = decodeNs;
+    }
+
+    // 2. 编译临时计划 (从同一份模板表快照解析全部模板) 并执行
+    // 快照在整个批次期间保活所引用的模板
+    const std::shared_ptr<const TemplateMap> snapshot = engine.Snapshot();
+    const std::vector<std::shared_ptr<const TemplateEntry>> entries = ResolveTemplates(*snapshot, requests, count, false);
+    SearchPlan plan;
+    plan.Compile(requests, entries.data(), count, sourceImage.cols, sourceImage.rows, sourceImage.channels(),
+                 engine.stats, header && header->version >= 3 ? header->priorities : nullptr);
+
+    // 批次预算从调用开始计，包含解码
+    const bool v2 = header && header->version >= 2;
+    const int64_t deadlineNs = v2 && header->deadlineUs > 0 ? batchStart + header->deadlineUs * 1000 : 0;
+    std::string listKey;
+    if (deadlineNs > 0) {
+        listKey.assign(reinterpret_cast<const char*>(requests), sizeof(SearchRequest) * count);
+        std::lock_guard<std::mutex> lock(engine.deadlineMutex);
+        const auto it = engine.deadlineSkipped.find(listKey);
+        if (it != engine.deadlineSkipped.end()) {
+            for (int i = 0; i < count; i++) {
+                if (it->second[i]) plan.Boost(i);
+            }
+        }
+    }
+
+    BatchDebugStats stats = {};
+    plan.Run(sourceImage, results, &stats, extended, header, deadlineNs);
+    if (deadlineNs > 0) {
+        std::vector<uint8_t> skipped(count);
+        for (int i = 0; i < count; i++) {
+            skipped[i] = plan.Skipped(i) ? 1 : 0;
+        }
+        std::lock_guard<std::mutex> lock(engine.deadlineMutex);
+        if (plan.SkippedCount() == 0) {
+            engine.deadlineSkipped.erase(listKey);
+        } else {
+            if (engine.deadlineSkipped.size() >= SearchEngine::kMaxDeadlineLists &&
+                !engine.deadlineSkipped.count(listKey)) {
+                engine.deadlineSkipped.clear();
+            }
+            engine.deadlineSkipped[listKey] = std::move(skipped);
+        }
+    }
+    if (header) {
+        header->totalNs = StatsNowNs() - batchStart;
+    }
+    if (v2) {
+        header->skippedCount = plan.SkippedCount();
+    }
+
+    // 调试输出: 关闭时只有一次原子读取
+    if (DebugImages().Enabled()) {
+        bool allFound = true;
+        for (int i = 0; i < count; i++) {
+            allFound = allFound && (results ? results[i].x >= 0 : extended[i].x >= 0);
+        }
+        if (DebugImages().ShouldSample(allFound, -1.0, 0.0)) {
+            DebugImages().Submit("batch_source", sourceImage);
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(engine.lastBatchStatsMutex);
+    engine.lastBatchStats = stats;
+    return 0;
+}
 
 extern "C" {
 
-    EXPORT int load_template(const char* imagePath) {
+    EXPORT int engine_create() {
+        auto engine = std::make_shared<SearchEngine>();
+        std::lock_guard<std::mutex> lock(g_engineMutex);
+        for (int slot = 0; slot < kMaxEngines; slot++) {
+            if (g_engines[slot].Load()) continue;
+            const int generation = g_engineGenerations[slot]++;
+            engine->id = generation * kMaxEngines + slot + 1;
+            g_engines[slot].Store(engine);
+            return engine->id;
+        }
+        return -1; // 引擎数已达上限
+    }
+
+    EXPORT void engine_destroy(int engine) {
+        if (engine <= 0) return; // 默认引擎不可销毁
+        std::shared_ptr<SearchEngine> removed;
+        {
+            std::lock_guard<std::mutex> lock(g_engineMutex);
+            removed = LookupEngine(engine);
+            if (!removed) return;
+            g_engines[(engine - 1) % kMaxEngines].Store(nullptr);
+        }
+        // removed 在锁外析构；仍在进行中的调用持有自己的引用
+    }
+
+    EXPORT int engine_load_template(int engine, const char* imagePath) {
+        const std::shared_ptr<SearchEngine> e = LookupEngine(engine);
+        if (!e) return -5;
         if (!imagePath) return -1;
         
         // 读取图片 (IMREAD_COLOR 忽略 Alpha 通道，IMREAD_UNCHANGED 保留)
@@ -82,60 +520,141 @@ extern "C" {
             return -2; // 读取失败
         }
 
-        std::lock_guard<std::mutex> lock(g_mutex);
-        int id = g_nextTemplateId++;
-        g_templates[id] = templ;
+        std::shared_ptr<const TemplateEntry> entry = MakeTemplateEntry(templ);
+
+        std::lock_guard<std::mutex> lock(e->mutex);
+        int id = e->nextTemplateId++;
+        e->UpdateTemplatesLocked([&](TemplateMap& templates) { templates[id] = std::move(entry); });
         return id;
     }
 
-    EXPORT void release_template(int templateId) {
-        std::lock_guard<std::mutex> lock(g_mutex);
-        g_templates.erase(templateId);
+    EXPORT int engine_load_templates_bulk(int engine, const TemplateSource* sources, int count, int* outIds,
+                                          TemplateSize* outSizes) {
+        const std::shared_ptr<SearchEngine> e = LookupEngine(engine);
+        if (!e) return -5;
+        if (!sources || count <= 0 || !outIds) return 0;
+
+        // 解码与预计算在共用线程池上并行执行 (调用线程也参与)
+        std::vector<std::shared_ptr<const TemplateEntry>> entries(count);
+        SharedWorkers().ParallelFor(count, [&](int i) {
+            cv::Mat image = DecodeTemplate(sources[i]);
+            if (!image.empty()) {
+                entries[i] = MakeTemplateEntry(image);
+            }
+        });
+
+        // 一次复制按顺序登记，ID 与 sources 顺序一致
+        int loaded = 0;
+        std::lock_guard<std::mutex> lock(e->mutex);
+        e->UpdateTemplatesLocked([&](TemplateMap& templates) {
+            for (int i = 0; i < count; i++) {
+                const bool valid = sources[i].kind >= TEMPLATE_SOURCE_PATH && sources[i].kind <= TEMPLATE_SOURCE_RAW_BGR;
+                if (outSizes) {
+                    outSizes[i].width = entries[i] ? entries[i]->image.cols : 0;
+                    outSizes[i].height = entries[i] ? entries[i]->image.rows : 0;
+                }
+                if (!entries[i]) {
+                    outIds[i] = valid ? -2 : -1;
+                    continue;
+                }
+                const int id = e->nextTemplateId++;
+                templates[id] = std::move(entries[i]);
+                outIds[i] = id;
+                loaded++;
+            }
+        });
+        return loaded;
     }
 
-    EXPORT void release_all_templates() {
-        std::lock_guard<std::mutex> lock(g_mutex);
-        g_templates.clear();
-        g_nextTemplateId = 1;
+    EXPORT int engine_load_template_pack(int engine, const char* path, TemplatePackItem* out, int capacity) {
+        const std::shared_ptr<SearchEngine> e = LookupEngine(engine);
+        if (!e) return -5;
+        if (!path) return -1;
+
+        auto pack = std::make_shared<TemplatePack>();
+        if (!pack->Open(path)) {
+            return -2;
+        }
+        const int count = pack->Count();
+        if (!out || capacity < count) {
+            return count;
+        }
+
+        // 模板直接引用映射内存，并共同持有映射
+        std::vector<std::shared_ptr<const TemplateEntry>> entries(count);
+        for (int i = 0; i < count; i++) {
+            const ImageView level = pack->Level(i, 0);
+            const cv::Mat image(level.height, level.width, CV_8UC3, const_cast<uint8_t*>(level.data), level.stride);
+            entries[i] = MakeTemplateEntry(image, pack->Sums(i), pack);
+        }
+
+        std::lock_guard<std::mutex> lock(e->mutex);
+        e->UpdateTemplatesLocked([&](TemplateMap& templates) {
+            for (int i = 0; i < count; i++) {
+                const int id = e->nextTemplateId++;
+                templates[id] = std::move(entries[i]);
+
+                TemplatePackItem& item = out[i];
+                item.templateId = id;
+                item.width = pack->Entry(i).levels[0].width;
+                item.height = pack->Entry(i).levels[0].height;
+                std::memcpy(item.name, pack->Entry(i).name, sizeof(item.name));
+            }
+        });
+        return count;
     }
 
-    EXPORT SearchResult find_image(int templateId, int x, int y, int w, int h, double threshold) {
+    EXPORT void engine_release_template(int engine, int templateId) {
+        const std::shared_ptr<SearchEngine> e = LookupEngine(engine);
+        if (!e) return;
+        std::lock_guard<std::mutex> lock(e->mutex);
+        if (e->Snapshot()->count(templateId) == 0) return;
+        e->UpdateTemplatesLocked([&](TemplateMap& templates) { templates.erase(templateId); });
+    }
+
+    EXPORT void engine_release_all_templates(int engine) {
+        const std::shared_ptr<SearchEngine> e = LookupEngine(engine);
+        if (!e) return;
+        std::lock_guard<std::mutex> lock(e->mutex);
+        e->templates.Store(std::make_shared<const TemplateMap>());
+        e->nextTemplateId = 1;
+    }
+
+    EXPORT SearchResult engine_find_image(int engine, int templateId, int x, int y, int w, int h, double threshold) {
         SearchResult result = { -1, -1, 0.0 };
+        const std::shared_ptr<SearchEngine> e = LookupEngine(engine);
+        if (!e) return result;
 
-        cv::Mat templ;
+        std::shared_ptr<const TemplateEntry> entry;
         {
-            std::lock_guard<std::mutex> lock(g_mutex);
-            auto it = g_templates.find(templateId);
-            if (it == g_templates.end()) {
+            const std::shared_ptr<const TemplateMap> snapshot = e->Snapshot();
+            auto it = snapshot->find(templateId);
+            if (it == snapshot->end()) {
                 return result; // 模板不存在
             }
-            templ = it->second;
+            entry = it->second;
         }
+        const cv::Mat& templ = entry->image;
 
         // 截图 (ROI)
         cv::Mat screen = CaptureScreen(x, y, w, h);
-        
-        // 强制保存调试截图 (方便 Dart 层回显)
-        // 保存到临时文件，例如 debug_last_roi.png
-        if (!screen.empty()) {
-            cv::imwrite("debug_last_roi.png", screen);
-        }
 
         // 检查尺寸
         if (screen.empty() || screen.rows < templ.rows || screen.cols < templ.cols) {
+            if (!screen.empty() && DebugImages().ShouldSample(false, -1.0, threshold)) {
+                DebugImages().Submit("roi", screen);
+            }
             return result; // 屏幕区域比模板还小或截图失败
         }
 
         // 模板匹配
-        cv::Mat matchResult;
         // TM_CCOEFF_NORMED 是最常用的归一化相关系数匹配法
         // 结果范围 [-1, 1]，越接近 1 越匹配
-        cv::matchTemplate(screen, templ, matchResult, cv::TM_CCOEFF_NORMED);
-
-        // 寻找最大值位置
-        double minVal, maxVal;
-        cv::Point minLoc, maxLoc;
-        cv::minMaxLoc(matchResult, &minVal, &maxVal, &minLoc, &maxLoc);
+        // 大区域 (如全屏) 分块并行；小区域只分一块，两者的分数与位置规则相同
+        TiledMatcher tiles;
+        tiles.Plan(screen.cols, screen.rows, templ);
+        cv::Point maxLoc;
+        const double maxVal = tiles.Run(screen, *entry, &maxLoc);
 
         if (maxVal >= threshold) {
             // 返回的坐标是相对于屏幕左上角的绝对坐标
@@ -145,148 +664,548 @@ extern "C" {
             result.score = maxVal;
         }
 
+        // 调试输出 (方便 Dart 层回显)，由后台线程写盘
+        if (DebugImages().ShouldSample(maxVal >= threshold, maxVal, threshold)) {
+            DebugImages().Submit("roi", screen);
+        }
+
         return result;
     }
     
     EXPORT void debug_save_last_capture(const char* path) {
-        if (!g_lastCapture.empty() && path) {
-            cv::imwrite(path, g_lastCapture);
+        const cv::Mat last = DebugImages().Last();
+        if (!last.empty() && path) {
+            cv::imwrite(path, last);
         }
     }
 
-    EXPORT void find_images_batch(
-        uint8_t* imageBytes, int length, 
+    EXPORT void debug_sink_configure(int mode, int everyN, double nearMissMargin, int queueCapacity,
+                                     const char* directory) {
+        DebugSink::Config config;
+        config.mode = mode & (DEBUG_SINK_EVERY_N | DEBUG_SINK_MISSES);
+        config.everyN = everyN;
+        config.nearMissMargin = nearMissMargin;
+        config.queueCapacity = queueCapacity;
+        config.directory = directory ? directory : ".";
+        DebugImages().Configure(config);
+    }
+
+    EXPORT void debug_sink_get_stats(DebugSinkStats* out) {
+        if (!out) return;
+        const DebugSink::Counters counters = DebugImages().GetCounters();
+        out->sampled = counters.sampled;
+        out->written = counters.written;
+        out->dropped = counters.dropped;
+        out->failed = counters.failed;
+    }
+
+    EXPORT int automation_start(int engine, const AutomationRule* rules, int count,
+                                AutomationEventCallback callback, void* userData) {
+        if (!rules || count <= 0 || count > Automation::kMaxRules || !callback) return -3;
+        const std::shared_ptr<SearchEngine> e = LookupEngine(engine);
+        if (!e) return -5;
+
+        // 规则长期运行，持有模板引用 (释放模板不影响进行中的自动化)
+        std::vector<SearchRequest> requests(count);
+        for (int i = 0; i < count; i++) {
+            requests[i] = rules[i].request;
+        }
+        const std::vector<std::shared_ptr<const TemplateEntry>> entries =
+            ResolveTemplates(*e->Snapshot(), requests.data(), count, true);
+
+        std::shared_ptr<Automation> automation = std::make_shared<Automation>(
+            rules, entries.data(), count, e->stats, CallbackSink(callback, userData));
+
+        InstallAutomation(automation, std::vector<ScenarioRuleInfo>());
+        return 0;
+    }
+
+    EXPORT void automation_stop() {
+        InstallAutomation(nullptr, std::vector<ScenarioRuleInfo>());
+    }
+
+    EXPORT int automation_submit_frame(const uint8_t* pixels, int width, int height, int stride, long long arrivalNs) {
+        if (!pixels || width <= 0 || height <= 0) return -3;
+        const std::shared_ptr<Automation> automation = g_automation.Load();
+        if (!automation) return -1;
+        return automation->Submit(pixels, width, height, stride, arrivalNs) ? 0 : -1;
+    }
+
+    EXPORT void automation_get_stats(AutomationStats* out) {
+        if (!out) return;
+        const std::shared_ptr<Automation> automation = g_automation.Load();
+        if (automation) {
+            automation->GetStats(out);
+        } else {
+            *out = AutomationStats();
+        }
+    }
+
+    EXPORT void automation_set_governor(const AutomationGovernorConfig* config) {
+        std::lock_guard<std::mutex> lock(g_automationMutex);
+        g_governorConfig = config ? *config : AutomationGovernorConfig();
+        const std::shared_ptr<Automation> automation = g_automation.Load();
+        if (automation) automation->SetGovernor(g_governorConfig);
+    }
+
+    EXPORT void automation_set_frame_budget(long long budgetUs) {
+        std::lock_guard<std::mutex> lock(g_automationMutex);
+        g_frameBudgetUs = std::max(0LL, budgetUs);
+        const std::shared_ptr<Automation> automation = g_automation.Load();
+        if (automation) automation->SetFrameBudget(g_frameBudgetUs * 1000);
+    }
+
+    EXPORT int automation_get_rule_stats(AutomationRuleStats* out, int capacity) {
+        const std::shared_ptr<Automation> automation = g_automation.Load();
+        if (!automation) return 0;
+        return automation->GetRuleStats(out, out ? capacity : 0);
+    }
+
+    EXPORT int scenario_start(int engine, const char* path, AutomationEventCallback callback, void* userData,
+                              char* error, int errorSize) {
+        if (!path || !callback) return -3;
+        const std::shared_ptr<SearchEngine> e = LookupEngine(engine);
+        if (!e) return -5;
+
+        Scenario scenario;
+        std::vector<std::shared_ptr<const TemplateEntry>> entries;
+        std::string message;
+        if (!LoadScenario(path, &scenario, &message) || !LoadScenarioTemplates(scenario, &entries, &message)) {
+            if (errorSize > 0) CopyString(message, error, static_cast<size_t>(errorSize));
+            return -1;
+        }
+
+        const int count = static_cast<int>(scenario.rules.size());
+        std::vector<AutomationRule> rules(count);
+        std::vector<ScenarioRuleInfo> infos(count);
+        for (int i = 0; i < count; i++) {
+            const ScenarioRule& rule = scenario.rules[i];
+            rules[i] = rule.rule;
+            ScenarioRuleInfo& info = infos[i];
+            info = ScenarioRuleInfo();
+            CopyString(rule.name, info.name, sizeof(info.name));
+            CopyString(rule.label, info.label, sizeof(info.label));
+            info.templateId = rule.rule.request.templateId;
+            info.templateWidth = entries[i]->image.cols;
+            info.templateHeight = entries[i]->image.rows;
+            info.actionKey = rule.actionKey;
+            info.actionHoldMs = rule.actionHoldMs;
+            info.cooldownMs = rule.rule.repeatMs;
+        }
+
+        std::shared_ptr<Automation> automation = std::make_shared<Automation>(
+            rules.data(), entries.data(), count, e->stats, CallbackSink(callback, userData), ScenarioGraph(scenario));
+        InstallAutomation(automation, std::move(infos), scenario.hasGovernor ? &scenario.governor : nullptr);
+        return count;
+    }
+
+    EXPORT int scenario_get_rule(int index, ScenarioRuleInfo* out) {
+        if (!out) return -1;
+        std::lock_guard<std::mutex> lock(g_automationMutex);
+        if (index < 0 || index >= static_cast<int>(g_scenarioRules.size())) return -1;
+        *out = g_scenarioRules[index];
+        return 0;
+    }
+
+    EXPORT int recorder_start(const char* path, int keyframeInterval) {
+        if (!path || !path[0]) return -3;
+        std::lock_guard<std::mutex> lock(g_recorderMutex);
+        StopRecorderLocked();
+        std::shared_ptr<FrameRecorder> recorder = std::make_shared<FrameRecorder>();
+        if (!recorder->Start(path, keyframeInterval)) return -1;
+        g_recorder.Store(recorder);
+        return 0;
+    }
+
+    EXPORT int recorder_submit_frame(const uint8_t* pixels, int width, int height, int stride, long long arrivalNs) {
+        if (!pixels || width <= 0 || height <= 0) return -3;
+        const std::shared_ptr<FrameRecorder> recorder = g_recorder.Load();
+        if (!recorder) return -1;
+        return recorder->Submit(pixels, width, height, stride, arrivalNs) ? 0 : 1;
+    }
+
+    EXPORT int recorder_stop() {
+        std::lock_guard<std::mutex> lock(g_recorderMutex);
+        if (!g_recorder.Load()) return -1;
+        return StopRecorderLocked() ? 0 : -2;
+    }
+
+    EXPORT void recorder_get_stats(RecorderStats* out) {
+        if (!out) return;
+        const std::shared_ptr<FrameRecorder> recorder = g_recorder.Load();
+        if (recorder) {
+            recorder->GetStats(out);
+            return;
+        }
+        std::lock_guard<std::mutex> lock(g_recorderMutex);
+        *out = g_lastRecorderStats;
+    }
+
+    EXPORT void engine_get_last_batch_debug_stats(int engine, BatchDebugStats* out) {
+        const std::shared_ptr<SearchEngine> e = LookupEngine(engine);
+        if (!e || !out) return;
+        std::lock_guard<std::mutex> lock(e->lastBatchStatsMutex);
+        *out = e->lastBatchStats;
+    }
+
+    EXPORT uint8_t* engine_acquire_input_buffer(int engine, int size) {
+        const std::shared_ptr<SearchEngine> e = LookupEngine(engine);
+        if (!e || size <= 0) return nullptr;
+        return e->inputBuffers.Acquire(static_cast<size_t>(size));
+    }
+
+    EXPORT void engine_release_input_buffer(int engine, uint8_t* buffer) {
+        if (!buffer) return;
+        const std::shared_ptr<SearchEngine> e = LookupEngine(engine);
+        // 引擎已销毁时，借出的块在缓冲池析构时转为孤儿，在这里释放
+        if (!e || !e->inputBuffers.Release(buffer)) {
+            BufferPool::ReleaseOrphan(buffer);
+        }
+    }
+
+    EXPORT int engine_get_search_stats(int engine, SearchStats* out, TemplateStats* templates, int capacity) {
+        const std::shared_ptr<SearchEngine> e = LookupEngine(engine);
+        if (!e) return -5;
+        if (!out) return -1;
+
+        StatsSnapshot snapshot;
+        e->stats->Snapshot(&snapshot);
+
+        LatencySummary* stages[STATS_STAGE_COUNT] = {&out->decode, &out->convert, &out->match};
+        out->batches = snapshot.batches;
+        for (int s = 0; s < STATS_STAGE_COUNT; s++) {
+            const LatencySnapshot& l = snapshot.stages[s];
+            stages[s]->count = l.count;
+            stages[s]->totalNs = l.totalNs;
+            stages[s]->p50Ns = l.p50Ns;
+            stages[s]->p99Ns = l.p99Ns;
+            stages[s]->maxNs = l.maxNs;
+        }
+
+        const int total = static_cast<int>(snapshot.templates.size());
+        for (int i = 0; templates && i < total && i < capacity; i++) {
+            const TemplateStatsSnapshot& t = snapshot.templates[i];
+            templates[i].templateId = t.templateId;
+            templates[i].reserved = 0;
+            templates[i].calls = t.calls;
+            templates[i].hits = t.hits;
+            templates[i].totalNs = t.totalNs;
+            templates[i].maxNs = t.maxNs;
+        }
+        return total;
+    }
+
+    EXPORT void engine_reset_search_stats(int engine) {
+        const std::shared_ptr<SearchEngine> e = LookupEngine(engine);
+        if (e) {
+            e->stats->Reset();
+        }
+    }
+
+    EXPORT void trace_enable(int enabled) {
+#ifdef IMAGE_SEARCH_TRACING
+        TraceEnable(enabled != 0);
+#else
+        (void)enabled;
+#endif
+    }
+
+    EXPORT int trace_is_enabled() {
+#ifdef IMAGE_SEARCH_TRACING
+        return TraceEnabled() ? 1 : 0;
+#else
+        return 0;
+#endif
+    }
+
+    EXPORT long long trace_now_ns() {
+        return StatsNowNs();
+    }
+
+    EXPORT const char* trace_intern(const char* name) {
+#ifdef IMAGE_SEARCH_TRACING
+        return name ? TraceIntern(name) : nullptr;
+#else
+        (void)name;
+        return nullptr;
+#endif
+    }
+
+    EXPORT void trace_record(const char* name, long long startNs, long long durationNs) {
+#ifdef IMAGE_SEARCH_TRACING
+        if (name && TraceEnabled()) {
+            TraceRecord(name, startNs, durationNs);
+        }
+#else
+        (void)name;
+        (void)startNs;
+        (void)durationNs;
+#endif
+    }
+
+    EXPORT void trace_clear() {
+#ifdef IMAGE_SEARCH_TRACING
+        TraceClear();
+#endif
+    }
+
+    EXPORT int trace_dump(const char* path) {
+#ifdef IMAGE_SEARCH_TRACING
+        if (!path) return -1;
+        return TraceDump(path);
+#else
+        (void)path;
+        return -2;
+#endif
+    }
+
+    EXPORT void engine_find_images_batch(
+        int engine,
+        uint8_t* imageBytes, int length,
         int width, int height, int stride,
-        SearchRequest* requests, int count, 
+        SearchRequest* requests, int count,
         SearchResultItem* results
     ) {
-        if (!imageBytes || length <= 0 || !requests || !results || count <= 0) {
+        const std::shared_ptr<SearchEngine> e = LookupEngine(engine);
+        if (!e || !imageBytes || length <= 0 || !requests || !results || count <= 0) {
             return;
         }
+        RunBatch(*e, imageBytes, length, width, height, stride, requests, count, results);
+    }
 
-        cv::Mat sourceImage;
+    EXPORT int engine_find_images_batch_ex(
+        int engine,
+        uint8_t* imageBytes, int length,
+        int width, int height, int stride,
+        SearchRequest* requests, int count,
+        SearchResultEx* results, BatchHeader* header
+    ) {
+        const std::shared_ptr<SearchEngine> e = LookupEngine(engine);
+        if (!e) {
+            return -5;
+        }
+        if (!imageBytes || length <= 0 || !requests || !results || count <= 0 || !header) {
+            return -3;
+        }
+        if (!ResetBatchHeader(header, count)) {
+            return -4;
+        }
+        return RunBatch(*e, imageBytes, length, width, height, stride, requests, count, nullptr, results, header);
+    }
 
-        // 1. 解码或构造源图片
-        if (width > 0 && height > 0) {
-            // Raw BGRA 模式
-            // 注意：OpenCV 默认使用 BGR，而 WGC/Flutter 通常是 BGRA
-            // 如果不需要 Alpha，可以直接当作 4 通道处理，或者 cvtColor
-            // 这里我们假设 stride 是标准的 width * 4，且格式为 BGRA (8UC4)
-            // 如果 stride 不是标准的，可能需要调整 step
-            sourceImage = cv::Mat(height, width, CV_8UC4, imageBytes, stride > 0 ? stride : cv::Mat::AUTO_STEP);
-            
-            // matchTemplate 需要 BGR 或灰度，通常不需要 Alpha
-            // 转换为 BGR
-            cv::cvtColor(sourceImage, sourceImage, cv::COLOR_BGRA2BGR);
-        } else if (length > 54 && imageBytes[0] == 'B' && imageBytes[1] == 'M') {
-            // BMP Optimization (Zero-Copy Load)
-            BITMAPFILEHEADER* bmfh = (BITMAPFILEHEADER*)imageBytes;
-            BITMAPINFOHEADER* bmih = (BITMAPINFOHEADER*)(imageBytes + sizeof(BITMAPFILEHEADER));
-            
-            // Only optimize for 32bpp Top-Down BGRA (which our WGC capture produces)
-            if (bmih->biBitCount == 32 && bmih->biCompression == BI_RGB && bmih->biHeight < 0) {
-                int w = bmih->biWidth;
-                int h = -bmih->biHeight; // Absolute height
-                uint8_t* pixels = imageBytes + bmfh->bfOffBits;
-                
-                // Construct Mat pointing to existing memory
-                sourceImage = cv::Mat(h, w, CV_8UC4, pixels);
-                
-                // Convert to BGR for matching (Allocate new Mat)
-                cv::cvtColor(sourceImage, sourceImage, cv::COLOR_BGRA2BGR);
-            } else {
-                // Fallback for other BMP formats
-                std::vector<uint8_t> buffer(imageBytes, imageBytes + length);
-                sourceImage = cv::imdecode(buffer, cv::IMREAD_COLOR);
-            }
-        } else {
-            // 压缩图片模式 (PNG/JPG)
-            // 先将数据包装成 vector 或 Mat
-            std::vector<uint8_t> buffer(imageBytes, imageBytes + length);
-            sourceImage = cv::imdecode(buffer, cv::IMREAD_COLOR);
+    EXPORT int engine_submit_batch(
+        int engine,
+        uint8_t* imageBytes, int length,
+        int width, int height, int stride,
+        SearchRequest* requests, int count,
+        SearchResultItem* results,
+        BatchCompletionCallback callback, void* userData
+    ) {
+        std::shared_ptr<SearchEngine> e = LookupEngine(engine);
+        if (!e) {
+            return -5;
+        }
+        if (!imageBytes || length <= 0 || !requests || !results || count <= 0 || !callback) {
+            return -3;
         }
 
-        if (sourceImage.empty()) {
-            return; // 图片无效
+        const int ticket = g_nextTicket.fetch_add(1);
+        // 请求数组在这里复制，调用方提交后即可释放；图片与结果缓冲须保持有效直到回调
+        std::vector<SearchRequest> ownedRequests(requests, requests + count);
+        // 任务持有引擎引用，提交后销毁引擎也不影响进行中的批次
+        // 批次在共用线程池上执行，其中的分块匹配嵌套展开在同一池上，不会超出核数
+        SharedWorkers().Submit([=, e = std::move(e), ownedRequests = std::move(ownedRequests)]() mutable {
+            const int status = RunBatch(*e, imageBytes, length, width, height, stride,
+                                        ownedRequests.data(), count, results);
+            callback(ticket, status, userData);
+        });
+        return ticket;
+    }
+
+    EXPORT int engine_compile_search_plan(int engine, SearchRequest* requests, int count,
+                                          int frameWidth, int frameHeight) {
+        return engine_compile_search_plan_ex(engine, requests, count, frameWidth, frameHeight, nullptr);
+    }
+
+    EXPORT int engine_compile_search_plan_ex(int engine, SearchRequest* requests, int count,
+                                             int frameWidth, int frameHeight, const int* priorities) {
+        const std::shared_ptr<SearchEngine> e = LookupEngine(engine);
+        if (!e) {
+            return -5;
+        }
+        if (!requests || count <= 0 || frameWidth <= 0 || frameHeight <= 0) {
+            return -3;
         }
-        
-        // 不要保存调试图,性能影响较大
-        //cv::imwrite("debug_last_batch_source.png", sourceImage);
 
-        // 2. 批量处理任务
-        for (int i = 0; i < count; i++) {
-            // 注意：C++ 指针偏移
-            SearchRequest& req = requests[i];
-            SearchResultItem& res = results[i];
-            
-            // 初始化结果
-            res.templateId = req.templateId;
-            res.x = -1;
-            res.y = -1;
-            res.score = 0.0;
-
-            // 获取模板
-            cv::Mat templ;
-            {
-                std::lock_guard<std::mutex> lock(g_mutex);
-                auto it = g_templates.find(req.templateId);
-                if (it == g_templates.end()) {
-                    continue; // 模板不存在
-                }
-                templ = it->second;
-            }
+        // 计划长期持有所引用的模板，释放模板后计划仍可安全运行
+        const std::vector<std::shared_ptr<const TemplateEntry>> entries =
+            ResolveTemplates(*e->Snapshot(), requests, count, true);
+        std::shared_ptr<SearchPlan> plan = std::make_shared<SearchPlan>();
+        plan->Compile(requests, entries.data(), count, frameWidth, frameHeight, 4, e->stats, priorities);
 
-            // 处理 ROI
-            cv::Mat searchArea;
-            int offsetX = 0;
-            int offsetY = 0;
-
-            if (req.roiW > 0 && req.roiH > 0) {
-                // 确保 ROI 在图片范围内
-                int roiX = std::max(0, req.roiX);
-                int roiY = std::max(0, req.roiY);
-                // 确保不越界
-                int maxW = sourceImage.cols - roiX;
-                int maxH = sourceImage.rows - roiY;
-                
-                if (maxW <= 0 || maxH <= 0) {
-                     continue; // ROI 完全在图片外
-                }
-                
-                int roiW = std::min(req.roiW, maxW);
-                int roiH = std::min(req.roiH, maxH);
+        std::lock_guard<std::mutex> lock(g_planMutex);
+        for (int slot = 0; slot < kMaxSearchPlans; slot++) {
+            if (g_plans[slot].Load()) continue;
+            const int generation = g_planGenerations[slot]++;
+            plan->id = generation * kMaxSearchPlans + slot + 1;
+            g_plans[slot].Store(plan);
+            return plan->id;
+        }
+        return -1; // 计划数已达上限
+    }
 
-                if (roiW < templ.cols || roiH < templ.rows) {
-                    continue; // ROI 太小
-                }
+    EXPORT int run_search_plan(int planId, uint8_t* pixels, int stride, SearchResultItem* results) {
+        if (!pixels || !results) {
+            return -3;
+        }
+        // 执行期间持有引用，并发的 release_search_plan 不会释放正在执行的计划
+        const std::shared_ptr<SearchPlan> plan = LookupPlan(planId);
+        if (!plan) {
+            return -1;
+        }
+        if (stride > 0 && stride < plan->FrameWidth() * 4) {
+            return -3;
+        }
+        if (plan->busy.exchange(true, std::memory_order_acquire)) {
+            return -2; // 同一计划正在其他线程上执行
+        }
 
-                // 切割子图 (零拷贝)
-                searchArea = sourceImage(cv::Rect(roiX, roiY, roiW, roiH));
-                offsetX = roiX;
-                offsetY = roiY;
-            } else {
-                // 全图搜索
-                searchArea = sourceImage;
-            }
+        // 只构造 Mat 头，不复制像素
+        const cv::Mat frame(plan->FrameHeight(), plan->FrameWidth(), CV_8UC4, pixels,
+                            stride > 0 ? stride : cv::Mat::AUTO_STEP);
+        plan->Run(frame, results, nullptr);
 
-            // 检查尺寸
-            if (searchArea.rows < templ.rows || searchArea.cols < templ.cols) {
-                continue;
-            }
+        plan->busy.store(false, std::memory_order_release);
+        return 0;
+    }
+
+    EXPORT int run_search_plan_ex(int planId, uint8_t* pixels, int stride, SearchResultEx* results,
+                                  BatchHeader* header) {
+        const int64_t start = StatsNowNs();
+        if (!pixels || !results || !header) {
+            return -3;
+        }
+        const std::shared_ptr<SearchPlan> plan = LookupPlan(planId);
+        if (!plan) {
+            return -1;
+        }
+        if (stride > 0 && stride < plan->FrameWidth() * 4) {
+            return -3;
+        }
+        if (!ResetBatchHeader(header, plan->RequestCount())) {
+            return -4;
+        }
+        if (plan->busy.exchange(true, std::memory_order_acquire)) {
+            return -2;
+        }
 
-            // 匹配
-            cv::Mat matchResult;
-            cv::matchTemplate(searchArea, templ, matchResult, cv::TM_CCOEFF_NORMED);
+        // 优先级在编译时确定；被跳过的步骤由计划自己记住，下一次执行时优先
+        const bool v2 = header->version >= 2;
+        const int64_t deadlineNs = v2 && header->deadlineUs > 0 ? start + header->deadlineUs * 1000 : 0;
+        const cv::Mat frame(plan->FrameHeight(), plan->FrameWidth(), CV_8UC4, pixels,
+                            stride > 0 ? stride : cv::Mat::AUTO_STEP);
+        plan->Run(frame, nullptr, nullptr, results, header, deadlineNs);
+        header->totalNs = StatsNowNs() - start;
+        if (v2) {
+            header->skippedCount = plan->SkippedCount();
+        }
 
-            double minVal, maxVal;
-            cv::Point minLoc, maxLoc;
-            cv::minMaxLoc(matchResult, &minVal, &maxVal, &minLoc, &maxLoc);
+        plan->busy.store(false, std::memory_order_release);
+        return 0;
+    }
 
-            if (maxVal >= req.threshold) {
-                res.x = offsetX + maxLoc.x;
-                res.y = offsetY + maxLoc.y;
-                res.score = maxVal;
-            }
+    EXPORT void release_search_plan(int planId) {
+        std::shared_ptr<SearchPlan> plan;
+        {
+            std::lock_guard<std::mutex> lock(g_planMutex);
+            plan = LookupPlan(planId);
+            if (!plan) return;
+            g_plans[(planId - 1) % kMaxSearchPlans].Store(nullptr);
         }
+        // plan 在锁外释放引用；仍在执行的 run_search_plan 持有自己的引用，结束后析构计划
+    }
+    // === 默认引擎上的旧接口 ===
+
+    EXPORT int load_template(const char* imagePath) {
+        return engine_load_template(0, imagePath);
+    }
+
+    EXPORT int load_templates_bulk(const TemplateSource* sources, int count, int* outIds, TemplateSize* outSizes) {
+        return engine_load_templates_bulk(0, sources, count, outIds, outSizes);
+    }
+
+    EXPORT int load_template_pack(const char* path, TemplatePackItem* out, int capacity) {
+        return engine_load_template_pack(0, path, out, capacity);
+    }
+
+    EXPORT void release_template(int templateId) {
+        engine_release_template(0, templateId);
+    }
+
+    EXPORT void release_all_templates() {
+        engine_release_all_templates(0);
+    }
+
+    EXPORT SearchResult find_image(int templateId, int x, int y, int w, int h, double threshold) {
+        return engine_find_image(0, templateId, x, y, w, h, threshold);
+    }
+
+    EXPORT void get_last_batch_debug_stats(BatchDebugStats* out) {
+        engine_get_last_batch_debug_stats(0, out);
+    }
+
+    EXPORT uint8_t* acquire_input_buffer(int size) {
+        return engine_acquire_input_buffer(0, size);
+    }
+
+    EXPORT void release_input_buffer(uint8_t* buffer) {
+        engine_release_input_buffer(0, buffer);
+    }
+
+    EXPORT int get_search_stats(SearchStats* out, TemplateStats* templates, int capacity) {
+        return engine_get_search_stats(0, out, templates, capacity);
+    }
+
+    EXPORT void reset_search_stats() {
+        engine_reset_search_stats(0);
+    }
+
+    EXPORT void find_images_batch(
+        uint8_t* imageBytes, int length,
+        int width, int height, int stride,
+        SearchRequest* requests, int count,
+        SearchResultItem* results
+    ) {
+        engine_find_images_batch(0, imageBytes, length, width, height, stride, requests, count, results);
+    }
+
+    EXPORT int find_images_batch_ex(
+        uint8_t* imageBytes, int length,
+        int width, int height, int stride,
+        SearchRequest* requests, int count,
+        SearchResultEx* results, BatchHeader* header
+    ) {
+        return engine_find_images_batch_ex(0, imageBytes, length, width, height, stride, requests, count,
+                                           results, header);
+    }
+
+    EXPORT int submit_batch(
+        uint8_t* imageBytes, int length,
+        int width, int height, int stride,
+        SearchRequest* requests, int count,
+        SearchResultItem* results,
+        BatchCompletionCallback callback, void* userData
+    ) {
+        return engine_submit_batch(0, imageBytes, length, width, height, stride, requests, count, results,
+                                   callback, userData);
+    }
+
+    EXPORT int compile_search_plan(SearchRequest* requests, int count, int frameWidth, int frameHeight) {
+        return engine_compile_search_plan(0, requests, count, frameWidth, frameHeight);
+    }
+
+    EXPORT int compile_search_plan_ex(SearchRequest* requests, int count, int frameWidth, int frameHeight,
+                                      const int* priorities) {
+        return engine_compile_search_plan_ex(0, requests, count, frameWidth, frameHeight, priorities);
     }
 }
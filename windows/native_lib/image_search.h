@@ -2,9 +2,13 @@
 #define IMAGE_SEARCH_H
 
 #ifdef _WIN32
+#ifdef IMAGE_SEARCH_EXPORTS
 #define EXPORT __declspec(dllexport)
 #else
-#define EXPORT
+#define EXPORT __declspec(dllimport) // Runner 等直接链接 DLL 的模块
+#endif
+#else
+#define EXPORT __attribute__((visibility("default")))
 #endif
 
 #include <cstdint>
@@ -23,6 +27,51 @@ extern "C" {
     // 返回值: templateId (>0 成功, <=0 失败)
     EXPORT int load_template(const char* imagePath);
 
+    // 批量加载的模板来源 (TemplateSource::kind)
+    enum TemplateSourceKind {
+        TEMPLATE_SOURCE_PATH = 0,     // path: 图片文件路径
+        TEMPLATE_SOURCE_ENCODED = 1,  // data/length: 内存中的 PNG/JPG/BMP 编码数据
+        TEMPLATE_SOURCE_RAW_BGRA = 2, // data/width/height/stride: BGRA 原始像素
+        TEMPLATE_SOURCE_RAW_BGR = 3,  // data/width/height/stride: BGR 原始像素
+    };
+
+    struct TemplateSource {
+        int kind;    // TemplateSourceKind
+        int width;   // 仅原始像素
+        int height;  // 仅原始像素
+        int stride;  // 仅原始像素，<= 0 表示紧密排列
+        const char* path;
+        const uint8_t* data;
+        int length;  // 编码数据长度
+    };
+
+    struct TemplateSize {
+        int width;
+        int height;
+    };
+
+    // 批量加载模板：在工作线程池上并行解码，一次加锁登记全部模板
+    // 模板 ID 按 sources 顺序分配；数据在调用期间复制，返回后调用方即可释放
+    // outIds[i]: templateId (>0 成功, -1 参数无效, -2 读取 / 解码失败)
+    // outSizes[i]: 模板宽高 (失败时为 0)，可为 NULL
+    // 返回值: 成功加载的数量
+    EXPORT int load_templates_bulk(const TemplateSource* sources, int count, int* outIds, TemplateSize* outSizes);
+
+    // 模板包中的一项
+    struct TemplatePackItem {
+        int templateId;
+        int width;
+        int height;
+        char name[64];  // 打包时的名称 (通常是原始文件名)，以 0 结尾
+    };
+
+    // 加载模板包 (由 tools/template_packer 生成的 .pack 文件)
+    // 文件被内存映射，模板像素与统计量直接取自映射内存，不再解码图片；
+    // 映射在最后一个引用它的模板释放后解除
+    // out 为 NULL 或 capacity 小于包内模板数时只返回模板数，不登记任何模板
+    // 返回值: 包内模板数 (>=0), -1 参数无效, -2 文件无法打开或格式无效
+    EXPORT int load_template_pack(const char* path, TemplatePackItem* out, int capacity);
+
     // 释放特定模板
     EXPORT void release_template(int templateId);
 
@@ -35,16 +84,71 @@ extern "C" {
     // threshold: 匹配阈值 (0.0 - 1.0, 推荐 0.8-0.9)
     EXPORT SearchResult find_image(int templateId, int x, int y, int w, int h, double threshold);
 
-    // 调试用：保存最后一次截图到文件 (方便查看截图是否正确)
+    // 调试用：保存调试输出最近采样的一张图片到文件 (方便查看截图是否正确)
+    // 调试输出关闭时不保留图片，此函数不写文件
     EXPORT void debug_save_last_capture(const char* path);
 
+    // === 调试图片输出 ===
+    // 查找线程只做采样判断，采中的图片 (find_image 的截图区域、批量查找的源图)
+    // 由后台线程编码为 PNG，写为 <directory>/<tag>_<序号>.png 并覆盖 debug_last_<tag>.png
+    // (tag 为 roi 或 batch_source)。队列满时丢弃，不阻塞查找。默认关闭。
+
+    // 采样方式 (可组合)
+    enum DebugSinkMode {
+        DEBUG_SINK_OFF = 0,
+        DEBUG_SINK_EVERY_N = 1, // 每 everyN 次调用采样一次
+        DEBUG_SINK_MISSES = 2,  // 未命中时采样；nearMissMargin > 0 时仅限分数在 [阈值 - margin, 阈值) 内
+                                // (批量查找不返回未命中的分数，按任一请求未命中判断)
+    };
+
+    struct DebugSinkStats {
+        long long sampled;  // 进入队列的图片数
+        long long written;  // 已写盘
+        long long dropped;  // 队列满被丢弃
+        long long failed;   // 编码或写盘失败
+    };
+
+    // 配置调试输出；directory 为 NULL 时使用当前目录 (需已存在)
+    EXPORT void debug_sink_configure(int mode, int everyN, double nearMissMargin, int queueCapacity,
+                                     const char* directory);
+
+    EXPORT void debug_sink_get_stats(DebugSinkStats* out);
+
+    // 匹配算法 (SearchRequest::method)
+    enum SearchMethod {
+        // OpenCV TM_CCOEFF_NORMED，默认算法，对亮度变化鲁棒
+        SEARCH_METHOD_CCOEFF_NORMED = 0,
+        // 逐次消除 SSD，适合像素级一致的 UI 元素，分数为 1 - RMS(差值)/255
+        SEARCH_METHOD_SSD = 1,
+        // 8 位整数 NCC (AVX2/SSE4.1/标量运行时分派)，分数与 TM_CCOEFF_NORMED 一致，
+        // 不分配结果图，小模板 / 小 ROI 时快于 OpenCV 的 DFT 实现
+        SEARCH_METHOD_NCC_INT8 = 2,
+        // 按代价自动选择: 乘加次数 (候选位置数 x 模板像素数) 较小时用 SEARCH_METHOD_NCC_INT8，
+        // 否则用 SEARCH_METHOD_CCOEFF_NORMED；SearchResultEx::method 给出实际使用的算法
+        // (SSD / NCC_INT8 的模板超过约 11000 行或列、或约 842 万像素时同样改用 CCOEFF_NORMED)
+        SEARCH_METHOD_AUTO = 3,
+    };
+
+    // 请求优先级 (BatchHeader::priorities 版本 3 / compile_search_plan_ex / AutomationRule::priority)
+    // 只在设置了截止时间 (BatchHeader::deadlineUs / automation_set_frame_budget) 时影响执行顺序: 优先级高的先执行，
+    // 同级按估计代价从小到大；预算耗尽后其余请求被跳过 (SEARCH_RESULT_SKIPPED_DEADLINE)，
+    // 同一请求列表的下一批次或计划的下一次执行排在所有非关键请求之前
+    enum SearchPriority {
+        SEARCH_PRIORITY_NORMAL = 0,
+        SEARCH_PRIORITY_CRITICAL = 100, // 不低于该值的请求总是执行，不受截止时间限制
+    };
+
     // 批量任务结构体
+    // method 占用 roiH 与 threshold 之间原有的对齐空位，结构体大小不变 (32 字节)
+    // find_images_batch / submit_batch / compile_search_plan / AutomationRule 按该布局读取且没有版本号，
+    // 不能再追加字段；新的逐请求参数放在带版本的结构体中 (如 BatchHeader::priorities)
     struct SearchRequest {
         int templateId;
         int roiX;
         int roiY;
         int roiW;
         int roiH;
+        int method;  // SearchMethod
         double threshold;
     };
 
@@ -55,6 +159,156 @@ extern "C" {
         double score;
     };
 
+    // 最近一次 find_images_batch 的调试统计
+    // 重叠 ROI 先合并为准备区域，像素转换每个区域只做一次；
+    // SSD / 整数 NCC 请求按 (ROI, 模板尺寸, 通道数) 分组，组内共享一次滑动窗口统计
+    struct BatchDebugStats {
+        int requestCount;       // 请求总数
+        int opencvRequests;     // 走 OpenCV matchTemplate 的请求数
+        int kernelRequests;     // 走自研内核 (SSD / 整数 NCC) 的请求数
+        int groupCount;         // 自研内核请求被分成的组数
+        int sharedRequests;     // 位于多请求组内、共享窗口统计的请求数
+        int windowStatsPasses;  // 实际计算窗口统计的次数
+        int windowStatsSaved;   // 因共享而省去的窗口统计次数
+        int regionCount;        // 重叠 ROI 合并后的准备区域数
+        long long requestedPixels; // 各请求 ROI 面积之和
+        long long preparedPixels;  // 实际准备 (转换) 的像素数
+    };
+
+    // 扩展结果 (find_images_batch_ex，按需启用)
+    // 结构体布局随 SEARCH_RESULT_EX_VERSION 变化；调用方在 BatchHeader 中声明自己使用的版本与大小
+    // 版本 2: BatchHeader 增加 deadlineUs / skippedCount
+    // 版本 3: BatchHeader 增加 priorities (仍接受版本 1、2 的调用方)
+    #define SEARCH_RESULT_EX_VERSION 3
+
+    // SearchResultEx::flags
+    enum SearchResultFlags {
+        SEARCH_RESULT_NOT_RUN = 1 << 0,     // 模板不存在或 ROI 无效，未执行匹配
+        SEARCH_RESULT_CACHED = 1 << 1,      // 滑动窗口统计复用了同组其他请求的计算结果
+        SEARCH_RESULT_PREFILTERED = 1 << 2, // 部分候选位置被 SSD 窗口和下界预先淘汰
+        SEARCH_RESULT_SKIPPED_DEADLINE = 1 << 3, // 批次预算耗尽，未执行匹配 (结果为未找到)
+        SEARCH_RESULT_TILED = 1 << 4,       // 大 ROI 分块并行匹配 (分数与不分块时相同)
+    };
+
+    struct SearchResultEx {
+        int templateId;
+        int x;
+        int y;
+        int method;               // 实际使用的算法 (SearchMethod)，编译时可能由默认算法自动切换
+        double score;
+        long long timeNs;         // 本请求的匹配耗时 (不含解码与区域转换)
+        long long positions;      // 评估的候选位置数
+        long long pixelsScanned;  // 参与比较的模板像素次数 (SSD 为剪枝后的实际值)
+        int flags;                // SearchResultFlags
+        int reserved;
+    };
+
+    // 批次级信息
+    struct BatchHeader {
+        int version;        // 输入: 调用方使用的 SEARCH_RESULT_EX_VERSION；输出: 库实现的版本
+        int resultSize;     // 输入: 调用方的 sizeof(SearchResultEx)
+        int requestCount;
+        int regionCount;    // 准备区域数
+        long long decodeNs; // 解码 / 构造源图
+        long long convertNs;// 各区域 BGRA -> BGR 转换合计
+        long long matchNs;  // 全部匹配合计
+        long long totalNs;  // 整个调用
+        // 以下字段自版本 2 起
+        long long deadlineUs; // 输入: 批次预算 (微秒，从调用开始计)，0 表示不限
+        int skippedCount;     // 因预算耗尽跳过的请求数
+        int reserved;
+        // 以下字段自版本 3 起
+        const int* priorities; // 输入: 与 requests 等长的优先级 (SearchPriority 或任意整数，越大越先执行)，
+                               // NULL 表示全部为 SEARCH_PRIORITY_NORMAL；只在 deadlineUs > 0 时生效
+    };
+
+    // 获取最近一次批量查找的调试统计
+    EXPORT void get_last_batch_debug_stats(BatchDebugStats* out);
+
+    // 运行期统计 (长时间运行时观察引擎行为)
+    // 记录端每线程无锁计数，读取时汇总；延迟分位数来自对数-线性直方图 (相对误差约 6%)
+    struct LatencySummary {
+        long long count;
+        long long totalNs;
+        long long p50Ns;
+        long long p99Ns;
+        long long maxNs;
+    };
+
+    struct SearchStats {
+        long long batches;       // 批量查找次数 (find_images_batch / _ex / submit_batch)
+        LatencySummary decode;   // 每批一次: 解码 / 构造源图
+        LatencySummary convert;  // 每个准备区域一次: BGRA -> BGR
+        LatencySummary match;    // 每个请求一次 (含 run_search_plan)
+    };
+
+    // 按模板的统计
+    // 模板按 templateId 的低 10 位分槽，ID 相差 1024 整数倍的模板会合并计数
+    struct TemplateStats {
+        int templateId;
+        int reserved;
+        long long calls;
+        long long hits;     // 分数达到阈值的次数
+        long long totalNs;
+        long long maxNs;
+    };
+
+    // 获取统计快照
+    // templates 可为 NULL；最多写入 capacity 项，按 templateId 排序
+    // 返回值: 有调用记录的模板数 (可能大于 capacity)，-1 参数无效
+    EXPORT int get_search_stats(SearchStats* out, TemplateStats* templates, int capacity);
+
+    // 清零全部统计
+    EXPORT void reset_search_stats();
+
+    // === 追踪 (Chrome trace-event) ===
+    // 需以 IMAGE_SEARCH_TRACING=ON 构建，否则以下函数为空操作，trace_dump 返回 -2
+    // 运行期默认关闭；开启后各线程把作用域事件写入各自的环形缓冲，dump 时汇总成 JSON
+
+    // 开关追踪 (非 0 开启)
+    EXPORT void trace_enable(int enabled);
+
+    // 追踪是否开启 (未编译追踪支持时恒为 0)
+    EXPORT int trace_is_enabled();
+
+    // 当前追踪时钟 (纳秒)，供调用方为 trace_record 计时
+    EXPORT long long trace_now_ns();
+
+    // 驻留事件名称，返回在进程生命周期内有效的句柄 (同名返回同一句柄)；未编译追踪支持时返回 NULL
+    // 驻留需要加锁查表，调用方应按调用点缓存句柄 (不受 trace_enable 影响，可在启动时取得)
+    EXPORT const char* trace_intern(const char* name);
+
+    // 记录一个完整事件 (调用方线程)，不加锁、不分配；name 必须是 trace_intern 返回的句柄，NULL 时忽略
+    EXPORT void trace_record(const char* name, long long startNs, long long durationNs);
+
+    // 清空已记录的事件
+    EXPORT void trace_clear();
+
+    // 写出 JSON (可在 chrome://tracing 或 Perfetto 中打开)
+    // 返回值: 事件数, -1 文件无法写入, -2 未编译追踪支持
+    EXPORT int trace_dump(const char* path);
+
+    // 批量查找 (扩展结果)
+    // 与 find_images_batch 相同，但为每个请求输出耗时与代价统计，并在 header 中输出批次耗时
+    // header->version / resultSize 必须由调用方填写，用于校验结构体布局
+    // header->deadlineUs > 0 (版本 2) 时按 header->priorities (版本 3) 排序执行，超出预算的非关键请求被跳过
+    // 返回值: 0 成功, -2 图片无效, -3 参数无效, -4 版本或结构体大小不匹配
+    EXPORT int find_images_batch_ex(
+        uint8_t* imageBytes, int length,
+        int width, int height, int stride,
+        SearchRequest* requests, int count,
+        SearchResultEx* results, BatchHeader* header
+    );
+
+    // 从缓冲池取得一块输入缓冲 (64 字节对齐，容量 >= size)
+    // 调用方把帧数据 (BMP / PNG / Raw BGRA) 直接写入其中，再传给 find_images_batch，
+    // 后者原地读取；用完后调用 release_input_buffer 归还，下一帧复用同一块内存
+    // 返回值: 缓冲指针，失败返回 NULL
+    EXPORT uint8_t* acquire_input_buffer(int size);
+
+    // 归还 acquire_input_buffer 取得的缓冲；其他指针会被忽略
+    EXPORT void release_input_buffer(uint8_t* buffer);
+
     // 批量查找
     // imageBytes: 图片数据指针 (可以是 PNG/JPG 压缩数据，也可以是 BGRA 原始像素)
     // length: 数据长度
@@ -70,6 +324,269 @@ extern "C" {
         SearchRequest* requests, int count, 
         SearchResultItem* results
     );
+
+    // 异步批量查找完成回调
+    // ticket: submit_batch 返回的票据；status: 0 成功，-2 图片无效
+    // 在原生工作线程上调用，回调返回后库不再访问该批次的图片与结果缓冲
+    typedef void (*BatchCompletionCallback)(int ticket, int status, void* userData);
+
+    // 异步批量查找：提交到原生工作线程池后立即返回，多个批次可并发执行
+    // 参数含义与 find_images_batch 相同；requests 在提交时复制，
+    // imageBytes 与 results 必须保持有效直到 callback 被调用
+    // 返回值: ticket (>0 成功, -3 参数无效)
+    EXPORT int submit_batch(
+        uint8_t* imageBytes, int length,
+        int width, int height, int stride,
+        SearchRequest* requests, int count,
+        SearchResultItem* results,
+        BatchCompletionCallback callback, void* userData
+    );
+
+    // 编译可重复执行的查找计划 (每帧发送相同请求列表的场景)
+    // 编译时一次性解析模板、裁剪 ROI、合并准备区域、划分分组、选择算法并预分配工作区；
+    // 计划持有模板引用，之后 release_template 不影响已编译的计划
+    // frameWidth / frameHeight: 之后每次执行的 BGRA 帧尺寸
+    // 返回值: planId (>0 成功, -1 计划数已达上限, -3 参数无效)
+    EXPORT int compile_search_plan(SearchRequest* requests, int count, int frameWidth, int frameHeight);
+
+    // 同 compile_search_plan，另给出与 requests 等长的优先级 (SearchPriority，NULL 表示全部为 SEARCH_PRIORITY_NORMAL)
+    // 优先级在编译时固定，只在 run_search_plan_ex 设置了截止时间时生效
+    EXPORT int compile_search_plan_ex(SearchRequest* requests, int count, int frameWidth, int frameHeight,
+                                      const int* priorities);
+
+    // 在一帧 BGRA 原始像素上执行计划
+    // 稳态下不加锁；使用 SSD / 整数 NCC 内核的请求不分配内存
+    // (TM_CCOEFF_NORMED 请求的结果图已预分配，但 OpenCV 内部的 DFT 临时缓冲仍由其自行管理)
+    // 执行不会更新 get_last_batch_debug_stats
+    // results: 长度需 >= 编译时的请求数
+    // 返回值: 0 成功, -1 计划无效, -2 同一计划正在其他线程执行, -3 参数无效
+    EXPORT int run_search_plan(int planId, uint8_t* pixels, int stride, SearchResultItem* results);
+
+    // 与 run_search_plan 相同，但输出扩展结果与本次执行的耗时，并可限定本帧预算
+    // header->version / resultSize 的校验同 find_images_batch_ex (decodeNs 恒为 0)；
+    // header->deadlineUs > 0 (版本 2) 时按编译时的优先级执行，超出预算的非关键请求被跳过
+    // (SEARCH_RESULT_SKIPPED_DEADLINE)；跳过记录保存在计划内，下一次执行时这些请求优先。
+    // header->priorities 被忽略
+    // 返回值: 0 成功, -1 计划无效, -2 同一计划正在其他线程执行, -3 参数无效, -4 版本或结构体大小不匹配
+    EXPORT int run_search_plan_ex(int planId, uint8_t* pixels, int stride, SearchResultEx* results,
+                                  BatchHeader* header);
+
+    // 释放计划；之后该 ID 失效。正在其他线程上执行的 run_search_plan 照常完成，计划在其结束后析构
+    EXPORT void release_search_plan(int planId);
+
+    // === 帧驱动自动化 ===
+    // 注册一组规则后，每来一帧 (automation_submit_frame，由 Runner 在截图回调中调用)
+    // 就在工作线程上执行一次全部规则，只通过回调上报紧凑的事件，不再由 Dart 拉取整帧。
+    // 评估跟不上帧率时只评估最新一帧。同一时间只有一组规则生效。
+
+    struct AutomationRule {
+        SearchRequest request;  // 模板、ROI、算法与阈值
+        int repeatMs;           // 持续出现时重复上报的最小间隔 (毫秒)，0 表示只在出现 / 消失时上报
+        int priority;           // SearchPriority，只在设置了单帧预算 (automation_set_frame_budget) 时生效
+    };
+
+    enum AutomationEventKind {
+        AUTOMATION_EVENT_LOST = 0,   // 上一帧出现、这一帧消失
+        AUTOMATION_EVENT_FOUND = 1,  // 上一帧未出现、这一帧出现
+        AUTOMATION_EVENT_REPEAT = 2, // 持续出现，距上次上报已超过 repeatMs
+    };
+
+    struct AutomationEvent {
+        int kind;           // AutomationEventKind
+        int rule;           // 规则下标
+        int templateId;
+        int x;
+        int y;
+        int reserved;
+        double score;
+        long long frameId;   // 从 1 开始的帧序号
+        long long latencyNs; // 帧到达到评估完成的反应延迟
+    };
+
+    struct AutomationStats {
+        long long framesSubmitted;
+        long long framesEvaluated;
+        long long framesDropped;  // 流水线任一级跟不上时被挤掉的帧数
+        long long events;
+        long long lastLatencyNs;  // 以下延迟均为帧到达到评估完成
+        long long p50LatencyNs;   // 最近 256 帧
+        long long p99LatencyNs;
+        long long maxLatencyNs;   // 自启动以来
+        long long rulesEvaluated; // 实际匹配的规则次数
+        long long rulesSkipped;   // 因前置条件未满足而短路跳过的规则次数
+        long long rulesDeferred;  // 调度器判定未到期或超出单帧预算、沿用上次结果的规则次数
+        double cpuUsage;          // 评估线程忙碌比例 (单核，最近约 0.5 秒)
+        double governorScale;     // 因 CPU 预算放大采样间隔的倍数 (1 表示未受限)
+    };
+
+    // 自适应调度 (按规则调整评估频率)
+    // 刚命中的规则按 minIntervalMs 采样 (0 表示每帧)，未命中时间隔从 16 ms 起每次加倍，直到 maxIntervalMs；
+    // 画面变化 (采样像素的平均绝对帧差) 超过 sceneChangeThreshold 时所有规则立即重新评估；
+    // 评估线程忙碌比例超过 cpuBudget 时整体放大采样间隔，回落到预算一半以下时逐步恢复。
+    // 未到期的规则沿用上次结果，不产生事件。
+    struct AutomationGovernorConfig {
+        int enabled;                 // 0: 每帧评估全部规则 (默认)
+        int minIntervalMs;
+        int maxIntervalMs;
+        double sceneChangeThreshold; // 0-255，0 表示不检测画面变化
+        double cpuBudget;            // 0-1 (单核比例)，0 表示不限制
+    };
+
+    struct AutomationRuleStats {
+        long long evaluations;   // 实际匹配次数
+        long long hits;
+        double rateHz;           // 最近约 0.5 秒的实际评估频率
+        double hitRate;          // 命中率滑动平均 (用于条件排序)
+        int intervalMs;          // 当前采样间隔 (未计入 CPU 预算倍数)
+        int reserved;
+    };
+
+    // 事件回调 (在工作线程上调用，参数均为值，适合 Dart NativeCallable.listener)
+    typedef void (*AutomationEventCallback)(int kind, int rule, int templateId, int x, int y, double score,
+                                            long long frameId, long long latencyNs, void* userData);
+
+    // 启动自动化 (已在运行时先停止旧的)；模板在 engine 中解析并被规则持有
+    // 规则相互独立，每帧全部评估；count 不超过 64
+    // 返回值: 0 成功, -3 参数无效, -5 引擎无效
+    EXPORT int automation_start(int engine, const AutomationRule* rules, int count,
+                                AutomationEventCallback callback, void* userData);
+
+    // 停止自动化；返回后不会再有回调。可在事件回调内调用 (工作线程在回调返回后退出，由后台回收)
+    EXPORT void automation_stop();
+
+    // 提交一帧 BGRA 像素 (内部复制，返回后即可复用缓冲)
+    // arrivalNs: 帧到达时间，取自 trace_now_ns 同一时钟；传 0 表示以提交时刻为准
+    // 返回值: 0 已提交, -1 自动化未运行, -3 参数无效
+    EXPORT int automation_submit_frame(const uint8_t* pixels, int width, int height, int stride, long long arrivalNs);
+
+    EXPORT void automation_get_stats(AutomationStats* out);
+
+    // 设置调度参数，立即作用于运行中的自动化，并作为之后 automation_start 的默认值
+    // (场景文件中的 governor 段优先)；config 为空时关闭调度
+    EXPORT void automation_set_governor(const AutomationGovernorConfig* config);
+
+    // 设置单帧评估预算 (微秒，从开始评估该帧计)，0 表示不限 (默认)；
+    // 立即作用于运行中的自动化，并作为之后 automation_start / scenario_start 的默认值。
+    // 预算耗尽后其余非关键规则 (priority < SEARCH_PRIORITY_CRITICAL) 本帧不再匹配，沿用上次结论 (计为延后)，
+    // 下一帧优先评估
+    EXPORT void automation_set_frame_budget(long long budgetUs);
+
+    // 每条规则的评估频率与命中情况，返回规则数 (写入 min(规则数, capacity) 项)，未运行时返回 0
+    EXPORT int automation_get_rule_stats(AutomationRuleStats* out, int capacity);
+
+    // 场景文件 (JSON，格式见 scenario.h): 模板、ROI、阈值、前置条件、冷却时间与动作
+    // 编译为规则图后启动自动化 (替换当前规则组)。前置条件未满足的规则短路跳过，不做匹配。
+    // 回调与 automation_start 相同，rule 为场景中的规则下标；动作由调用方按 scenario_get_rule 执行。
+    // 模板由场景加载 (路径相对场景文件目录)，不登记到引擎的模板表，templateId 为场景内模板编号；
+    // engine 只决定运行期统计记入哪个引擎。
+    // error: 失败时写入原因 (UTF-8，以 0 结尾)，可为空
+    // 返回值: 规则数 (>0), -1 场景无效或模板加载失败, -3 参数无效, -5 引擎无效
+    EXPORT int scenario_start(int engine, const char* path, AutomationEventCallback callback, void* userData,
+                              char* error, int errorSize);
+
+    struct ScenarioRuleInfo {
+        char name[32];      // UTF-8，超长时截断
+        char label[64];     // 显示名称
+        int templateId;     // 场景内模板编号
+        int templateWidth;
+        int templateHeight;
+        int actionKey;      // Windows 虚拟键码，0 表示无动作
+        int actionHoldMs;
+        int cooldownMs;
+    };
+
+    // 当前运行场景的第 index 条规则
+    // 返回值: 0 成功, -1 没有运行中的场景或下标越界
+    EXPORT int scenario_get_rule(int index, ScenarioRuleInfo* out);
+
+    // === 帧录制 ===
+    // 把截图帧 (recorder_submit_frame，由 Runner 在截图回调中调用) 无损压缩写入 .frec 文件，
+    // 供 search_replay / automation_replay 回放。关键帧之间是只存变化块的差分帧 (格式见 frame_recorder.h)；
+    // 编码与写盘在后台线程进行，跟不上时丢弃新帧而不阻塞截图。同一时间只有一个录制。
+
+    struct RecorderStats {
+        long long submitted;     // 进入写入队列的帧
+        long long written;       // 已写入文件的帧
+        long long dropped;       // 写入线程跟不上、队列满而丢弃的帧
+        long long keyframes;
+        long long bytesWritten;  // 文件当前大小
+        long long rawBytes;      // 已写入帧的 BGR 原始大小 (除以 bytesWritten 即压缩比)
+        long long lastEncodeNs;  // 最近一帧的转换、编码与写入耗时
+        long long maxEncodeNs;
+        int recording;           // 1 表示正在录制
+        int failed;              // 1 表示写入出错 (磁盘满等)，之后的帧不再写入
+    };
+
+    // 开始录制到 path (已在录制时先停止旧的录制)
+    // keyframeInterval: 关键帧间隔 (帧数)，决定随机访问时最多解码的帧数；<= 0 使用默认值 60
+    // 返回值: 0 成功, -1 文件无法创建, -3 参数无效
+    EXPORT int recorder_start(const char* path, int keyframeInterval);
+
+    // 提交一帧 BGRA 像素 (内部复制，返回后即可复用缓冲)，参数同 automation_submit_frame
+    // 返回值: 0 已排队, 1 队列满 (或正在停止) 被丢弃, -1 未在录制, -3 参数无效
+    EXPORT int recorder_submit_frame(const uint8_t* pixels, int width, int height, int stride, long long arrivalNs);
+
+    // 停止录制: 写完排队中的帧与索引后关闭文件
+    // 返回值: 0 成功, -1 未在录制, -2 写入出错 (已写入的完整帧仍可读取)
+    EXPORT int recorder_stop();
+
+    // 当前 (或最近一次) 录制的统计
+    EXPORT void recorder_get_stats(RecorderStats* out);
+
+    // === 引擎实例 ===
+    // 每个引擎拥有独立的模板表 (模板 ID 各自从 1 编号)、输入缓冲池与运行期统计，
+    // 多个会话 (如同时处理两个游戏窗口) 使用各自的引擎即可互不争用。
+    // 以上不带引擎参数的接口都作用于默认引擎 (句柄 0)。
+    // 下列 engine_* 接口与同名旧接口语义一致，引擎句柄无效时返回 -5
+    // (无返回值的接口不做任何事，find 接口返回未找到，acquire 返回 NULL)。
+    // 计划在编译时绑定引擎，run_search_plan / release_search_plan 只需计划 ID。
+
+    // 创建引擎，返回句柄 (>0)，-1 表示数量已达上限
+    EXPORT int engine_create();
+
+    // 销毁引擎及其模板表；进行中的调用与已编译的计划持有各自的引用，可安全完成
+    // 仍借出的输入缓冲保持有效，之后照常用 engine_release_input_buffer 归还时释放
+    // 默认引擎 (0) 不可销毁
+    EXPORT void engine_destroy(int engine);
+
+    EXPORT int engine_load_template(int engine, const char* imagePath);
+    EXPORT int engine_load_templates_bulk(int engine, const TemplateSource* sources, int count, int* outIds,
+                                          TemplateSize* outSizes);
+    EXPORT int engine_load_template_pack(int engine, const char* path, TemplatePackItem* out, int capacity);
+    EXPORT void engine_release_template(int engine, int templateId);
+    EXPORT void engine_release_all_templates(int engine);
+    EXPORT SearchResult engine_find_image(int engine, int templateId, int x, int y, int w, int h, double threshold);
+    EXPORT void engine_get_last_batch_debug_stats(int engine, BatchDebugStats* out);
+    EXPORT int engine_get_search_stats(int engine, SearchStats* out, TemplateStats* templates, int capacity);
+    EXPORT void engine_reset_search_stats(int engine);
+    EXPORT uint8_t* engine_acquire_input_buffer(int engine, int size);
+    EXPORT void engine_release_input_buffer(int engine, uint8_t* buffer);
+    EXPORT void engine_find_images_batch(
+        int engine,
+        uint8_t* imageBytes, int length,
+        int width, int height, int stride,
+        SearchRequest* requests, int count,
+        SearchResultItem* results
+    );
+    EXPORT int engine_find_images_batch_ex(
+        int engine,
+        uint8_t* imageBytes, int length,
+        int width, int height, int stride,
+        SearchRequest* requests, int count,
+        SearchResultEx* results, BatchHeader* header
+    );
+    EXPORT int engine_submit_batch(
+        int engine,
+        uint8_t* imageBytes, int length,
+        int width, int height, int stride,
+        SearchRequest* requests, int count,
+        SearchResultItem* results,
+        BatchCompletionCallback callback, void* userData
+    );
+    EXPORT int engine_compile_search_plan(int engine, SearchRequest* requests, int count,
+                                          int frameWidth, int frameHeight);
+    EXPORT int engine_compile_search_plan_ex(int engine, SearchRequest* requests, int count,
+                                             int frameWidth, int frameHeight, const int* priorities);
 }
 
 #endif // IMAGE_SEARCH_H
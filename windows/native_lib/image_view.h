@@ -0,0 +1,19 @@
+#ifndef IMAGE_VIEW_H
+#define IMAGE_VIEW_H
+
+#include <cstdint>
+
+// 8 位交错像素的只读视图 (不拥有内存)
+// 匹配内核只依赖该结构，不依赖 OpenCV，便于在任意平台单独编译与基准测试
+struct ImageView {
+    const uint8_t* data = nullptr;
+    int width = 0;
+    int height = 0;
+    int stride = 0;   // 每行字节数
+    int channels = 0; // 每像素字节数 (1/3/4)
+
+    const uint8_t* Row(int y) const { return data + static_cast<intptr_t>(y) * stride; }
+    bool Empty() const { return data == nullptr || width <= 0 || height <= 0; }
+};
+
+#endif // IMAGE_VIEW_H
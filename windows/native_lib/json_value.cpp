@@ -0,0 +1,291 @@
+#include "json_value.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <utility>
+
+const JsonValue* JsonValue::Find(const std::string& key) const {
+    if (type_ != OBJECT) return nullptr;
+    auto it = members_.find(key);
+    return it == members_.end() ? nullptr : &it->second;
+}
+
+// 递归下降解析器；嵌套深度有上限，避免恶意文件耗尽栈
+class JsonParser {
+public:
+    explicit JsonParser(const std::string& text) : text_(text) {}
+
+    bool ParseDocument(JsonValue* out, std::string* error) {
+        SkipSpace();
+        if (!ParseValue(out, 0)) {
+            Report(error);
+            return false;
+        }
+        SkipSpace();
+        if (pos_ != text_.size()) {
+            Fail("trailing characters");
+            Report(error);
+            return false;
+        }
+        return true;
+    }
+
+private:
+    static const int kMaxDepth = 64;
+
+    bool Fail(const char* message) {
+        if (!message_) {
+            message_ = message;
+            failPos_ = pos_;
+        }
+        return false;
+    }
+
+    void Report(std::string* error) const {
+        if (!error) return;
+        int line = 1;
+        for (size_t i = 0; i < failPos_ && i < text_.size(); i++) {
+            if (text_[i] == '\n') line++;
+        }
+        char buffer[160];
+        std::snprintf(buffer, sizeof(buffer), "line %d: %s", line, message_ ? message_ : "invalid JSON");
+        *error = buffer;
+    }
+
+    void SkipSpace() {
+        while (pos_ < text_.size()) {
+            const char c = text_[pos_];
+            if (c != ' ' && c != '\t' && c != '\n' && c != '\r') break;
+            pos_++;
+        }
+    }
+
+    bool Consume(const char* literal) {
+        size_t i = 0;
+        while (literal[i]) {
+            if (pos_ + i >= text_.size() || text_[pos_ + i] != literal[i]) return false;
+            i++;
+        }
+        pos_ += i;
+        return true;
+    }
+
+    bool ParseValue(JsonValue* out, int depth) {
+        if (depth > kMaxDepth) return Fail("nesting too deep");
+        if (pos_ >= text_.size()) return Fail("unexpected end of input");
+        const char c = text_[pos_];
+        if (c == '{') return ParseObject(out, depth);
+        if (c == '[') return ParseArray(out, depth);
+        if (c == '"') {
+            out->type_ = JsonValue::STRING;
+            return ParseString(&out->string_);
+        }
+        if (c == '-' || (c >= '0' && c <= '9')) return ParseNumber(out);
+        if (Consume("true")) {
+            out->type_ = JsonValue::BOOL;
+            out->bool_ = true;
+            return true;
+        }
+        if (Consume("false")) {
+            out->type_ = JsonValue::BOOL;
+            out->bool_ = false;
+            return true;
+        }
+        if (Consume("null")) {
+            out->type_ = JsonValue::NUL;
+            return true;
+        }
+        return Fail("unexpected character");
+    }
+
+    bool ParseObject(JsonValue* out, int depth) {
+        out->type_ = JsonValue::OBJECT;
+        pos_++; // '{'
+        SkipSpace();
+        if (pos_ < text_.size() && text_[pos_] == '}') {
+            pos_++;
+            return true;
+        }
+        for (;;) {
+            SkipSpace();
+            if (pos_ >= text_.size() || text_[pos_] != '"') return Fail("expected object key");
+            std::string key;
+            if (!ParseString(&key)) return false;
+            SkipSpace();
+            if (pos_ >= text_.size() || text_[pos_] != ':') return Fail("expected ':'");
+            pos_++;
+            SkipSpace();
+            // 重复的键以最后一次为准
+            if (!ParseValue(&out->members_[key], depth + 1)) return false;
+            SkipSpace();
+            if (pos_ >= text_.size()) return Fail("unterminated object");
+            if (text_[pos_] == ',') {
+                pos_++;
+                continue;
+            }
+            if (text_[pos_] == '}') {
+                pos_++;
+                return true;
+            }
+            return Fail("expected ',' or '}'");
+        }
+    }
+
+    bool ParseArray(JsonValue* out, int depth) {
+        out->type_ = JsonValue::ARRAY;
+        pos_++; // '['
+        SkipSpace();
+        if (pos_ < text_.size() && text_[pos_] == ']') {
+            pos_++;
+            return true;
+        }
+        for (;;) {
+            SkipSpace();
+            out->items_.emplace_back();
+            if (!ParseValue(&out->items_.back(), depth + 1)) return false;
+            SkipSpace();
+            if (pos_ >= text_.size()) return Fail("unterminated array");
+            if (text_[pos_] == ',') {
+                pos_++;
+                continue;
+            }
+            if (text_[pos_] == ']') {
+                pos_++;
+                return true;
+            }
+            return Fail("expected ',' or ']'");
+        }
+    }
+
+    bool ParseNumber(JsonValue* out) {
+        const size_t start = pos_;
+        if (text_[pos_] == '-') pos_++;
+        if (pos_ >= text_.size() || text_[pos_] < '0' || text_[pos_] > '9') return Fail("invalid number");
+        if (text_[pos_] == '0') {
+            pos_++;
+        } else {
+            while (pos_ < text_.size() && text_[pos_] >= '0' && text_[pos_] <= '9') pos_++;
+        }
+        if (pos_ < text_.size() && text_[pos_] == '.') {
+            pos_++;
+            if (pos_ >= text_.size() || text_[pos_] < '0' || text_[pos_] > '9') return Fail("invalid number");
+            while (pos_ < text_.size() && text_[pos_] >= '0' && text_[pos_] <= '9') pos_++;
+        }
+        if (pos_ < text_.size() && (text_[pos_] == 'e' || text_[pos_] == 'E')) {
+            pos_++;
+            if (pos_ < text_.size() && (text_[pos_] == '+' || text_[pos_] == '-')) pos_++;
+            if (pos_ >= text_.size() || text_[pos_] < '0' || text_[pos_] > '9') return Fail("invalid number");
+            while (pos_ < text_.size() && text_[pos_] >= '0' && text_[pos_] <= '9') pos_++;
+        }
+        out->type_ = JsonValue::NUMBER;
+        out->number_ = std::strtod(text_.substr(start, pos_ - start).c_str(), nullptr);
+        return true;
+    }
+
+    bool ParseHex4(unsigned* out) {
+        if (pos_ + 4 > text_.size()) return Fail("truncated \\u escape");
+        unsigned value = 0;
+        for (int i = 0; i < 4; i++) {
+            const char c = text_[pos_++];
+            value <<= 4;
+            if (c >= '0' && c <= '9') value |= c - '0';
+            else if (c >= 'a' && c <= 'f') value |= c - 'a' + 10;
+            else if (c >= 'A' && c <= 'F') value |= c - 'A' + 10;
+            else return Fail("invalid \\u escape");
+        }
+        *out = value;
+        return true;
+    }
+
+    static void AppendUtf8(unsigned cp, std::string* out) {
+        if (cp < 0x80) {
+            out->push_back(static_cast<char>(cp));
+        } else if (cp < 0x800) {
+            out->push_back(static_cast<char>(0xC0 | (cp >> 6)));
+            out->push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+        } else if (cp < 0x10000) {
+            out->push_back(static_cast<char>(0xE0 | (cp >> 12)));
+            out->push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+            out->push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+        } else {
+            out->push_back(static_cast<char>(0xF0 | (cp >> 18)));
+            out->push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3F)));
+            out->push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+            out->push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+        }
+    }
+
+    bool ParseString(std::string* out) {
+        pos_++; // '"'
+        for (;;) {
+            if (pos_ >= text_.size()) return Fail("unterminated string");
+            const char c = text_[pos_++];
+            if (c == '"') return true;
+            if (static_cast<unsigned char>(c) < 0x20) return Fail("control character in string");
+            if (c != '\\') {
+                out->push_back(c);
+                continue;
+            }
+            if (pos_ >= text_.size()) return Fail("unterminated string");
+            const char e = text_[pos_++];
+            switch (e) {
+            case '"': out->push_back('"'); break;
+            case '\\': out->push_back('\\'); break;
+            case '/': out->push_back('/'); break;
+            case 'b': out->push_back('\b'); break;
+            case 'f': out->push_back('\f'); break;
+            case 'n': out->push_back('\n'); break;
+            case 'r': out->push_back('\r'); break;
+            case 't': out->push_back('\t'); break;
+            case 'u': {
+                unsigned cp;
+                if (!ParseHex4(&cp)) return false;
+                if (cp >= 0xD800 && cp <= 0xDBFF) {
+                    unsigned low;
+                    if (!Consume("\\u") || !ParseHex4(&low) || low < 0xDC00 || low > 0xDFFF) {
+                        return Fail("invalid surrogate pair");
+                    }
+                    cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                } else if (cp >= 0xDC00 && cp <= 0xDFFF) {
+                    return Fail("invalid surrogate pair");
+                }
+                AppendUtf8(cp, out);
+                break;
+            }
+            default:
+                return Fail("invalid escape");
+            }
+        }
+    }
+
+    const std::string& text_;
+    size_t pos_ = 0;
+    const char* message_ = nullptr;
+    size_t failPos_ = 0;
+};
+
+bool JsonValue::Parse(const std::string& text, JsonValue* out, std::string* error) {
+    JsonValue value;
+    JsonParser parser(text);
+    if (!parser.ParseDocument(&value, error)) return false;
+    *out = std::move(value);
+    return true;
+}
+
+std::string JsonQuote(const std::string& text) {
+    std::string out = "\"";
+    for (const char c : text) {
+        const unsigned char u = static_cast<unsigned char>(c);
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (u < 0x20) {
+            char buffer[8];
+            std::snprintf(buffer, sizeof(buffer), "\\u%04x", u);
+            out += buffer;
+        } else {
+            out += c;
+        }
+    }
+    return out + "\"";
+}
@@ -0,0 +1,59 @@
+#ifndef JSON_VALUE_H
+#define JSON_VALUE_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+// 最小 JSON 解析 (RFC 8259)
+//
+// 只用于读取场景等小型配置文件: 整个文档解析为值树，不做流式处理。
+// 字符串按 UTF-8 保存 (\uXXXX 转义含代理对会被编码为 UTF-8)；数字统一为 double。
+class JsonValue {
+public:
+    enum Type { NUL, BOOL, NUMBER, STRING, ARRAY, OBJECT };
+
+    JsonValue() = default;
+
+    Type type() const { return type_; }
+    bool IsNull() const { return type_ == NUL; }
+    bool IsBool() const { return type_ == BOOL; }
+    bool IsNumber() const { return type_ == NUMBER; }
+    bool IsString() const { return type_ == STRING; }
+    bool IsArray() const { return type_ == ARRAY; }
+    bool IsObject() const { return type_ == OBJECT; }
+
+    bool AsBool() const { return bool_; }
+    double AsNumber() const { return number_; }
+    const std::string& AsString() const { return string_; }
+    const std::vector<JsonValue>& Items() const { return items_; }
+    const std::map<std::string, JsonValue>& Members() const { return members_; }
+
+    // 对象成员，不存在 (或自身不是对象) 时返回 nullptr
+    const JsonValue* Find(const std::string& key) const;
+
+    // 解析整个文档，失败返回 false 并写入带行号的原因 (error 可为空)
+    static bool Parse(const std::string& text, JsonValue* out, std::string* error = nullptr);
+
+private:
+    friend class JsonParser;
+
+    Type type_ = NUL;
+    bool bool_ = false;
+    double number_ = 0;
+    std::string string_;
+    std::vector<JsonValue> items_;
+    std::map<std::string, JsonValue> members_;
+};
+
+// JSON 字符串字面量: 加引号，转义引号、反斜杠与控制字符 (\uXXXX)，其余字节 (UTF-8) 原样输出
+// 配置、标注、报告与追踪的写出共用
+std::string JsonQuote(const std::string& text);
+
+// 解析辅助: 写入错误原因 (error 可为空) 并返回 false
+inline bool SetError(std::string* error, const std::string& message) {
+    if (error) *error = message;
+    return false;
+}
+
+#endif // JSON_VALUE_H
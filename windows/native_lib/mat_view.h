@@ -0,0 +1,19 @@
+#ifndef MAT_VIEW_H
+#define MAT_VIEW_H
+
+#include "image_view.h"
+
+#include <opencv2/core.hpp>
+
+// cv::Mat 转为匹配内核使用的只读视图 (零拷贝，支持非连续 ROI)
+inline ImageView ToImageView(const cv::Mat& mat) {
+    ImageView view;
+    view.data = mat.data;
+    view.width = mat.cols;
+    view.height = mat.rows;
+    view.stride = static_cast<int>(mat.step);
+    view.channels = mat.channels();
+    return view;
+}
+
+#endif // MAT_VIEW_H
@@ -0,0 +1,140 @@
+#include "ncc_matcher.h"
+#include "simd_dot.h"
+
+#include <cfloat>
+#include <cmath>
+
+void PrepareNccTemplate(const ImageView& templ, const TemplateSums& templSums, NccTemplate* out) {
+    out->rowElems = templ.width * templ.channels;
+    out->wide.resize(static_cast<size_t>(out->rowElems) * templ.height);
+    for (int y = 0; y < templ.height; y++) {
+        const uint8_t* row = templ.Row(y);
+        int16_t* dst = out->wide.data() + static_cast<size_t>(y) * out->rowElems;
+        for (int i = 0; i < out->rowElems; i++) {
+            dst[i] = row[i];
+        }
+    }
+
+    // 超出 Fits 的模板不会走整数内核，这里也不做会溢出的乘积
+    out->varianceScaled = 0;
+    if (!SlidingWindowStats::Fits(templ.width, templ.height, templ.channels, true)) {
+        return;
+    }
+    int64_t meanEnergy = 0;
+    for (int c = 0; c < templSums.channels; c++) {
+        meanEnergy += templSums.sum[c] * templSums.sum[c];
+    }
+    out->varianceScaled = templSums.area * templSums.sumSq - meanEnergy;
+}
+
+// 由整数分子与窗口方差得到分数，与 OpenCV common_matchTemplate 相同的边界处理
+static double NormalizeScore(int64_t numerator, int64_t windowVariance, double templNorm) {
+    const double num = static_cast<double>(numerator);
+    const double t = std::sqrt(static_cast<double>(windowVariance > 0 ? windowVariance : 0)) * templNorm;
+    if (std::fabs(num) < t) {
+        return num / t;
+    }
+    if (std::fabs(num) < t * 1.125) {
+        return num > 0 ? 1.0 : -1.0;
+    }
+    return 0.0;
+}
+
+void BeginNccSearch(NccMatchResult* result) {
+    *result = NccMatchResult();
+    result->score = -DBL_MAX;
+}
+
+void NccMatchRow(const ImageView& src, const TemplateSums& templSums, const NccTemplate& ncc,
+                 const int32_t* windowSums, const int64_t* windowSquareSums,
+                 int cols, int y, NccMatchResult* result, float* rowScores) {
+    const DotU8S16Fn dot = GetDotU8S16();
+    const int ch = templSums.channels;
+    const int64_t area = templSums.area;
+    const int rows = static_cast<int>(ncc.wide.size() / (ncc.rowElems > 0 ? ncc.rowElems : 1));
+    const double templNorm = std::sqrt(static_cast<double>(ncc.varianceScaled));
+
+    result->positions += cols;
+    for (int x = 0; x < cols; x++) {
+        double score;
+        if (ncc.varianceScaled <= 0) {
+            // 纯色模板: OpenCV 对整张结果图返回 1
+            score = 1.0;
+        } else {
+            const int32_t* ws = windowSums + x * ch;
+            int64_t meanCross = 0;
+            int64_t meanEnergy = 0;
+            for (int c = 0; c < ch; c++) {
+                meanCross += templSums.sum[c] * ws[c];
+                meanEnergy += static_cast<int64_t>(ws[c]) * ws[c];
+            }
+            const int64_t windowVariance = area * windowSquareSums[x] - meanEnergy;
+
+            int64_t cross = 0;
+            const uint8_t* base = src.data + static_cast<intptr_t>(y) * src.stride + x * ch;
+            for (int r = 0; r < rows; r++) {
+                cross += dot(base + static_cast<intptr_t>(r) * src.stride,
+                             ncc.wide.data() + static_cast<size_t>(r) * ncc.rowElems, ncc.rowElems);
+            }
+
+            score = NormalizeScore(area * cross - meanCross, windowVariance, templNorm);
+        }
+
+        if (rowScores) {
+            rowScores[x] = static_cast<float>(score);
+        }
+        // 严格大于: 与 minMaxLoc 一样返回行优先的第一个最大值
+        if (score > result->score) {
+            result->score = score;
+            result->x = x;
+            result->y = y;
+        }
+    }
+}
+
+double NccScoreAt(const ImageView& src, const TemplateSums& templSums, const NccTemplate& ncc, int x, int y) {
+    if (ncc.varianceScaled <= 0) {
+        return 1.0;
+    }
+    const DotU8S16Fn dot = GetDotU8S16();
+    const int ch = templSums.channels;
+    const int rows = static_cast<int>(ncc.wide.size() / (ncc.rowElems > 0 ? ncc.rowElems : 1));
+    int64_t windowSums[4] = {};
+    int64_t windowSquares = 0;
+    int64_t cross = 0;
+    for (int r = 0; r < rows; r++) {
+        const uint8_t* row = src.data + static_cast<intptr_t>(y + r) * src.stride + x * ch;
+        cross += dot(row, ncc.wide.data() + static_cast<size_t>(r) * ncc.rowElems, ncc.rowElems);
+        for (int i = 0; i < ncc.rowElems; i++) {
+            windowSums[i % ch] += row[i];
+            windowSquares += row[i] * row[i];
+        }
+    }
+
+    int64_t meanCross = 0;
+    int64_t meanEnergy = 0;
+    for (int c = 0; c < ch; c++) {
+        meanCross += templSums.sum[c] * windowSums[c];
+        meanEnergy += windowSums[c] * windowSums[c];
+    }
+    const int64_t area = templSums.area;
+    return NormalizeScore(area * cross - meanCross, area * windowSquares - meanEnergy,
+                          std::sqrt(static_cast<double>(ncc.varianceScaled)));
+}
+
+bool MatchNcc(const ImageView& src, const ImageView& templ, const TemplateSums& templSums,
+              const NccTemplate& ncc, double threshold, SlidingWindowStats* scratch,
+              NccMatchResult* result) {
+    BeginNccSearch(result);
+    if (templ.channels != src.channels || !scratch->Reset(src, templ.width, templ.height, true)) {
+        return false;
+    }
+
+    do {
+        NccMatchRow(src, templSums, ncc, scratch->Sums(), scratch->SquareSums(),
+                    scratch->Cols(), scratch->Row(), result);
+    } while (scratch->Advance());
+
+    result->found = result->x >= 0 && result->score >= threshold;
+    return result->found;
+}
@@ -0,0 +1,54 @@
+#ifndef NCC_MATCHER_H
+#define NCC_MATCHER_H
+
+#include "image_view.h"
+#include "window_stats.h"
+
+#include <cstdint>
+#include <vector>
+
+// 8 位整数归一化相关系数匹配 (与 TM_CCOEFF_NORMED 等价)
+//
+// 分子与方差全部用整数精确计算 (均乘以面积 N 以消去除法):
+//     num  = N * sum(T * I) - sum_c T_c * S_c
+//     varT = N * sum(T^2)   - sum_c T_c^2
+//     varI = N * sum(I^2)   - sum_c S_c^2
+//     score = num / sqrt(varT * varI)
+// 其中 sum(T * I) 由 SIMD 点积逐行计算，T_c / varT 在模板加载时预计算，
+// S_c / sum(I^2) 来自 SlidingWindowStats 的滑动窗口统计。
+// 不分配结果图，逐行追踪最大值，边界处理与 OpenCV 保持一致。
+
+// 模板的预计算数据
+struct NccTemplate {
+    std::vector<int16_t> wide;  // 展宽为 16 位的模板像素，逐行紧密排列
+    int rowElems = 0;           // 每行元素数 (宽 * 通道)
+    int64_t varianceScaled = 0; // varT；模板超出 SlidingWindowStats::Fits (normalized) 时为 0
+};
+
+void PrepareNccTemplate(const ImageView& templ, const TemplateSums& templSums, NccTemplate* out);
+
+struct NccMatchResult {
+    bool found = false;
+    int x = -1;
+    int y = -1;
+    double score = 0.0;
+    int64_t positions = 0;
+};
+
+void BeginNccSearch(NccMatchResult* result);
+
+// 处理结果图第 y 行的全部候选位置，更新最大值
+// rowScores 可为空；非空时写入该行每个位置的分数 (用于校验或调试)
+void NccMatchRow(const ImageView& src, const TemplateSums& templSums, const NccTemplate& ncc,
+                 const int32_t* windowSums, const int64_t* windowSquareSums,
+                 int cols, int y, NccMatchResult* result, float* rowScores = nullptr);
+
+// 单个候选位置 (x, y) 的分数，与 NccMatchRow 逐位相同；窗口统计直接求和，代价 O(模板面积)
+double NccScoreAt(const ImageView& src, const TemplateSums& templSums, const NccTemplate& ncc, int x, int y);
+
+// 完整搜索，返回 true 表示最大分数不低于 threshold
+bool MatchNcc(const ImageView& src, const ImageView& templ, const TemplateSums& templSums,
+              const NccTemplate& ncc, double threshold, SlidingWindowStats* scratch,
+              NccMatchResult* result);
+
+#endif // NCC_MATCHER_H
@@ -0,0 +1,275 @@
+#include "scenario.h"
+#include "json_value.h"
+
+#include <opencv2/imgcodecs.hpp>
+
+#include <fstream>
+#include <map>
+#include <sstream>
+
+static bool IsAbsolutePath(const std::string& path) {
+    if (path.empty()) return false;
+    if (path[0] == '/' || path[0] == '\\') return true;
+    return path.size() > 1 && path[1] == ':'; // 盘符
+}
+
+std::string JoinPath(const std::string& dir, const std::string& file) {
+    if (dir.empty() || IsAbsolutePath(file)) return file;
+    const char last = dir.back();
+    return last == '/' || last == '\\' ? dir + file : dir + "/" + file;
+}
+
+// "F" / "7" -> 对应的虚拟键码 (字母、数字与 ASCII 相同)，也接受少量命名键与数字键码
+static bool ParseKey(const JsonValue& value, int* out) {
+    if (value.IsNumber()) {
+        *out = static_cast<int>(value.AsNumber());
+        return *out > 0 && *out < 256;
+    }
+    if (!value.IsString()) return false;
+    const std::string& key = value.AsString();
+    if (key.size() == 1) {
+        char c = key[0];
+        if (c >= 'a' && c <= 'z') c = static_cast<char>(c - 'a' + 'A');
+        if ((c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9')) {
+            *out = c;
+            return true;
+        }
+        return false;
+    }
+    static const struct { const char* name; int code; } kNamedKeys[] = {
+        {"SPACE", 0x20}, {"ENTER", 0x0D}, {"ESC", 0x1B}, {"TAB", 0x09},
+        {"LEFT", 0x25}, {"UP", 0x26}, {"RIGHT", 0x27}, {"DOWN", 0x28},
+    };
+    for (const auto& named : kNamedKeys) {
+        if (key == named.name) {
+            *out = named.code;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ParseSearchMethod(const std::string& name, int* out) {
+    if (name == "ccoeff") *out = SEARCH_METHOD_CCOEFF_NORMED;
+    else if (name == "ssd") *out = SEARCH_METHOD_SSD;
+    else if (name == "ncc") *out = SEARCH_METHOD_NCC_INT8;
+    else if (name == "auto") *out = SEARCH_METHOD_AUTO;
+    else return false;
+    return true;
+}
+
+bool ParseSearchRequestFields(const JsonValue& item, SearchRequest* request, std::string* error) {
+    if (const JsonValue* roi = item.Find("roi")) {
+        if (!roi->IsArray() || roi->Items().size() != 4) return SetError(error, "\"roi\" must be [x, y, w, h]");
+        int values[4];
+        for (int i = 0; i < 4; i++) {
+            if (!roi->Items()[i].IsNumber()) return SetError(error, "\"roi\" must be numeric");
+            values[i] = static_cast<int>(roi->Items()[i].AsNumber());
+        }
+        request->roiX = values[0];
+        request->roiY = values[1];
+        request->roiW = values[2];
+        request->roiH = values[3];
+    }
+    if (const JsonValue* threshold = item.Find("threshold")) {
+        if (!threshold->IsNumber()) return SetError(error, "\"threshold\" must be a number");
+        request->threshold = threshold->AsNumber();
+    }
+    return true;
+}
+
+static bool ParseGovernor(const JsonValue& value, AutomationGovernorConfig* out, std::string* error) {
+    if (!value.IsObject()) return SetError(error, "\"governor\" must be an object");
+    *out = AutomationGovernorConfig();
+    out->enabled = 1;
+    if (const JsonValue* enabled = value.Find("enabled")) {
+        if (!enabled->IsBool()) return SetError(error, "governor: \"enabled\" must be a boolean");
+        out->enabled = enabled->AsBool() ? 1 : 0;
+    }
+    static const char* const kFields[] = {"minIntervalMs", "maxIntervalMs", "sceneChange", "cpuBudget"};
+    double values[4] = {};
+    for (int i = 0; i < 4; i++) {
+        const JsonValue* field = value.Find(kFields[i]);
+        if (!field) continue;
+        if (!field->IsNumber() || field->AsNumber() < 0) {
+            return SetError(error, std::string("governor: \"") + kFields[i] + "\" must be >= 0");
+        }
+        values[i] = field->AsNumber();
+    }
+    if (values[3] > 1) return SetError(error, "governor: \"cpuBudget\" must be in [0, 1]");
+    out->minIntervalMs = static_cast<int>(values[0]);
+    out->maxIntervalMs = static_cast<int>(values[1]);
+    out->sceneChangeThreshold = values[2];
+    out->cpuBudget = values[3];
+    return true;
+}
+
+// 深度优先检查 when 引用是否成环
+static bool HasCycle(const std::vector<ScenarioRule>& rules, int index, std::vector<int>* marks) {
+    (*marks)[index] = 1; // 访问中
+    for (const int dep : rules[index].conditions) {
+        if ((*marks)[dep] == 1) return true;
+        if ((*marks)[dep] == 0 && HasCycle(rules, dep, marks)) return true;
+    }
+    (*marks)[index] = 2; // 已完成
+    return false;
+}
+
+bool ParseScenario(const std::string& text, const std::string& baseDir, Scenario* out, std::string* error) {
+    JsonValue root;
+    std::string parseError;
+    if (!JsonValue::Parse(text, &root, &parseError)) {
+        return SetError(error, "invalid JSON: " + parseError);
+    }
+    if (!root.IsObject()) return SetError(error, "scenario must be a JSON object");
+
+    Scenario scenario;
+    if (const JsonValue* name = root.Find("name")) {
+        if (name->IsString()) scenario.name = name->AsString();
+    }
+
+    if (const JsonValue* governor = root.Find("governor")) {
+        if (!ParseGovernor(*governor, &scenario.governor, error)) return false;
+        scenario.hasGovernor = true;
+    }
+
+    const JsonValue* rules = root.Find("rules");
+    if (!rules || !rules->IsArray() || rules->Items().empty()) {
+        return SetError(error, "\"rules\" must be a non-empty array");
+    }
+    if (static_cast<int>(rules->Items().size()) > kScenarioMaxRules) {
+        return SetError(error, "too many rules (max " + std::to_string(kScenarioMaxRules) + ")");
+    }
+
+    std::map<std::string, int> ruleIndex;
+    std::map<std::string, int> templateIndex;
+    std::vector<std::vector<std::string>> whenNames;
+    for (const JsonValue& item : rules->Items()) {
+        const std::string where = "rule " + std::to_string(scenario.rules.size());
+        if (!item.IsObject()) return SetError(error, where + ": must be an object");
+
+        ScenarioRule rule;
+        const JsonValue* name = item.Find("name");
+        if (!name || !name->IsString() || name->AsString().empty()) {
+            return SetError(error, where + ": \"name\" is required");
+        }
+        rule.name = name->AsString();
+        if (!ruleIndex.emplace(rule.name, static_cast<int>(scenario.rules.size())).second) {
+            return SetError(error, where + ": duplicate name \"" + rule.name + "\"");
+        }
+        const JsonValue* label = item.Find("label");
+        rule.label = label && label->IsString() ? label->AsString() : rule.name;
+
+        const JsonValue* templ = item.Find("template");
+        if (!templ || !templ->IsString() || templ->AsString().empty()) {
+            return SetError(error, where + ": \"template\" is required");
+        }
+        const std::string path = JoinPath(baseDir, templ->AsString());
+        auto inserted = templateIndex.emplace(path, static_cast<int>(scenario.templatePaths.size()));
+        if (inserted.second) scenario.templatePaths.push_back(path);
+        rule.templateIndex = inserted.first->second;
+
+        SearchRequest& request = rule.rule.request;
+        request.templateId = rule.templateIndex + 1;
+        request.method = SEARCH_METHOD_CCOEFF_NORMED;
+        request.threshold = 0.9;
+        std::string fieldError;
+        if (!ParseSearchRequestFields(item, &request, &fieldError)) return SetError(error, where + ": " + fieldError);
+        if (const JsonValue* method = item.Find("method")) {
+            if (!method->IsString() || !ParseSearchMethod(method->AsString(), &request.method)) {
+                return SetError(error, where + ": unknown method");
+            }
+        }
+        if (const JsonValue* cooldown = item.Find("cooldownMs")) {
+            if (!cooldown->IsNumber() || cooldown->AsNumber() < 0) {
+                return SetError(error, where + ": \"cooldownMs\" must be >= 0");
+            }
+            rule.rule.repeatMs = static_cast<int>(cooldown->AsNumber());
+        }
+        if (const JsonValue* priority = item.Find("priority")) {
+            if (!priority->IsNumber()) return SetError(error, where + ": \"priority\" must be a number");
+            rule.rule.priority = static_cast<int>(priority->AsNumber());
+        }
+        if (const JsonValue* probability = item.Find("probability")) {
+            if (!probability->IsNumber() || probability->AsNumber() < 0 || probability->AsNumber() > 1) {
+                return SetError(error, where + ": \"probability\" must be in [0, 1]");
+            }
+            rule.probability = probability->AsNumber();
+        }
+        if (const JsonValue* action = item.Find("action")) {
+            const JsonValue* key = action->Find("key");
+            if (!key || !ParseKey(*key, &rule.actionKey)) {
+                return SetError(error, where + ": \"action.key\" must be a letter, digit, key name or key code");
+            }
+            const JsonValue* hold = action->Find("holdMs");
+            rule.actionHoldMs = hold && hold->IsNumber() ? static_cast<int>(hold->AsNumber()) : 50;
+        }
+
+        std::vector<std::string> when;
+        if (const JsonValue* conditions = item.Find("when")) {
+            if (!conditions->IsArray()) return SetError(error, where + ": \"when\" must be an array of rule names");
+            for (const JsonValue& condition : conditions->Items()) {
+                if (!condition.IsString()) return SetError(error, where + ": \"when\" must be an array of rule names");
+                when.push_back(condition.AsString());
+            }
+        }
+        whenNames.push_back(when);
+        scenario.rules.push_back(rule);
+    }
+
+    // 名称全部登记后再解析 when，允许引用写在后面的规则
+    for (size_t i = 0; i < scenario.rules.size(); i++) {
+        for (const std::string& name : whenNames[i]) {
+            auto it = ruleIndex.find(name);
+            if (it == ruleIndex.end()) {
+                return SetError(error, "rule \"" + scenario.rules[i].name + "\": unknown condition \"" + name + "\"");
+            }
+            scenario.rules[i].conditions.push_back(it->second);
+        }
+    }
+    std::vector<int> marks(scenario.rules.size(), 0);
+    for (size_t i = 0; i < scenario.rules.size(); i++) {
+        if (marks[i] == 0 && HasCycle(scenario.rules, static_cast<int>(i), &marks)) {
+            return SetError(error, "rule \"" + scenario.rules[i].name + "\": conditions form a cycle");
+        }
+    }
+
+    *out = std::move(scenario);
+    return true;
+}
+
+bool LoadScenario(const std::string& path, Scenario* out, std::string* error) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return SetError(error, "cannot open " + path);
+    std::ostringstream text;
+    text << file.rdbuf();
+
+    const size_t slash = path.find_last_of("/\\");
+    const std::string baseDir = slash == std::string::npos ? std::string() : path.substr(0, slash + 1);
+    return ParseScenario(text.str(), baseDir, out, error);
+}
+
+bool LoadScenarioTemplates(const Scenario& scenario, std::vector<std::shared_ptr<const TemplateEntry>>* ruleEntries,
+                           std::string* error) {
+    // 与 load_template 一致: 统一解码为 BGR
+    std::vector<std::shared_ptr<const TemplateEntry>> templates;
+    for (const std::string& path : scenario.templatePaths) {
+        const cv::Mat image = cv::imread(path, cv::IMREAD_COLOR);
+        if (image.empty()) return SetError(error, "cannot decode template " + path);
+        templates.push_back(MakeTemplateEntry(image));
+    }
+    ruleEntries->clear();
+    for (const ScenarioRule& rule : scenario.rules) {
+        ruleEntries->push_back(templates[rule.templateIndex]);
+    }
+    return true;
+}
+
+AutomationGraph ScenarioGraph(const Scenario& scenario) {
+    AutomationGraph graph;
+    for (const ScenarioRule& rule : scenario.rules) {
+        graph.conditions.push_back(rule.conditions);
+        graph.probabilities.push_back(rule.probability);
+    }
+    return graph;
+}
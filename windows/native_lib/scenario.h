@@ -0,0 +1,90 @@
+#ifndef SCENARIO_H
+#define SCENARIO_H
+
+#include "automation.h"
+#include "image_search.h"
+#include "template_entry.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+class JsonValue;
+
+// 场景文件 (JSON)
+//
+// 描述一组自动化规则: 模板、ROI、阈值、前置条件、冷却时间与动作，
+// 编译为 Automation 的规则图后在原生层按帧评估。调整场景无需重新构建程序。
+//
+// {
+//   "name": "剧情自动跳过",
+//   "rules": [
+//     { "name": "juqing", "label": "剧情", "template": "juqing.png", "threshold": 0.7 },
+//     { "name": "f", "template": "f.png", "roi": [1000, 400, 1500, 1100], "threshold": 0.7,
+//       "when": ["juqing"], "cooldownMs": 1000, "action": { "key": "F", "holdMs": 50 } }
+//   ]
+// }
+//
+// 规则字段:
+//   name        必填，场景内唯一，供 when 引用
+//   label       显示名称，默认同 name
+//   template    必填，模板图片路径 (相对场景文件所在目录)；多条规则引用同一文件时只加载一次
+//   roi         [x, y, w, h]，省略或 w/h <= 0 表示整帧
+//   threshold   默认 0.9
+//   method      "ccoeff" (默认) / "ssd" / "ncc" / "auto"
+//   when        前置规则名列表，全部命中时才评估本规则 (按代价与命中率排序、短路求值)
+//   cooldownMs  持续命中时重复上报 (重复执行动作) 的最小间隔，0 表示只在出现时上报
+//   action      { "key": "F" | 虚拟键码, "holdMs": 50 }，命中时由调用方执行
+//   probability 初始命中率估计 (0-1，默认 0.5)，运行中按实际命中率修正
+//   priority    SearchPriority (默认 0，>= 100 为关键)，只在设置了单帧预算 (automation_set_frame_budget) 时生效
+//
+// 可选的顶层 "governor" 段开启自适应调度 (见 AutomationGovernorConfig)，覆盖 automation_set_governor 的设置:
+//   "governor": { "minIntervalMs": 0, "maxIntervalMs": 1000, "sceneChange": 12, "cpuBudget": 0.25 }
+//   enabled 默认为 true；省略的字段为 0 (不限制 / 不检测)
+
+static const int kScenarioMaxRules = 64;
+
+struct ScenarioRule {
+    std::string name;
+    std::string label;
+    int templateIndex = 0;        // Scenario::templatePaths 的下标
+    AutomationRule rule = {};     // request.templateId 为场景内模板编号 (templateIndex + 1)
+    std::vector<int> conditions;  // when 中的规则下标
+    int actionKey = 0;            // Windows 虚拟键码，0 表示无动作
+    int actionHoldMs = 0;
+    double probability = 0.5;
+};
+
+struct Scenario {
+    std::string name;
+    std::vector<ScenarioRule> rules;
+    std::vector<std::string> templatePaths; // 已按场景文件目录解析
+    bool hasGovernor = false;
+    AutomationGovernorConfig governor = {};
+};
+
+// 解析场景文本；baseDir 为模板相对路径的基准目录 (可为空)
+// 校验名称唯一、when 引用存在且无环、规则数不超过 kScenarioMaxRules
+bool ParseScenario(const std::string& text, const std::string& baseDir, Scenario* out, std::string* error);
+
+// 读取并解析场景文件
+bool LoadScenario(const std::string& path, Scenario* out, std::string* error);
+
+// 解码场景引用的全部模板 (BGR)，按规则顺序输出与之对应的模板
+bool LoadScenarioTemplates(const Scenario& scenario, std::vector<std::shared_ptr<const TemplateEntry>>* ruleEntries,
+                           std::string* error);
+
+// 算法名 ("ccoeff" / "ssd" / "ncc" / "auto") 转为 SearchMethod，未知名称返回 false
+bool ParseSearchMethod(const std::string& name, int* out);
+
+// 读取场景规则与标注模板共用的请求字段: "roi": [x, y, w, h] 与 "threshold"
+// 不存在的字段保持 *request 原值；失败返回 false，error 为不含位置前缀的原因
+bool ParseSearchRequestFields(const JsonValue& item, SearchRequest* request, std::string* error);
+
+// 按 dir 解析相对路径 (绝对路径与 dir 为空时原样返回)
+std::string JoinPath(const std::string& dir, const std::string& file);
+
+// 规则图: 每条规则的前置条件与初始命中率
+AutomationGraph ScenarioGraph(const Scenario& scenario);
+
+#endif // SCENARIO_H
@@ -0,0 +1,436 @@
+#include "search_plan.h"
+#include "search_stats.h"
+#include "trace.h"
+
+#include <opencv2/imgproc.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <tuple>
+
+// SEARCH_METHOD_AUTO: 直接相关 (整数 NCC) 的乘加次数不超过该值时使用整数 NCC 内核：
+// 两者分数一致 (误差 < 1e-3)，而紧贴目标的小 ROI 上直接计算比 OpenCV 的 DFT 路径更快且不分配内存。
+// 超过该值时 DFT 的渐进优势占上风，使用 OpenCV。
+static const double kDirectNccMaxMacs = 4.0e6;
+
+// 把请求 ROI 裁剪到源图范围内 (roiW/roiH <= 0 表示全图)
+// 返回 false 表示 ROI 在图外或小于模板
+static bool ClampSearchArea(const SearchRequest& req, int imageWidth, int imageHeight,
+                            const cv::Mat& templ, PlanRect* area) {
+    PlanRect rect;
+    rect.width = imageWidth;
+    rect.height = imageHeight;
+
+    if (req.roiW > 0 && req.roiH > 0) {
+        // 确保 ROI 在图片范围内
+        rect.x = std::max(0, req.roiX);
+        rect.y = std::max(0, req.roiY);
+        // 确保不越界
+        const int maxW = imageWidth - rect.x;
+        const int maxH = imageHeight - rect.y;
+        if (maxW <= 0 || maxH <= 0) {
+            return false; // ROI 完全在图片外
+        }
+        rect.width = std::min(req.roiW, maxW);
+        rect.height = std::min(req.roiH, maxH);
+    }
+
+    if (rect.width < templ.cols || rect.height < templ.rows) {
+        return false; // ROI 太小
+    }
+    *area = rect;
+    return true;
+}
+
+static bool IsKernelMethod(int method) {
+    return method == SEARCH_METHOD_SSD || method == SEARCH_METHOD_NCC_INT8;
+}
+
+// 乘加次数估计: 候选位置数 x 模板像素数
+static double MatchCost(const PlanRect& area, const cv::Mat& templ) {
+    const double positions = static_cast<double>(area.width - templ.cols + 1) * (area.height - templ.rows + 1);
+    return positions * templ.cols * templ.rows * templ.channels();
+}
+
+// 尚未执行的步骤的耗时模型，按典型桌面 CPU 单线程粗略标定并偏保守；首次执行后由实测值取代
+// 内核 (SSD / 整数 NCC) 与乘加次数成正比 (SSD 剪枝后更快，按上界估计)；
+// OpenCV 的相关对大模板走 DFT，耗时约与 ROI 样本数 x log2(样本数) 成正比，取两者中较小的
+static const double kKernelNsPerMac = 0.05;
+static const double kDftNsPerSampleLog = 1.0;
+
+static int64_t ModelOpenCvNs(const PlanRect& area, const cv::Mat& templ) {
+    const double samples = static_cast<double>(area.width) * area.height * templ.channels();
+    const double dft = kDftNsPerSampleLog * samples * std::log2(std::max(2.0, samples));
+    return static_cast<int64_t>(std::min(MatchCost(area, templ) * kKernelNsPerMac, dft));
+}
+
+// 为请求选择实际执行的算法
+// 只有 SEARCH_METHOD_AUTO 按代价选择；显式指定的算法原样执行 (未知值按 TM_CCOEFF_NORMED 处理)，
+// 但超出内核整数累加范围的模板 (SlidingWindowStats::Fits) 改用 TM_CCOEFF_NORMED
+static int ChooseMethod(int requested, const PlanRect& area, const cv::Mat& templ) {
+    switch (requested) {
+    case SEARCH_METHOD_SSD:
+    case SEARCH_METHOD_NCC_INT8:
+        return SlidingWindowStats::Fits(templ.cols, templ.rows, templ.channels(), requested == SEARCH_METHOD_NCC_INT8)
+                   ? requested
+                   : SEARCH_METHOD_CCOEFF_NORMED;
+    case SEARCH_METHOD_AUTO:
+        return MatchCost(area, templ) <= kDirectNccMaxMacs &&
+                       SlidingWindowStats::Fits(templ.cols, templ.rows, templ.channels(), true)
+                   ? SEARCH_METHOD_NCC_INT8
+                   : SEARCH_METHOD_CCOEFF_NORMED;
+    default:
+        return SEARCH_METHOD_CCOEFF_NORMED;
+    }
+}
+
+void SearchPlan::Compile(const SearchRequest* requests, const std::shared_ptr<const TemplateEntry>* entries,
+                         int count, int frameWidth, int frameHeight, int sourceChannels,
+                         std::shared_ptr<SearchStatsRegistry> recorder, const int* priorities) {
+    recorder_ = std::move(recorder);
+    frameWidth_ = frameWidth;
+    frameHeight_ = frameHeight;
+    requests_.assign(count, CompiledRequest());
+    regions_.clear();
+    openCvSteps_.clear();
+    openCvLocal_.clear();
+    openCvTiles_.clear();
+    groups_.clear();
+    jobs_.clear();
+    jobRequests_.clear();
+    steps_.clear();
+    skipped_.assign(count, 0);
+    skippedCount_ = 0;
+    stats_ = BatchDebugStats();
+    stats_.requestCount = count;
+
+    // 1. 解析模板、裁剪 ROI、选择算法
+    std::vector<PlanRect> areas(count);
+    for (int i = 0; i < count; i++) {
+        const SearchRequest& req = requests[i];
+        CompiledRequest& compiled = requests_[i];
+        compiled.templateId = req.templateId;
+        compiled.threshold = req.threshold;
+        compiled.priority = priorities ? priorities[i] : SEARCH_PRIORITY_NORMAL;
+
+        const std::shared_ptr<const TemplateEntry>& entry = entries[i];
+        if (!entry) {
+            continue; // 模板不存在
+        }
+        PlanRect area;
+        if (!ClampSearchArea(req, frameWidth, frameHeight, entry->image, &area)) {
+            continue;
+        }
+        compiled.entry = entry;
+        compiled.area = area;
+        compiled.method = ChooseMethod(req.method, area, compiled.entry->image);
+        areas[i] = area;
+    }
+
+    // 2. 合并准备区域
+    BatchPlan plan;
+    PlanBatch(areas.data(), count, &plan);
+    stats_.regionCount = static_cast<int>(plan.regions.size());
+    stats_.requestedPixels = plan.requestedPixels;
+    stats_.preparedPixels = plan.preparedPixels;
+
+    // 3. 按区域展开执行步骤；自研内核请求按 (ROI, 模板尺寸, 通道) 分组
+    size_t maxGroupWidth = 0;
+    bool anyNcc = false;
+    std::vector<int> kernelRequests;
+    size_t next = 0;
+    for (size_t r = 0; r < plan.regions.size(); r++) {
+        const PlanRect& pr = plan.regions[r];
+        CompiledRegion region;
+        region.rect = cv::Rect(pr.x, pr.y, pr.width, pr.height);
+        if (sourceChannels == 4) {
+            region.converted.create(pr.height, pr.width, CV_8UC3);
+        }
+        region.firstOpenCv = static_cast<int>(openCvSteps_.size());
+        region.firstGroup = static_cast<int>(groups_.size());
+
+        kernelRequests.clear();
+        for (; next < plan.requests.size() && plan.requests[next].region == static_cast<int>(r); next++) {
+            const int index = plan.requests[next].index;
+            CompiledRequest& compiled = requests_[index];
+            if (IsKernelMethod(compiled.method)) {
+                kernelRequests.push_back(index);
+                continue;
+            }
+            const cv::Rect local(compiled.area.x - pr.x, compiled.area.y - pr.y,
+                                 compiled.area.width, compiled.area.height);
+            const cv::Mat& templ = compiled.entry->image;
+            CompiledStep step;
+            step.region = static_cast<int>(r);
+            step.openCv = static_cast<int>(openCvSteps_.size());
+            step.priority = compiled.priority;
+            step.critical = compiled.priority >= SEARCH_PRIORITY_CRITICAL;
+            step.cost = MatchCost(compiled.area, templ);
+            step.estimateNs = ModelOpenCvNs(compiled.area, templ);
+            compiled.step = static_cast<int>(steps_.size());
+            steps_.push_back(step);
+            openCvSteps_.push_back(index);
+            openCvLocal_.push_back(local);
+            openCvTiles_.emplace_back();
+            openCvTiles_.back().Plan(local.width, local.height, templ);
+        }
+        region.openCvCount = static_cast<int>(openCvSteps_.size()) - region.firstOpenCv;
+
+        auto groupKey = [this](int index) {
+            const CompiledRequest& c = requests_[index];
+            const cv::Mat& templ = c.entry->image;
+            return std::make_tuple(c.area.x, c.area.y, c.area.width, c.area.height,
+                                   templ.cols, templ.rows, templ.channels());
+        };
+        std::sort(kernelRequests.begin(), kernelRequests.end(),
+                  [&](int a, int b) { return groupKey(a) < groupKey(b); });
+
+        size_t begin = 0;
+        while (begin < kernelRequests.size()) {
+            size_t end = begin + 1;
+            while (end < kernelRequests.size() && groupKey(kernelRequests[end]) == groupKey(kernelRequests[begin])) {
+                end++;
+            }
+
+            const CompiledRequest& head = requests_[kernelRequests[begin]];
+            CompiledGroup group;
+            group.local = cv::Rect(head.area.x - pr.x, head.area.y - pr.y, head.area.width, head.area.height);
+            group.firstJob = static_cast<int>(jobs_.size());
+            group.jobCount = static_cast<int>(end - begin);
+            CompiledStep step;
+            step.region = static_cast<int>(r);
+            step.group = static_cast<int>(groups_.size());
+            step.priority = head.priority;
+            for (size_t k = begin; k < end; k++) {
+                CompiledRequest& c = requests_[kernelRequests[k]];
+                step.priority = std::max(step.priority, c.priority);
+                step.cost += MatchCost(c.area, c.entry->image);
+                c.step = static_cast<int>(steps_.size());
+                KernelJob job;
+                job.templ = ToImageView(c.entry->image);
+                job.sums = &c.entry->sums;
+                job.method = c.method == SEARCH_METHOD_SSD ? KERNEL_METHOD_SSD : KERNEL_METHOD_NCC;
+                // 只为实际走 NCC 内核的模板展宽 (编译时完成，执行时不再检查)
+                job.ncc = job.method == KERNEL_METHOD_NCC ? &c.entry->Ncc() : nullptr;
+                job.threshold = c.threshold;
+                anyNcc |= job.method == KERNEL_METHOD_NCC;
+                jobs_.push_back(job);
+                jobRequests_.push_back(kernelRequests[k]);
+            }
+            step.critical = step.priority >= SEARCH_PRIORITY_CRITICAL;
+            step.estimateNs = static_cast<int64_t>(step.cost * kKernelNsPerMac);
+            steps_.push_back(step);
+            groups_.push_back(group);
+            maxGroupWidth = std::max(maxGroupWidth, static_cast<size_t>(group.local.width));
+
+            stats_.kernelRequests += group.jobCount;
+            stats_.groupCount++;
+            stats_.windowStatsPasses++;
+            if (group.jobCount > 1) {
+                stats_.sharedRequests += group.jobCount;
+                stats_.windowStatsSaved += group.jobCount - 1;
+            }
+            begin = end;
+        }
+        region.groupCount = static_cast<int>(groups_.size()) - region.firstGroup;
+        regions_.push_back(std::move(region));
+    }
+    stats_.opencvRequests = static_cast<int>(openCvSteps_.size());
+
+    // 不设截止时间时按区域顺序执行，与编译顺序一致
+    order_.resize(steps_.size());
+    for (size_t i = 0; i < steps_.size(); i++) {
+        order_[i] = static_cast<int>(i);
+    }
+
+    // 4. 预分配窗口统计缓冲
+    windowStats_.Reserve(static_cast<int>(maxGroupWidth), 4, anyNcc);
+}
+
+void SearchPlan::Boost(int index) {
+    const int step = requests_[index].step;
+    if (step >= 0) steps_[step].boosted = true;
+}
+
+void SearchPlan::MarkSkipped(const CompiledStep& step, SearchResultEx* extended) {
+    auto mark = [&](int index) {
+        skipped_[index] = 1;
+        skippedCount_++;
+        if (extended) extended[index].flags |= SEARCH_RESULT_SKIPPED_DEADLINE;
+    };
+    if (step.openCv >= 0) {
+        mark(openCvSteps_[step.openCv]);
+        return;
+    }
+    const CompiledGroup& group = groups_[step.group];
+    for (int j = group.firstJob; j < group.firstJob + group.jobCount; j++) {
+        mark(jobRequests_[j]);
+    }
+}
+
+void SearchPlan::Run(const cv::Mat& source, SearchResultItem* results, BatchDebugStats* stats,
+                     SearchResultEx* extended, BatchHeader* header, int64_t deadlineNs) {
+    TRACE_SCOPE("plan_run");
+    const bool timed = extended != nullptr;
+    std::fill(skipped_.begin(), skipped_.end(), static_cast<uint8_t>(0));
+    skippedCount_ = 0;
+    for (size_t i = 0; i < requests_.size(); i++) {
+        const CompiledRequest& c = requests_[i];
+        if (results) {
+            SearchResultItem& res = results[i];
+            res.templateId = c.templateId;
+            res.x = -1;
+            res.y = -1;
+            res.score = 0.0;
+        }
+        if (extended) {
+            SearchResultEx& ex = extended[i];
+            ex = SearchResultEx();
+            ex.templateId = c.templateId;
+            ex.x = -1;
+            ex.y = -1;
+            ex.method = c.method;
+            ex.flags = c.entry ? 0 : SEARCH_RESULT_NOT_RUN;
+        }
+    }
+    if (stats) {
+        *stats = stats_;
+    }
+    if (header) {
+        header->regionCount = static_cast<int>(regions_.size());
+    }
+    if (source.cols != frameWidth_ || source.rows != frameHeight_) {
+        return; // 帧尺寸与编译时不一致
+    }
+
+    auto store = [&](int index, int x, int y, double score) {
+        if (results) {
+            results[index].x = x;
+            results[index].y = y;
+            results[index].score = score;
+        }
+        if (extended) {
+            extended[index].x = x;
+            extended[index].y = y;
+            extended[index].score = score;
+        }
+    };
+
+    // 截止时间: 关键步骤在前，其次是上次被跳过的步骤，再按优先级与估计代价
+    if (deadlineNs > 0) {
+        std::sort(order_.begin(), order_.end(), [this](int a, int b) {
+            const CompiledStep& sa = steps_[a];
+            const CompiledStep& sb = steps_[b];
+            if (sa.critical != sb.critical) return sa.critical;
+            if (sa.boosted != sb.boosted) return sa.boosted;
+            if (sa.priority != sb.priority) return sa.priority > sb.priority;
+            if (sa.cost != sb.cost) return sa.cost < sb.cost;
+            return a < b;
+        });
+    } else {
+        for (size_t i = 0; i < order_.size(); i++) {
+            order_[i] = static_cast<int>(i);
+        }
+    }
+
+    long long convertNs = 0;
+    long long matchNs = 0;
+    for (const int s : order_) {
+        CompiledStep& step = steps_[s];
+        // 上次被跳过的步骤不看估计，预算未耗尽就执行: 估计偏高的步骤也不会一直得不到执行
+        // (批次查找每次编译临时计划，其中的估计始终来自模型)
+        const int64_t now = StatsNowNs();
+        if (deadlineNs > 0 && !step.critical &&
+            (step.boosted ? now >= deadlineNs : now + step.estimateNs > deadlineNs)) {
+            step.boosted = true;
+            MarkSkipped(step, extended);
+            continue;
+        }
+        step.boosted = false;
+
+        // 转换只做一次，区域内的请求都从这里取零拷贝子视图
+        CompiledRegion& region = regions_[step.region];
+        if (region.prepared.empty()) {
+            if (source.channels() == 4) {
+                TRACE_SCOPE("convert");
+                const long long convertStart = StatsNowNs();
+                cv::cvtColor(source(region.rect), region.converted, cv::COLOR_BGRA2BGR);
+                region.prepared = region.converted;
+                const long long ns = StatsNowNs() - convertStart;
+                convertNs += ns;
+                if (recorder_) recorder_->RecordStage(STATS_STAGE_CONVERT, ns);
+            } else {
+                region.prepared = source(region.rect);
+            }
+        }
+        const cv::Mat& prepared = region.prepared;
+        const long long stepStart = StatsNowNs();
+
+        if (step.openCv >= 0) {
+            const int k = step.openCv;
+            const int index = openCvSteps_[k];
+            const CompiledRequest& c = requests_[index];
+            TRACE_SCOPE("matchTemplate");
+            const long long start = StatsNowNs();
+            TiledMatcher& tiles = openCvTiles_[k];
+            cv::Point maxLoc;
+            const double maxVal = tiles.Run(prepared(openCvLocal_[k]), *c.entry, &maxLoc);
+            const bool hit = maxVal >= c.threshold;
+            if (hit) {
+                store(index, c.area.x + maxLoc.x, c.area.y + maxLoc.y, maxVal);
+            }
+            const long long ns = StatsNowNs() - start;
+            matchNs += ns;
+            if (recorder_) recorder_->RecordMatch(c.templateId, ns, hit);
+            if (extended) {
+                SearchResultEx& ex = extended[index];
+                ex.timeNs = ns;
+                ex.positions = tiles.Positions();
+                ex.pixelsScanned = ex.positions * c.entry->image.rows * c.entry->image.cols;
+                if (tiles.Tiled()) ex.flags |= SEARCH_RESULT_TILED;
+            }
+        } else {
+            const CompiledGroup& group = groups_[step.group];
+            TRACE_SCOPE("kernel_group");
+            const long long groupStart = StatsNowNs();
+            RunKernelGroup(ToImageView(prepared(group.local)), &jobs_[group.firstJob], group.jobCount,
+                           &windowStats_, timed);
+            // 未逐任务计时时按组耗时平均分摊
+            const long long groupShare = (StatsNowNs() - groupStart) / group.jobCount;
+            for (int j = group.firstJob; j < group.firstJob + group.jobCount; j++) {
+                const KernelJob& job = jobs_[j];
+                const int index = jobRequests_[j];
+                if (job.found) {
+                    store(index, region.rect.x + group.local.x + job.x,
+                          region.rect.y + group.local.y + job.y, job.score);
+                }
+                const long long ns = timed ? job.timeNs : groupShare;
+                matchNs += ns;
+                if (recorder_) recorder_->RecordMatch(requests_[index].templateId, ns, job.found);
+                if (extended) {
+                    SearchResultEx& ex = extended[index];
+                    ex.timeNs = job.timeNs;
+                    ex.positions = job.positions;
+                    ex.pixelsScanned = job.pixelsScanned;
+                    if (j > group.firstJob) ex.flags |= SEARCH_RESULT_CACHED;
+                    if (job.rejectedByBound > 0) ex.flags |= SEARCH_RESULT_PREFILTERED;
+                }
+            }
+        }
+
+        // 耗时估计: 首次取实测值 (替换模型估计)，之后按 1/4 权重滑动平均
+        const int64_t stepNs = StatsNowNs() - stepStart;
+        step.estimateNs = step.measured ? step.estimateNs + (stepNs - step.estimateNs) / 4 : stepNs;
+        step.measured = true;
+    }
+
+    // 不跨帧持有源图引用
+    for (CompiledRegion& region : regions_) {
+        region.prepared.release();
+    }
+
+    if (header) {
+        header->convertNs += convertNs;
+        header->matchNs += matchNs;
+    }
+}
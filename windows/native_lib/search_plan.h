@@ -0,0 +1,129 @@
+#ifndef SEARCH_PLAN_H
+#define SEARCH_PLAN_H
+
+#include "image_search.h"
+#include "batch_planner.h"
+#include "group_matcher.h"
+#include "search_stats.h"
+#include "template_entry.h"
+#include "tiled_matcher.h"
+
+#include <opencv2/core.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// 编译好的批量查找计划
+//
+// 编译阶段一次性完成：解析模板引用、裁剪 ROI、合并准备区域、划分共享窗口统计的分组、
+// 选择算法并预分配每个请求的工作区 (区域转换缓冲、OpenCV 结果图、内核任务)。
+// 执行阶段只做像素转换与匹配；使用自研内核的请求在稳态下零分配、零加锁。
+//
+// 执行单位是步骤: 一个 OpenCV 请求，或共享窗口统计的一组内核请求；区域在第一个用到它的步骤前转换。
+// OpenCV 请求在编译时划分为块 (TiledMatcher，小 ROI 只有一块)，执行时并行匹配各块后精确归约。
+// 设置截止时间时步骤按 (关键, 上次被跳过, 优先级, 估计代价) 排序，
+// 预计超出截止时间的非关键步骤被跳过并在下次优先执行，最坏情况下的单帧耗时因此有界。
+//
+// find_images_batch 每次调用编译一个临时计划后立即执行；
+// compile_search_plan 则把计划保存下来，供每帧重复执行。
+class SearchPlan {
+public:
+    // entries: 与 requests 一一对应的模板 (由调用者从同一份模板表快照解析)，为空表示模板不存在
+    // 计划复制这些指针；若其不持有引用计数，调用者需保证模板在计划使用期间有效
+    // frameWidth / frameHeight: 之后每次执行时的帧尺寸
+    // sourceChannels: 之后输入帧的通道数，为 4 (BGRA) 时预分配每个区域的转换缓冲
+    // recorder: 执行时写入的运行期统计 (所属引擎的注册表)，为空时不记录
+    // priorities: 与 requests 等长的优先级 (SearchPriority)，为空时全部为 SEARCH_PRIORITY_NORMAL
+    void Compile(const SearchRequest* requests, const std::shared_ptr<const TemplateEntry>* entries,
+                 int count, int frameWidth, int frameHeight, int sourceChannels,
+                 std::shared_ptr<SearchStatsRegistry> recorder = nullptr, const int* priorities = nullptr);
+
+    // 在一帧上执行计划
+    // source: BGRA (8UC4) 或 BGR (8UC3)，尺寸必须与编译时一致
+    // results / extended: 长度 >= 请求数，至少提供其一；extended 非空时逐请求计时
+    // stats / header 可为空；header 只累加 convertNs / matchNs 并写入 regionCount
+    // deadlineNs: 截止时间 (StatsNowNs 时基)，0 表示不限；
+    // 非关键步骤在 当前时间 + 该步骤的耗时估计 (未执行过时来自代价模型，之后为实测的滑动平均) 超过截止时间时被跳过；
+    // 上次被跳过的步骤只在预算已耗尽时跳过
+    void Run(const cv::Mat& source, SearchResultItem* results, BatchDebugStats* stats,
+             SearchResultEx* extended = nullptr, BatchHeader* header = nullptr, int64_t deadlineNs = 0);
+
+    // 把请求所在的步骤标记为上次被跳过 (临时计划由调用方延续跨批次的跳过记录)
+    void Boost(int index);
+
+    // 最近一次 Run 中该请求是否因截止时间被跳过
+    bool Skipped(int index) const { return skipped_[index] != 0; }
+    int SkippedCount() const { return skippedCount_; }
+
+    int FrameWidth() const { return frameWidth_; }
+    int FrameHeight() const { return frameHeight_; }
+    int RequestCount() const { return static_cast<int>(requests_.size()); }
+
+    // 计划 ID 与执行中标志，由计划注册表使用
+    int id = 0;
+    std::atomic<bool> busy{false};
+
+private:
+    struct CompiledRequest {
+        int templateId = 0;
+        std::shared_ptr<const TemplateEntry> entry; // 为空表示模板不存在或 ROI 无效
+        int method = SEARCH_METHOD_CCOEFF_NORMED;   // 编译时选定的算法
+        double threshold = 0.0;
+        int priority = 0;
+        int step = -1;                              // 所属步骤，-1 表示不执行
+        PlanRect area;                              // 源图坐标
+    };
+
+    // 执行步骤: 一个 OpenCV 请求 (openCv >= 0) 或一个内核分组 (group >= 0)
+    struct CompiledStep {
+        int region = 0;
+        int openCv = -1;          // openCvSteps_ 下标
+        int group = -1;           // groups_ 下标
+        int priority = 0;         // 分组取成员的最高优先级
+        bool critical = false;
+        bool boosted = false;     // 上次因截止时间被跳过
+        double cost = 0;          // 乘加次数估计
+        int64_t estimateNs = 0;   // 耗时估计: 编译时来自代价模型，执行后为实测耗时的滑动平均
+        bool measured = false;    // estimateNs 已是实测值
+    };
+
+    struct CompiledRegion {
+        cv::Rect rect;
+        cv::Mat converted;                          // 预分配的 BGR 转换缓冲
+        cv::Mat prepared;                           // 本次执行的区域图像，未转换时为空
+        int firstOpenCv = 0;
+        int openCvCount = 0;
+        int firstGroup = 0;
+        int groupCount = 0;
+    };
+
+    struct CompiledGroup {
+        cv::Rect local;   // 相对区域的 ROI
+        int firstJob = 0;
+        int jobCount = 0;
+    };
+
+    void MarkSkipped(const CompiledStep& step, SearchResultEx* extended);
+
+    int frameWidth_ = 0;
+    int frameHeight_ = 0;
+    std::vector<CompiledRequest> requests_;
+    std::vector<CompiledRegion> regions_;
+    std::vector<int> openCvSteps_;        // OpenCV 请求的下标 (按区域排列)
+    std::vector<cv::Rect> openCvLocal_;   // 与 openCvSteps_ 对应的区域内 ROI
+    std::vector<TiledMatcher> openCvTiles_;  // 与 openCvSteps_ 对应，不分块时只有一块
+    std::vector<CompiledGroup> groups_;
+    std::vector<KernelJob> jobs_;
+    std::vector<int> jobRequests_;        // 与 jobs_ 对应的请求下标
+    std::vector<CompiledStep> steps_;
+    std::vector<int> order_;              // 执行顺序 (steps_ 下标)
+    std::vector<uint8_t> skipped_;        // 每个请求最近一次是否被跳过
+    int skippedCount_ = 0;
+    SlidingWindowStats windowStats_;
+    BatchDebugStats stats_ = {};          // 编译时确定的分组统计
+    std::shared_ptr<SearchStatsRegistry> recorder_;
+};
+
+#endif // SEARCH_PLAN_H
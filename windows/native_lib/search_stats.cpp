@@ -0,0 +1,231 @@
+#include "search_stats.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+
+// 对数-线性分桶: 值 v < 16 直接落在桶 v；否则按最高位 e 分组，每组 16 个子桶
+static const int kSubBucketBits = 4;
+static const int kSubBuckets = 1 << kSubBucketBits;
+static const int kMaxExponent = 40;
+static const int kHistogramBuckets = (kMaxExponent - kSubBucketBits + 2) * kSubBuckets;
+
+static int BucketIndex(int64_t ns) {
+    if (ns < kSubBuckets) {
+        return ns < 0 ? 0 : static_cast<int>(ns);
+    }
+    int e = 63;
+    while (!((static_cast<uint64_t>(ns) >> e) & 1)) e--;
+    if (e > kMaxExponent) {
+        return kHistogramBuckets - 1;
+    }
+    const int sub = static_cast<int>((static_cast<uint64_t>(ns) >> (e - kSubBucketBits)) & (kSubBuckets - 1));
+    return (e - kSubBucketBits + 1) * kSubBuckets + sub;
+}
+
+// 桶的上界 (报告分位数时使用，偏保守)
+static int64_t BucketUpperBound(int index) {
+    if (index < kSubBuckets) {
+        return index;
+    }
+    const int e = index / kSubBuckets + kSubBucketBits - 1;
+    const int sub = index % kSubBuckets;
+    const int64_t base = (int64_t(1) << e) | (int64_t(sub) << (e - kSubBucketBits));
+    return base + (int64_t(1) << (e - kSubBucketBits)) - 1;
+}
+
+static void AtomicMax(std::atomic<int64_t>& target, int64_t value) {
+    int64_t current = target.load(std::memory_order_relaxed);
+    while (value > current && !target.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+    }
+}
+
+struct StageCounters {
+    std::atomic<int64_t> count{0};
+    std::atomic<int64_t> totalNs{0};
+    std::atomic<int64_t> maxNs{0};
+    std::atomic<int64_t> buckets[kHistogramBuckets];
+
+    StageCounters() {
+        for (auto& b : buckets) b.store(0, std::memory_order_relaxed);
+    }
+};
+
+struct TemplateCounters {
+    std::atomic<int> templateId{0};
+    std::atomic<int64_t> calls{0};
+    std::atomic<int64_t> hits{0};
+    std::atomic<int64_t> totalNs{0};
+    std::atomic<int64_t> maxNs{0};
+};
+
+// 单个线程的分片；按缓存行对齐，避免与其他线程的分片伪共享
+struct alignas(64) StatsShard {
+    std::atomic<bool> owned{false};
+    std::atomic<int64_t> batches{0};
+    StageCounters stages[STATS_STAGE_COUNT];
+    TemplateCounters templates[kStatsTemplateSlots];
+};
+
+static std::atomic<uint64_t> g_nextRegistryUid{1};
+
+// 线程本地的分片缓存: (注册表 uid, 分片)
+// 线程退出时把分片标记为空闲，供该注册表的新线程复用 (计数保留)
+struct LocalShards {
+    std::vector<std::pair<uint64_t, std::shared_ptr<StatsShard>>> entries;
+
+    ~LocalShards() {
+        for (auto& entry : entries) {
+            entry.second->owned.store(false);
+        }
+    }
+};
+
+static thread_local LocalShards t_localShards;
+
+SearchStatsRegistry::SearchStatsRegistry() : uid_(g_nextRegistryUid.fetch_add(1)) {}
+
+SearchStatsRegistry::~SearchStatsRegistry() = default;
+
+StatsShard& SearchStatsRegistry::LocalShard() {
+    auto& entries = t_localShards.entries;
+    for (auto& entry : entries) {
+        if (entry.first == uid_) {
+            return *entry.second;
+        }
+    }
+
+    // 未命中: 顺带清理已销毁的注册表留下的分片 (只剩本线程持有)
+    entries.erase(std::remove_if(entries.begin(), entries.end(),
+                                 [](const std::pair<uint64_t, std::shared_ptr<StatsShard>>& e) {
+                                     return e.second.use_count() == 1;
+                                 }),
+                  entries.end());
+
+    std::shared_ptr<StatsShard> shard;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto& candidate : shards_) {
+            bool expected = false;
+            if (candidate->owned.compare_exchange_strong(expected, true)) {
+                shard = candidate;
+                break;
+            }
+        }
+        if (!shard) {
+            shard = std::make_shared<StatsShard>();
+            shard->owned.store(true);
+            shards_.push_back(shard);
+        }
+    }
+    entries.emplace_back(uid_, shard);
+    return *shard;
+}
+
+int64_t StatsNowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void SearchStatsRegistry::RecordBatch() {
+    LocalShard().batches.fetch_add(1, std::memory_order_relaxed);
+}
+
+void SearchStatsRegistry::RecordStage(StatsStage stage, int64_t ns) {
+    StageCounters& c = LocalShard().stages[stage];
+    c.count.fetch_add(1, std::memory_order_relaxed);
+    c.totalNs.fetch_add(ns, std::memory_order_relaxed);
+    c.buckets[BucketIndex(ns)].fetch_add(1, std::memory_order_relaxed);
+    AtomicMax(c.maxNs, ns);
+}
+
+void SearchStatsRegistry::RecordMatch(int templateId, int64_t ns, bool hit) {
+    StatsShard& shard = LocalShard();
+    TemplateCounters& t = shard.templates[templateId & (kStatsTemplateSlots - 1)];
+    t.templateId.store(templateId, std::memory_order_relaxed);
+    t.calls.fetch_add(1, std::memory_order_relaxed);
+    if (hit) t.hits.fetch_add(1, std::memory_order_relaxed);
+    t.totalNs.fetch_add(ns, std::memory_order_relaxed);
+    AtomicMax(t.maxNs, ns);
+
+    RecordStage(STATS_STAGE_MATCH, ns);
+}
+
+// 从合并后的直方图求分位数
+static int64_t Percentile(const std::vector<int64_t>& buckets, int64_t count, double q) {
+    if (count <= 0) return 0;
+    const int64_t rank = std::max<int64_t>(1, static_cast<int64_t>(q * count + 0.5));
+    int64_t seen = 0;
+    for (int i = 0; i < kHistogramBuckets; i++) {
+        seen += buckets[i];
+        if (seen >= rank) return BucketUpperBound(i);
+    }
+    return BucketUpperBound(kHistogramBuckets - 1);
+}
+
+void SearchStatsRegistry::Snapshot(StatsSnapshot* out) const {
+    *out = StatsSnapshot();
+    std::vector<std::vector<int64_t>> buckets(STATS_STAGE_COUNT, std::vector<int64_t>(kHistogramBuckets, 0));
+    std::vector<TemplateStatsSnapshot> slots(kStatsTemplateSlots);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& shard : shards_) {
+        out->batches += shard->batches.load(std::memory_order_relaxed);
+        for (int s = 0; s < STATS_STAGE_COUNT; s++) {
+            const StageCounters& c = shard->stages[s];
+            LatencySnapshot& l = out->stages[s];
+            l.count += c.count.load(std::memory_order_relaxed);
+            l.totalNs += c.totalNs.load(std::memory_order_relaxed);
+            l.maxNs = std::max(l.maxNs, c.maxNs.load(std::memory_order_relaxed));
+            for (int i = 0; i < kHistogramBuckets; i++) {
+                buckets[s][i] += c.buckets[i].load(std::memory_order_relaxed);
+            }
+        }
+        for (int i = 0; i < kStatsTemplateSlots; i++) {
+            const TemplateCounters& t = shard->templates[i];
+            const int64_t calls = t.calls.load(std::memory_order_relaxed);
+            if (calls == 0) continue;
+            TemplateStatsSnapshot& slot = slots[i];
+            slot.templateId = t.templateId.load(std::memory_order_relaxed);
+            slot.calls += calls;
+            slot.hits += t.hits.load(std::memory_order_relaxed);
+            slot.totalNs += t.totalNs.load(std::memory_order_relaxed);
+            slot.maxNs = std::max(slot.maxNs, t.maxNs.load(std::memory_order_relaxed));
+        }
+    }
+
+    for (int s = 0; s < STATS_STAGE_COUNT; s++) {
+        // 直方图与 count 分别读取，并发记录时可能相差几个样本，以直方图为准
+        int64_t histogramCount = 0;
+        for (int64_t b : buckets[s]) histogramCount += b;
+        // 桶上界可能略大于实际最大值，分位数不超过 maxNs
+        out->stages[s].p50Ns = std::min(Percentile(buckets[s], histogramCount, 0.50), out->stages[s].maxNs);
+        out->stages[s].p99Ns = std::min(Percentile(buckets[s], histogramCount, 0.99), out->stages[s].maxNs);
+    }
+    for (const TemplateStatsSnapshot& slot : slots) {
+        if (slot.calls > 0) out->templates.push_back(slot);
+    }
+    std::sort(out->templates.begin(), out->templates.end(),
+              [](const TemplateStatsSnapshot& a, const TemplateStatsSnapshot& b) { return a.templateId < b.templateId; });
+}
+
+void SearchStatsRegistry::Reset() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& shard : shards_) {
+        shard->batches.store(0, std::memory_order_relaxed);
+        for (StageCounters& c : shard->stages) {
+            c.count.store(0, std::memory_order_relaxed);
+            c.totalNs.store(0, std::memory_order_relaxed);
+            c.maxNs.store(0, std::memory_order_relaxed);
+            for (auto& b : c.buckets) b.store(0, std::memory_order_relaxed);
+        }
+        for (TemplateCounters& t : shard->templates) {
+            t.calls.store(0, std::memory_order_relaxed);
+            t.hits.store(0, std::memory_order_relaxed);
+            t.totalNs.store(0, std::memory_order_relaxed);
+            t.maxNs.store(0, std::memory_order_relaxed);
+        }
+    }
+}
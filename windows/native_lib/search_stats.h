@@ -0,0 +1,94 @@
+#ifndef SEARCH_STATS_H
+#define SEARCH_STATS_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// 运行期统计 (长时间挂机时观察引擎行为)
+//
+// 每个引擎实例持有自己的 SearchStatsRegistry，互不干扰。
+// 记录端每个线程在每个注册表中写自己的分片 (首次记录时登记，线程退出后分片留给新线程复用)，
+// 只对本分片做 relaxed 原子加，不加锁也不与其他线程争用缓存行。
+// 读取端把所有分片相加得到快照；直方图在快照时才计算分位数，因此 UI 每秒轮询也很便宜。
+//
+// 延迟直方图为 HDR 风格的对数-线性分桶: 每个 2 的幂区间再均分 16 个子桶，
+// 相对误差约 6%，覆盖 1ns 到约 2^40ns (18 分钟)。
+
+// 按模板统计的槽位数；槽位按 templateId & (kStatsTemplateSlots - 1) 选择，
+// ID 相差 1024 整数倍的模板会共用一个槽位
+static const int kStatsTemplateSlots = 1024;
+
+enum StatsStage {
+    STATS_STAGE_DECODE = 0,  // 解码 / 构造源图 (每批一次)
+    STATS_STAGE_CONVERT = 1, // 准备区域像素转换 (每区域一次)
+    STATS_STAGE_MATCH = 2,   // 单个请求的匹配
+    STATS_STAGE_COUNT = 3,
+};
+
+struct LatencySnapshot {
+    int64_t count = 0;
+    int64_t totalNs = 0;
+    int64_t p50Ns = 0;
+    int64_t p99Ns = 0;
+    int64_t maxNs = 0;
+};
+
+struct TemplateStatsSnapshot {
+    int templateId = 0;
+    int64_t calls = 0;
+    int64_t hits = 0;
+    int64_t totalNs = 0;
+    int64_t maxNs = 0;
+};
+
+struct StatsSnapshot {
+    int64_t batches = 0;
+    LatencySnapshot stages[STATS_STAGE_COUNT];
+    std::vector<TemplateStatsSnapshot> templates; // 只含有调用记录的模板，按 templateId 排序
+};
+
+struct StatsShard;
+
+class SearchStatsRegistry {
+public:
+    SearchStatsRegistry();
+    ~SearchStatsRegistry();
+
+    SearchStatsRegistry(const SearchStatsRegistry&) = delete;
+    SearchStatsRegistry& operator=(const SearchStatsRegistry&) = delete;
+
+    // 记录 (热路径，无锁；只在本线程首次写入该注册表时加锁登记分片)
+    void RecordBatch();
+    void RecordStage(StatsStage stage, int64_t ns);
+    void RecordMatch(int templateId, int64_t ns, bool hit);
+
+    // 汇总所有线程的分片
+    void Snapshot(StatsSnapshot* out) const;
+
+    // 清零所有分片 (与并发记录之间不保证原子性，个别正在进行的记录可能被计入或丢弃)
+    void Reset();
+
+private:
+    StatsShard& LocalShard();
+
+    const uint64_t uid_; // 进程内唯一且不复用，线程本地缓存以它查找分片
+    mutable std::mutex mutex_;
+    // 分片由注册表与线程本地缓存共同持有，任一方先销毁都安全
+    std::vector<std::shared_ptr<StatsShard>> shards_;
+};
+
+// 单调时钟 (纳秒)
+int64_t StatsNowNs();
+
+// 已排序样本的分位数 (离线工具汇总逐次耗时等样本时使用)，空数组返回 T()
+template <typename T>
+T SortedPercentile(const std::vector<T>& sorted, double q) {
+    if (sorted.empty()) return T();
+    return sorted[std::min(sorted.size() - 1, static_cast<size_t>(q * sorted.size()))];
+}
+
+#endif // SEARCH_STATS_H
@@ -0,0 +1,149 @@
+#include "simd_dot.h"
+
+#include <cstdlib>
+#include <cstring>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define SIMD_DOT_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+// MSVC 无需额外编译选项即可使用全部内建函数；GCC/Clang 需要按函数开启目标指令集，
+// 这样整个库仍按基线 x86-64 编译，只有被运行时选中的函数才会执行 AVX2 指令
+#if defined(_MSC_VER) && !defined(__clang__)
+#define TARGET_AVX2
+#define TARGET_SSE41
+#else
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#define TARGET_SSE41 __attribute__((target("sse4.1")))
+#endif
+
+static int64_t DotScalar(const uint8_t* src, const int16_t* templ, int n) {
+    int32_t s = 0;
+    for (int i = 0; i < n; i++) {
+        s += static_cast<int32_t>(src[i]) * templ[i];
+    }
+    return s;
+}
+
+#ifdef SIMD_DOT_X86
+
+TARGET_SSE41 static int64_t DotSse41(const uint8_t* src, const int16_t* templ, int n) {
+    __m128i acc0 = _mm_setzero_si128();
+    __m128i acc1 = _mm_setzero_si128();
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        const __m128i a0 = _mm_cvtepu8_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + i)));
+        const __m128i a1 = _mm_cvtepu8_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + i + 8)));
+        const __m128i b0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(templ + i));
+        const __m128i b1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(templ + i + 8));
+        acc0 = _mm_add_epi32(acc0, _mm_madd_epi16(a0, b0));
+        acc1 = _mm_add_epi32(acc1, _mm_madd_epi16(a1, b1));
+    }
+    for (; i + 8 <= n; i += 8) {
+        const __m128i a0 = _mm_cvtepu8_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + i)));
+        const __m128i b0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(templ + i));
+        acc0 = _mm_add_epi32(acc0, _mm_madd_epi16(a0, b0));
+    }
+    __m128i s = _mm_add_epi32(acc0, acc1);
+    s = _mm_add_epi32(s, _mm_shuffle_epi32(s, _MM_SHUFFLE(1, 0, 3, 2)));
+    s = _mm_add_epi32(s, _mm_shuffle_epi32(s, _MM_SHUFFLE(2, 3, 0, 1)));
+    int32_t total = _mm_cvtsi128_si32(s);
+    for (; i < n; i++) {
+        total += static_cast<int32_t>(src[i]) * templ[i];
+    }
+    return total;
+}
+
+TARGET_AVX2 static int64_t DotAvx2(const uint8_t* src, const int16_t* templ, int n) {
+    __m256i acc0 = _mm256_setzero_si256();
+    __m256i acc1 = _mm256_setzero_si256();
+    int i = 0;
+    for (; i + 32 <= n; i += 32) {
+        const __m256i a0 = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i)));
+        const __m256i a1 = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + 16)));
+        const __m256i b0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(templ + i));
+        const __m256i b1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(templ + i + 16));
+        acc0 = _mm256_add_epi32(acc0, _mm256_madd_epi16(a0, b0));
+        acc1 = _mm256_add_epi32(acc1, _mm256_madd_epi16(a1, b1));
+    }
+    for (; i + 16 <= n; i += 16) {
+        const __m256i a0 = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i)));
+        const __m256i b0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(templ + i));
+        acc0 = _mm256_add_epi32(acc0, _mm256_madd_epi16(a0, b0));
+    }
+    const __m256i acc = _mm256_add_epi32(acc0, acc1);
+    __m128i s = _mm_add_epi32(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+    s = _mm_add_epi32(s, _mm_shuffle_epi32(s, _MM_SHUFFLE(1, 0, 3, 2)));
+    s = _mm_add_epi32(s, _mm_shuffle_epi32(s, _MM_SHUFFLE(2, 3, 0, 1)));
+    int32_t total = _mm_cvtsi128_si32(s);
+    for (; i < n; i++) {
+        total += static_cast<int32_t>(src[i]) * templ[i];
+    }
+    return total;
+}
+
+static bool CpuHasSse41() {
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 1);
+    return (info[2] & (1 << 19)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("sse4.1");
+#endif
+}
+
+static bool CpuHasAvx2() {
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) return false;
+    __cpuid(info, 1);
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    const bool avx = (info[2] & (1 << 28)) != 0;
+    // 操作系统必须保存 YMM 寄存器状态
+    if (!osxsave || !avx || (_xgetbv(0) & 6) != 6) return false;
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#endif // SIMD_DOT_X86
+
+struct DotDispatch {
+    DotU8S16Fn fn;
+    const char* isa;
+};
+
+static DotDispatch SelectDot() {
+    const char* forced = std::getenv("IMAGE_SEARCH_SIMD");
+    const bool allowAvx2 = !forced || std::strcmp(forced, "avx2") == 0;
+    const bool allowSse41 = allowAvx2 || std::strcmp(forced, "sse41") == 0;
+#ifdef SIMD_DOT_X86
+    if (allowAvx2 && CpuHasAvx2()) return {DotAvx2, "avx2"};
+    if (allowSse41 && CpuHasSse41()) return {DotSse41, "sse41"};
+#else
+    (void)allowSse41;
+#endif
+    return {DotScalar, "scalar"};
+}
+
+static const DotDispatch& Dispatch() {
+    static const DotDispatch dispatch = SelectDot();
+    return dispatch;
+}
+
+DotU8S16Fn GetDotU8S16() {
+    return Dispatch().fn;
+}
+
+const char* DotU8S16Isa() {
+    return Dispatch().isa;
+}
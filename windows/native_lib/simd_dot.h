@@ -0,0 +1,17 @@
+#ifndef SIMD_DOT_H
+#define SIMD_DOT_H
+
+#include <cstdint>
+
+// 8 位源像素与 16 位 (预先展宽的) 模板像素的点积
+// 使用 16 位乘、32 位累加 (madd)，单次调用要求 n * 255 * 255 < 2^31，即 n < 33000
+using DotU8S16Fn = int64_t (*)(const uint8_t* src, const int16_t* templ, int n);
+
+// 运行时按 CPU 能力选择实现: AVX2 > SSE4.1 > 标量
+// 可通过环境变量 IMAGE_SEARCH_SIMD=scalar|sse41|avx2 强制降级 (基准测试用)
+DotU8S16Fn GetDotU8S16();
+
+// 当前选用的指令集名称 ("avx2" / "sse41" / "scalar")
+const char* DotU8S16Isa();
+
+#endif // SIMD_DOT_H
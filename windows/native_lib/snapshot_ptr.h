@@ -0,0 +1,74 @@
+#ifndef SNAPSHOT_PTR_H
+#define SNAPSHOT_PTR_H
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+// 可无锁读取的 shared_ptr 槽位
+// std::atomic_load / atomic_store (shared_ptr 重载) 在 libstdc++ 与 MSVC 上都借助全局锁实现，
+// 热路径上的读者会与其他读者串行；这里改为两计数器的读侧临界区 (用户态 RCU 的简化形式):
+//   读者: 在当前纪元的计数器上登记 -> 复制 shared_ptr (一次原子加引用) -> 注销。
+//   写者: 换入新的持有块 -> 翻转纪元 -> 等待旧纪元计数器归零 -> 释放旧持有块。
+// 读侧临界区只包含一次 shared_ptr 复制，写者的等待以纳秒计；读者不加锁、不等待写者
+// (写者恰好翻转纪元时重试一次)。被读出的对象由 shared_ptr 保活，可在临界区外长期使用。
+// 写入较少 (加载模板、启停录制等)，写者之间用互斥量串行。
+template <typename T>
+class SnapshotPtr {
+public:
+    SnapshotPtr() = default;
+    explicit SnapshotPtr(std::shared_ptr<T> value) : holder_(value ? new Holder{std::move(value)} : nullptr) {}
+    ~SnapshotPtr() { delete holder_.load(std::memory_order_relaxed); }
+
+    SnapshotPtr(const SnapshotPtr&) = delete;
+    SnapshotPtr& operator=(const SnapshotPtr&) = delete;
+
+    // 读取当前值 (无锁)
+    std::shared_ptr<T> Load() const {
+        for (;;) {
+            const unsigned epoch = epoch_.load();
+            std::atomic<int>& readers = readers_[epoch & 1].count;
+            readers.fetch_add(1);
+            // 登记后纪元未变: 写者要么尚未翻转 (会等待本读者)，要么已换入新值 (本读者读到新值)
+            if (epoch_.load() == epoch) {
+                const Holder* holder = holder_.load();
+                std::shared_ptr<T> value = holder ? holder->value : std::shared_ptr<T>();
+                readers.fetch_sub(1);
+                return value;
+            }
+            readers.fetch_sub(1);
+        }
+    }
+
+    // 替换为新值；返回时已没有读者能读到旧值
+    // 旧对象在最后一个持有者释放时析构 (可能就在此处)
+    void Store(std::shared_ptr<T> value) {
+        Holder* next = value ? new Holder{std::move(value)} : nullptr;
+        std::lock_guard<std::mutex> lock(writer_);
+        Holder* previous = holder_.exchange(next);
+        const unsigned epoch = epoch_.load();
+        epoch_.store(epoch + 1);
+        while (readers_[epoch & 1].count.load() != 0) {
+            std::this_thread::yield();
+        }
+        delete previous;
+    }
+
+private:
+    struct Holder {
+        std::shared_ptr<T> value;
+    };
+    // 两个纪元的读者计数各占一条缓存行
+    struct alignas(64) ReaderCount {
+        std::atomic<int> count{0};
+    };
+
+    // 读者的登记与写者的检查都使用顺序一致的原子操作: 两者之间的先后必须全局一致
+    std::atomic<Holder*> holder_{nullptr};
+    std::atomic<unsigned> epoch_{0};
+    mutable ReaderCount readers_[2];
+    std::mutex writer_;
+};
+
+#endif // SNAPSHOT_PTR_H
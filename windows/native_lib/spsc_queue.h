@@ -0,0 +1,125 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+// 单生产者 / 单消费者有界队列 (无锁)
+// Capacity 必须是 2 的幂；读写位置各占一条缓存行，生产者与消费者互不争用
+template <typename T, size_t Capacity>
+class SpscQueue {
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "capacity must be a power of two");
+
+public:
+    // 只能由生产者线程调用；队列满时返回 false
+    bool TryPush(const T& value) {
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_.load(std::memory_order_acquire) == Capacity) return false;
+        slots_[tail & (Capacity - 1)] = value;
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // 只能由消费者线程调用；队列空时返回 false
+    bool TryPop(T* out) {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        if (head == tail_.load(std::memory_order_acquire)) return false;
+        *out = slots_[head & (Capacity - 1)];
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    T slots_[Capacity] = {};
+    alignas(64) std::atomic<size_t> head_{0};
+    alignas(64) std::atomic<size_t> tail_{0};
+};
+
+// 丢弃最旧元素的单生产者 / 单消费者环 (无锁)
+// 满时生产者把最旧的元素从消费端抢走并交还给调用方 (通常是一块可复用的缓冲)，
+// 消费者因此总是拿到最近的 Capacity 个元素。元素为缓冲槽位编号，槽位本身按原子读写，
+// 读取与抢占交错时消费者的 CAS 失败并重试，不会读到被改写一半的值。
+template <size_t Capacity>
+class DropOldestRing {
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "capacity must be a power of two");
+
+public:
+    DropOldestRing() {
+        for (auto& slot : slots_) slot.store(0, std::memory_order_relaxed);
+    }
+
+    // 只能由生产者线程调用；返回 true 表示为腾出位置丢弃了最旧的元素 (写入 *dropped)
+    bool Push(uint32_t value, uint32_t* dropped) {
+        const uint64_t tail = tail_.load(std::memory_order_relaxed);
+        uint64_t head = head_.load(std::memory_order_acquire);
+        bool evicted = false;
+        while (tail - head >= Capacity) {
+            const uint32_t oldest = slots_[head & (Capacity - 1)].load(std::memory_order_relaxed);
+            if (head_.compare_exchange_weak(head, head + 1, std::memory_order_acq_rel, std::memory_order_acquire)) {
+                *dropped = oldest;
+                evicted = true;
+                break;
+            }
+            // 消费者刚取走一个 (或伪失败): head 已更新，重新判断是否仍然满
+        }
+        slots_[tail & (Capacity - 1)].store(value, std::memory_order_relaxed);
+        tail_.store(tail + 1, std::memory_order_release);
+        return evicted;
+    }
+
+    // 只能由消费者线程调用；环空时返回 false
+    bool Pop(uint32_t* out) {
+        uint64_t head = head_.load(std::memory_order_acquire);
+        for (;;) {
+            if (head == tail_.load(std::memory_order_acquire)) return false;
+            const uint32_t value = slots_[head & (Capacity - 1)].load(std::memory_order_relaxed);
+            // head 未变说明该槽位在读取期间没有被生产者抢占改写
+            if (head_.compare_exchange_weak(head, head + 1, std::memory_order_acq_rel, std::memory_order_acquire)) {
+                *out = value;
+                return true;
+            }
+        }
+    }
+
+private:
+    std::atomic<uint32_t> slots_[Capacity];
+    alignas(64) std::atomic<uint64_t> head_{0};
+    alignas(64) std::atomic<uint64_t> tail_{0};
+};
+
+// 空闲线程的唤醒信号
+// 数据经由无锁队列传递；只有消费者确实无事可做时才进入等待，生产者仅在有等待者时加锁通知。
+// 用法: seen = Sequence(); 检查队列; 为空则 Wait(seen)
+class WakeSignal {
+public:
+    uint32_t Sequence() const { return sequence_.load(std::memory_order_seq_cst); }
+
+    void Notify() {
+        sequence_.fetch_add(1, std::memory_order_seq_cst);
+        if (waiters_.load(std::memory_order_seq_cst) > 0) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            cv_.notify_all();
+        }
+    }
+
+    // 等到 Sequence() 不再等于 seen
+    void Wait(uint32_t seen) {
+        waiters_.fetch_add(1, std::memory_order_seq_cst);
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [&] { return sequence_.load(std::memory_order_seq_cst) != seen; });
+        }
+        waiters_.fetch_sub(1, std::memory_order_seq_cst);
+    }
+
+private:
+    std::atomic<uint32_t> sequence_{0};
+    std::atomic<int> waiters_{0};
+    std::mutex mutex_;
+    std::condition_variable cv_;
+};
+
+#endif // SPSC_QUEUE_H
@@ -0,0 +1,96 @@
+#include "ssd_matcher.h"
+
+#include <algorithm>
+#include <cmath>
+
+int64_t SsdLimitFromThreshold(double threshold, int64_t area, int channels) {
+    const double t = std::min(1.0, std::max(0.0, threshold));
+    const double rms = (1.0 - t) * 255.0;
+    return static_cast<int64_t>(std::floor(rms * rms * static_cast<double>(area * channels)));
+}
+
+double SsdToScore(int64_t ssd, int64_t area, int channels) {
+    const double n = static_cast<double>(area * channels);
+    if (n <= 0) return 0.0;
+    return 1.0 - std::sqrt(static_cast<double>(ssd) / n) / 255.0;
+}
+
+void BeginSsdSearch(int64_t limit, SsdMatchResult* result) {
+    *result = SsdMatchResult();
+    result->ssd = limit;
+}
+
+// 单行差平方和 (每字节最多 255^2，行宽在 SlidingWindowStats::Fits 的范围内时不会溢出 int32)
+static inline int64_t RowSsd(const uint8_t* a, const uint8_t* b, int n) {
+    int32_t s = 0;
+    for (int i = 0; i < n; i++) {
+        const int32_t d = static_cast<int32_t>(a[i]) - static_cast<int32_t>(b[i]);
+        s += d * d;
+    }
+    return s;
+}
+
+void SsdMatchRow(const ImageView& src, const ImageView& templ, const TemplateSums& templSums,
+                 const int32_t* windowSums, int cols, int y, int64_t limit, SsdMatchResult* result) {
+    const int ch = templ.channels;
+    const int rowBytes = templ.width * ch;
+    const int64_t area = templSums.area;
+
+    result->positions += cols;
+    for (int x = 0; x < cols; x++) {
+        // 只接受严格更优的位置，保证与 minMaxLoc 一样返回行优先的第一个最小值
+        const int64_t bound = result->found ? result->ssd - 1 : limit;
+        if (bound < 0) {
+            result->rejectedByBound += cols - x;
+            return;
+        }
+
+        // 1. 窗口和下界 (Cauchy-Schwarz): sum_c (S_c - T_c)^2 <= N * SSD
+        const int32_t* ws = windowSums + x * ch;
+        int64_t lower = 0;
+        for (int c = 0; c < ch; c++) {
+            const int64_t d = static_cast<int64_t>(ws[c]) - templSums.sum[c];
+            lower += d * d;
+        }
+        if (lower > bound * area) {
+            result->rejectedByBound++;
+            continue;
+        }
+
+        // 2. 逐行累加，超过上限立即终止
+        int64_t partial = 0;
+        int r = 0;
+        for (; r < templ.height; r++) {
+            partial += RowSsd(src.Row(y + r) + x * ch, templ.Row(r), rowBytes);
+            if (partial > bound) break;
+        }
+        result->pixelsCompared += static_cast<int64_t>(std::min(r + 1, templ.height)) * rowBytes;
+        if (r < templ.height) {
+            result->rejectedEarly++;
+            continue;
+        }
+
+        result->found = true;
+        result->ssd = partial;
+        result->x = x;
+        result->y = y;
+    }
+}
+
+bool MatchSsd(const ImageView& src, const ImageView& templ, const TemplateSums& templSums,
+              double threshold, SlidingWindowStats* scratch, SsdMatchResult* result) {
+    const int64_t limit = SsdLimitFromThreshold(threshold, templSums.area, templ.channels);
+    BeginSsdSearch(limit, result);
+    if (templ.channels != src.channels || !scratch->Reset(src, templ.width, templ.height)) {
+        return false;
+    }
+
+    do {
+        SsdMatchRow(src, templ, templSums, scratch->Sums(), scratch->Cols(), scratch->Row(), limit, result);
+    } while (scratch->Advance());
+
+    if (result->found) {
+        result->score = SsdToScore(result->ssd, templSums.area, templ.channels);
+    }
+    return result->found;
+}
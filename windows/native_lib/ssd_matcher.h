@@ -0,0 +1,52 @@
+#ifndef SSD_MATCHER_H
+#define SSD_MATCHER_H
+
+#include "image_view.h"
+#include "window_stats.h"
+
+#include <cstdint>
+
+// 逐次消除 (Successive Elimination) SSD 匹配
+//
+// 对每个候选位置先用窗口像素和给出的下界
+//     SSD >= sum_c (S_c - T_c)^2 / N
+// 直接淘汰大部分位置；剩余位置逐行累加差平方和，一旦超过当前最优值立即终止。
+// 适用于像素级一致的 UI 元素，大多数位置只需读取几行即可被排除。
+//
+// 分数定义为 1 - RMS(差值) / 255，范围 [0, 1]，与 TM_CCOEFF_NORMED 一样越大越相似，
+// 因此 SearchRequest::threshold 的语义保持不变。
+
+struct SsdMatchResult {
+    bool found = false;
+    int x = -1;
+    int y = -1;
+    int64_t ssd = 0;
+    double score = 0.0;
+
+    // 剪枝统计
+    int64_t positions = 0;        // 候选位置总数
+    int64_t rejectedByBound = 0;  // 被窗口和下界直接淘汰
+    int64_t rejectedEarly = 0;    // 逐行累加途中提前终止
+    int64_t pixelsCompared = 0;   // 实际比较的字节数
+};
+
+// 阈值 (相似度) 换算为允许的最大 SSD
+int64_t SsdLimitFromThreshold(double threshold, int64_t area, int channels);
+
+// SSD 换算为相似度分数
+double SsdToScore(int64_t ssd, int64_t area, int channels);
+
+// 开始一次搜索：清空结果并设置初始上限
+void BeginSsdSearch(int64_t limit, SsdMatchResult* result);
+
+// 处理结果图第 y 行的全部候选位置
+// windowSums: 该行的逐通道窗口和 (SlidingWindowStats::Sums)
+void SsdMatchRow(const ImageView& src, const ImageView& templ, const TemplateSums& templSums,
+                 const int32_t* windowSums, int cols, int y, int64_t limit, SsdMatchResult* result);
+
+// 完整搜索：逐行推进窗口统计并调用 SsdMatchRow
+// scratch 由调用者持有以便复用内存
+bool MatchSsd(const ImageView& src, const ImageView& templ, const TemplateSums& templSums,
+              double threshold, SlidingWindowStats* scratch, SsdMatchResult* result);
+
+#endif // SSD_MATCHER_H
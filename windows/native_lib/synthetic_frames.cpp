@@ -0,0 +1,282 @@
+#include "synthetic_frames.h"
+
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+struct Color {
+    uint8_t b, g, r;
+};
+
+Color RandomColor(SplitMix64& rng) {
+    const uint64_t v = rng.Next();
+    return {static_cast<uint8_t>(v), static_cast<uint8_t>(v >> 8), static_cast<uint8_t>(v >> 16)};
+}
+
+// 裁剪到图像范围内；完全在外时返回空矩形
+cv::Rect Clip(const cv::Rect& rect, int width, int height) {
+    const int x0 = std::max(rect.x, 0);
+    const int y0 = std::max(rect.y, 0);
+    const int x1 = std::min(rect.x + rect.width, width);
+    const int y1 = std::min(rect.y + rect.height, height);
+    return x1 > x0 && y1 > y0 ? cv::Rect(x0, y0, x1 - x0, y1 - y0) : cv::Rect();
+}
+
+bool Intersects(const cv::Rect& a, const cv::Rect& b) {
+    return a.x < b.x + b.width && b.x < a.x + a.width && a.y < b.y + b.height && b.y < a.y + a.height;
+}
+
+// 形状自行绘制 (不用 cv::rectangle / cv::circle)，像素结果只取决于整数与 IEEE 基本运算
+void FillRect(cv::Mat& image, const cv::Rect& rect, Color c) {
+    const cv::Rect clipped = Clip(rect, image.cols, image.rows);
+    for (int y = clipped.y; y < clipped.y + clipped.height; y++) {
+        uint8_t* p = image.ptr<uint8_t>(y) + clipped.x * 3;
+        for (int x = 0; x < clipped.width; x++, p += 3) {
+            p[0] = c.b;
+            p[1] = c.g;
+            p[2] = c.r;
+        }
+    }
+}
+
+void FillEllipse(cv::Mat& image, const cv::Rect& box, Color c) {
+    const cv::Rect clipped = Clip(box, image.cols, image.rows);
+    const double cx = box.x + box.width * 0.5;
+    const double cy = box.y + box.height * 0.5;
+    const double rx = box.width * 0.5;
+    const double ry = box.height * 0.5;
+    for (int y = clipped.y; y < clipped.y + clipped.height; y++) {
+        const double dy = (y + 0.5 - cy) / ry;
+        uint8_t* row = image.ptr<uint8_t>(y);
+        for (int x = clipped.x; x < clipped.x + clipped.width; x++) {
+            const double dx = (x + 0.5 - cx) / rx;
+            if (dx * dx + dy * dy > 1.0) continue;
+            row[x * 3] = c.b;
+            row[x * 3 + 1] = c.g;
+            row[x * 3 + 2] = c.r;
+        }
+    }
+}
+
+// 随机方向的两色线性渐变 (整数插值)
+void FillGradient(cv::Mat& image, SplitMix64& rng) {
+    const Color a = RandomColor(rng);
+    const Color b = RandomColor(rng);
+    int dx = rng.Range(-8, 8);
+    const int dy = rng.Range(-8, 8);
+    if (dx == 0 && dy == 0) dx = 1;
+    const int64_t w = image.cols - 1;
+    const int64_t h = image.rows - 1;
+    const int64_t corners[4] = {0, w * dx, h * dy, w * dx + h * dy};
+    const int64_t lo = *std::min_element(corners, corners + 4);
+    const int64_t span = std::max<int64_t>(1, *std::max_element(corners, corners + 4) - lo);
+    for (int y = 0; y < image.rows; y++) {
+        uint8_t* p = image.ptr<uint8_t>(y);
+        for (int x = 0; x < image.cols; x++, p += 3) {
+            const int64_t t = static_cast<int64_t>(x) * dx + static_cast<int64_t>(y) * dy - lo;
+            p[0] = static_cast<uint8_t>(a.b + (b.b - a.b) * t / span);
+            p[1] = static_cast<uint8_t>(a.g + (b.g - a.g) * t / span);
+            p[2] = static_cast<uint8_t>(a.r + (b.r - a.r) * t / span);
+        }
+    }
+}
+
+// 随机形状 (矩形或椭圆)，尺寸在 [2, maxSide] 内
+void ScatterShapes(cv::Mat& image, SplitMix64& rng, int count, int maxSide) {
+    for (int i = 0; i < count; i++) {
+        const int w = rng.Range(2, maxSide);
+        const int h = rng.Range(2, maxSide);
+        // 取随机数的顺序必须固定，不能放在同一个调用的参数里 (求值顺序随编译器而变)
+        const int x = rng.Range(-w / 2, image.cols - w / 2);
+        const int y = rng.Range(-h / 2, image.rows - h / 2);
+        const cv::Rect box(x, y, w, h);
+        const Color c = RandomColor(rng);
+        if (rng.Next() & 1) {
+            FillRect(image, box, c);
+        } else {
+            FillEllipse(image, box, c);
+        }
+    }
+}
+
+void FillBackground(cv::Mat& image, int background, SplitMix64& rng) {
+    if (background == SYNTHETIC_BACKGROUND_MIXED) background = rng.Range(0, SYNTHETIC_BACKGROUND_MIXED - 1);
+    switch (background) {
+    case SYNTHETIC_BACKGROUND_FLAT:
+        FillRect(image, cv::Rect(0, 0, image.cols, image.rows), RandomColor(rng));
+        break;
+    case SYNTHETIC_BACKGROUND_GRADIENT:
+        FillGradient(image, rng);
+        break;
+    case SYNTHETIC_BACKGROUND_NOISE: {
+        // 每个格点一种随机色，双线性放大为平滑的色斑
+        const int cell = rng.Range(16, 96);
+        cv::Mat grid(image.rows / cell + 2, image.cols / cell + 2, CV_8UC3);
+        for (int y = 0; y < grid.rows; y++) {
+            uint8_t* p = grid.ptr<uint8_t>(y);
+            for (int x = 0; x < grid.cols; x++, p += 3) {
+                const Color c = RandomColor(rng);
+                p[0] = c.b;
+                p[1] = c.g;
+                p[2] = c.r;
+            }
+        }
+        cv::resize(grid, image, image.size(), 0, 0, cv::INTER_LINEAR);
+        break;
+    }
+    case SYNTHETIC_BACKGROUND_CHECKER: {
+        const int cell = rng.Range(8, 64);
+        const Color colors[2] = {RandomColor(rng), RandomColor(rng)};
+        for (int y = 0; y < image.rows; y++) {
+            uint8_t* p = image.ptr<uint8_t>(y);
+            for (int x = 0; x < image.cols; x++, p += 3) {
+                const Color& c = colors[((x / cell) + (y / cell)) & 1];
+                p[0] = c.b;
+                p[1] = c.g;
+                p[2] = c.r;
+            }
+        }
+        break;
+    }
+    default:
+        FillGradient(image, rng);
+        ScatterShapes(image, rng, std::max(1, image.cols * image.rows / 4000),
+                      std::max(3, std::min(image.cols, image.rows) / 6));
+        break;
+    }
+}
+
+// 近似高斯噪声: 一个 64 位随机数的 8 个字节之和 (均值 1020，标准差约 209) 按 sigma 缩放
+// 每个通道只取一次随机数，整数运算，结果与平台无关
+void AddNoise(cv::Mat& image, double sigma, SplitMix64& rng) {
+    const int64_t k = std::llround(sigma / 209.02 * 65536.0);
+    for (int y = 0; y < image.rows; y++) {
+        uint8_t* p = image.ptr<uint8_t>(y);
+        for (int i = 0; i < image.cols * 3; i++) {
+            uint64_t v = rng.Next();
+            v = (v & 0x00FF00FF00FF00FFull) + ((v >> 8) & 0x00FF00FF00FF00FFull);
+            v += v >> 16;
+            v += v >> 32;
+            const int64_t sum = static_cast<int64_t>(v & 0xFFFF);
+            const int value = p[i] + static_cast<int>((sum - 1020) * k / 65536);
+            p[i] = static_cast<uint8_t>(std::min(255, std::max(0, value)));
+        }
+    }
+}
+
+} // namespace
+
+bool ParseSyntheticBackground(const std::string& name, int* out) {
+    static const char* const kNames[] = {"flat", "gradient", "noise", "checker", "clutter", "mixed"};
+    for (int i = 0; i < static_cast<int>(sizeof(kNames) / sizeof(kNames[0])); i++) {
+        if (name == kNames[i]) {
+            *out = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+cv::Mat MakeSyntheticTemplate(uint64_t seed, int width, int height) {
+    SplitMix64 rng(seed);
+    cv::Mat image(height, width, CV_8UC3);
+    FillGradient(image, rng);
+    ScatterShapes(image, rng, std::max(3, width * height / 150), std::max(3, std::min(width, height) / 2));
+    return image;
+}
+
+void GenerateSyntheticFrame(const SyntheticFrameOptions& options, const std::vector<SyntheticTemplate>& templates,
+                            int index, cv::Mat* frame, std::vector<GroundTruthObject>* objects) {
+    // 每个阶段一条独立的随机序列: 调整噪声或遮挡参数不会改变实例的位置
+    SplitMix64 frameRng(options.seed + static_cast<uint64_t>(index) * 0xD1B54A32D192ED03ull);
+    SplitMix64 backgroundRng(frameRng.Next());
+    SplitMix64 layoutRng(frameRng.Next());
+    SplitMix64 occlusionRng(frameRng.Next());
+    SplitMix64 noiseRng(frameRng.Next());
+
+    frame->create(options.height, options.width, CV_8UC3);
+    FillBackground(*frame, options.background, backgroundRng);
+
+    objects->clear();
+    std::vector<cv::Rect> placed;
+    cv::Mat scaled;
+    for (int t = 0; t < static_cast<int>(templates.size()); t++) {
+        const SyntheticTemplate& templ = templates[t];
+        const cv::Rect region = templ.region.width > 0 && templ.region.height > 0
+                                    ? Clip(templ.region, options.width, options.height)
+                                    : cv::Rect(0, 0, options.width, options.height);
+        const int count = layoutRng.Range(options.minCount, options.maxCount);
+        for (int k = 0; k < count; k++) {
+            const double scale = 1.0 + (2.0 * layoutRng.Uniform() - 1.0) * options.scaleJitter;
+            const int w = std::max(1, static_cast<int>(std::lround(templ.image.cols * scale)));
+            const int h = std::max(1, static_cast<int>(std::lround(templ.image.rows * scale)));
+            if (w > region.width || h > region.height) continue;
+
+            // 拒绝采样找一个不与已放置实例重叠的位置，找不到则舍弃该实例
+            cv::Rect rect;
+            for (int attempt = 0; attempt < 64 && rect.width == 0; attempt++) {
+                const int x = layoutRng.Range(region.x, region.x + region.width - w);
+                const int y = layoutRng.Range(region.y, region.y + region.height - h);
+                const cv::Rect candidate(x, y, w, h);
+                bool free = true;
+                for (const cv::Rect& other : placed) {
+                    if (!options.allowOverlap && Intersects(candidate, other)) {
+                        free = false;
+                        break;
+                    }
+                }
+                if (free) rect = candidate;
+            }
+            if (rect.width == 0) continue;
+
+            cv::Mat target = (*frame)(rect);
+            if (w == templ.image.cols && h == templ.image.rows) {
+                templ.image.copyTo(target);
+            } else {
+                cv::resize(templ.image, scaled, cv::Size(w, h), 0, 0, scale < 1 ? cv::INTER_AREA : cv::INTER_LINEAR);
+                scaled.copyTo(target);
+            }
+            placed.push_back(rect);
+            GroundTruthObject object;
+            object.templateIndex = t;
+            object.x = rect.x;
+            object.y = rect.y;
+            object.width = w;
+            object.height = h;
+            objects->push_back(object);
+        }
+    }
+
+    // 遮挡: 从随机一侧用单色条覆盖实例的一部分 (类似弹出的界面面板)
+    if (options.occlusion > 0) {
+        for (const cv::Rect& rect : placed) {
+            const double fraction = occlusionRng.Uniform() * options.occlusion;
+            const int side = occlusionRng.Range(0, 3);
+            const Color c = RandomColor(occlusionRng);
+            const bool horizontal = side < 2;
+            const int band = static_cast<int>(std::lround((horizontal ? rect.width : rect.height) * fraction));
+            if (band <= 0) continue;
+            cv::Rect cover = rect;
+            if (horizontal) {
+                cover.width = band;
+                if (side == 1) cover.x = rect.x + rect.width - band;
+            } else {
+                cover.height = band;
+                if (side == 3) cover.y = rect.y + rect.height - band;
+            }
+            FillRect(*frame, cover, c);
+        }
+    }
+
+    if (options.noiseSigma > 0) AddNoise(*frame, options.noiseSigma, noiseRng);
+
+    if (options.jpegQuality > 0) {
+        std::vector<uint8_t> encoded;
+        cv::imencode(".jpg", *frame, encoded, {cv::IMWRITE_JPEG_QUALITY, std::min(options.jpegQuality, 100)});
+        *frame = cv::imdecode(encoded, cv::IMREAD_COLOR);
+    }
+}
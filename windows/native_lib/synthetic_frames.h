@@ -0,0 +1,86 @@
+#ifndef SYNTHETIC_FRAMES_H
+#define SYNTHETIC_FRAMES_H
+
+#include "ground_truth.h"
+
+#include <opencv2/core.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// 合成帧生成器
+// 把模板按可控的数量、位置、尺度合成到背景纹理上，并叠加遮挡、噪声与 JPEG 压缩失真，
+// 同时给出标注 (ground_truth.h 格式)，使基准与精度回归 (tools/accuracy_harness) 不依赖
+// 无法分发的游戏截图，也能覆盖截图中少见的边界情况。
+// 每帧只由 (seed, 帧下标) 决定: 随机数使用 SplitMix64 并自行完成全部采样，不依赖 std 分布
+// (其结果随标准库实现而变)。同一 OpenCV 版本下输出逐字节一致；JPEG 失真依赖 libjpeg 版本。
+
+// SplitMix64: 状态 64 位，一次乘加与两次异或移位，足以生成纹理与布局
+class SplitMix64 {
+public:
+    explicit SplitMix64(uint64_t seed) : state_(seed) {}
+
+    uint64_t Next() {
+        uint64_t z = (state_ += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    // [0, 1)，53 位精度
+    double Uniform() { return (Next() >> 11) * (1.0 / 9007199254740992.0); }
+
+    // [lo, hi] 内的整数；hi < lo 时返回 lo
+    int Range(int lo, int hi) {
+        if (hi <= lo) return lo;
+        return lo + static_cast<int>(Next() % (static_cast<uint64_t>(hi) - lo + 1));
+    }
+
+private:
+    uint64_t state_;
+};
+
+enum SyntheticBackground {
+    SYNTHETIC_BACKGROUND_FLAT = 0,     // 单色
+    SYNTHETIC_BACKGROUND_GRADIENT = 1, // 两色线性渐变
+    SYNTHETIC_BACKGROUND_NOISE = 2,    // 平滑的块状噪声 (低分辨率随机色放大)
+    SYNTHETIC_BACKGROUND_CHECKER = 3,  // 棋盘格
+    SYNTHETIC_BACKGROUND_CLUTTER = 4,  // 渐变上叠加大量随机色块，接近游戏界面的杂乱程度
+    SYNTHETIC_BACKGROUND_MIXED = 5,    // 每帧从以上几种中随机选择
+};
+
+// 背景名称 (flat / gradient / noise / checker / clutter / mixed)
+bool ParseSyntheticBackground(const std::string& name, int* out);
+
+struct SyntheticFrameOptions {
+    int width = 1280;
+    int height = 720;
+    uint64_t seed = 1;
+    int background = SYNTHETIC_BACKGROUND_MIXED;
+    int minCount = 0;           // 每个模板每帧的实例数在 [minCount, maxCount] 内均匀选取
+    int maxCount = 1;           // (0 个实例的帧用于统计误报)
+    double scaleJitter = 0;     // 实例尺度在 [1 - scaleJitter, 1 + scaleJitter] 内
+    double occlusion = 0;       // 每个实例被遮挡的比例 (从一侧覆盖) 在 [0, occlusion] 内
+    double noiseSigma = 0;      // 近似高斯噪声的标准差 (灰度级)，0 表示不加
+    int jpegQuality = 0;        // 1-100 时做一次 JPEG 编解码，0 表示不做
+    bool allowOverlap = false;  // 为 false 时实例之间互不重叠 (放不下的实例被舍弃)
+};
+
+// 要合成的模板
+struct SyntheticTemplate {
+    cv::Mat image;              // BGR (8UC3)
+    cv::Rect region;            // 实例放置范围 (帧坐标)，为空表示整帧；与查找请求的 ROI 对应
+};
+
+// 生成一个随机纹理模板 (BGR)，用于没有任何图片素材的场合；同一 seed 结果相同
+cv::Mat MakeSyntheticTemplate(uint64_t seed, int width, int height);
+
+// 生成第 index 帧
+// frame: 输出 BGR (8UC3)，尺寸为 options.width x options.height
+// objects: 输出帧中的全部实例 (templateIndex 为 templates 下标，宽高为缩放后的尺寸)
+// 实例按模板顺序放置，被后放置的实例或遮挡物部分覆盖时仍计入标注
+void GenerateSyntheticFrame(const SyntheticFrameOptions& options, const std::vector<SyntheticTemplate>& templates,
+                            int index, cv::Mat* frame, std::vector<GroundTruthObject>* objects);
+
+#endif // SYNTHETIC_FRAMES_H
@@ -0,0 +1,51 @@
+#ifndef TEMPLATE_ENTRY_H
+#define TEMPLATE_ENTRY_H
+
+#include "mat_view.h"
+#include "ncc_matcher.h"
+#include "window_stats.h"
+
+#include <opencv2/core.hpp>
+
+#include <memory>
+#include <mutex>
+
+// 已加载的模板及其预计算数据 (加载后只读，可在多个搜索间共享)
+// 通过 shared_ptr 持有：正在执行的批次或编译好的计划会让模板一直有效，
+// 即使其间调用了 release_template
+struct TemplateEntry {
+    cv::Mat image;     // BGR
+    TemplateSums sums; // 逐通道像素和 / 平方和
+    std::shared_ptr<const void> storage; // image 指向外部内存 (如映射的模板包) 时保持其有效
+
+    // 整数 NCC 内核使用的展宽模板 (模板大小的 2 倍)，首次使用时准备，之后只读；可在多个线程上同时调用
+    // 模板包中的大量模板多数只走 SSD 或 OpenCV，加载时不为它们展宽
+    const NccTemplate& Ncc() const {
+        std::call_once(nccOnce_, [this] { PrepareNccTemplate(ToImageView(image), sums, &ncc_); });
+        return ncc_;
+    }
+
+private:
+    mutable std::once_flag nccOnce_;
+    mutable NccTemplate ncc_;
+};
+
+// 构造模板条目并预计算统计量，匹配时不再重复遍历模板
+inline std::shared_ptr<const TemplateEntry> MakeTemplateEntry(const cv::Mat& image) {
+    auto entry = std::make_shared<TemplateEntry>();
+    entry->image = image;
+    ComputeTemplateSums(ToImageView(entry->image), &entry->sums);
+    return entry;
+}
+
+// 统计量已预先算好 (来自模板包) 时直接使用，image 不复制
+inline std::shared_ptr<const TemplateEntry> MakeTemplateEntry(const cv::Mat& image, const TemplateSums& sums,
+                                                              std::shared_ptr<const void> storage) {
+    auto entry = std::make_shared<TemplateEntry>();
+    entry->image = image;
+    entry->sums = sums;
+    entry->storage = std::move(storage);
+    return entry;
+}
+
+#endif // TEMPLATE_ENTRY_H
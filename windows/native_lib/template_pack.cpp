@@ -0,0 +1,331 @@
+#include "template_pack.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// 文件布局依赖结构体大小，修改字段时必须同时提升 kPackVersion
+static_assert(sizeof(PackHeader) == 40, "PackHeader layout changed");
+static_assert(sizeof(PackPlane) == 24, "PackPlane layout changed");
+static_assert(sizeof(PackEntry) == 248, "PackEntry layout changed");
+
+static uint64_t AlignUp(uint64_t value) {
+    return (value + kPackAlignment - 1) / kPackAlignment * kPackAlignment;
+}
+
+static void SetError(std::string* error, const char* message) {
+    if (error) *error = message;
+}
+
+TemplatePack::~TemplatePack() {
+    Close();
+}
+
+bool TemplatePack::Open(const std::string& path, std::string* error) {
+    Close();
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        SetError(error, "cannot open file");
+        return false;
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart <= 0) {
+        CloseHandle(file);
+        SetError(error, "empty file");
+        return false;
+    }
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping) {
+        CloseHandle(file);
+        SetError(error, "cannot map file");
+        return false;
+    }
+    const void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!view) {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        SetError(error, "cannot map file");
+        return false;
+    }
+    file_ = file;
+    mapping_ = mapping;
+    data_ = static_cast<const uint8_t*>(view);
+    size_ = static_cast<uint64_t>(size.QuadPart);
+#else
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        SetError(error, "cannot open file");
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        ::close(fd);
+        SetError(error, "empty file");
+        return false;
+    }
+    void* view = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd); // 映射建立后即可关闭描述符
+    if (view == MAP_FAILED) {
+        SetError(error, "cannot map file");
+        return false;
+    }
+    data_ = static_cast<const uint8_t*>(view);
+    size_ = static_cast<uint64_t>(st.st_size);
+#endif
+
+    header_ = reinterpret_cast<const PackHeader*>(data_);
+    if (!Validate(error)) {
+        Close();
+        return false;
+    }
+    entries_ = reinterpret_cast<const PackEntry*>(data_ + header_->entriesOffset);
+    return true;
+}
+
+void TemplatePack::Close() {
+    if (data_) {
+#ifdef _WIN32
+        UnmapViewOfFile(data_);
+        CloseHandle(static_cast<HANDLE>(mapping_));
+        CloseHandle(static_cast<HANDLE>(file_));
+        mapping_ = nullptr;
+        file_ = nullptr;
+#else
+        munmap(const_cast<uint8_t*>(data_), static_cast<size_t>(size_));
+#endif
+    }
+    data_ = nullptr;
+    size_ = 0;
+    header_ = nullptr;
+    entries_ = nullptr;
+}
+
+// 平面是否完整位于文件内
+static bool PlaneInBounds(const PackPlane& plane, int channels, uint64_t fileSize) {
+    if (plane.width <= 0 || plane.height <= 0) return false;
+    if (plane.stride < static_cast<uint64_t>(plane.width) * channels) return false;
+    const uint64_t bytes = static_cast<uint64_t>(plane.stride) * plane.height;
+    return plane.offset <= fileSize && bytes <= fileSize - plane.offset;
+}
+
+bool TemplatePack::Validate(std::string* error) const {
+    if (size_ < sizeof(PackHeader)) {
+        SetError(error, "file too small");
+        return false;
+    }
+    if (std::memcmp(header_->magic, kPackMagic, sizeof(kPackMagic)) != 0) {
+        SetError(error, "bad magic");
+        return false;
+    }
+    if (header_->version != kPackVersion || header_->headerSize != sizeof(PackHeader) ||
+        header_->entrySize != sizeof(PackEntry)) {
+        SetError(error, "unsupported version");
+        return false;
+    }
+    if (header_->fileSize != size_) {
+        SetError(error, "truncated file");
+        return false;
+    }
+    const uint64_t entriesBytes = static_cast<uint64_t>(header_->entryCount) * sizeof(PackEntry);
+    if (header_->entriesOffset % alignof(PackEntry) != 0 || header_->entriesOffset > size_ ||
+        entriesBytes > size_ - header_->entriesOffset) {
+        SetError(error, "entry table out of bounds");
+        return false;
+    }
+
+    const PackEntry* entries = reinterpret_cast<const PackEntry*>(data_ + header_->entriesOffset);
+    for (uint32_t i = 0; i < header_->entryCount; i++) {
+        const PackEntry& e = entries[i];
+        if (std::memchr(e.name, 0, sizeof(e.name)) == nullptr || e.channels != 3 ||
+            e.levelCount < 1 || e.levelCount > kPackMaxLevels) {
+            SetError(error, "bad entry");
+            return false;
+        }
+        for (int level = 0; level < e.levelCount; level++) {
+            if (!PlaneInBounds(e.levels[level], e.channels, size_)) {
+                SetError(error, "pixel plane out of bounds");
+                return false;
+            }
+        }
+        if ((e.flags & kPackEntryHasMask) && !PlaneInBounds(e.mask, 1, size_)) {
+            SetError(error, "mask out of bounds");
+            return false;
+        }
+    }
+    return true;
+}
+
+ImageView TemplatePack::Level(int index, int level) const {
+    const PackEntry& e = entries_[index];
+    ImageView view;
+    if (level < 0 || level >= e.levelCount) return view;
+    const PackPlane& plane = e.levels[level];
+    view.data = data_ + plane.offset;
+    view.width = plane.width;
+    view.height = plane.height;
+    view.stride = static_cast<int>(plane.stride);
+    view.channels = e.channels;
+    return view;
+}
+
+ImageView TemplatePack::Mask(int index) const {
+    const PackEntry& e = entries_[index];
+    ImageView view;
+    if (!(e.flags & kPackEntryHasMask)) return view;
+    view.data = data_ + e.mask.offset;
+    view.width = e.mask.width;
+    view.height = e.mask.height;
+    view.stride = static_cast<int>(e.mask.stride);
+    view.channels = 1;
+    return view;
+}
+
+TemplateSums TemplatePack::Sums(int index) const {
+    const PackEntry& e = entries_[index];
+    TemplateSums sums;
+    sums.channels = e.channels;
+    sums.area = e.area;
+    for (int c = 0; c < 4; c++) sums.sum[c] = e.sum[c];
+    sums.sumSq = e.sumSq;
+    return sums;
+}
+
+// 按对齐跨度复制平面像素
+static void CopyPlane(const ImageView& src, PackPlane* plane, std::vector<uint8_t>* out) {
+    plane->width = src.width;
+    plane->height = src.height;
+    plane->stride = static_cast<uint32_t>(AlignUp(static_cast<uint64_t>(src.width) * src.channels));
+    plane->reserved = 0;
+    plane->offset = 0;
+    out->assign(static_cast<size_t>(plane->stride) * src.height, 0);
+    const size_t rowBytes = static_cast<size_t>(src.width) * src.channels;
+    for (int y = 0; y < src.height; y++) {
+        std::memcpy(out->data() + static_cast<size_t>(y) * plane->stride, src.Row(y), rowBytes);
+    }
+}
+
+bool TemplatePackWriter::Add(const std::string& name, const ImageView* levels, int levelCount,
+                             const ImageView* mask) {
+    if (name.empty() || name.size() >= static_cast<size_t>(kPackNameSize) || !levels ||
+        levelCount < 1 || levelCount > kPackMaxLevels) {
+        return false;
+    }
+    for (int level = 0; level < levelCount; level++) {
+        if (levels[level].Empty() || levels[level].channels != 3) return false;
+    }
+    if (mask && (mask->Empty() || mask->channels != 1 ||
+                 mask->width != levels[0].width || mask->height != levels[0].height)) {
+        return false;
+    }
+
+    Pending pending;
+    PackEntry& e = pending.entry;
+    std::memset(&e, 0, sizeof(e));
+    std::memcpy(e.name, name.c_str(), name.size());
+    e.channels = 3;
+    e.levelCount = levelCount;
+
+    pending.levels.resize(levelCount);
+    for (int level = 0; level < levelCount; level++) {
+        CopyPlane(levels[level], &e.levels[level], &pending.levels[level]);
+    }
+    if (mask) {
+        e.flags |= kPackEntryHasMask;
+        CopyPlane(*mask, &e.mask, &pending.mask);
+    }
+
+    TemplateSums sums;
+    ComputeTemplateSums(levels[0], &sums);
+    e.area = sums.area;
+    for (int c = 0; c < 4; c++) e.sum[c] = sums.sum[c];
+    e.sumSq = sums.sumSq;
+
+    entries_.push_back(std::move(pending));
+    return true;
+}
+
+bool TemplatePackWriter::Write(const std::string& path, std::string* error) const {
+    PackHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, kPackMagic, sizeof(kPackMagic));
+    header.version = kPackVersion;
+    header.headerSize = sizeof(PackHeader);
+    header.entryCount = static_cast<uint32_t>(entries_.size());
+    header.entrySize = sizeof(PackEntry);
+    header.entriesOffset = AlignUp(sizeof(PackHeader));
+
+    // 先分配数据区偏移
+    std::vector<PackEntry> table;
+    table.reserve(entries_.size());
+    uint64_t offset = AlignUp(header.entriesOffset + sizeof(PackEntry) * entries_.size());
+    for (const Pending& pending : entries_) {
+        PackEntry e = pending.entry;
+        for (int level = 0; level < e.levelCount; level++) {
+            e.levels[level].offset = offset;
+            offset = AlignUp(offset + pending.levels[level].size());
+        }
+        if (e.flags & kPackEntryHasMask) {
+            e.mask.offset = offset;
+            offset = AlignUp(offset + pending.mask.size());
+        }
+        table.push_back(e);
+    }
+    header.fileSize = offset;
+
+    FILE* file = std::fopen(path.c_str(), "wb");
+    if (!file) {
+        SetError(error, "cannot create file");
+        return false;
+    }
+
+    uint64_t written = 0;
+    static const uint8_t kZeros[kPackAlignment] = {};
+    auto writeBytes = [&](const void* data, size_t bytes) {
+        if (bytes > 0 && std::fwrite(data, 1, bytes, file) != bytes) return false;
+        written += bytes;
+        return true;
+    };
+    auto padTo = [&](uint64_t target) {
+        while (written < target) {
+            const size_t n = static_cast<size_t>(std::min<uint64_t>(target - written, kPackAlignment));
+            if (!writeBytes(kZeros, n)) return false;
+        }
+        return true;
+    };
+
+    bool ok = writeBytes(&header, sizeof(header)) && padTo(header.entriesOffset) &&
+              writeBytes(table.data(), sizeof(PackEntry) * table.size());
+    for (size_t i = 0; ok && i < entries_.size(); i++) {
+        const PackEntry& e = table[i];
+        for (int level = 0; ok && level < e.levelCount; level++) {
+            ok = padTo(e.levels[level].offset) &&
+                 writeBytes(entries_[i].levels[level].data(), entries_[i].levels[level].size());
+        }
+        if (ok && (e.flags & kPackEntryHasMask)) {
+            ok = padTo(e.mask.offset) && writeBytes(entries_[i].mask.data(), entries_[i].mask.size());
+        }
+    }
+    ok = ok && padTo(header.fileSize);
+
+    if (std::fclose(file) != 0) ok = false;
+    if (!ok) {
+        std::remove(path.c_str());
+        SetError(error, "write failed");
+    }
+    return ok;
+}
@@ -0,0 +1,125 @@
+#ifndef TEMPLATE_PACK_H
+#define TEMPLATE_PACK_H
+
+#include "image_view.h"
+#include "window_stats.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// 模板包 (.pack) 文件格式
+//
+// 离线打包工具 (tools/template_packer.cpp) 把一组模板图片解码为 BGR 像素平面，
+// 连同预计算的统计量、金字塔层与掩码写入单个文件。运行时只需内存映射该文件、
+// 校验头部后直接在映射内存上构造模板，不再逐个 imread / 解码 PNG。
+//
+// 布局 (小端序):
+//     PackHeader
+//     PackEntry[entryCount]
+//     数据区: 像素平面 / 金字塔层 / 掩码，每块起始偏移按 64 字节对齐，行跨度也按 64 字节对齐
+//
+// 所有偏移均相对文件开头；读取时逐项校验不越界，损坏的文件整体拒绝加载。
+
+static const char kPackMagic[8] = {'I', 'M', 'G', 'P', 'A', 'C', 'K', 0};
+static const uint32_t kPackVersion = 1;
+static const int kPackNameSize = 64;      // 名称 (含结尾 0) 的最大字节数
+static const int kPackMaxLevels = 4;      // 金字塔层数上限 (含原图)
+static const uint32_t kPackAlignment = 64;
+
+// 掩码标志 (PackEntry::flags)
+static const uint32_t kPackEntryHasMask = 1u << 0;
+
+struct PackHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t headerSize;  // sizeof(PackHeader)，用于向后兼容扩展
+    uint32_t entryCount;
+    uint32_t entrySize;   // sizeof(PackEntry)
+    uint64_t entriesOffset;
+    uint64_t fileSize;
+};
+
+// 一层像素平面 (BGR，8 位)
+struct PackPlane {
+    int32_t width;
+    int32_t height;
+    uint32_t stride;
+    uint32_t reserved;
+    uint64_t offset;
+};
+
+struct PackEntry {
+    char name[kPackNameSize];  // 以 0 结尾，通常是原始文件名 (如 "juqing.png")
+    int32_t channels;          // 目前固定为 3 (BGR)
+    uint32_t flags;
+    int32_t levelCount;        // 有效的 levels 数量，levels[0] 为原图
+    uint32_t reserved;
+    PackPlane levels[kPackMaxLevels]; // 每层为上一层 2x2 平均降采样
+    PackPlane mask;            // 单通道掩码 (源图 alpha > 0 处为 255)，仅 kPackEntryHasMask 时有效
+    // levels[0] 的统计量，与 ComputeTemplateSums 的结果相同
+    int64_t area;
+    int64_t sum[4];
+    int64_t sumSq;
+};
+
+// 只读的内存映射模板包
+class TemplatePack {
+public:
+    TemplatePack() = default;
+    ~TemplatePack();
+
+    TemplatePack(const TemplatePack&) = delete;
+    TemplatePack& operator=(const TemplatePack&) = delete;
+
+    // 映射并校验文件，失败返回 false (error 可为空，写入原因)
+    bool Open(const std::string& path, std::string* error = nullptr);
+    void Close();
+
+    int Count() const { return header_ ? static_cast<int>(header_->entryCount) : 0; }
+    const PackEntry& Entry(int index) const { return entries_[index]; }
+
+    // 第 level 层像素 / 掩码的视图 (直接指向映射内存)
+    ImageView Level(int index, int level) const;
+    ImageView Mask(int index) const;
+
+    // levels[0] 的统计量
+    TemplateSums Sums(int index) const;
+
+private:
+    bool Validate(std::string* error) const;
+
+    const uint8_t* data_ = nullptr;
+    uint64_t size_ = 0;
+    const PackHeader* header_ = nullptr;
+    const PackEntry* entries_ = nullptr;
+#ifdef _WIN32
+    void* file_ = nullptr;
+    void* mapping_ = nullptr;
+#endif
+};
+
+// 模板包写入器 (离线打包工具使用)
+class TemplatePackWriter {
+public:
+    // 添加一个模板
+    // levels: levelCount 个 BGR 平面，levels[0] 为原图，之后每层为上一层的降采样
+    // mask: 单通道掩码，可为空
+    // 返回 false 表示参数无效 (名称过长、通道数不是 3、层数超限等)
+    bool Add(const std::string& name, const ImageView* levels, int levelCount, const ImageView* mask);
+
+    bool Write(const std::string& path, std::string* error = nullptr) const;
+
+    int Count() const { return static_cast<int>(entries_.size()); }
+
+private:
+    struct Pending {
+        PackEntry entry;
+        std::vector<std::vector<uint8_t>> levels; // 已按对齐跨度重排的像素
+        std::vector<uint8_t> mask;
+    };
+
+    std::vector<Pending> entries_;
+};
+
+#endif // TEMPLATE_PACK_H
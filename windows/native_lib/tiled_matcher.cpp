@@ -0,0 +1,256 @@
+#include "tiled_matcher.h"
+#include "mat_view.h"
+#include "trace.h"
+#include "work_stealing_pool.h"
+
+#include <opencv2/imgproc.hpp>
+
+#include <algorithm>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+// 块数少于该值时不分块 (并行收益抵不过重叠与调度开销)
+static const int kMinTiles = 4;
+// 块边长下限 (结果图像素)，并且不小于模板边长的 kMinTileTemplateRatio 倍
+static const int kMinTileSide = 64;
+static const int kMinTileTemplateRatio = 2;
+// 需要重算的位置多于该值时先用积分图跳过纯色窗口
+static const long long kFlatCheckCandidates = 1024;
+// 积分图以 double 保存整数和，模板面积不超过该值时窗口方差的整数运算在 2^53 内精确
+static const long long kFlatCheckMaxArea = 512 * 512;
+
+// 每个核心的 L2 缓存大小，无法获取时按 1 MB 估计
+static size_t L2CacheBytes() {
+    static const size_t bytes = [] {
+        size_t result = 0;
+#ifdef _WIN32
+        DWORD length = 0;
+        GetLogicalProcessorInformation(nullptr, &length);
+        std::vector<SYSTEM_LOGICAL_PROCESSOR_INFORMATION> info(length / sizeof(SYSTEM_LOGICAL_PROCESSOR_INFORMATION));
+        if (!info.empty() && GetLogicalProcessorInformation(info.data(), &length)) {
+            for (const SYSTEM_LOGICAL_PROCESSOR_INFORMATION& item : info) {
+                if (item.Relationship == RelationCache && item.Cache.Level == 2) {
+                    result = item.Cache.Size;
+                    break;
+                }
+            }
+        }
+#elif defined(_SC_LEVEL2_CACHE_SIZE)
+        const long size = sysconf(_SC_LEVEL2_CACHE_SIZE);
+        if (size > 0) result = static_cast<size_t>(size);
+#endif
+        return result > 0 ? result : static_cast<size_t>(1) << 20;
+    }();
+    return bytes;
+}
+
+// 块的输入 (BGR) 与结果图 (float) 合计放得进 L2 一半的最大边长
+static int CacheTileSide(const cv::Mat& templ) {
+    const size_t budget = L2CacheBytes() / 2;
+    auto bytes = [&](int side) {
+        const size_t inputPixels = static_cast<size_t>(side + templ.cols - 1) * (side + templ.rows - 1);
+        return inputPixels * templ.channels() + static_cast<size_t>(side) * side * sizeof(float);
+    };
+    int side = kMinTileSide;
+    while (bytes(side + 16) <= budget) {
+        side += 16;
+    }
+    return std::max(side, kMinTileTemplateRatio * std::max(templ.cols, templ.rows));
+}
+
+bool TiledMatcher::Plan(int width, int height, const cv::Mat& templ, int tileSide) {
+    tiles_.clear();
+    templWidth_ = templ.cols;
+    templHeight_ = templ.rows;
+    const int cols = width - templ.cols + 1;
+    const int rows = height - templ.rows + 1;
+    positions_ = cols > 0 && rows > 0 ? static_cast<long long>(cols) * rows : 0;
+    if (positions_ == 0) return false;
+
+    // 超出整数 NCC 范围的模板 (SlidingWindowStats::Fits) 无法精确重算，只分一块并直接取 DFT 结果
+    exact_ = SlidingWindowStats::Fits(templ.cols, templ.rows, templ.channels(), true);
+    int tilesX = 1;
+    int tilesY = 1;
+    if (!exact_) {
+        // 保持一块
+    } else if (tileSide > 0) {
+        tilesX = (cols + tileSide - 1) / tileSide;
+        tilesY = (rows + tileSide - 1) / tileSide;
+    } else if (HardwareThreads() >= 2) {
+        // 单核机器上分块只有开销；块数太少时只分一块
+        tileSide = CacheTileSide(templ);
+        tilesX = (cols + tileSide - 1) / tileSide;
+        tilesY = (rows + tileSide - 1) / tileSide;
+        if (tilesX * tilesY < kMinTiles) {
+            tilesX = 1;
+            tilesY = 1;
+        }
+    }
+    // 均分结果图，避免边缘出现很窄的块
+
+    tiles_.resize(static_cast<size_t>(tilesX) * tilesY);
+    for (int ty = 0; ty < tilesY; ty++) {
+        const int y0 = rows * ty / tilesY;
+        const int y1 = rows * (ty + 1) / tilesY;
+        for (int tx = 0; tx < tilesX; tx++) {
+            const int x0 = cols * tx / tilesX;
+            const int x1 = cols * (tx + 1) / tilesX;
+            Tile& tile = tiles_[static_cast<size_t>(ty) * tilesX + tx];
+            tile.output = cv::Rect(x0, y0, x1 - x0, y1 - y0);
+            tile.result.create(tile.output.height, tile.output.width, CV_32FC1);
+        }
+    }
+    return true;
+}
+
+// 窗口 (x, y, w, h) 的各通道是否都是纯色 (方差为 0)
+// 此时 NccScoreAt 的分子与窗口方差都恰为 0，分数为 0 (模板本身不是纯色时)
+static bool FlatWindow(const cv::Mat& sums, const cv::Mat& squares, int x, int y, int w, int h) {
+    const int ch = sums.channels();
+    const double area = static_cast<double>(w) * h;
+    const double* s0 = sums.ptr<double>(y);
+    const double* s1 = sums.ptr<double>(y + h);
+    const double* q0 = squares.ptr<double>(y);
+    const double* q1 = squares.ptr<double>(y + h);
+    for (int c = 0; c < ch; c++) {
+        const int left = x * ch + c;
+        const int right = (x + w) * ch + c;
+        const double sum = s1[right] - s1[left] - s0[right] + s0[left];
+        const double square = q1[right] - q1[left] - q0[right] + q0[left];
+        if (area * square != sum * sum) return false;
+    }
+    return true;
+}
+
+double TiledMatcher::Run(const cv::Mat& image, const TemplateEntry& entry, cv::Point* loc) {
+    const cv::Mat& templ = entry.image;
+    refined_ = 0;
+
+    // 1. 各块 DFT 相关，记录块内最大值与其附近的位置数
+    SharedWorkers().ParallelFor(TileCount(), [&](int index) {
+        TRACE_SCOPE("match_tile");
+        Tile& tile = tiles_[index];
+        const cv::Rect input(tile.output.x, tile.output.y, tile.output.width + templWidth_ - 1,
+                             tile.output.height + templHeight_ - 1);
+        cv::matchTemplate(image(input), templ, tile.result, cv::TM_CCOEFF_NORMED);
+
+        double minVal, maxVal;
+        cv::minMaxLoc(tile.result, &minVal, &maxVal);
+        tile.max = maxVal;
+        const float cutoff = static_cast<float>(maxVal - kRefineMargin);
+        tile.near = 0;
+        for (int y = 0; y < tile.result.rows; y++) {
+            const float* row = tile.result.ptr<float>(y);
+            for (int x = 0; x < tile.result.cols; x++) {
+                tile.near += row[x] >= cutoff;
+            }
+        }
+    });
+
+    double globalMax = -1.0;
+    long long near = 0;
+    for (const Tile& tile : tiles_) {
+        globalMax = std::max(globalMax, tile.max);
+        near += tile.near;
+    }
+    capped_ = false;
+    if (!exact_) {
+        return RunUntiled(image, templ, loc);
+    }
+    const NccTemplate& ncc = entry.Ncc();
+    const long long area = static_cast<long long>(templWidth_) * templHeight_;
+    const bool flatCheck = near > kFlatCheckCandidates && ncc.varianceScaled > 0 && area <= kFlatCheckMaxArea;
+    if (flatCheck) {
+        TRACE_SCOPE("flat_integral");
+        cv::integral(image, sums_, squares_, CV_64F, CV_64F);
+    }
+    const float cutoff = static_cast<float>(globalMax - kRefineMargin);
+    auto flat = [&](int px, int py) {
+        return flatCheck && FlatWindow(sums_, squares_, px, py, templWidth_, templHeight_);
+    };
+
+    // 2. 重算代价有上限: 各块的 near 之和是重算数的上界，超出预算时再按全局阈值精确计数 (纯色窗口不计)；
+    //    仍超出时 (如线性渐变上几乎所有位置的分数都相同) 改为不分块的 DFT 结果，按 minMaxLoc 取值
+    if (near * area > kMaxRefinePixels) {
+        SharedWorkers().ParallelFor(TileCount(), [&](int index) {
+            Tile& tile = tiles_[index];
+            tile.candidates = 0;
+            if (tile.max < cutoff) return;
+            for (int y = 0; y < tile.result.rows; y++) {
+                const float* row = tile.result.ptr<float>(y);
+                for (int x = 0; x < tile.result.cols; x++) {
+                    tile.candidates += row[x] >= cutoff && !flat(tile.output.x + x, tile.output.y + y);
+                }
+            }
+        });
+        long long candidates = 0;
+        for (const Tile& tile : tiles_) candidates += tile.candidates;
+        if (candidates * area > kMaxRefinePixels) {
+            capped_ = true;
+            return RunUntiled(image, templ, loc);
+        }
+    }
+
+    // 3. 各块重新扫描结果图，精确重算与全局最大值相差不超过 margin 的全部位置
+    const ImageView view = ToImageView(image);
+    SharedWorkers().ParallelFor(TileCount(), [&](int index) {
+        TRACE_SCOPE("refine_tile");
+        Tile& tile = tiles_[index];
+        tile.best = -2.0;
+        tile.bestLoc = cv::Point(-1, -1);
+        tile.refined = 0;
+        if (tile.max < cutoff) return;
+        for (int y = 0; y < tile.result.rows; y++) {
+            const float* row = tile.result.ptr<float>(y);
+            for (int x = 0; x < tile.result.cols; x++) {
+                if (row[x] < cutoff) continue;
+                const int px = tile.output.x + x;
+                const int py = tile.output.y + y;
+                const double score = flat(px, py) ? 0.0 : NccScoreAt(view, entry.sums, ncc, px, py);
+                tile.refined++;
+                // 块内按行优先扫描，严格大于即保留第一个最大值
+                if (score > tile.best) {
+                    tile.best = score;
+                    tile.bestLoc = cv::Point(px, py);
+                }
+            }
+        }
+    });
+
+    // 4. 归约: 分数最高 -> y 最小 -> x 最小，与块的顺序无关
+    double best = -2.0;
+    cv::Point bestLoc(-1, -1);
+    for (const Tile& tile : tiles_) {
+        refined_ += tile.refined;
+        if (tile.bestLoc.x < 0) continue;
+        const cv::Point& p = tile.bestLoc;
+        if (tile.best > best || (tile.best == best && (p.y < bestLoc.y || (p.y == bestLoc.y && p.x < bestLoc.x)))) {
+            best = tile.best;
+            bestLoc = p;
+        }
+    }
+    *loc = bestLoc;
+    return best;
+}
+
+double TiledMatcher::RunUntiled(const cv::Mat& image, const cv::Mat& templ, cv::Point* loc) {
+    // 只分一块时块的结果图就是整幅结果图，无需再算
+    const cv::Mat* result = &tiles_[0].result;
+    if (tiles_.size() > 1) {
+        TRACE_SCOPE("match_untiled");
+        cv::matchTemplate(image, templ, untiled_, cv::TM_CCOEFF_NORMED);
+        result = &untiled_;
+    }
+    double minVal, maxVal;
+    cv::Point minLoc;
+    cv::minMaxLoc(*result, &minVal, &maxVal, &minLoc, loc);
+    return maxVal;
+}
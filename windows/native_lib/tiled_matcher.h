@@ -0,0 +1,86 @@
+#ifndef TILED_MATCHER_H
+#define TILED_MATCHER_H
+
+#include "template_entry.h"
+
+#include <opencv2/core.hpp>
+
+#include <vector>
+
+// 大 ROI 的分块并行匹配 (TM_CCOEFF_NORMED)
+//
+// 结果图划分为互不重叠的块，每块的输入区域向右下多取 模板尺寸 - 1 个像素 (相邻块的输入互相重叠)，
+// 每个候选位置恰好属于一个块。块在共用线程池 SharedWorkers() (work_stealing_pool.h) 上并行匹配，边长按 L2 缓存选取:
+// 块的输入 (BGR) 与结果图合计不超过 L2 的一半，但不小于模板边长的 2 倍，以限制重叠部分的重复计算。
+//
+// OpenCV 的 DFT 相关在不同块尺寸下舍入不同 (分数相差约 1e-4)，直接比较各块最大值会随分块方式变化。
+// 因此 DFT 分数只用于筛选: 求出全局最大值后，各块重新扫描自己的结果图，把与全局最大值相差不超过
+// kRefineMargin 的全部位置用整数 NCC (NccScoreAt) 精确重算，按 分数最高 -> y 最小 -> x 最小 选出结果
+// (与 minMaxLoc 的并列规则一致)。margin 大于两倍的 DFT 误差，精确分数并列最高的位置必定都在重算之列，
+// 结果因此与块大小、块数和线程数无关；纯色或重复纹理上大量近似并列的位置也不例外。
+// 重算的位置很多时 (大片纯色)，先用积分图判断窗口是否纯色: 纯色窗口的精确分数恒为 0，无需点积。
+//
+// 不值得分块时 (ROI 小、单核机器) 只分一块，走同样的筛选与重算，因此 TM_CCOEFF_NORMED 的分数与位置
+// 不随 ROI 是否越过分块门槛而变化；引擎的全部 OpenCV 路径都经由本类匹配。
+// 重算代价 (非纯色候选数 x 模板面积) 超过 kMaxRefinePixels 时 (如线性渐变上几乎全部位置分数相同)
+// 不再重算，改为不分块的 DFT 结果按 minMaxLoc 取值 (只分一块时直接使用该块的结果图)，
+// 与不分块时的结果同样相同；只有候选数恰在上限附近、不同分块的 DFT 舍入使判断不同时才可能例外。
+// 超出整数 NCC 范围 (SlidingWindowStats::Fits) 的巨大模板不分块、不重算，直接按 minMaxLoc 取 DFT 结果。
+class TiledMatcher {
+public:
+    // DFT 分数与精确分数的误差远小于该值；与最大值相差在此范围内的位置都要精确重算
+    static constexpr double kRefineMargin = 1e-3;
+    // 精确重算的像素次数上限 (约数十毫秒)
+    static constexpr long long kMaxRefinePixels = 1LL << 26;
+
+    // 按 ROI 尺寸与模板划分块并预分配结果图
+    // tileSide > 0 时使用指定的块边长 (基准测试与校验用)，否则按 L2 缓存选取，不值得分块时只分一块
+    // 返回 false 表示 ROI 小于模板，此时 TileCount() 为 0
+    bool Plan(int width, int height, const cv::Mat& templ, int tileSide = 0);
+
+    // 在 image (BGR，尺寸与 Plan 一致) 上匹配 entry，返回最高分，loc 为相对 image 的位置
+    // 可在多个线程上对不同的 TiledMatcher 同时调用
+    double Run(const cv::Mat& image, const TemplateEntry& entry, cv::Point* loc);
+
+    int TileCount() const { return static_cast<int>(tiles_.size()); }
+
+    // 是否分成了多块并行
+    bool Tiled() const { return tiles_.size() > 1; }
+
+    // 候选位置总数 (结果图面积)
+    long long Positions() const { return positions_; }
+
+    // 最近一次 Run 中精确重算的候选数
+    int Refined() const { return refined_; }
+
+    // 最近一次 Run 是否因重算代价超限而直接取不分块的 DFT 结果
+    bool Capped() const { return capped_; }
+
+private:
+    struct Tile {
+        cv::Rect output;  // 结果图坐标；输入区域为其向右下扩展 模板尺寸 - 1
+        cv::Mat result;   // DFT 分数
+        double max = 0;
+        long long near = 0; // 与块内最大值相差不超过 margin 的位置数 (全局重算数的上界)
+        long long candidates = 0; // 按全局阈值计的非纯色候选数 (只在 near 之和超出预算时计算)
+        // 精确重算后块内的最佳位置 (结果图坐标)
+        double best = 0;
+        cv::Point bestLoc;
+        int refined = 0;
+    };
+
+    double RunUntiled(const cv::Mat& image, const cv::Mat& templ, cv::Point* loc);
+
+    std::vector<Tile> tiles_;
+    cv::Mat untiled_; // 重算超限时不分块的结果图
+    cv::Mat sums_;    // 纯色判断用的积分图 (只在重算位置很多时计算)
+    cv::Mat squares_;
+    int templWidth_ = 0;
+    int templHeight_ = 0;
+    long long positions_ = 0;
+    int refined_ = 0;
+    bool capped_ = false;
+    bool exact_ = true; // 模板可用 NccScoreAt 精确重算
+};
+
+#endif // TILED_MATCHER_H
@@ -0,0 +1,414 @@
+// 精度 / 速度回归评估工具
+// 在标注帧集 (格式见 ground_truth.h) 上逐帧运行若干引擎模式，并列给出每种模式的
+// 精确率 / 召回率、定位误差与每个请求的耗时，使每项提速都带着实测的精度代价。
+// 用法: accuracy_harness [-m 模式 [-m ...]] [-t 像素] [-o text|json] [-v] [-b 基线.json [-e 容差]] 标注.json
+//   -m: 引擎模式，可重复，默认 ccoeff、ssd、ncc、auto。形如 算法[:gray][:x缩放]，例如 ncc:gray:x0.5
+//       gray: 帧与模板转为单通道灰度后匹配；x0.5: 帧与模板按比例缩小后匹配，位置换算回原图坐标
+//       (灰度转换与缩放计入每帧耗时 prep，各请求的匹配耗时取自 SearchResultEx)
+//   -t: 定位容差 (中心距离，像素)，默认为标注实例短边的一半
+//   -o: text 为对齐的表格 (默认)，json 供保存为基线或做进一步分析
+//   -v: 另外列出每个模板在各模式下的结果
+//   -b: 与之前 -o json 保存的基线对比，同名模式的精确率或召回率下降超过容差 (-e，默认 0.01) 时返回 3
+// 每帧每个模板只返回一个最佳位置，因此按 (帧, 模板) 计数:
+//   命中且位于某个标注实例的容差内为 TP；命中但不在任何实例附近为 FP (该帧有实例时同时计一次 FN)；
+//   有实例而未命中为 FN。定位误差只统计 TP。
+// 返回值: 0 成功, 1 标注或图片无法读取, 2 参数无效, 3 相对基线退化
+#include "ground_truth.h"
+#include "json_value.h"
+#include "scenario.h"
+#include "search_plan.h"
+#include "search_stats.h"
+#include "template_entry.h"
+
+#include <opencv2/opencv.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// 引擎模式
+struct Mode {
+    std::string name;
+    int method = SEARCH_METHOD_CCOEFF_NORMED;
+    bool gray = false;
+    double scale = 1.0;
+};
+
+// 解析 "算法[:gray][:x缩放]"
+static bool ParseMode(const std::string& spec, Mode* out) {
+    Mode mode;
+    mode.name = spec;
+    std::stringstream parts(spec);
+    std::string part;
+    bool first = true;
+    while (std::getline(parts, part, ':')) {
+        if (first) {
+            if (!ParseSearchMethod(part, &mode.method)) return false;
+            first = false;
+        } else if (part == "gray") {
+            mode.gray = true;
+        } else if (part.size() > 1 && part[0] == 'x') {
+            char* end = nullptr;
+            mode.scale = std::strtod(part.c_str() + 1, &end);
+            if (*end != 0 || mode.scale <= 0 || mode.scale > 1) return false;
+        } else {
+            return false;
+        }
+    }
+    if (first) return false;
+    *out = mode;
+    return true;
+}
+
+struct Counts {
+    long long tp = 0;
+    long long fp = 0;
+    long long fn = 0;
+    std::vector<double> errors;   // TP 的定位误差 (像素)
+    std::vector<long long> times; // 每个请求的匹配耗时
+
+    double Precision() const { return tp + fp > 0 ? static_cast<double>(tp) / (tp + fp) : 1.0; }
+    double Recall() const { return tp + fn > 0 ? static_cast<double>(tp) / (tp + fn) : 1.0; }
+};
+
+// 一种模式的模板、计划与统计
+struct ModeRun {
+    Mode mode;
+    std::vector<std::shared_ptr<const TemplateEntry>> entries;
+    std::vector<SearchRequest> requests;
+    std::unique_ptr<SearchPlan> plan;
+    cv::Mat gray;
+    cv::Mat scaled;
+    std::vector<SearchResultEx> results;
+    Counts total;
+    std::vector<Counts> perTemplate;
+    long long frames = 0;
+    long long prepNs = 0;   // 灰度转换与缩放
+    long long frameNs = 0;  // prep + 计划执行
+};
+
+static double Mean(const std::vector<double>& values) {
+    double sum = 0;
+    for (const double v : values) sum += v;
+    return values.empty() ? 0 : sum / values.size();
+}
+
+static int Scaled(int value, double scale) {
+    return std::max(1, static_cast<int>(std::lround(value * scale)));
+}
+
+// 按模式准备模板 (灰度 / 缩小)
+static cv::Mat PrepareTemplate(const cv::Mat& bgr, const Mode& mode) {
+    cv::Mat out = bgr;
+    if (mode.gray) cv::cvtColor(out, out, cv::COLOR_BGR2GRAY);
+    if (mode.scale < 1) {
+        cv::resize(out, out, cv::Size(Scaled(out.cols, mode.scale), Scaled(out.rows, mode.scale)), 0, 0,
+                   cv::INTER_AREA);
+    }
+    return out;
+}
+
+// 在一帧上执行一种模式并按标注计数
+static void RunFrame(ModeRun& run, const cv::Mat& bgra, const GroundTruthFrame& frame,
+                     const std::vector<cv::Mat>& templates, double tolerance) {
+    const Mode& mode = run.mode;
+    const long long start = StatsNowNs();
+    const cv::Mat* source = &bgra;
+    if (mode.gray) {
+        cv::cvtColor(*source, run.gray, cv::COLOR_BGRA2GRAY);
+        source = &run.gray;
+    }
+    if (mode.scale < 1) {
+        cv::resize(*source, run.scaled, cv::Size(Scaled(source->cols, mode.scale), Scaled(source->rows, mode.scale)),
+                   0, 0, cv::INTER_AREA);
+        source = &run.scaled;
+    }
+    const long long prepNs = StatsNowNs() - start;
+
+    const int count = static_cast<int>(run.requests.size());
+    if (!run.plan || run.plan->FrameWidth() != source->cols || run.plan->FrameHeight() != source->rows) {
+        run.plan = std::make_unique<SearchPlan>();
+        run.plan->Compile(run.requests.data(), run.entries.data(), count, source->cols, source->rows,
+                          source->channels());
+    }
+    run.results.resize(count);
+    const long long runStart = StatsNowNs();
+    run.plan->Run(*source, nullptr, nullptr, run.results.data());
+    run.prepNs += prepNs;
+    run.frameNs += prepNs + (StatsNowNs() - runStart);
+    run.frames++;
+
+    for (int i = 0; i < count; i++) {
+        const SearchResultEx& r = run.results[i];
+        Counts& counts = run.perTemplate[i];
+        counts.times.push_back(r.timeNs);
+        run.total.times.push_back(r.timeNs);
+
+        const int tw = templates[i].cols;
+        const int th = templates[i].rows;
+        bool present = false;
+        double best = -1;
+        if (r.x >= 0) {
+            // 换算回原图坐标，比较中心点
+            const double cx = r.x / mode.scale + tw / 2.0;
+            const double cy = r.y / mode.scale + th / 2.0;
+            for (const GroundTruthObject& object : frame.objects) {
+                if (object.templateIndex != i) continue;
+                present = true;
+                const int ow = object.width > 0 ? object.width : tw;
+                const int oh = object.height > 0 ? object.height : th;
+                const double distance = std::hypot(cx - (object.x + ow / 2.0), cy - (object.y + oh / 2.0));
+                const double limit = tolerance > 0 ? tolerance : std::min(ow, oh) / 2.0;
+                if (distance <= limit && (best < 0 || distance < best)) best = distance;
+            }
+        } else {
+            for (const GroundTruthObject& object : frame.objects) {
+                if (object.templateIndex == i) present = true;
+            }
+        }
+
+        Counts* targets[2] = {&counts, &run.total};
+        for (Counts* c : targets) {
+            if (best >= 0) {
+                c->tp++;
+                c->errors.push_back(best);
+            } else {
+                if (r.x >= 0) c->fp++;
+                if (present) c->fn++;
+            }
+        }
+    }
+}
+
+struct Summary {
+    double precision, recall;
+    long long tp, fp, fn;
+    double locMean, locP95, locMax;
+    double requestP50Us, requestP99Us;
+    double frameMs, prepMs;
+};
+
+static Summary Summarize(Counts counts, long long frames, long long frameNs, long long prepNs) {
+    std::sort(counts.errors.begin(), counts.errors.end());
+    std::sort(counts.times.begin(), counts.times.end());
+    Summary s;
+    s.precision = counts.Precision();
+    s.recall = counts.Recall();
+    s.tp = counts.tp;
+    s.fp = counts.fp;
+    s.fn = counts.fn;
+    s.locMean = Mean(counts.errors);
+    s.locP95 = SortedPercentile(counts.errors, 0.95);
+    s.locMax = counts.errors.empty() ? 0 : counts.errors.back();
+    s.requestP50Us = SortedPercentile(counts.times, 0.50) / 1e3;
+    s.requestP99Us = SortedPercentile(counts.times, 0.99) / 1e3;
+    s.frameMs = frames > 0 ? frameNs / 1e6 / frames : 0;
+    s.prepMs = frames > 0 ? prepNs / 1e6 / frames : 0;
+    return s;
+}
+
+static void PrintJsonSummary(const Summary& s) {
+    std::printf("\"precision\": %.6f, \"recall\": %.6f, \"tp\": %lld, \"fp\": %lld, \"fn\": %lld, "
+                "\"locMean\": %.3f, \"locP95\": %.3f, \"locMax\": %.3f, \"requestP50Us\": %.1f, "
+                "\"requestP99Us\": %.1f, \"frameMs\": %.3f, \"prepMs\": %.3f",
+                s.precision, s.recall, s.tp, s.fp, s.fn, s.locMean, s.locP95, s.locMax, s.requestP50Us,
+                s.requestP99Us, s.frameMs, s.prepMs);
+}
+
+// 与基线对比，打印退化的模式；返回是否有退化
+static bool CompareBaseline(const std::string& path, const std::vector<ModeRun>& runs,
+                            const std::vector<Summary>& summaries, double tolerance, bool* failed) {
+    std::ifstream file(path, std::ios::binary);
+    std::ostringstream text;
+    text << file.rdbuf();
+    JsonValue root;
+    std::string error;
+    const JsonValue* modes = nullptr;
+    if (!file || !JsonValue::Parse(text.str(), &root, &error) || !(modes = root.Find("modes")) || !modes->IsArray()) {
+        std::fprintf(stderr, "%s: not a baseline (%s)\n", path.c_str(), error.c_str());
+        *failed = true;
+        return false;
+    }
+    bool regressed = false;
+    for (size_t i = 0; i < runs.size(); i++) {
+        for (const JsonValue& item : modes->Items()) {
+            const JsonValue* name = item.Find("mode");
+            const JsonValue* precision = item.Find("precision");
+            const JsonValue* recall = item.Find("recall");
+            if (!name || !name->IsString() || name->AsString() != runs[i].mode.name || !precision ||
+                !precision->IsNumber() || !recall || !recall->IsNumber()) {
+                continue;
+            }
+            const double dp = summaries[i].precision - precision->AsNumber();
+            const double dr = summaries[i].recall - recall->AsNumber();
+            if (dp < -tolerance || dr < -tolerance) {
+                std::fprintf(stderr, "regression %s: precision %.4f -> %.4f, recall %.4f -> %.4f\n",
+                             runs[i].mode.name.c_str(), precision->AsNumber(), summaries[i].precision,
+                             recall->AsNumber(), summaries[i].recall);
+                regressed = true;
+            }
+        }
+    }
+    return regressed;
+}
+
+int main(int argc, char** argv) {
+    std::vector<std::string> modeSpecs;
+    double tolerance = 0;
+    std::string format = "text";
+    std::string baselinePath;
+    double baselineTolerance = 0.01;
+    bool verbose = false;
+    bool valid = true;
+    int arg = 1;
+    for (; arg < argc && argv[arg][0] == '-'; arg++) {
+        if (std::strcmp(argv[arg], "-v") == 0) {
+            verbose = true;
+            continue;
+        }
+        if (arg + 1 >= argc) {
+            valid = false;
+            break;
+        }
+        const char* value = argv[++arg];
+        if (std::strcmp(argv[arg - 1], "-m") == 0) {
+            modeSpecs.push_back(value);
+        } else if (std::strcmp(argv[arg - 1], "-t") == 0) {
+            tolerance = std::atof(value);
+        } else if (std::strcmp(argv[arg - 1], "-o") == 0) {
+            format = value;
+        } else if (std::strcmp(argv[arg - 1], "-b") == 0) {
+            baselinePath = value;
+        } else if (std::strcmp(argv[arg - 1], "-e") == 0) {
+            baselineTolerance = std::atof(value);
+        } else {
+            valid = false;
+        }
+    }
+    if (modeSpecs.empty()) modeSpecs = {"ccoeff", "ssd", "ncc", "auto"};
+    std::vector<ModeRun> runs(modeSpecs.size());
+    for (size_t i = 0; i < modeSpecs.size(); i++) {
+        if (!ParseMode(modeSpecs[i], &runs[i].mode)) {
+            std::fprintf(stderr, "invalid mode: %s\n", modeSpecs[i].c_str());
+            valid = false;
+        }
+    }
+    if (!valid || arg + 1 != argc || (format != "text" && format != "json") || tolerance < 0) {
+        std::fprintf(stderr, "usage: accuracy_harness [-m method[:gray][:xScale] ...] [-t pixels] [-o text|json] [-v] "
+                             "[-b baseline.json [-e tolerance]] truth.json\n");
+        return 2;
+    }
+
+    GroundTruth truth;
+    std::string error;
+    if (!LoadGroundTruth(argv[arg], &truth, &error)) {
+        std::fprintf(stderr, "%s: %s\n", argv[arg], error.c_str());
+        return 1;
+    }
+
+    // 与 load_template 一致: 模板统一为 BGR
+    std::vector<cv::Mat> templates;
+    for (const GroundTruthTemplate& templ : truth.templates) {
+        templates.push_back(cv::imread(templ.path, cv::IMREAD_COLOR));
+        if (templates.back().empty()) {
+            std::fprintf(stderr, "cannot decode template %s\n", templ.path.c_str());
+            return 1;
+        }
+    }
+    for (ModeRun& run : runs) {
+        run.perTemplate.resize(truth.templates.size());
+        for (size_t i = 0; i < truth.templates.size(); i++) {
+            run.entries.push_back(MakeTemplateEntry(PrepareTemplate(templates[i], run.mode)));
+            SearchRequest request = truth.templates[i].request;
+            request.method = run.mode.method;
+            if (request.roiW > 0 && request.roiH > 0 && run.mode.scale < 1) {
+                const double s = run.mode.scale;
+                request.roiX = static_cast<int>(std::floor(request.roiX * s));
+                request.roiY = static_cast<int>(std::floor(request.roiY * s));
+                request.roiW = static_cast<int>(std::ceil(request.roiW * s));
+                request.roiH = static_cast<int>(std::ceil(request.roiH * s));
+            }
+            run.requests.push_back(request);
+        }
+    }
+
+    // 每帧只解码一次，依次交给各模式
+    cv::Mat bgra;
+    long long evaluated = 0;
+    for (const GroundTruthFrame& frame : truth.frames) {
+        const cv::Mat bgr = cv::imread(frame.image, cv::IMREAD_COLOR);
+        if (bgr.empty()) {
+            std::fprintf(stderr, "cannot decode frame %s\n", frame.image.c_str());
+            return 1;
+        }
+        // 实时路径提交的是 WGC 的 BGRA 帧，评估保持同样的通道布局
+        cv::cvtColor(bgr, bgra, cv::COLOR_BGR2BGRA);
+        for (ModeRun& run : runs) {
+            RunFrame(run, bgra, frame, templates, tolerance);
+        }
+        evaluated++;
+    }
+
+    std::vector<Summary> summaries;
+    for (const ModeRun& run : runs) {
+        summaries.push_back(Summarize(run.total, run.frames, run.frameNs, run.prepNs));
+    }
+
+    if (format == "json") {
+        std::printf("{\n  \"truth\": %s,\n  \"frames\": %lld,\n  \"modes\": [\n", JsonQuote(argv[arg]).c_str(),
+                    evaluated);
+        for (size_t m = 0; m < runs.size(); m++) {
+            std::printf("    { \"mode\": %s, ", JsonQuote(runs[m].mode.name).c_str());
+            PrintJsonSummary(summaries[m]);
+            std::printf(",\n      \"templates\": [\n");
+            for (size_t i = 0; i < truth.templates.size(); i++) {
+                std::printf("        { \"name\": %s, ", JsonQuote(truth.templates[i].name).c_str());
+                PrintJsonSummary(Summarize(runs[m].perTemplate[i], runs[m].frames, runs[m].frameNs, runs[m].prepNs));
+                std::printf(" }%s\n", i + 1 < truth.templates.size() ? "," : "");
+            }
+            std::printf("      ] }%s\n", m + 1 < runs.size() ? "," : "");
+        }
+        std::printf("  ]\n}\n");
+    } else {
+        // 第一个模式为对照: recall 差值与提速倍数都相对它
+        std::printf("%lld frames, %zu templates\n", evaluated, truth.templates.size());
+        std::printf("%-20s %9s %9s %8s %6s %6s %6s %8s %8s %8s %9s %9s %9s %8s\n", "mode", "precision", "recall",
+                    "d_recall", "TP", "FP", "FN", "loc_mean", "loc_p95", "loc_max", "req_p50us", "req_p99us",
+                    "frame_ms", "speedup");
+        for (size_t m = 0; m < runs.size(); m++) {
+            const Summary& s = summaries[m];
+            std::printf("%-20s %9.4f %9.4f %+8.4f %6lld %6lld %6lld %8.2f %8.2f %8.2f %9.1f %9.1f %9.3f %7.2fx\n",
+                        runs[m].mode.name.c_str(), s.precision, s.recall, s.recall - summaries[0].recall, s.tp, s.fp,
+                        s.fn, s.locMean, s.locP95, s.locMax, s.requestP50Us, s.requestP99Us, s.frameMs,
+                        s.frameMs > 0 ? summaries[0].frameMs / s.frameMs : 0.0);
+        }
+        if (verbose) {
+            for (size_t i = 0; i < truth.templates.size(); i++) {
+                std::printf("\n%s (%dx%d)\n", truth.templates[i].name.c_str(), templates[i].cols, templates[i].rows);
+                for (size_t m = 0; m < runs.size(); m++) {
+                    const Summary s =
+                        Summarize(runs[m].perTemplate[i], runs[m].frames, runs[m].frameNs, runs[m].prepNs);
+                    std::printf("  %-18s precision=%.4f recall=%.4f TP=%lld FP=%lld FN=%lld loc_mean=%.2f "
+                                "loc_max=%.2f req_p50=%.1fus req_p99=%.1fus\n",
+                                runs[m].mode.name.c_str(), s.precision, s.recall, s.tp, s.fp, s.fn, s.locMean,
+                                s.locMax, s.requestP50Us, s.requestP99Us);
+                }
+            }
+        }
+    }
+
+    if (!baselinePath.empty()) {
+        bool failed = false;
+        const bool regressed = CompareBaseline(baselinePath, runs, summaries, baselineTolerance, &failed);
+        if (failed) return 1;
+        if (regressed) return 3;
+    }
+    return 0;
+}
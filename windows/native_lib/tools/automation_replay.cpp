@@ -0,0 +1,186 @@
+// 自动化规则回放工具
+// 把录制的帧按顺序喂给 Automation::Evaluate，打印产生的事件与反应延迟，
+// 用于在 Linux 上离线调试规则 (阈值、ROI、repeatMs) 而不需要游戏窗口
+// 用法: automation_replay [-f 帧率] [-g 最小间隔,最大间隔,画面变化,CPU预算] (-s 场景.json | -r 模板,x,y,w,h,阈值[,repeatMs] [-r ...]) 帧文件...
+//   -f: 按给定帧率间隔回放 (repeatMs 依赖真实时间)，默认 0 表示尽快回放
+//   -g: 开启自适应调度 (覆盖场景中的 governor 段)，与 -f 一起使用才能反映真实的采样间隔
+//   -s: 场景文件 (格式见 scenario.h)，调整场景后可直接对比匹配与跳过的规则数
+//   -r: 一条独立规则，ROI 为 0,0,0,0 时搜索整帧；可重复
+// 帧文件为 .frec (recorder_start 的录制) 时按顺序回放其中的每一帧
+#include "automation.h"
+#include "frame_recorder.h"
+#include "scenario.h"
+#include "search_stats.h"
+#include "template_entry.h"
+
+#include <opencv2/opencv.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+static const char* KindName(int kind) {
+    switch (kind) {
+    case AUTOMATION_EVENT_FOUND: return "FOUND";
+    case AUTOMATION_EVENT_REPEAT: return "REPEAT";
+    default: return "LOST";
+    }
+}
+
+// 解析 "模板,x,y,w,h,阈值[,repeatMs]"
+static bool ParseRule(const char* spec, std::string* path, AutomationRule* rule) {
+    const char* comma = std::strchr(spec, ',');
+    if (!comma) return false;
+    path->assign(spec, comma - spec);
+    *rule = AutomationRule();
+    rule->request.method = SEARCH_METHOD_CCOEFF_NORMED;
+    const int n = std::sscanf(comma + 1, "%d,%d,%d,%d,%lf,%d", &rule->request.roiX, &rule->request.roiY,
+                              &rule->request.roiW, &rule->request.roiH, &rule->request.threshold,
+                              &rule->repeatMs);
+    return n >= 5;
+}
+
+int main(int argc, char** argv) {
+    double fps = 0;
+    std::string scenarioPath;
+    std::vector<std::string> templatePaths;
+    std::vector<AutomationRule> rules;
+    AutomationGovernorConfig governor = {};
+    bool hasGovernor = false;
+    int arg = 1;
+    for (; arg + 1 < argc; arg += 2) {
+        if (std::strcmp(argv[arg], "-f") == 0) {
+            fps = std::atof(argv[arg + 1]);
+        } else if (std::strcmp(argv[arg], "-g") == 0) {
+            governor.enabled = 1;
+            if (std::sscanf(argv[arg + 1], "%d,%d,%lf,%lf", &governor.minIntervalMs, &governor.maxIntervalMs,
+                            &governor.sceneChangeThreshold, &governor.cpuBudget) != 4) {
+                std::fprintf(stderr, "invalid governor: %s\n", argv[arg + 1]);
+                return 2;
+            }
+            hasGovernor = true;
+        } else if (std::strcmp(argv[arg], "-s") == 0) {
+            scenarioPath = argv[arg + 1];
+        } else if (std::strcmp(argv[arg], "-r") == 0) {
+            std::string path;
+            AutomationRule rule;
+            if (!ParseRule(argv[arg + 1], &path, &rule)) {
+                std::fprintf(stderr, "invalid rule: %s\n", argv[arg + 1]);
+                return 2;
+            }
+            templatePaths.push_back(path);
+            rules.push_back(rule);
+        } else {
+            break;
+        }
+    }
+    if (rules.empty() == scenarioPath.empty() || arg >= argc ||
+        static_cast<int>(rules.size()) > Automation::kMaxRules) {
+        std::fprintf(stderr, "usage: automation_replay [-f fps] [-g minMs,maxMs,sceneChange,cpuBudget] "
+                             "(-s scenario.json | "
+                             "-r templ,x,y,w,h,threshold[,repeatMs] [-r ...]) frame...\n");
+        return 2;
+    }
+
+    std::vector<std::shared_ptr<const TemplateEntry>> entries;
+    std::vector<std::string> ruleNames;
+    AutomationGraph graph;
+    if (!scenarioPath.empty()) {
+        Scenario scenario;
+        std::string error;
+        if (!LoadScenario(scenarioPath, &scenario, &error) || !LoadScenarioTemplates(scenario, &entries, &error)) {
+            std::fprintf(stderr, "%s: %s\n", scenarioPath.c_str(), error.c_str());
+            return 1;
+        }
+        for (const ScenarioRule& rule : scenario.rules) {
+            rules.push_back(rule.rule);
+            ruleNames.push_back(rule.name);
+        }
+        graph = ScenarioGraph(scenario);
+        if (scenario.hasGovernor && !hasGovernor) {
+            governor = scenario.governor;
+        }
+    } else {
+        // 与 load_template 一致: 模板统一为 BGR
+        for (size_t i = 0; i < templatePaths.size(); i++) {
+            const cv::Mat templ = cv::imread(templatePaths[i], cv::IMREAD_COLOR);
+            if (templ.empty()) {
+                std::fprintf(stderr, "cannot decode template %s\n", templatePaths[i].c_str());
+                return 1;
+            }
+            entries.push_back(MakeTemplateEntry(templ));
+            rules[i].request.templateId = static_cast<int>(i) + 1;
+        }
+        ruleNames = templatePaths;
+    }
+
+    Automation automation(rules.data(), entries.data(), static_cast<int>(rules.size()),
+                          std::make_shared<SearchStatsRegistry>(), [&](const AutomationEvent& event) {
+                              std::printf("frame %6lld  %-6s rule=%d (%s) at (%d,%d) score=%.3f latency=%.2fms\n",
+                                          event.frameId, KindName(event.kind), event.rule,
+                                          ruleNames[event.rule].c_str(), event.x, event.y, event.score,
+                                          event.latencyNs / 1e6);
+                          },
+                          graph);
+    automation.SetGovernor(governor);
+
+    const auto interval = std::chrono::duration<double>(fps > 0 ? 1.0 / fps : 0.0);
+    auto next = std::chrono::steady_clock::now();
+    cv::Mat frame;
+    auto evaluate = [&](const cv::Mat& raw) {
+        // 实时路径提交的是 WGC 的 BGRA 帧，回放保持同样的通道布局
+        cv::cvtColor(raw, frame, cv::COLOR_BGR2BGRA);
+        if (fps > 0) {
+            std::this_thread::sleep_until(next);
+            next += std::chrono::duration_cast<std::chrono::steady_clock::duration>(interval);
+        }
+        automation.Evaluate(frame, StatsNowNs());
+    };
+    for (; arg < argc; arg++) {
+        const std::string path = argv[arg];
+        if (path.size() > 5 && path.compare(path.size() - 5, 5, ".frec") == 0) {
+            FrameRecordReader reader;
+            std::string error;
+            if (!reader.Open(path, &error)) {
+                std::fprintf(stderr, "skip %s\n", error.c_str());
+                continue;
+            }
+            cv::Mat raw;
+            for (int i = 0; i < reader.FrameCount(); i++) {
+                if (!reader.Read(i, &raw)) {
+                    std::fprintf(stderr, "skip %s#%d: cannot decode\n", path.c_str(), i);
+                    break; // 之后的差分帧都依赖这一帧
+                }
+                evaluate(raw);
+            }
+            continue;
+        }
+        const cv::Mat raw = cv::imread(path, cv::IMREAD_COLOR);
+        if (raw.empty()) {
+            std::fprintf(stderr, "skip %s: cannot decode\n", path.c_str());
+            continue;
+        }
+        evaluate(raw);
+    }
+
+    AutomationStats stats;
+    automation.GetStats(&stats);
+    std::printf("frames=%lld events=%lld rules matched=%lld skipped=%lld deferred=%lld "
+                "latency p50=%.2fms p99=%.2fms max=%.2fms cpu=%.0f%% scale=%.2f\n",
+                stats.framesEvaluated, stats.events, stats.rulesEvaluated, stats.rulesSkipped, stats.rulesDeferred,
+                stats.p50LatencyNs / 1e6, stats.p99LatencyNs / 1e6, stats.maxLatencyNs / 1e6, stats.cpuUsage * 100,
+                stats.governorScale);
+    std::vector<AutomationRuleStats> ruleStats(rules.size());
+    automation.GetRuleStats(ruleStats.data(), static_cast<int>(ruleStats.size()));
+    for (size_t i = 0; i < ruleStats.size(); i++) {
+        const AutomationRuleStats& rule = ruleStats[i];
+        std::printf("rule %zu (%s): matched=%lld hits=%lld rate=%.1fHz hitRate=%.2f interval=%dms\n", i,
+                    ruleNames[i].c_str(), rule.evaluations, rule.hits, rule.rateHz, rule.hitRate, rule.intervalMs);
+    }
+    return 0;
+}
@@ -0,0 +1,267 @@
+// 匹配算法基准测试
+// 对比 cv::matchTemplate 与自研匹配内核在不同模板尺寸下的耗时，
+// 并逐位置校验整数 NCC 与 TM_CCOEFF_NORMED 的分数误差；
+// 最后两列是大 ROI 分块并行 (TiledMatcher) 的耗时与块数，以及分块与不分块的结果是否逐位相同
+// 之后在重复纹理、纯色与线性渐变背景上 (大量近似并列的位置) 比较多种块边长的 TiledMatcher 结果，
+// 结果都必须与不分块的 cv::matchTemplate 按同一规则取得的结果逐位相同
+// 用法: bench_matchers [源图宽] [源图高] [重复次数]
+// 返回值: 0 正常, 1 校验失败 (自研内核未找到模板、NCC 分数误差 >= 1e-3 或分块与不分块的结果不一致)
+// 典型 ROI 尺寸下 (如 400x400) 自研内核的优势最明显；全图大模板时 OpenCV 的 DFT 更快，
+// 全图 (如 bench_matchers 3840 2160) 时分块并行随核数加速
+#include "mat_view.h"
+#include "ncc_matcher.h"
+#include "simd_dot.h"
+#include "ssd_matcher.h"
+#include "synthetic_frames.h"
+#include "template_entry.h"
+#include "tiled_matcher.h"
+#include "work_stealing_pool.h"
+
+#include <opencv2/opencv.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+
+// 返回单次调用的平均毫秒数
+static double TimeIt(int iterations, const std::function<void()>& fn) {
+    fn(); // 预热
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) fn();
+    const auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count() / iterations;
+}
+
+// 生成带低频结构的 BGR 帧，比纯白噪声更接近游戏画面
+static cv::Mat MakeFrame(int width, int height) {
+    cv::Mat noise(height, width, CV_8UC3);
+    cv::randu(noise, cv::Scalar::all(0), cv::Scalar::all(256));
+    cv::Mat frame;
+    cv::GaussianBlur(noise, frame, cv::Size(0, 0), 3.0);
+    cv::normalize(frame, frame, 0, 255, cv::NORM_MINMAX);
+    return frame;
+}
+
+// 不分块的参照: 整幅 cv::matchTemplate，再按 TiledMatcher 的规则取值
+// (与最大值相差不超过 margin 的非纯色位置用整数 NCC 重算，按 分数 -> y -> x 取最高；重算代价超限时取 minMaxLoc)
+static double UntiledReference(const cv::Mat& frame, const TemplateEntry& entry, cv::Point* loc, bool* capped) {
+    const cv::Mat& templ = entry.image;
+    cv::Mat map;
+    cv::matchTemplate(frame, templ, map, cv::TM_CCOEFF_NORMED);
+    double minVal, maxVal;
+    cv::Point minLoc;
+    cv::minMaxLoc(map, &minVal, &maxVal, &minLoc, loc);
+
+    cv::Mat sums, squares;
+    cv::integral(frame, sums, squares, CV_64F, CV_64F);
+    const int ch = frame.channels();
+    auto flat = [&](int x, int y) {
+        const double area = static_cast<double>(templ.cols) * templ.rows;
+        for (int c = 0; c < ch; c++) {
+            const int l = x * ch + c;
+            const int r = (x + templ.cols) * ch + c;
+            const double sum = sums.at<double>(y + templ.rows, r) - sums.at<double>(y + templ.rows, l) -
+                               sums.at<double>(y, r) + sums.at<double>(y, l);
+            const double square = squares.at<double>(y + templ.rows, r) - squares.at<double>(y + templ.rows, l) -
+                                  squares.at<double>(y, r) + squares.at<double>(y, l);
+            if (area * square != sum * sum) return false;
+        }
+        return true;
+    };
+    const float cutoff = static_cast<float>(maxVal - TiledMatcher::kRefineMargin);
+    long long candidates = 0;
+    for (int y = 0; y < map.rows; y++) {
+        for (int x = 0; x < map.cols; x++) {
+            candidates += map.at<float>(y, x) >= cutoff && !flat(x, y);
+        }
+    }
+    *capped = candidates * templ.cols * templ.rows > TiledMatcher::kMaxRefinePixels;
+    if (*capped) return maxVal;
+
+    const ImageView view = ToImageView(frame);
+    const NccTemplate& ncc = entry.Ncc();
+    double best = -2.0;
+    for (int y = 0; y < map.rows; y++) {
+        for (int x = 0; x < map.cols; x++) {
+            if (map.at<float>(y, x) < cutoff) continue;
+            const double score = flat(x, y) ? 0.0 : NccScoreAt(view, entry.sums, ncc, x, y);
+            if (score > best) {
+                best = score;
+                *loc = cv::Point(x, y);
+            }
+        }
+    }
+    return best;
+}
+
+// 以自动分块与多种块边长在 frame 上匹配 templ，结果 (分数与位置) 必须与不分块的参照逐位相同；打印每种分块的结果
+static bool CheckTileInvariance(const char* name, const cv::Mat& frame, const cv::Mat& templ) {
+    const std::shared_ptr<const TemplateEntry> entry = MakeTemplateEntry(templ);
+    cv::Point expectLoc;
+    bool capped = false;
+    const double expectScore = UntiledReference(frame, *entry, &expectLoc, &capped);
+    std::printf("%8s untiled%s score=%.9f at (%d, %d)\n", name, capped ? " (capped)" : "", expectScore,
+                expectLoc.x, expectLoc.y);
+
+    // 0 为自动 (按 L2 分块，不值得分块时只分一块)
+    const int sides[] = {0, std::max(frame.cols, frame.rows), 64, 96, 160};
+    bool equal = true;
+    for (const int side : sides) {
+        TiledMatcher tiled;
+        if (!tiled.Plan(frame.cols, frame.rows, templ, side)) continue;
+        cv::Point loc;
+        const double score = tiled.Run(frame, *entry, &loc);
+        std::printf("%8s side=%5d tiles=%4d refined=%8d%s score=%.9f at (%d, %d)\n", name, side, tiled.TileCount(),
+                    tiled.Refined(), tiled.Capped() ? " (capped)" : "", score, loc.x, loc.y);
+        equal &= score == expectScore && loc == expectLoc && tiled.Capped() == capped;
+    }
+    std::printf("%8s tile_eq %s\n", name, equal ? "ok" : "DIFF");
+    return equal;
+}
+
+int main(int argc, char** argv) {
+    const int width = argc > 1 ? std::atoi(argv[1]) : 400;
+    const int height = argc > 2 ? std::atoi(argv[2]) : 400;
+    const int iterations = argc > 3 ? std::atoi(argv[3]) : 5;
+
+    cv::setRNGSeed(42);
+    const cv::Mat frame = MakeFrame(width, height);
+    const int sizes[] = {16, 32, 64, 128};
+    bool ok = true;
+
+    std::printf("frame %dx%d, %d iterations, simd=%s, tile workers=%d\n", width, height, iterations,
+                DotU8S16Isa(), SharedWorkers().Size());
+    std::printf("%6s %12s %12s %12s %10s %10s %12s %12s %10s %12s %6s %8s\n",
+                "templ", "ccoeff_ms", "sqdiff_ms", "ssd_sea_ms", "bound_rej", "early_rej",
+                "ncc_int8_ms", "max_diff", "match", "tiled_ms", "tiles", "tile_eq");
+
+    for (const int size : sizes) {
+        if (size > width || size > height) continue;
+        const cv::Rect where(width / 3, height / 2, size, size);
+        const cv::Mat templ = frame(where).clone();
+
+        cv::Mat result;
+        cv::Mat ccoeffMap;
+        const double ccoeffMs = TimeIt(iterations, [&] {
+            cv::matchTemplate(frame, templ, ccoeffMap, cv::TM_CCOEFF_NORMED);
+            double maxVal;
+            cv::Point maxLoc;
+            cv::minMaxLoc(ccoeffMap, nullptr, &maxVal, nullptr, &maxLoc);
+        });
+        const double sqdiffMs = TimeIt(iterations, [&] {
+            cv::matchTemplate(frame, templ, result, cv::TM_SQDIFF);
+            double minVal;
+            cv::Point minLoc;
+            cv::minMaxLoc(result, &minVal, nullptr, &minLoc, nullptr);
+        });
+
+        const ImageView templView = ToImageView(templ);
+        TemplateSums templSums;
+        ComputeTemplateSums(templView, &templSums);
+        SlidingWindowStats scratch;
+        SsdMatchResult match;
+        const double ssdMs = TimeIt(iterations, [&] {
+            MatchSsd(ToImageView(frame), templView, templSums, 0.95, &scratch, &match);
+        });
+
+        NccTemplate ncc;
+        PrepareNccTemplate(templView, templSums, &ncc);
+        NccMatchResult nccMatch;
+        const double nccMs = TimeIt(iterations, [&] {
+            MatchNcc(ToImageView(frame), templView, templSums, ncc, 0.9, &scratch, &nccMatch);
+        });
+
+        // 逐位置与 OpenCV 的分数比较 (要求误差 < 1e-3)
+        cv::Mat nccMap(ccoeffMap.rows, ccoeffMap.cols, CV_32FC1);
+        NccMatchResult check;
+        BeginNccSearch(&check);
+        scratch.Reset(ToImageView(frame), templ.cols, templ.rows, true);
+        do {
+            NccMatchRow(ToImageView(frame), templSums, ncc, scratch.Sums(), scratch.SquareSums(),
+                        scratch.Cols(), scratch.Row(), &check, nccMap.ptr<float>(scratch.Row()));
+        } while (scratch.Advance());
+        double maxDiff = 0.0;
+        for (int y = 0; y < nccMap.rows; y++) {
+            const float* a = nccMap.ptr<float>(y);
+            const float* b = ccoeffMap.ptr<float>(y);
+            for (int x = 0; x < nccMap.cols; x++) {
+                maxDiff = std::max(maxDiff, static_cast<double>(std::fabs(a[x] - b[x])));
+            }
+        }
+
+        // 分块并行: 自动分块 (按 L2) 的耗时；并与不分块的参照、按最小块分块的结果逐位比较
+        const std::shared_ptr<const TemplateEntry> entry = MakeTemplateEntry(templ);
+        TiledMatcher tiled;
+        double tiledMs = 0.0;
+        cv::Point tiledLoc;
+        double tiledScore = 0.0;
+        if (tiled.Plan(width, height, templ)) {
+            tiledMs = TimeIt(iterations, [&] { tiledScore = tiled.Run(frame, *entry, &tiledLoc); });
+        }
+        cv::Point untiledLoc;
+        bool capped = false;
+        const double untiledScore = UntiledReference(frame, *entry, &untiledLoc, &capped);
+        TiledMatcher fine;
+        fine.Plan(width, height, templ, 64);
+        cv::Point fineLoc;
+        const double fineScore = fine.Run(frame, *entry, &fineLoc);
+        const bool tileEqual = fineScore == untiledScore && fineLoc == untiledLoc &&
+                               (tiled.TileCount() == 0 || (tiledScore == untiledScore && tiledLoc == untiledLoc));
+
+        const double positions = static_cast<double>(match.positions > 0 ? match.positions : 1);
+        const bool ssdOk = match.found && match.x == where.x && match.y == where.y;
+        const bool nccOk = nccMatch.found && nccMatch.x == where.x && nccMatch.y == where.y;
+        ok &= ssdOk && nccOk && tileEqual && maxDiff < 1e-3;
+        std::printf("%6d %12.3f %12.3f %12.3f %9.1f%% %9.1f%% %12.3f %12.2e %10s %12.3f %6d %8s\n",
+                    size, ccoeffMs, sqdiffMs, ssdMs,
+                    100.0 * match.rejectedByBound / positions,
+                    100.0 * match.rejectedEarly / positions,
+                    nccMs, maxDiff, ssdOk && nccOk ? "ok" : "MISS",
+                    tiledMs, tiled.TileCount(), tileEqual ? "ok" : "DIFF");
+    }
+
+    // 重复纹理: 12x12 的随机块平铺，模板内容在整帧周期性出现；
+    // 纯色: 单色背景上贴一份模板，其余位置的窗口都是纯色；
+    // 渐变: 合成帧的线性渐变背景 (量化后有大量近似并列的位置)，模板取自背景本身；
+    // 斜坡: 各通道为坐标的整数线性函数，每个窗口都是模板加常数，全部位置分数相同 (重算代价超限)
+    cv::Mat patch(12, 12, CV_8UC3);
+    cv::randu(patch, cv::Scalar::all(0), cv::Scalar::all(256));
+    cv::Mat repeated;
+    cv::repeat(patch, height / 12 + 1, width / 12 + 1, repeated);
+    repeated = repeated(cv::Rect(0, 0, width, height)).clone();
+    const cv::Mat repeatedTempl = repeated(cv::Rect(7, 5, 32, 32)).clone();
+    cv::Mat flat(height, width, CV_8UC3, cv::Scalar(40, 40, 40));
+    cv::Mat pasted = flat(cv::Rect(width / 3, height / 2, 32, 32));
+    repeatedTempl.copyTo(pasted);
+    SyntheticFrameOptions gradientOptions;
+    gradientOptions.width = width;
+    gradientOptions.height = height;
+    gradientOptions.background = SYNTHETIC_BACKGROUND_GRADIENT;
+    gradientOptions.maxCount = 0;
+    cv::Mat gradient;
+    std::vector<GroundTruthObject> objects;
+    GenerateSyntheticFrame(gradientOptions, {}, 0, &gradient, &objects);
+    const int rampSide = std::min(std::min(width, height), 255);
+    cv::Mat ramp(rampSide, rampSide, CV_8UC3);
+    for (int y = 0; y < ramp.rows; y++) {
+        uint8_t* p = ramp.ptr<uint8_t>(y);
+        for (int x = 0; x < ramp.cols; x++, p += 3) {
+            p[0] = static_cast<uint8_t>(x);
+            p[1] = static_cast<uint8_t>(y);
+            p[2] = static_cast<uint8_t>(255 - x);
+        }
+    }
+    if (width >= 64 && height >= 64) {
+        ok &= CheckTileInvariance("repeated", repeated, repeatedTempl);
+        ok &= CheckTileInvariance("flat", flat, repeatedTempl);
+        ok &= CheckTileInvariance("gradient", gradient, gradient(cv::Rect(width / 3, height / 2, 32, 32)).clone());
+    }
+    if (rampSide >= 128) {
+        ok &= CheckTileInvariance("ramp", ramp, ramp(cv::Rect(rampSide / 3, rampSide / 2, 48, 48)).clone());
+    }
+    std::printf("%s\n", ok ? "OK" : "MISMATCH");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,299 @@
+// 录制编解码往返校验
+// 1. frame_codec: 零游程与 LZ 两级、关键帧与差分帧 (两种残差压缩) 在多种尺寸 (含不是块边长整数倍的)
+//    与画面变化下编码后解码必须逐字节还原，截断的数据必须解码失败；
+// 2. FrameRecorder / FrameRecordReader: 录制一段含尺寸变化的 BGRA 帧序列，读回的 BGR 帧必须逐字节相同；
+// 3. 压缩比: 每种合成背景 (synthetic_frames) 录制一段平移且有模板移动的画面，
+//    输出 rawBytes / bytesWritten (并与只做零游程时对比)，低于该背景的下限即失败。
+// 用法: codec_roundtrip [临时录制文件路径]   (默认在当前目录写 codec_roundtrip.frec，结束时删除)
+// 返回值: 0 全部通过, 1 不一致或压缩比不足
+#include "frame_codec.h"
+#include "frame_recorder.h"
+#include "synthetic_frames.h"
+
+#include <opencv2/imgproc.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+// xorshift32: 只用于生成测试数据
+static uint32_t NextRandom(uint32_t* state) {
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+// 大片零与随机字面段交替，覆盖编码按 8 字节成组跳过时的各种边界
+static std::vector<uint8_t> MakeRuns(size_t size, uint32_t* state) {
+    std::vector<uint8_t> data(size, 0);
+    size_t i = 0;
+    while (i < size) {
+        const size_t zeros = NextRandom(state) % 40;
+        const size_t literals = NextRandom(state) % 40;
+        i += zeros;
+        for (size_t k = 0; k < literals && i < size; k++, i++) {
+            data[i] = static_cast<uint8_t>(NextRandom(state) % 255 + 1);
+        }
+    }
+    return data;
+}
+
+// 短周期重复 (匹配与源重叠) 夹杂随机字节，覆盖 LZ 的各种偏移与长度延长
+static std::vector<uint8_t> MakeRepeats(size_t size, uint32_t* state) {
+    std::vector<uint8_t> data(size);
+    size_t period = 1 + NextRandom(state) % 12;
+    for (size_t i = 0; i < size; i++) {
+        if (i < period || NextRandom(state) % 64 == 0) {
+            data[i] = static_cast<uint8_t>(NextRandom(state) >> 24);
+            if (NextRandom(state) % 8 == 0) period = 1 + NextRandom(state) % 12;
+        } else {
+            data[i] = data[i - period];
+        }
+    }
+    return data;
+}
+
+typedef void (*StageEncode)(const uint8_t*, size_t, std::vector<uint8_t>*);
+typedef bool (*StageDecode)(const uint8_t*, size_t, uint8_t*, size_t);
+
+static bool CheckStage(const char* name, StageEncode encode, StageDecode decode, uint32_t* state) {
+    bool ok = true;
+    std::vector<uint8_t> encoded;
+    for (size_t size = 0; size < 2000; size += size < 300 ? 7 : 131) {
+        const std::vector<uint8_t> inputs[] = {
+            std::vector<uint8_t>(size, 0),
+            std::vector<uint8_t>(size, 0x5a),
+            MakeRuns(size, state),
+            MakeRepeats(size, state),
+        };
+        for (const std::vector<uint8_t>& input : inputs) {
+            encoded.clear();
+            encode(input.data(), input.size(), &encoded);
+            std::vector<uint8_t> decoded(input.size(), 0xcc);
+            if (!decode(encoded.data(), encoded.size(), decoded.data(), decoded.size()) || decoded != input) {
+                std::printf("%s size=%zu: MISMATCH\n", name, size);
+                ok = false;
+            }
+            // 长度不符或数据截断必须失败，不能越界写
+            std::vector<uint8_t> longer(input.size() + 1);
+            if (decode(encoded.data(), encoded.size(), longer.data(), longer.size())) {
+                std::printf("%s size=%zu: accepted wrong length\n", name, size);
+                ok = false;
+            }
+            if (!encoded.empty() && decode(encoded.data(), encoded.size() - 1, decoded.data(), decoded.size())) {
+                std::printf("%s size=%zu: accepted truncated data\n", name, size);
+                ok = false;
+            }
+        }
+    }
+    return ok;
+}
+
+// 在 previous 上改写几个矩形区域 (部分跨越块边界) 得到下一帧
+static void Mutate(std::vector<uint8_t>* bgr, int width, int height, uint32_t* state) {
+    for (int n = 0; n < 3; n++) {
+        const int x0 = static_cast<int>(NextRandom(state) % width);
+        const int y0 = static_cast<int>(NextRandom(state) % height);
+        const int x1 = std::min(width, x0 + 1 + static_cast<int>(NextRandom(state) % 80));
+        const int y1 = std::min(height, y0 + 1 + static_cast<int>(NextRandom(state) % 80));
+        for (int y = y0; y < y1; y++) {
+            uint8_t* row = bgr->data() + static_cast<size_t>(y) * width * 3;
+            for (int x = x0 * 3; x < x1 * 3; x++) {
+                row[x] = static_cast<uint8_t>(NextRandom(state) >> 24);
+            }
+        }
+    }
+}
+
+static bool CheckFrames(int width, int height, FrameResidualCodec codec, uint32_t* state) {
+    const size_t bytes = static_cast<size_t>(width) * height * 3;
+    std::vector<uint8_t> current = MakeRuns(bytes, state);
+    FrameCodecScratch scratch;
+    std::vector<uint8_t> encoded;
+    std::vector<uint8_t> decoded(bytes);
+
+    EncodeKeyframe(current.data(), width, height, &scratch, &encoded, codec);
+    bool ok = DecodeKeyframe(encoded.data(), encoded.size(), width, height, &scratch, decoded.data(), codec) &&
+              decoded == current;
+    if (!encoded.empty() &&
+        DecodeKeyframe(encoded.data(), encoded.size() - 1, width, height, &scratch, decoded.data(), codec)) {
+        std::printf("keyframe %dx%d: accepted truncated data\n", width, height);
+        ok = false;
+    }
+
+    // 差分帧链: 解码端从关键帧开始就地更新，每一步都要与编码端的当前帧相同
+    std::vector<uint8_t> reference = current;
+    for (int step = 0; step < 8 && ok; step++) {
+        std::vector<uint8_t> previous = current;
+        // 第 0 步画面不变 (没有变化块)
+        if (step > 0) Mutate(&current, width, height, state);
+        encoded.clear();
+        EncodeDeltaFrame(current.data(), previous.data(), width, height, &scratch, &encoded, codec);
+        if (!DecodeDeltaFrame(encoded.data(), encoded.size(), width, height, &scratch, reference.data(), codec) ||
+            reference != current) {
+            std::printf("delta %dx%d step %d: MISMATCH\n", width, height, step);
+            ok = false;
+        }
+    }
+    std::printf("frames %4dx%-4d %-8s %s\n", width, height, codec == FRAME_RESIDUAL_LZ ? "lz" : "zero-run",
+                ok ? "ok" : "MISMATCH");
+    return ok;
+}
+
+// 录制含尺寸变化的 BGRA 序列再读回；队列满时 Submit 丢帧，这里重试直到被接受
+static bool CheckRecorder(const std::string& path, uint32_t* state) {
+    const cv::Size sizes[] = {cv::Size(150, 100), cv::Size(150, 100), cv::Size(97, 131)};
+    const int framesPerSize = 9;
+    std::vector<cv::Mat> expected;
+
+    FrameRecorder recorder;
+    std::string error;
+    if (!recorder.Start(path, 4, &error)) {
+        std::printf("recorder: %s\n", error.c_str());
+        return false;
+    }
+    for (const cv::Size& size : sizes) {
+        cv::Mat frame(size, CV_8UC4);
+        for (int y = 0; y < frame.rows; y++) {
+            uint8_t* row = frame.ptr<uint8_t>(y);
+            for (int x = 0; x < frame.cols * 4; x++) row[x] = static_cast<uint8_t>(NextRandom(state) >> 24);
+        }
+        for (int i = 0; i < framesPerSize; i++) {
+            // 移动的色块: 相邻帧只有少数块变化
+            frame(cv::Rect(i * 7 % (size.width - 20), i * 5 % (size.height - 20), 20, 20)).setTo(
+                cv::Scalar(i * 30 % 256, 255 - i * 20, i * 11 % 256, 255));
+            const int64_t arrivalNs = static_cast<int64_t>(expected.size()) + 1;
+            while (!recorder.Submit(frame.data, frame.cols, frame.rows, static_cast<int>(frame.step[0]), arrivalNs)) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            cv::Mat bgr;
+            cv::cvtColor(frame, bgr, cv::COLOR_BGRA2BGR);
+            expected.push_back(bgr);
+        }
+    }
+    if (!recorder.Stop()) {
+        std::printf("recorder: write failed\n");
+        return false;
+    }
+
+    FrameRecordReader reader;
+    if (!reader.Open(path, &error)) {
+        std::printf("reader: %s\n", error.c_str());
+        return false;
+    }
+    bool ok = reader.FrameCount() == static_cast<int>(expected.size());
+    // 倒序读一遍 (每帧都从关键帧重新解码) 再顺序读一遍 (走缓存)
+    for (int pass = 0; pass < 2 && ok; pass++) {
+        for (int k = 0; k < reader.FrameCount() && ok; k++) {
+            const int i = pass == 0 ? reader.FrameCount() - 1 - k : k;
+            cv::Mat frame;
+            ok = reader.Read(i, &frame) && reader.ArrivalNs(i) == i + 1 && frame.size() == expected[i].size() &&
+                 std::memcmp(frame.data, expected[i].data, expected[i].total() * expected[i].elemSize()) == 0;
+            if (!ok) std::printf("recorder frame %d: MISMATCH\n", i);
+        }
+    }
+    std::printf("recorder %d frames %s\n", reader.FrameCount(), ok ? "ok" : "MISMATCH");
+    return ok;
+}
+
+// 每种背景录制 kCompressionFrames 帧: 背景每帧向左平移 3 像素 (循环)，一个 48x48 模板斜向移动；
+// 每 8 帧一个关键帧。下限约为该内容上实测压缩比的一半，且明显高于只做零游程时的压缩比
+// (平移后的纹理几乎没有零段，零游程在渐变与杂乱背景上只有 1.2-1.4 倍)
+static bool CheckCompression(const std::string& path) {
+    static const int kCompressionFrames = 24;
+    static const struct {
+        int background;
+        const char* name;
+        double minRatio;
+    } kCases[] = {
+        {SYNTHETIC_BACKGROUND_FLAT, "flat", 16},
+        {SYNTHETIC_BACKGROUND_GRADIENT, "gradient", 3},
+        {SYNTHETIC_BACKGROUND_NOISE, "noise", 14},
+        {SYNTHETIC_BACKGROUND_CHECKER, "checker", 14},
+        {SYNTHETIC_BACKGROUND_CLUTTER, "clutter", 2.5},
+    };
+    const cv::Mat templ = MakeSyntheticTemplate(7, 48, 48);
+    bool ok = true;
+    for (const auto& test : kCases) {
+        SyntheticFrameOptions options;
+        options.width = 640;
+        options.height = 360;
+        options.background = test.background;
+        options.maxCount = 0;
+        cv::Mat background;
+        std::vector<GroundTruthObject> objects;
+        GenerateSyntheticFrame(options, std::vector<SyntheticTemplate>(), 0, &background, &objects);
+
+        FrameRecorder recorder;
+        std::string error;
+        if (!recorder.Start(path, 8, &error)) {
+            std::printf("compression: %s\n", error.c_str());
+            return false;
+        }
+        // 同样的帧只做零游程时的总大小 (编码结果依次追加，不含文件头与索引)，用于对比
+        FrameCodecScratch scratch;
+        std::vector<uint8_t> zeroRun;
+        cv::Mat previous;
+        cv::Mat frame(background.size(), CV_8UC3);
+        cv::Mat bgra;
+        for (int i = 0; i < kCompressionFrames; i++) {
+            const int dx = i * 3 % frame.cols;
+            const int rest = frame.cols - dx;
+            background(cv::Rect(dx, 0, rest, frame.rows)).copyTo(frame(cv::Rect(0, 0, rest, frame.rows)));
+            if (dx > 0) background(cv::Rect(0, 0, dx, frame.rows)).copyTo(frame(cv::Rect(rest, 0, dx, frame.rows)));
+            templ.copyTo(frame(cv::Rect(20 + i * 17, 30 + i * 9, templ.cols, templ.rows)));
+            if (i % 8 == 0) {
+                EncodeKeyframe(frame.data, frame.cols, frame.rows, &scratch, &zeroRun, FRAME_RESIDUAL_ZERO_RUN);
+            } else {
+                EncodeDeltaFrame(frame.data, previous.data, frame.cols, frame.rows, &scratch, &zeroRun,
+                                 FRAME_RESIDUAL_ZERO_RUN);
+            }
+            frame.copyTo(previous);
+
+            cv::cvtColor(frame, bgra, cv::COLOR_BGR2BGRA);
+            while (!recorder.Submit(bgra.data, bgra.cols, bgra.rows, static_cast<int>(bgra.step[0]), i + 1)) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+        if (!recorder.Stop()) {
+            std::printf("compression: write failed\n");
+            return false;
+        }
+        RecorderStats stats;
+        recorder.GetStats(&stats);
+        const double ratio = stats.bytesWritten > 0 ? static_cast<double>(stats.rawBytes) / stats.bytesWritten : 0;
+        const double zeroRunRatio = static_cast<double>(stats.rawBytes) / std::max<size_t>(zeroRun.size(), 1);
+        const bool pass = stats.written == kCompressionFrames && ratio >= test.minRatio;
+        std::printf("compression %-8s raw/written %6.2f (zero-run only %5.2f, min %.1f) %s\n", test.name, ratio,
+                    zeroRunRatio, test.minRatio, pass ? "ok" : "FAIL");
+        ok &= pass;
+    }
+    return ok;
+}
+
+int main(int argc, char** argv) {
+    const std::string path = argc > 1 ? argv[1] : "codec_roundtrip.frec";
+    uint32_t state = 0x2545F491u;
+
+    bool ok = CheckStage("zero-run", ZeroRunEncode, ZeroRunDecode, &state);
+    ok &= CheckStage("lz", LzEncode, LzDecode, &state);
+    const int sizes[][2] = {{1, 1}, {64, 64}, {63, 65}, {130, 70}, {200, 129}};
+    for (const FrameResidualCodec codec : {FRAME_RESIDUAL_ZERO_RUN, FRAME_RESIDUAL_LZ}) {
+        for (const auto& size : sizes) {
+            ok &= CheckFrames(size[0], size[1], codec, &state);
+        }
+    }
+    ok &= CheckRecorder(path, &state);
+    ok &= CheckCompression(path);
+    std::remove(path.c_str());
+
+    std::printf("%s\n", ok ? "OK" : "FAIL");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,414 @@
+// 无界面查找回放工具
+// 不需要 Flutter 应用与游戏窗口: 把录制的帧 (BMP/PNG/JPG、原始 BGRA、.frec 录制或视频) 交给编译好的查找计划逐帧执行，
+// 输出每帧每个请求的命中、位置、分数与耗时，用于测量录制会话上的吞吐，以及在同一输入上对比引擎模式。
+// 帧在多个线程上并行处理 (默认使用全部硬件线程)，每个线程持有自己的计划；输出按帧序排列。
+// 用法: search_replay [-j 线程数] [-o csv|json] [-M ccoeff|ssd|ncc|auto] [-d 截止微秒] [-R 宽x高]
+//                     (-s 场景.json | -r 模板,x,y,w,h,阈值[,优先级] [-r ...]) (-v 视频 | 帧目录或帧文件...)
+//   -j: 并行处理帧的线程数，默认为硬件线程数
+//   -o: 逐请求结果的格式 (标准输出)，默认 csv；汇总 (吞吐、逐请求命中率与耗时分位数) 始终打印到标准错误
+//   -M: 覆盖全部请求的算法，用于在同一输入上对比
+//   -d: 每帧的批次预算，同 BatchHeader::deadlineUs (被跳过的请求带 SKIPPED_DEADLINE 标志)
+//   -R: .raw 帧文件的尺寸 (BGRA，行紧密排列)
+//   -v: 视频文件 (OpenCV videoio 可解码的格式)，按顺序解码
+//   -r: 一个查找请求，ROI 为 0,0,0,0 时搜索整帧；可重复
+// .frec 为 recorder_start 录制的文件，展开为其中的每一帧 (帧名为 文件#帧下标)。
+// 目录按文件名排序，只取 .bmp / .png / .jpg / .jpeg / .raw / .frec 文件。
+// 返回值: 0 成功, 1 场景、模板或输入无法读取, 2 参数无效
+#include "frame_recorder.h"
+#include "json_value.h"
+#include "scenario.h"
+#include "search_plan.h"
+#include "search_stats.h"
+#include "template_entry.h"
+#include "work_stealing_pool.h"
+
+#include <opencv2/opencv.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+// 一帧的全部结果
+struct FrameRecord {
+    int index = 0;
+    std::string source;
+    long long totalNs = 0;   // 计划执行耗时 (含区域转换，不含解码)
+    std::vector<SearchResultEx> results;
+};
+
+// 帧来源: 文件列表或视频；Next 可在多个线程上并发调用
+class FrameSource {
+public:
+    bool OpenFiles(const std::vector<std::string>& paths, int rawWidth, int rawHeight) {
+        rawWidth_ = rawWidth;
+        rawHeight_ = rawHeight;
+        for (const std::string& path : paths) {
+            std::error_code ec;
+            if (fs::is_directory(path, ec)) {
+                std::vector<std::string> files;
+                for (const fs::directory_entry& entry : fs::directory_iterator(path, ec)) {
+                    if (entry.is_regular_file() && IsFrameFile(entry.path())) {
+                        files.push_back(entry.path().string());
+                    }
+                }
+                std::sort(files.begin(), files.end());
+                for (const std::string& file : files) AddFile(file);
+            } else {
+                AddFile(path);
+            }
+        }
+        return !items_.empty();
+    }
+
+    bool OpenVideo(const std::string& path) {
+        video_ = true;
+        videoPath_ = path;
+        return capture_.open(path);
+    }
+
+    // 取下一帧 (BGRA)，没有更多帧时返回 false；无法解码的文件跳过并提示
+    bool Next(int* index, std::string* name, cv::Mat* frame) {
+        cv::Mat bgr;
+        for (;;) {
+            std::string path;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (video_) {
+                    // 视频只能顺序解码
+                    if (!capture_.read(bgr)) return false;
+                    *index = next_++;
+                    *name = videoPath_;
+                } else {
+                    if (next_ >= static_cast<int>(items_.size())) return false;
+                    *index = next_++;
+                    const Item& item = items_[*index];
+                    path = item.path;
+                    *name = path;
+                    if (item.recording >= 0) {
+                        // 录制文件在锁内按顺序解码，每帧只需解码一次差分
+                        *name = path + "#" + std::to_string(item.frame);
+                        if (!recordings_[item.recording]->Read(item.frame, &bgr)) bgr.release();
+                        path.clear();
+                    }
+                }
+            }
+            if (!video_ && !path.empty()) {
+                if (IsRaw(path)) {
+                    if (ReadRaw(path, frame)) return true;
+                } else {
+                    bgr = cv::imread(path, cv::IMREAD_COLOR);
+                }
+            }
+            if (!bgr.empty()) {
+                // 实时路径提交的是 WGC 的 BGRA 帧，回放保持同样的通道布局 (区域转换计入耗时)
+                cv::cvtColor(bgr, *frame, cv::COLOR_BGR2BGRA);
+                return true;
+            }
+            std::fprintf(stderr, "skip %s: cannot decode\n", name->c_str());
+        }
+    }
+
+private:
+    static std::string Extension(const fs::path& path) {
+        std::string ext = path.extension().string();
+        std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return std::tolower(c); });
+        return ext;
+    }
+
+    static bool IsFrameFile(const fs::path& path) {
+        const std::string ext = Extension(path);
+        return ext == ".bmp" || ext == ".png" || ext == ".jpg" || ext == ".jpeg" || ext == ".raw" || ext == ".frec";
+    }
+
+    static bool IsRaw(const std::string& path) { return Extension(path) == ".raw"; }
+
+    // 录制文件展开为其中的每一帧，无法打开时跳过并提示
+    void AddFile(const std::string& path) {
+        if (Extension(path) != ".frec") {
+            items_.push_back(Item{path, -1, 0});
+            return;
+        }
+        std::unique_ptr<FrameRecordReader> reader = std::make_unique<FrameRecordReader>();
+        std::string error;
+        if (!reader->Open(path, &error)) {
+            std::fprintf(stderr, "skip %s\n", error.c_str());
+            return;
+        }
+        for (int i = 0; i < reader->FrameCount(); i++) {
+            items_.push_back(Item{path, static_cast<int>(recordings_.size()), i});
+        }
+        recordings_.push_back(std::move(reader));
+    }
+
+    bool ReadRaw(const std::string& path, cv::Mat* frame) const {
+        if (rawWidth_ <= 0 || rawHeight_ <= 0) return false;
+        std::ifstream in(path, std::ios::binary);
+        frame->create(rawHeight_, rawWidth_, CV_8UC4);
+        const std::streamsize bytes = static_cast<std::streamsize>(rawWidth_) * rawHeight_ * 4;
+        return in.read(reinterpret_cast<char*>(frame->data), bytes) && in.gcount() == bytes;
+    }
+
+    struct Item {
+        std::string path;
+        int recording;  // recordings_ 下标，-1 表示单帧文件
+        int frame;      // 录制中的帧下标
+    };
+
+    std::mutex mutex_;
+    std::vector<Item> items_;
+    std::vector<std::unique_ptr<FrameRecordReader>> recordings_;
+    int next_ = 0;
+    int rawWidth_ = 0;
+    int rawHeight_ = 0;
+    bool video_ = false;
+    std::string videoPath_;
+    cv::VideoCapture capture_;
+};
+
+// 解析 "模板,x,y,w,h,阈值[,优先级]"
+static bool ParseRequest(const char* spec, std::string* path, SearchRequest* request, int* priority) {
+    const char* comma = std::strchr(spec, ',');
+    if (!comma) return false;
+    path->assign(spec, comma - spec);
+    *request = SearchRequest();
+    request->method = SEARCH_METHOD_CCOEFF_NORMED;
+    *priority = SEARCH_PRIORITY_NORMAL;
+    const int n = std::sscanf(comma + 1, "%d,%d,%d,%d,%lf,%d", &request->roiX, &request->roiY, &request->roiW,
+                              &request->roiH, &request->threshold, priority);
+    return n >= 5;
+}
+
+// CSV 字段: 含逗号、引号或换行时加引号
+static std::string CsvField(const std::string& text) {
+    if (text.find_first_of(",\"\n") == std::string::npos) return text;
+    std::string out = "\"";
+    for (const char c : text) {
+        if (c == '"') out += '"';
+        out += c;
+    }
+    return out + "\"";
+}
+
+int main(int argc, char** argv) {
+    int threads = HardwareThreads();
+    std::string format = "csv";
+    int methodOverride = -1;
+    long long deadlineUs = 0;
+    int rawWidth = 0;
+    int rawHeight = 0;
+    std::string scenarioPath;
+    std::string videoPath;
+    std::vector<std::string> templatePaths;
+    std::vector<SearchRequest> requests;
+    std::vector<int> priorities; // 与 requests 对应，同 BatchHeader::priorities
+    bool valid = true;
+    int arg = 1;
+    for (; arg + 1 < argc && argv[arg][0] == '-'; arg += 2) {
+        const char* value = argv[arg + 1];
+        if (std::strcmp(argv[arg], "-j") == 0) {
+            threads = std::atoi(value);
+        } else if (std::strcmp(argv[arg], "-o") == 0) {
+            format = value;
+        } else if (std::strcmp(argv[arg], "-M") == 0) {
+            valid &= ParseSearchMethod(value, &methodOverride);
+        } else if (std::strcmp(argv[arg], "-d") == 0) {
+            deadlineUs = std::atoll(value);
+        } else if (std::strcmp(argv[arg], "-R") == 0) {
+            valid &= std::sscanf(value, "%dx%d", &rawWidth, &rawHeight) == 2;
+        } else if (std::strcmp(argv[arg], "-s") == 0) {
+            scenarioPath = value;
+        } else if (std::strcmp(argv[arg], "-v") == 0) {
+            videoPath = value;
+        } else if (std::strcmp(argv[arg], "-r") == 0) {
+            std::string path;
+            SearchRequest request;
+            int priority;
+            if (!ParseRequest(value, &path, &request, &priority)) {
+                std::fprintf(stderr, "invalid request: %s\n", value);
+                return 2;
+            }
+            templatePaths.push_back(path);
+            requests.push_back(request);
+            priorities.push_back(priority);
+        } else {
+            valid = false;
+        }
+    }
+    if (!valid || threads <= 0 || (format != "csv" && format != "json") || requests.empty() == scenarioPath.empty() ||
+        (videoPath.empty() == (arg >= argc))) {
+        std::fprintf(stderr, "usage: search_replay [-j threads] [-o csv|json] [-M ccoeff|ssd|ncc|auto] [-d deadlineUs] "
+                             "[-R WxH] (-s scenario.json | -r templ,x,y,w,h,threshold[,priority] [-r ...]) "
+                             "(-v video | frame-dir-or-file...)\n");
+        return 2;
+    }
+
+    // 模板与请求名
+    std::vector<std::shared_ptr<const TemplateEntry>> entries;
+    std::vector<std::string> names;
+    if (!scenarioPath.empty()) {
+        Scenario scenario;
+        std::string error;
+        if (!LoadScenario(scenarioPath, &scenario, &error) || !LoadScenarioTemplates(scenario, &entries, &error)) {
+            std::fprintf(stderr, "%s: %s\n", scenarioPath.c_str(), error.c_str());
+            return 1;
+        }
+        for (const ScenarioRule& rule : scenario.rules) {
+            requests.push_back(rule.rule.request);
+            priorities.push_back(SEARCH_PRIORITY_NORMAL);
+            names.push_back(rule.name);
+        }
+    } else {
+        // 与 load_template 一致: 模板统一为 BGR
+        for (size_t i = 0; i < templatePaths.size(); i++) {
+            const cv::Mat templ = cv::imread(templatePaths[i], cv::IMREAD_COLOR);
+            if (templ.empty()) {
+                std::fprintf(stderr, "cannot decode template %s\n", templatePaths[i].c_str());
+                return 1;
+            }
+            entries.push_back(MakeTemplateEntry(templ));
+            requests[i].templateId = static_cast<int>(i) + 1;
+        }
+        names = templatePaths;
+    }
+    if (methodOverride >= 0) {
+        for (SearchRequest& request : requests) request.method = methodOverride;
+    }
+    const int count = static_cast<int>(requests.size());
+
+    FrameSource source;
+    if (!videoPath.empty() ? !source.OpenVideo(videoPath)
+                           : !source.OpenFiles(std::vector<std::string>(argv + arg, argv + argc), rawWidth, rawHeight)) {
+        std::fprintf(stderr, "no frames: cannot open input\n");
+        return 1;
+    }
+
+    // 并行执行: 每个线程一个计划，帧尺寸变化时重新编译
+    std::mutex recordsMutex;
+    std::vector<FrameRecord> records;
+    const long long wallStart = StatsNowNs();
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([&] {
+            SearchPlan plan;
+            bool compiled = false;
+            FrameRecord record;
+            cv::Mat frame;
+            while (source.Next(&record.index, &record.source, &frame)) {
+                if (!compiled || frame.cols != plan.FrameWidth() || frame.rows != plan.FrameHeight()) {
+                    plan.Compile(requests.data(), entries.data(), count, frame.cols, frame.rows, 4, nullptr,
+                                 priorities.data());
+                    compiled = true;
+                }
+                record.results.resize(count);
+                const long long start = StatsNowNs();
+                BatchHeader header = {};
+                plan.Run(frame, nullptr, nullptr, record.results.data(), &header,
+                         deadlineUs > 0 ? start + deadlineUs * 1000 : 0);
+                record.totalNs = StatsNowNs() - start;
+                std::lock_guard<std::mutex> lock(recordsMutex);
+                records.push_back(record);
+            }
+        });
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    const double wallSeconds = (StatsNowNs() - wallStart) / 1e9;
+    std::sort(records.begin(), records.end(),
+              [](const FrameRecord& a, const FrameRecord& b) { return a.index < b.index; });
+
+    // 逐请求汇总
+    struct RequestSummary {
+        long long hits = 0;
+        long long skipped = 0;
+        double hitScore = 0;
+        std::vector<long long> times;
+    };
+    std::vector<RequestSummary> summaries(count);
+    std::vector<long long> frameTimes;
+    for (const FrameRecord& record : records) {
+        frameTimes.push_back(record.totalNs);
+        for (int i = 0; i < count; i++) {
+            const SearchResultEx& r = record.results[i];
+            RequestSummary& s = summaries[i];
+            if (r.flags & SEARCH_RESULT_SKIPPED_DEADLINE) {
+                s.skipped++;
+                continue;
+            }
+            if (r.x >= 0) {
+                s.hits++;
+                s.hitScore += r.score;
+            }
+            s.times.push_back(r.timeNs);
+        }
+    }
+    std::sort(frameTimes.begin(), frameTimes.end());
+    for (RequestSummary& s : summaries) std::sort(s.times.begin(), s.times.end());
+    const size_t frames = records.size();
+    const double fps = wallSeconds > 0 ? frames / wallSeconds : 0;
+
+    // 逐请求结果
+    if (format == "csv") {
+        std::printf("frame,source,request,name,template_id,hit,x,y,score,method,time_us,flags\n");
+        for (const FrameRecord& record : records) {
+            for (int i = 0; i < count; i++) {
+                const SearchResultEx& r = record.results[i];
+                std::printf("%d,%s,%d,%s,%d,%d,%d,%d,%.4f,%d,%.1f,%d\n", record.index,
+                            CsvField(record.source).c_str(), i, CsvField(names[i]).c_str(), r.templateId,
+                            r.x >= 0 ? 1 : 0, r.x, r.y, r.score, r.method, r.timeNs / 1e3, r.flags);
+            }
+        }
+    } else {
+        std::printf("{\"frames\":[");
+        for (size_t f = 0; f < records.size(); f++) {
+            const FrameRecord& record = records[f];
+            std::printf("%s\n{\"frame\":%d,\"source\":%s,\"totalUs\":%.1f,\"results\":[", f ? "," : "",
+                        record.index, JsonQuote(record.source).c_str(), record.totalNs / 1e3);
+            for (int i = 0; i < count; i++) {
+                const SearchResultEx& r = record.results[i];
+                std::printf("%s{\"request\":%d,\"hit\":%s,\"x\":%d,\"y\":%d,\"score\":%.4f,\"method\":%d,"
+                            "\"timeUs\":%.1f,\"flags\":%d}",
+                            i ? "," : "", i, r.x >= 0 ? "true" : "false", r.x, r.y, r.score, r.method,
+                            r.timeNs / 1e3, r.flags);
+            }
+            std::printf("]}");
+        }
+        std::printf("\n],\"summary\":{\"frames\":%zu,\"threads\":%d,\"wallSeconds\":%.3f,\"fps\":%.2f,"
+                    "\"frameP50Us\":%.1f,\"frameP99Us\":%.1f,\"requests\":[",
+                    frames, threads, wallSeconds, fps, SortedPercentile(frameTimes, 0.5) / 1e3,
+                    SortedPercentile(frameTimes, 0.99) / 1e3);
+        for (int i = 0; i < count; i++) {
+            const RequestSummary& s = summaries[i];
+            std::printf("%s\n{\"request\":%d,\"name\":%s,\"hits\":%lld,\"skipped\":%lld,\"meanHitScore\":%.4f,"
+                        "\"p50Us\":%.1f,\"p99Us\":%.1f}",
+                        i ? "," : "", i, JsonQuote(names[i]).c_str(), s.hits, s.skipped,
+                        s.hits ? s.hitScore / s.hits : 0.0, SortedPercentile(s.times, 0.5) / 1e3,
+                        SortedPercentile(s.times, 0.99) / 1e3);
+        }
+        std::printf("\n]}}\n");
+    }
+
+    // 汇总 (标准错误，不混入结果)
+    std::fprintf(stderr, "frames=%zu threads=%d wall=%.2fs throughput=%.1f fps frame p50=%.2fms p99=%.2fms\n",
+                 frames, threads, wallSeconds, fps, SortedPercentile(frameTimes, 0.5) / 1e6,
+                 SortedPercentile(frameTimes, 0.99) / 1e6);
+    for (int i = 0; i < count; i++) {
+        const RequestSummary& s = summaries[i];
+        std::fprintf(stderr, "request %d (%s): hits=%lld/%zu skipped=%lld meanHitScore=%.3f p50=%.3fms p99=%.3fms\n",
+                     i, names[i].c_str(), s.hits, frames, s.skipped, s.hits ? s.hitScore / s.hits : 0.0,
+                     SortedPercentile(s.times, 0.5) / 1e6, SortedPercentile(s.times, 0.99) / 1e6);
+    }
+    return 0;
+}
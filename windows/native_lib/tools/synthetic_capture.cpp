@@ -0,0 +1,144 @@
+// 合成帧源
+// 不需要游戏窗口与截图驱动，在 Linux 上以固定帧率向 Automation::Submit 推送合成的 BGRA 帧，
+// 走与实时截图相同的流水线 (复制 -> 准备线程转换 / 采样 -> 匹配线程评估)，
+// 用于验证流水线的丢帧策略、吞吐与反应延迟。
+// 一个随机纹理模板按周期出现 / 消失并换位置，结束时核对 FOUND / LOST 事件数。
+// 用法: synthetic_capture [-f 帧率] [-n 帧数] [-s 宽x高] [-p 周期帧数]
+//   默认 60 fps、600 帧、1280x720、每 30 帧切换一次可见状态
+// 返回值: 0 事件数与预期一致, 1 不一致, 2 参数无效
+#include "automation.h"
+#include "search_stats.h"
+#include "template_entry.h"
+
+#include <opencv2/imgproc.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <thread>
+
+// xorshift32: 只用于生成纹理，不追求统计质量
+static uint32_t NextRandom(uint32_t* state) {
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+static void FillNoise(cv::Mat* image, uint32_t* state) {
+    for (int y = 0; y < image->rows; y++) {
+        uint8_t* row = image->ptr<uint8_t>(y);
+        for (size_t i = 0; i < static_cast<size_t>(image->cols) * image->channels(); i++) {
+            row[i] = static_cast<uint8_t>(NextRandom(state) >> 24);
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    double fps = 60;
+    int frames = 600;
+    int width = 1280;
+    int height = 720;
+    int period = 30;
+    for (int arg = 1; arg + 1 < argc; arg += 2) {
+        if (std::strcmp(argv[arg], "-f") == 0) {
+            fps = std::atof(argv[arg + 1]);
+        } else if (std::strcmp(argv[arg], "-n") == 0) {
+            frames = std::atoi(argv[arg + 1]);
+        } else if (std::strcmp(argv[arg], "-s") == 0) {
+            if (std::sscanf(argv[arg + 1], "%dx%d", &width, &height) != 2) width = 0;
+        } else if (std::strcmp(argv[arg], "-p") == 0) {
+            period = std::atoi(argv[arg + 1]);
+        } else {
+            width = 0;
+        }
+    }
+    const int tw = 64;
+    const int th = 48;
+    if (fps <= 0 || frames <= 0 || width < tw * 2 || height < th * 2 || period <= 0) {
+        std::fprintf(stderr, "usage: synthetic_capture [-f fps] [-n frames] [-s WxH] [-p period]\n");
+        return 2;
+    }
+
+    uint32_t seed = 0x9E3779B9u;
+    cv::Mat background(height, width, CV_8UC4);
+    FillNoise(&background, &seed);
+    cv::Mat templ(th, tw, CV_8UC3);
+    FillNoise(&templ, &seed);
+    cv::Mat templBgra;
+    cv::cvtColor(templ, templBgra, cv::COLOR_BGR2BGRA);
+
+    AutomationRule rule = {};
+    rule.request.templateId = 1;
+    rule.request.method = SEARCH_METHOD_CCOEFF_NORMED;
+    rule.request.threshold = 0.9;
+    const std::shared_ptr<const TemplateEntry> entry = MakeTemplateEntry(templ);
+
+    std::atomic<int> found{0};
+    std::atomic<int> lost{0};
+    std::atomic<int> misplaced{0};
+    std::atomic<int> expectX{-1};
+    std::atomic<int> expectY{-1};
+    Automation automation(&rule, &entry, 1, std::make_shared<SearchStatsRegistry>(),
+                          [&](const AutomationEvent& event) {
+                              if (event.kind == AUTOMATION_EVENT_FOUND) {
+                                  found++;
+                                  // 丢帧时事件可能来自上一周期的帧，只统计位置明显不符的情况
+                                  if (std::abs(event.x - expectX.load()) > 1 || std::abs(event.y - expectY.load()) > 1) {
+                                      misplaced++;
+                                  }
+                              } else if (event.kind == AUTOMATION_EVENT_LOST) {
+                                  lost++;
+                              }
+                          });
+    automation.Start();
+
+    cv::Mat frame(height, width, CV_8UC4);
+    int visiblePeriods = 0;
+    const auto interval = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(1.0 / fps));
+    auto next = std::chrono::steady_clock::now();
+    const long long start = StatsNowNs();
+    for (int i = 0; i < frames; i++) {
+        const int cycle = i / period;
+        const bool visible = cycle % 2 == 0;
+        background.copyTo(frame);
+        if (visible) {
+            const int x = (cycle * 197) % (width - tw);
+            const int y = (cycle * 131) % (height - th);
+            if (i % period == 0) {
+                visiblePeriods++;
+                expectX = x;
+                expectY = y;
+            }
+            cv::Mat target = frame(cv::Rect(x, y, tw, th));
+            templBgra.copyTo(target);
+        }
+        automation.Submit(frame.data, width, height, static_cast<int>(frame.step[0]), StatsNowNs());
+        next += interval;
+        std::this_thread::sleep_until(next);
+    }
+    // 给流水线留出处理最后几帧的时间
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    automation.Stop();
+    const double seconds = (StatsNowNs() - start) / 1e9;
+
+    AutomationStats stats;
+    automation.GetStats(&stats);
+    std::printf("submitted=%lld evaluated=%lld dropped=%lld (%.1f fps evaluated)\n", stats.framesSubmitted,
+                stats.framesEvaluated, stats.framesDropped, stats.framesEvaluated / seconds);
+    std::printf("latency p50=%.2fms p99=%.2fms max=%.2fms\n", stats.p50LatencyNs / 1e6, stats.p99LatencyNs / 1e6,
+                stats.maxLatencyNs / 1e6);
+
+    // 最后一个周期可见时不会有对应的 LOST
+    const int lastVisible = ((frames - 1) / period) % 2 == 0 ? 1 : 0;
+    const bool ok = found == visiblePeriods && lost == visiblePeriods - lastVisible && misplaced == 0;
+    std::printf("found=%d lost=%d misplaced=%d expected found=%d lost=%d: %s\n", found.load(), lost.load(),
+                misplaced.load(), visiblePeriods, visiblePeriods - lastVisible, ok ? "OK" : "MISMATCH");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,157 @@
+// 合成标注帧集
+// 用 synthetic_frames.h 生成帧目录与标注文件 (ground_truth.h 格式)，可直接交给
+// accuracy_harness 与 search_replay，在 Linux 上离线评估而不依赖游戏截图。
+// 用法: synthetic_corpus [选项] 输出目录
+//   -s 宽x高:      帧尺寸，默认 1280x720
+//   -n 帧数:       默认 100
+//   -S 种子:       默认 1；同一种子与参数生成逐字节相同的帧集
+//   -T 名称=路径:  使用已有模板图片，可重复
+//   -g 个数:宽x高: 另外生成若干随机纹理模板 (没有 -T 时默认 4:48x48)
+//   -b 背景:       flat / gradient / noise / checker / clutter / mixed (默认)
+//   -c 最少:最多:  每个模板每帧的实例数，默认 0:1
+//   -j 比例:       尺度抖动，如 0.1 表示 0.9-1.1 倍
+//   -O 比例:       遮挡比例上限
+//   -N 标准差:     噪声标准差 (灰度级)
+//   -q 质量:       JPEG 压缩质量 (1-100)，默认不压缩
+//   -t 阈值:       写入标注的匹配阈值，默认 0.8
+//   -a:            允许实例互相重叠
+// 输出: 目录/templates/*.png、目录/frames/000000.png ...、目录/truth.json
+// 返回值: 0 成功, 1 读写失败, 2 参数无效
+#include "ground_truth.h"
+#include "synthetic_frames.h"
+
+#include <opencv2/opencv.hpp>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+int main(int argc, char** argv) {
+    SyntheticFrameOptions options;
+    int frames = 100;
+    int generated = 0;
+    int generatedWidth = 48;
+    int generatedHeight = 48;
+    double threshold = 0.8;
+    std::vector<std::pair<std::string, std::string>> files;
+    bool valid = true;
+    int arg = 1;
+    for (; arg < argc && argv[arg][0] == '-'; arg++) {
+        if (std::strcmp(argv[arg], "-a") == 0) {
+            options.allowOverlap = true;
+            continue;
+        }
+        if (arg + 1 >= argc) {
+            valid = false;
+            break;
+        }
+        const char* option = argv[arg];
+        const char* value = argv[++arg];
+        if (std::strcmp(option, "-s") == 0) {
+            valid &= std::sscanf(value, "%dx%d", &options.width, &options.height) == 2;
+        } else if (std::strcmp(option, "-n") == 0) {
+            frames = std::atoi(value);
+        } else if (std::strcmp(option, "-S") == 0) {
+            options.seed = std::strtoull(value, nullptr, 0);
+        } else if (std::strcmp(option, "-T") == 0) {
+            const char* equals = std::strchr(value, '=');
+            valid &= equals != nullptr && equals != value && equals[1] != 0;
+            if (equals) files.emplace_back(std::string(value, equals), std::string(equals + 1));
+        } else if (std::strcmp(option, "-g") == 0) {
+            valid &= std::sscanf(value, "%d:%dx%d", &generated, &generatedWidth, &generatedHeight) == 3;
+        } else if (std::strcmp(option, "-b") == 0) {
+            valid &= ParseSyntheticBackground(value, &options.background);
+        } else if (std::strcmp(option, "-c") == 0) {
+            valid &= std::sscanf(value, "%d:%d", &options.minCount, &options.maxCount) == 2;
+        } else if (std::strcmp(option, "-j") == 0) {
+            options.scaleJitter = std::atof(value);
+        } else if (std::strcmp(option, "-O") == 0) {
+            options.occlusion = std::atof(value);
+        } else if (std::strcmp(option, "-N") == 0) {
+            options.noiseSigma = std::atof(value);
+        } else if (std::strcmp(option, "-q") == 0) {
+            options.jpegQuality = std::atoi(value);
+        } else if (std::strcmp(option, "-t") == 0) {
+            threshold = std::atof(value);
+        } else {
+            valid = false;
+        }
+    }
+    if (files.empty() && generated == 0) generated = 4;
+    if (!valid || arg + 1 != argc || options.width <= 0 || options.height <= 0 || frames <= 0 ||
+        options.minCount < 0 || options.maxCount < options.minCount || options.scaleJitter < 0 ||
+        options.scaleJitter >= 1 || options.occlusion < 0 || options.occlusion > 1 || options.noiseSigma < 0 ||
+        options.jpegQuality < 0 || options.jpegQuality > 100 || generated < 0 || generatedWidth <= 0 ||
+        generatedHeight <= 0) {
+        std::fprintf(stderr, "usage: synthetic_corpus [-s WxH] [-n frames] [-S seed] [-T name=path ...] "
+                             "[-g count:WxH] [-b flat|gradient|noise|checker|clutter|mixed] [-c min:max] "
+                             "[-j jitter] [-O occlusion] [-N sigma] [-q jpeg] [-t threshold] [-a] out_dir\n");
+        return 2;
+    }
+
+    const std::filesystem::path root(argv[arg]);
+    std::error_code ec;
+    std::filesystem::create_directories(root / "templates", ec);
+    std::filesystem::create_directories(root / "frames", ec);
+    if (ec) {
+        std::fprintf(stderr, "cannot create %s: %s\n", root.string().c_str(), ec.message().c_str());
+        return 1;
+    }
+
+    // 模板复制进输出目录，帧集自包含
+    GroundTruth truth;
+    std::vector<SyntheticTemplate> templates;
+    for (size_t i = 0; i < files.size() + generated; i++) {
+        GroundTruthTemplate templ;
+        SyntheticTemplate synthetic;
+        if (i < files.size()) {
+            templ.name = files[i].first;
+            synthetic.image = cv::imread(files[i].second, cv::IMREAD_COLOR);
+            if (synthetic.image.empty()) {
+                std::fprintf(stderr, "cannot decode template %s\n", files[i].second.c_str());
+                return 1;
+            }
+        } else {
+            const int k = static_cast<int>(i - files.size());
+            templ.name = "synthetic" + std::to_string(k);
+            synthetic.image = MakeSyntheticTemplate(options.seed * 1000003 + k, generatedWidth, generatedHeight);
+        }
+        templ.path = "templates/" + templ.name + ".png";
+        templ.request.threshold = threshold;
+        if (!cv::imwrite((root / templ.path).string(), synthetic.image)) {
+            std::fprintf(stderr, "cannot write %s\n", (root / templ.path).string().c_str());
+            return 1;
+        }
+        truth.templates.push_back(templ);
+        templates.push_back(synthetic);
+    }
+
+    cv::Mat frame;
+    long long objects = 0;
+    for (int i = 0; i < frames; i++) {
+        GroundTruthFrame entry;
+        char name[32];
+        std::snprintf(name, sizeof(name), "frames/%06d.png", i);
+        entry.image = name;
+        GenerateSyntheticFrame(options, templates, i, &frame, &entry.objects);
+        // PNG 无损: 失真只来自生成参数
+        if (!cv::imwrite((root / entry.image).string(), frame)) {
+            std::fprintf(stderr, "cannot write %s\n", (root / entry.image).string().c_str());
+            return 1;
+        }
+        objects += static_cast<long long>(entry.objects.size());
+        truth.frames.push_back(std::move(entry));
+    }
+
+    std::string error;
+    if (!SaveGroundTruth((root / "truth.json").string(), truth, &error)) {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+    std::fprintf(stderr, "%d frames, %zu templates, %lld objects -> %s\n", frames, truth.templates.size(), objects,
+                 (root / "truth.json").string().c_str());
+    return 0;
+}
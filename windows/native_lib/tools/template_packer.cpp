@@ -0,0 +1,127 @@
+// 模板打包工具
+// 把一组模板图片解码为 BGR 平面，连同统计量、金字塔层与 alpha 掩码写入 .pack 文件，
+// 运行时由 load_template_pack 内存映射加载 (格式见 template_pack.h)
+// 用法: template_packer [-l 层数] 输出.pack 输入文件或目录...
+//   -l: 金字塔层数 (含原图，1-4，默认 3)；过小的层 (任一边 < 4 像素) 会被省略
+//   目录按文件名排序递归收集 png/jpg/jpeg/bmp，名称为相对该目录的路径 (以 / 分隔)
+#include "mat_view.h"
+#include "template_pack.h"
+
+#include <opencv2/opencv.hpp>
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+static bool IsImageFile(const fs::path& path) {
+    std::string ext = path.extension().string();
+    std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return std::tolower(c); });
+    return ext == ".png" || ext == ".jpg" || ext == ".jpeg" || ext == ".bmp";
+}
+
+// 收集 (名称, 路径)
+static void CollectInputs(const fs::path& input, std::vector<std::pair<std::string, fs::path>>* out) {
+    if (fs::is_directory(input)) {
+        std::vector<std::pair<std::string, fs::path>> found;
+        for (const auto& item : fs::recursive_directory_iterator(input)) {
+            if (item.is_regular_file() && IsImageFile(item.path())) {
+                found.emplace_back(fs::relative(item.path(), input).generic_string(), item.path());
+            }
+        }
+        std::sort(found.begin(), found.end());
+        out->insert(out->end(), found.begin(), found.end());
+    } else {
+        out->emplace_back(input.filename().string(), input);
+    }
+}
+
+int main(int argc, char** argv) {
+    int levels = 3;
+    int arg = 1;
+    if (arg + 1 < argc && std::strcmp(argv[arg], "-l") == 0) {
+        levels = std::atoi(argv[arg + 1]);
+        arg += 2;
+    }
+    if (argc - arg < 2 || levels < 1 || levels > kPackMaxLevels) {
+        std::fprintf(stderr, "usage: template_packer [-l levels(1-%d)] out.pack input...\n", kPackMaxLevels);
+        return 2;
+    }
+    const std::string output = argv[arg++];
+
+    std::vector<std::pair<std::string, fs::path>> inputs;
+    for (; arg < argc; arg++) {
+        CollectInputs(argv[arg], &inputs);
+    }
+
+    TemplatePackWriter writer;
+    for (const auto& input : inputs) {
+        const cv::Mat raw = cv::imread(input.second.string(), cv::IMREAD_UNCHANGED);
+        if (raw.empty() || raw.depth() != CV_8U) {
+            std::fprintf(stderr, "skip %s: cannot decode\n", input.second.string().c_str());
+            continue;
+        }
+
+        // 与 load_template 的 IMREAD_COLOR 一致: 统一转为 BGR
+        cv::Mat bgr;
+        cv::Mat mask;
+        if (raw.channels() == 4) {
+            cv::cvtColor(raw, bgr, cv::COLOR_BGRA2BGR);
+            cv::Mat alpha;
+            cv::extractChannel(raw, alpha, 3);
+            // 只有确实存在透明像素时才写入掩码
+            if (cv::countNonZero(alpha < 255) > 0) {
+                mask = alpha > 0;
+            }
+        } else if (raw.channels() == 1) {
+            cv::cvtColor(raw, bgr, cv::COLOR_GRAY2BGR);
+        } else {
+            bgr = raw;
+        }
+
+        std::vector<cv::Mat> pyramid{bgr};
+        while (static_cast<int>(pyramid.size()) < levels) {
+            const cv::Mat& last = pyramid.back();
+            if (last.cols / 2 < 4 || last.rows / 2 < 4) break;
+            cv::Mat down;
+            cv::resize(last, down, cv::Size(last.cols / 2, last.rows / 2), 0, 0, cv::INTER_AREA);
+            pyramid.push_back(down);
+        }
+
+        std::vector<ImageView> views;
+        for (const cv::Mat& level : pyramid) {
+            views.push_back(ToImageView(level));
+        }
+        const ImageView maskView = mask.empty() ? ImageView() : ToImageView(mask);
+        if (!writer.Add(input.first, views.data(), static_cast<int>(views.size()),
+                        mask.empty() ? nullptr : &maskView)) {
+            std::fprintf(stderr, "skip %s: invalid entry (name must be < %d bytes)\n",
+                         input.first.c_str(), kPackNameSize);
+            continue;
+        }
+        std::printf("%-40s %4dx%-4d levels=%zu%s\n", input.first.c_str(), bgr.cols, bgr.rows,
+                    pyramid.size(), mask.empty() ? "" : " mask");
+    }
+
+    std::string error;
+    if (!writer.Write(output, &error)) {
+        std::fprintf(stderr, "failed to write %s: %s\n", output.c_str(), error.c_str());
+        return 1;
+    }
+
+    // 回读校验
+    TemplatePack check;
+    if (!check.Open(output, &error)) {
+        std::fprintf(stderr, "verification failed: %s\n", error.c_str());
+        return 1;
+    }
+    std::printf("wrote %s: %d templates\n", output.c_str(), check.Count());
+    return 0;
+}
@@ -0,0 +1,141 @@
+#include "trace.h"
+#include "json_value.h"
+#include "search_stats.h"
+
+#ifdef IMAGE_SEARCH_TRACING
+
+#include <atomic>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <vector>
+
+// 每个线程缓冲的事件数 (每个事件 24 字节)
+static const uint32_t kTraceRingSize = 1 << 14;
+
+struct TraceEvent {
+    const char* name;
+    int64_t startNs;
+    int64_t durationNs;
+};
+
+// 单写者环形缓冲: 写线程填好槽位后以 release 发布 written；
+// 读取方复制后再次读取 written，丢弃复制期间可能被覆盖的槽位
+struct TraceRing {
+    std::atomic<bool> owned{false};
+    std::atomic<uint64_t> written{0};
+    std::atomic<uint64_t> cleared{0};  // TraceClear 时的 written，之前的事件不再导出
+    int tid = 0;
+    TraceEvent events[kTraceRingSize];
+};
+
+static std::atomic<bool> g_traceEnabled{false};
+static std::mutex g_ringMutex;
+
+static std::vector<std::unique_ptr<TraceRing>>& Rings() {
+    static std::vector<std::unique_ptr<TraceRing>>* rings = new std::vector<std::unique_ptr<TraceRing>>();
+    return *rings;
+}
+
+// 首次记录时登记；线程退出后缓冲留给新线程复用，已有事件保留到被覆盖
+struct RingHandle {
+    TraceRing* ring = nullptr;
+
+    RingHandle() {
+        std::lock_guard<std::mutex> lock(g_ringMutex);
+        for (auto& candidate : Rings()) {
+            bool expected = false;
+            if (candidate->owned.compare_exchange_strong(expected, true)) {
+                ring = candidate.get();
+                return;
+            }
+        }
+        Rings().push_back(std::make_unique<TraceRing>());
+        ring = Rings().back().get();
+        ring->tid = static_cast<int>(Rings().size());
+        ring->owned.store(true);
+    }
+
+    ~RingHandle() {
+        ring->owned.store(false);
+    }
+};
+
+int64_t TraceNowNs() {
+    return StatsNowNs();
+}
+
+bool TraceEnabled() {
+    return g_traceEnabled.load(std::memory_order_relaxed);
+}
+
+void TraceEnable(bool enabled) {
+    g_traceEnabled.store(enabled, std::memory_order_relaxed);
+}
+
+void TraceRecord(const char* name, int64_t startNs, int64_t durationNs) {
+    thread_local RingHandle handle;
+    TraceRing& ring = *handle.ring;
+    const uint64_t index = ring.written.load(std::memory_order_relaxed);
+    ring.events[index & (kTraceRingSize - 1)] = {name, startNs, durationNs};
+    ring.written.store(index + 1, std::memory_order_release);
+}
+
+const char* TraceIntern(const char* name) {
+    static std::mutex internMutex;
+    static std::set<std::string>* names = new std::set<std::string>();
+    std::lock_guard<std::mutex> lock(internMutex);
+    return names->insert(name ? name : "").first->c_str();
+}
+
+int TraceDump(const std::string& path) {
+    FILE* file = std::fopen(path.c_str(), "wb");
+    if (!file) {
+        return -1;
+    }
+
+    std::vector<TraceEvent> copy;
+    int total = 0;
+    std::fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[", file);
+
+    std::lock_guard<std::mutex> lock(g_ringMutex);
+    for (const auto& ring : Rings()) {
+        const uint64_t end = ring->written.load(std::memory_order_acquire);
+        uint64_t begin = end > kTraceRingSize ? end - kTraceRingSize : 0;
+        const uint64_t cleared = ring->cleared.load(std::memory_order_relaxed);
+        if (begin < cleared) begin = cleared;
+        copy.clear();
+        for (uint64_t i = begin; i < end; i++) {
+            copy.push_back(ring->events[i & (kTraceRingSize - 1)]);
+        }
+        // 复制期间写线程可能已覆盖最旧的槽位；此外它可能正在写下标 after 的槽位 (尚未发布)，
+        // 该槽位原有的事件 after - kTraceRingSize 也不可信
+        const uint64_t after = ring->written.load(std::memory_order_acquire);
+        const uint64_t firstValid = after + 1 > kTraceRingSize ? after + 1 - kTraceRingSize : 0;
+        const size_t skip = firstValid > begin ? static_cast<size_t>(firstValid - begin) : 0;
+
+        for (size_t i = skip; i < copy.size(); i++) {
+            const TraceEvent& e = copy[i];
+            std::fputs(total == 0 ? "\n" : ",\n", file);
+            std::fputs("{\"name\":", file);
+            std::fputs(JsonQuote(e.name ? e.name : "").c_str(), file);
+            std::fprintf(file, ",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                         ring->tid, e.startNs / 1000.0, e.durationNs / 1000.0);
+            total++;
+        }
+    }
+    std::fputs("\n]}\n", file);
+    const bool ok = std::fclose(file) == 0;
+    return ok ? total : -1;
+}
+
+void TraceClear() {
+    std::lock_guard<std::mutex> lock(g_ringMutex);
+    for (const auto& ring : Rings()) {
+        // written 只由写线程修改，这里只记录清空时的位置
+        ring->cleared.store(ring->written.load(std::memory_order_acquire), std::memory_order_relaxed);
+    }
+}
+
+#endif // IMAGE_SEARCH_TRACING
@@ -0,0 +1,65 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <cstdint>
+#include <string>
+
+// 轻量级追踪 (导出为 Chrome trace-event JSON，可在 chrome://tracing 或 Perfetto 中查看)
+//
+// TRACE_SCOPE("name") 在作用域结束时记录一个完整事件 (ph = "X"，含开始时间与时长)，
+// 写入当前线程自己的环形缓冲，不加锁；缓冲写满后覆盖最旧的事件。
+// 名称必须是静态字符串 (只保存指针)；来自外部的名称先经 TraceIntern 驻留。
+//
+// 两级开关:
+//   - 编译期: 未定义 IMAGE_SEARCH_TRACING 时宏展开为空，不产生任何代码
+//   - 运行期: TraceEnable(false) (默认) 时每个作用域只多一次 relaxed 原子读取
+
+#ifdef IMAGE_SEARCH_TRACING
+
+// 单调时钟 (纳秒)，与 search_stats 使用同一时基
+int64_t TraceNowNs();
+
+bool TraceEnabled();
+void TraceEnable(bool enabled);
+
+// 记录一个完整事件
+void TraceRecord(const char* name, int64_t startNs, int64_t durationNs);
+
+// 驻留外部传入的名称，返回在进程生命周期内有效的指针
+// 加全局锁并构造字符串查表，只应在每个调用点首次使用时调用一次 (导出为 trace_intern)
+const char* TraceIntern(const char* name);
+
+// 把所有线程缓冲中的事件写成 Chrome trace-event JSON，返回事件数，失败返回 -1
+int TraceDump(const std::string& path);
+
+// 清空所有缓冲
+void TraceClear();
+
+class TraceScope {
+public:
+    explicit TraceScope(const char* name) : name_(TraceEnabled() ? name : nullptr) {
+        if (name_) start_ = TraceNowNs();
+    }
+    ~TraceScope() {
+        if (name_) TraceRecord(name_, start_, TraceNowNs() - start_);
+    }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    const char* name_;
+    int64_t start_ = 0;
+};
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_SCOPE(name) TraceScope TRACE_CONCAT(traceScope_, __LINE__)(name)
+
+#else
+
+#define TRACE_SCOPE(name) ((void)0)
+
+#endif // IMAGE_SEARCH_TRACING
+
+#endif // TRACE_H
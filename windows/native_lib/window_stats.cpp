@@ -0,0 +1,141 @@
+#include "window_stats.h"
+
+#include <cstddef>
+
+void ComputeTemplateSums(const ImageView& templ, TemplateSums* out) {
+    *out = TemplateSums();
+    out->channels = templ.channels;
+    out->area = static_cast<int64_t>(templ.width) * templ.height;
+    for (int y = 0; y < templ.height; y++) {
+        const uint8_t* row = templ.Row(y);
+        for (int x = 0; x < templ.width; x++) {
+            for (int c = 0; c < templ.channels; c++) {
+                const int64_t v = row[x * templ.channels + c];
+                out->sum[c] += v;
+                out->sumSq += v * v;
+            }
+        }
+    }
+}
+
+bool SlidingWindowStats::Fits(int windowWidth, int windowHeight, int channels, bool normalized) {
+    const int64_t limit = INT32_MAX;
+    const int64_t squares = static_cast<int64_t>(channels) * 255 * 255;
+    const int64_t area = static_cast<int64_t>(windowWidth) * windowHeight;
+    if (area * 255 > limit || windowHeight * squares > limit || windowWidth * squares > limit) {
+        return false;
+    }
+    // 分子 面积 * 互相关 与方差 面积 * 平方和: 互相关、平方和都不超过 面积 * 通道 * 255^2
+    return !normalized || area <= 0 || area <= INT64_MAX / (area * squares);
+}
+
+bool SlidingWindowStats::Reset(const ImageView& src, int windowWidth, int windowHeight, bool withSquares) {
+    src_ = src;
+    windowWidth_ = windowWidth;
+    windowHeight_ = windowHeight;
+    withSquares_ = withSquares;
+    cols_ = src.width - windowWidth + 1;
+    rows_ = src.height - windowHeight + 1;
+    row_ = 0;
+    if (src.Empty() || windowWidth <= 0 || windowHeight <= 0 || cols_ <= 0 || rows_ <= 0 ||
+        !Fits(windowWidth, windowHeight, src.channels, withSquares)) {
+        cols_ = 0;
+        rows_ = 0;
+        return false;
+    }
+
+    // assign 只在尺寸变化时重新分配，复用同一对象时稳态零分配
+    columnSums_.assign(static_cast<size_t>(src.width) * src.channels, 0);
+    sums_.resize(static_cast<size_t>(cols_) * src.channels);
+    if (withSquares) {
+        columnSquares_.assign(static_cast<size_t>(src.width), 0);
+        squareSums_.resize(static_cast<size_t>(cols_));
+    }
+    for (int y = 0; y < windowHeight; y++) {
+        AccumulateRow(y, 1);
+    }
+    SlideRow();
+    return true;
+}
+
+void SlidingWindowStats::Reserve(int srcWidth, int channels, bool withSquares) {
+    const size_t n = static_cast<size_t>(srcWidth) * channels;
+    columnSums_.reserve(n);
+    sums_.reserve(n);
+    if (withSquares) {
+        columnSquares_.reserve(static_cast<size_t>(srcWidth));
+        squareSums_.reserve(static_cast<size_t>(srcWidth));
+    }
+}
+
+bool SlidingWindowStats::Advance() {
+    if (row_ + 1 >= rows_) {
+        return false;
+    }
+    AccumulateRow(row_, -1);
+    AccumulateRow(row_ + windowHeight_, 1);
+    row_++;
+    SlideRow();
+    return true;
+}
+
+void SlidingWindowStats::AccumulateRow(int y, int sign) {
+    const uint8_t* row = src_.Row(y);
+    const int n = src_.width * src_.channels;
+    int32_t* col = columnSums_.data();
+    if (sign > 0) {
+        for (int i = 0; i < n; i++) col[i] += row[i];
+    } else {
+        for (int i = 0; i < n; i++) col[i] -= row[i];
+    }
+    if (!withSquares_) {
+        return;
+    }
+
+    // 每像素最多 通道 * 255^2 (BGR 195075，BGRA 260100)，列平方和在 Fits 保证的窗口高度内不会溢出 int32
+    const int ch = src_.channels;
+    int32_t* sq = columnSquares_.data();
+    for (int x = 0; x < src_.width; x++) {
+        int32_t s = 0;
+        for (int c = 0; c < ch; c++) {
+            const int32_t v = row[x * ch + c];
+            s += v * v;
+        }
+        sq[x] += sign * s;
+    }
+}
+
+void SlidingWindowStats::SlideRow() {
+    const int ch = src_.channels;
+    const int32_t* col = columnSums_.data();
+    int32_t* out = sums_.data();
+
+    // 第一个窗口直接累加，之后每右移一列加新列、减旧列
+    for (int c = 0; c < ch; c++) {
+        int32_t s = 0;
+        for (int x = 0; x < windowWidth_; x++) s += col[x * ch + c];
+        out[c] = s;
+    }
+    for (int x = 1; x < cols_; x++) {
+        const int32_t* add = col + (x + windowWidth_ - 1) * ch;
+        const int32_t* sub = col + (x - 1) * ch;
+        const int32_t* prev = out + (x - 1) * ch;
+        int32_t* cur = out + x * ch;
+        for (int c = 0; c < ch; c++) {
+            cur[c] = prev[c] + add[c] - sub[c];
+        }
+    }
+    if (!withSquares_) {
+        return;
+    }
+
+    const int32_t* sq = columnSquares_.data();
+    int64_t* outSq = squareSums_.data();
+    int64_t s = 0;
+    for (int x = 0; x < windowWidth_; x++) s += sq[x];
+    outSq[0] = s;
+    for (int x = 1; x < cols_; x++) {
+        s += static_cast<int64_t>(sq[x + windowWidth_ - 1]) - sq[x - 1];
+        outSq[x] = s;
+    }
+}
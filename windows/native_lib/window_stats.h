@@ -0,0 +1,73 @@
+#ifndef WINDOW_STATS_H
+#define WINDOW_STATS_H
+
+#include "image_view.h"
+
+#include <cstdint>
+#include <vector>
+
+// 模板的逐通道像素和 (加载时计算一次)
+struct TemplateSums {
+    int channels = 0;
+    int64_t area = 0;     // 单通道像素数 (宽 * 高)
+    int64_t sum[4] = {};  // 每个通道的像素和
+    int64_t sumSq = 0;    // 所有通道的像素平方和
+};
+
+void ComputeTemplateSums(const ImageView& templ, TemplateSums* out);
+
+// 源图滑动窗口统计 (逐行推进)
+// 按结果图的行 y 逐行产出窗口 [x, x+tw) x [y, y+th) 内每个通道的像素和，
+// 以及 (可选) 所有通道合计的像素平方和。
+// 内部维护列和并滚动更新，每行代价 O(宽 * 通道)，内存仅 O(宽)，
+// 因此即使是 4K 全图搜索也不需要整张积分图。
+class SlidingWindowStats {
+public:
+    // 绑定源图与窗口尺寸，并准备第 0 行的统计
+    // withSquares: 是否同时统计平方和 (归一化相关需要，SSD 不需要)
+    // 返回 false 表示源图小于窗口，或窗口超出 Fits 的范围 (withSquares 时按 normalized 判断)
+    bool Reset(const ImageView& src, int windowWidth, int windowHeight, bool withSquares = false);
+
+    // 窗口 (模板) 尺寸是否在内核 int32 累加的范围内:
+    //   逐通道窗口和 宽 * 高 * 255 (面积不超过约 842 万像素)；
+    //   列平方和 高 * 通道 * 255^2 (BGR 不超过 11008 行，BGRA 不超过 8256 行)；
+    //   SSD 的单行差平方和 宽 * 通道 * 255^2 (列数同上)；
+    //   normalized 时另有归一化相关的 int64 乘积 面积 * 面积 * 通道 * 255^2
+    //   (BGR 面积不超过 6876129 像素，BGRA 不超过 5954902 像素；int64 之外没有可移植的更宽整数)
+    // 超出范围的模板只能走 OpenCV (查找计划编译时自动切换)
+    static bool Fits(int windowWidth, int windowHeight, int channels, bool normalized = false);
+
+    // 预先按最大尺寸分配内部缓冲，之后 Reset 不超过该尺寸时不再分配
+    void Reserve(int srcWidth, int channels, bool withSquares);
+
+    // 推进到下一行，返回 false 表示已经没有更多行
+    bool Advance();
+
+    int Row() const { return row_; }
+    int Cols() const { return cols_; }
+    int Rows() const { return rows_; }
+
+    // 当前行每个位置的逐通道窗口和，布局为 [x * channels + c]
+    const int32_t* Sums() const { return sums_.data(); }
+
+    // 当前行每个位置所有通道合计的窗口平方和 (仅 withSquares 时有效)
+    const int64_t* SquareSums() const { return squareSums_.data(); }
+
+private:
+    void AccumulateRow(int y, int sign);
+    void SlideRow();
+
+    ImageView src_;
+    int windowWidth_ = 0;
+    int windowHeight_ = 0;
+    int cols_ = 0;
+    int rows_ = 0;
+    int row_ = 0;
+    bool withSquares_ = false;
+    std::vector<int32_t> columnSums_;
+    std::vector<int32_t> columnSquares_;  // 每列 (跨通道合计) 的平方和
+    std::vector<int32_t> sums_;
+    std::vector<int64_t> squareSums_;
+};
+
+#endif // WINDOW_STATS_H
@@ -0,0 +1,172 @@
+#include "work_stealing_pool.h"
+
+#include <algorithm>
+
+// 当前线程在所属池中的队列下标；非工作线程为 -1
+static thread_local const WorkStealingPool* t_pool = nullptr;
+static thread_local int t_queue = -1;
+
+struct WorkStealingPool::Batch {
+    const std::function<void(int)>* fn = nullptr;
+    std::atomic<int> remaining{0};
+    std::mutex mutex;
+    std::condition_variable done;
+};
+
+WorkStealingPool::WorkStealingPool(int threads) {
+    if (threads <= 0) {
+        threads = HardwareThreads() - 1;
+    }
+    for (int i = 0; i < threads; i++) {
+        queues_.push_back(std::make_unique<Queue>());
+    }
+    workers_.reserve(threads);
+    for (int i = 0; i < threads; i++) {
+        workers_.emplace_back(&WorkStealingPool::WorkerLoop, this, i);
+    }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    {
+        std::lock_guard<std::mutex> lock(idleMutex_);
+        stopping_ = true;
+    }
+    idle_.notify_all();
+    for (std::thread& worker : workers_) {
+        worker.join();
+    }
+}
+
+void WorkStealingPool::ParallelFor(int count, const std::function<void(int)>& fn) {
+    if (count <= 0) return;
+    if (count == 1 || workers_.empty()) {
+        for (int i = 0; i < count; i++) fn(i);
+        return;
+    }
+
+    Batch batch;
+    batch.fn = &fn;
+    batch.remaining.store(count, std::memory_order_relaxed);
+
+    // 工作线程嵌套调用时放进自己的队列 (其他线程会来窃取)；外部线程把任务轮流分给各队列
+    const int own = t_pool == this ? t_queue : -1;
+    const int queues = static_cast<int>(queues_.size());
+    const int first = static_cast<int>(nextQueue_.fetch_add(1, std::memory_order_relaxed) % queues);
+    for (int i = 0; i < count; i++) {
+        Queue& queue = *queues_[own >= 0 ? own : (first + i) % queues];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.push_back(Task{&batch, i});
+    }
+    pending_.fetch_add(count, std::memory_order_release);
+    {
+        std::lock_guard<std::mutex> lock(idleMutex_);
+    }
+    idle_.notify_all();
+
+    // 调用线程一起执行 (可能顺带执行其他批次的任务)，直到本批任务都被取走
+    Task task;
+    while (batch.remaining.load(std::memory_order_acquire) > 0) {
+        if ((own >= 0 && PopLocal(own, &task)) || Steal(own, &task)) {
+            Execute(task);
+            continue;
+        }
+        // 队列中已没有本批任务，剩余的正在其他线程上执行
+        std::unique_lock<std::mutex> lock(batch.mutex);
+        batch.done.wait(lock, [&] { return batch.remaining.load(std::memory_order_acquire) == 0; });
+    }
+    // 等最后一个完成的线程离开临界区后再销毁 batch
+    std::lock_guard<std::mutex> lock(batch.mutex);
+}
+
+void WorkStealingPool::Submit(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(detachedMutex_);
+        detached_.push_back(std::move(task));
+    }
+    pending_.fetch_add(1, std::memory_order_release);
+    {
+        std::lock_guard<std::mutex> lock(idleMutex_);
+    }
+    idle_.notify_one();
+}
+
+bool WorkStealingPool::PopDetached(std::function<void()>* out) {
+    std::lock_guard<std::mutex> lock(detachedMutex_);
+    if (detached_.empty()) return false;
+    *out = std::move(detached_.front());
+    detached_.pop_front();
+    pending_.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+}
+
+bool WorkStealingPool::PopLocal(int queue, Task* out) {
+    Queue& q = *queues_[queue];
+    std::lock_guard<std::mutex> lock(q.mutex);
+    if (q.tasks.empty()) return false;
+    *out = q.tasks.back();
+    q.tasks.pop_back();
+    pending_.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+}
+
+bool WorkStealingPool::Steal(int self, Task* out) {
+    const int queues = static_cast<int>(queues_.size());
+    const int start = self >= 0 ? self + 1 : 0;
+    for (int k = 0; k < queues; k++) {
+        const int victim = (start + k) % queues;
+        if (victim == self) continue;
+        Queue& q = *queues_[victim];
+        std::lock_guard<std::mutex> lock(q.mutex);
+        if (q.tasks.empty()) continue;
+        *out = q.tasks.front();
+        q.tasks.pop_front();
+        pending_.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+    return false;
+}
+
+void WorkStealingPool::Execute(const Task& task) {
+    Batch& batch = *task.batch;
+    (*batch.fn)(task.index);
+    // 在锁内计数与通知: 调用方返回前会再取一次锁，保证这里不再访问已销毁的 batch
+    std::lock_guard<std::mutex> lock(batch.mutex);
+    if (batch.remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        batch.done.notify_all();
+    }
+}
+
+void WorkStealingPool::WorkerLoop(int index) {
+    t_pool = this;
+    t_queue = index;
+    Task task;
+    std::function<void()> detached;
+    for (;;) {
+        if (PopLocal(index, &task) || Steal(index, &task)) {
+            Execute(task);
+            continue;
+        }
+        // 有人在等的 ParallelFor 任务优先，其次才是独立任务
+        if (PopDetached(&detached)) {
+            detached();
+            detached = nullptr;
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(idleMutex_);
+        idle_.wait(lock, [this] { return stopping_ || pending_.load(std::memory_order_acquire) > 0; });
+        if (stopping_ && pending_.load(std::memory_order_acquire) == 0) {
+            return;
+        }
+    }
+}
+
+int HardwareThreads() {
+    const unsigned n = std::thread::hardware_concurrency();
+    return n > 0 ? static_cast<int>(n) : 1;
+}
+
+WorkStealingPool& SharedWorkers() {
+    // 保留一个硬件线程给截图与 UI；有意不析构，避免 DLL 卸载时在加载器锁内等待线程退出
+    static WorkStealingPool* pool = new WorkStealingPool(std::max(1, HardwareThreads() - 1));
+    return *pool;
+}
@@ -0,0 +1,78 @@
+#ifndef WORK_STEALING_POOL_H
+#define WORK_STEALING_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// 工作窃取线程池 (用于把一次计算拆成若干块并行执行)
+//
+// 每个工作线程有自己的任务队列: 从队尾取自己的任务，空闲时从其他队列的队头窃取，
+// 块的耗时不均 (如分块匹配中的边缘块) 时负载自动均衡。
+// ParallelFor 的调用线程也参与执行并在全部完成后返回，
+// 因此可以在池内任务中嵌套调用，也可以由多个线程同时调用而不会互相等死。
+// Submit 提交的独立任务 (如异步批量查找) 进入单独的 FIFO 队列，只由工作线程在没有
+// ParallelFor 任务时取出: 独立任务内部的 ParallelFor 仍在同一池上展开，线程总数不超过池的大小，
+// 同步调用 ParallelFor 的线程也不会被顺带执行的长任务拖住。
+class WorkStealingPool {
+public:
+    // threads: 工作线程数 (不含调用线程)，<= 0 时为硬件线程数 - 1
+    explicit WorkStealingPool(int threads = 0);
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    // 对 [0, count) 中的每个下标调用一次 fn，顺序不定；返回时全部调用已完成
+    void ParallelFor(int count, const std::function<void(int)>& fn);
+
+    // 提交一个独立任务，立即返回；任务按提交顺序由工作线程执行
+    // 没有工作线程时任务不会执行，调用方需保证 Size() > 0
+    void Submit(std::function<void()> task);
+
+    // 工作线程数 (不含调用线程)
+    int Size() const { return static_cast<int>(workers_.size()); }
+
+private:
+    struct Batch;
+
+    struct Task {
+        Batch* batch = nullptr;
+        int index = 0;
+    };
+
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    bool PopLocal(int queue, Task* out);
+    bool Steal(int self, Task* out);
+    bool PopDetached(std::function<void()>* out);
+    static void Execute(const Task& task);
+    void WorkerLoop(int index);
+
+    std::vector<std::unique_ptr<Queue>> queues_; // 与 workers_ 一一对应
+    std::vector<std::thread> workers_;
+    std::mutex detachedMutex_;
+    std::deque<std::function<void()>> detached_; // Submit 提交的独立任务
+    std::atomic<int> pending_{0};                // 排队中 (尚未被取走) 的任务数，含独立任务
+    std::atomic<unsigned> nextQueue_{0};         // 外部线程提交时轮流选择起始队列
+    std::mutex idleMutex_;
+    std::condition_variable idle_;
+    bool stopping_ = false;
+};
+
+// 进程内共用的工作线程池 (首次使用时创建，工作线程数为硬件线程数 - 1，至少 1 个)
+// 分块匹配、批量加载模板与异步批量查找都在这里执行，互相嵌套时也不会超出核数
+WorkStealingPool& SharedWorkers();
+
+// 硬件线程数 (无法获取时为 1)
+int HardwareThreads();
+
+#endif // WORK_STEALING_POOL_H
@@ -1,4 +1,6 @@
 #include "flutter_window.h"
+#include "frame_trace.h"
+#include "native_lib/image_search.h"
 #include "utils.h"
 
 #include <optional>
@@ -1549,6 +1551,7 @@ void FlutterWindow::ResizePreviewWindow(const flutter::MethodCall<flutter::Encod
 }
 
 void FlutterWindow::GetLastFrame(std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result) {
+    FRAME_TRACE_SCOPE("get_last_frame");
     std::vector<uint8_t> bmp_data;
     {
         std::lock_guard<std::mutex> lock(frame_mutex_);
@@ -1597,6 +1600,9 @@ void FlutterWindow::OnFrameArrived(
     winrt::Windows::Foundation::IInspectable const& args) {
 
     try {
+        // 帧到达时刻，自动化事件的反应延迟从这里算起
+        const long long arrival_ns = trace_now_ns();
+        FRAME_TRACE_SCOPE("frame_arrived");
         // 1. Acquire lock to safely access members and check state
         std::unique_lock<std::mutex> lock(frame_mutex_);
         if (!is_capturing_ || !d3d11_context_ || !d3d11_device_) return;
@@ -1689,18 +1695,30 @@ void FlutterWindow::OnFrameArrived(
         src_box.bottom = offset_y + client_height;
         src_box.back = 1;
         
-        local_context->CopySubresourceRegion(local_staging.Get(), 0, 0, 0, 0, texture.Get(), 0, &src_box);
-        
         D3D11_MAPPED_SUBRESOURCE mapped;
-        hr = local_context->Map(local_staging.Get(), 0, D3D11_MAP_READ, 0, &mapped);
+        {
+            // Map 会等待 GPU 拷贝完成，两者合计为一次回读
+            FRAME_TRACE_SCOPE("gpu_readback");
+            local_context->CopySubresourceRegion(local_staging.Get(), 0, 0, 0, 0, texture.Get(), 0, &src_box);
+            hr = local_context->Map(local_staging.Get(), 0, D3D11_MAP_READ, 0, &mapped);
+        }
         if (FAILED(hr)) return;
         
         if (capture_texture_) {
+            FRAME_TRACE_SCOPE("texture_update");
             capture_texture_->UpdateFrame((uint8_t*)mapped.pData, client_width, client_height, mapped.RowPitch);
         }
+
+        // 交给原生自动化评估 (未启动时立即返回)；内部复制，不持有映射内存
+        automation_submit_frame((const uint8_t*)mapped.pData, (int)client_width, (int)client_height,
+                                (int)mapped.RowPitch, arrival_ns);
+        // 录制 (未开始时立即返回)；同样只复制，编码与写盘在后台线程
+        recorder_submit_frame((const uint8_t*)mapped.pData, (int)client_width, (int)client_height,
+                              (int)mapped.RowPitch, arrival_ns);
         
         // Cache for GetLastFrame
         {
+            FRAME_TRACE_SCOPE("frame_cache");
             std::lock_guard<std::mutex> cache_lock(frame_mutex_);
             if (is_capturing_) {
                 UINT stride = client_width * 4;
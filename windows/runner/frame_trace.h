@@ -0,0 +1,42 @@
+#ifndef RUNNER_FRAME_TRACE_H_
+#define RUNNER_FRAME_TRACE_H_
+
+// 截图路径上的追踪点，事件写入 native_image_search 的追踪缓冲，
+// 与搜索事件一起由 trace_dump 导出。
+// 仅在以 IMAGE_SEARCH_TRACING 构建时生效，否则 FRAME_TRACE_SCOPE 展开为空。
+// 名称在每个调用点首次执行时经 trace_intern 驻留一次 (函数内静态变量)，之后每帧只记录句柄。
+
+#ifdef IMAGE_SEARCH_TRACING
+
+#include "native_lib/image_search.h"
+
+class FrameTraceScope {
+ public:
+  // name: trace_intern 返回的句柄
+  explicit FrameTraceScope(const char* name)
+      : name_(trace_is_enabled() ? name : nullptr), start_(name_ ? trace_now_ns() : 0) {}
+  ~FrameTraceScope() {
+    if (name_) trace_record(name_, start_, trace_now_ns() - start_);
+  }
+
+  FrameTraceScope(const FrameTraceScope&) = delete;
+  FrameTraceScope& operator=(const FrameTraceScope&) = delete;
+
+ private:
+  const char* name_;
+  long long start_;
+};
+
+#define FRAME_TRACE_CONCAT_INNER(a, b) a##b
+#define FRAME_TRACE_CONCAT(a, b) FRAME_TRACE_CONCAT_INNER(a, b)
+#define FRAME_TRACE_SCOPE(name)                                                              \
+  static const char* const FRAME_TRACE_CONCAT(frame_trace_name_, __LINE__) = trace_intern(name); \
+  FrameTraceScope FRAME_TRACE_CONCAT(frame_trace_, __LINE__)(FRAME_TRACE_CONCAT(frame_trace_name_, __LINE__))
+
+#else
+
+#define FRAME_TRACE_SCOPE(name) ((void)0)
+
+#endif  // IMAGE_SEARCH_TRACING
+
+#endif  // RUNNER_FRAME_TRACE_H_